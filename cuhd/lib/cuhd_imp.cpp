@@ -33,6 +33,7 @@
 
 #include "cuhd_handler.hpp"
 #include "liblte/cuhd/cuhd.h"
+#include "liblte/phy/utils/trace.h"
 
 //#define METADATA_VERBOSE
 
@@ -176,12 +177,15 @@ int cuhd_recv(void *h, void *data, uint32_t nsamples, bool blocking)
 {
   cuhd_handler *handler = static_cast < cuhd_handler * >(h);
   uhd::rx_metadata_t md;
+  int ret;
+  TRACE_BEGIN(TRACE_CUHD_RECV);
   if (blocking) {
     int n = 0, p;
     complex_t *data_c = (complex_t *) data;
     do {
       p = handler->rx_stream->recv(&data_c[n], nsamples - n, md);
       if (p == -1) {
+        TRACE_END(TRACE_CUHD_RECV);
         return -1;
       }
       n += p;
@@ -191,10 +195,12 @@ int cuhd_recv(void *h, void *data, uint32_t nsamples, bool blocking)
       }
 #endif
     } while (n < nsamples);
-    return nsamples;
+    ret = nsamples;
   } else {
-    return handler->rx_stream->recv(data, nsamples, md, 0.0);
+    ret = handler->rx_stream->recv(data, nsamples, md, 0.0);
   }
+  TRACE_END(TRACE_CUHD_RECV);
+  return ret;
 }
 
 int cuhd_recv_timed(void *h,
@@ -0,0 +1,336 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+
+#include "bench.h"
+
+/* Pins the calling thread to cpu. Returns false if it could not be done */
+bool bench_pin_cpu(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &set)) {
+    perror("sched_setaffinity");
+    return false;
+  }
+  return true;
+}
+
+/* Time stamp counter, 0 on architectures without one */
+uint64_t bench_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+#else
+  return 0;
+#endif
+}
+
+double bench_time_ns() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double) t.tv_sec * 1e9 + (double) t.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+/* Sorts samples in place */
+void bench_stats(double *samples, uint32_t nof_samples, double *min, double *median,
+                 double *mean, double *p90, double *p99, double *max, double *stddev)
+{
+  uint32_t i;
+  double sum = 0, sum2 = 0, m;
+
+  qsort(samples, nof_samples, sizeof(double), cmp_double);
+  for (i = 0; i < nof_samples; i++) {
+    sum += samples[i];
+  }
+  m = sum / nof_samples;
+  for (i = 0; i < nof_samples; i++) {
+    sum2 += (samples[i] - m) * (samples[i] - m);
+  }
+  *min = samples[0];
+  if (nof_samples % 2) {
+    *median = samples[nof_samples / 2];
+  } else {
+    *median = (samples[nof_samples / 2 - 1] + samples[nof_samples / 2]) / 2;
+  }
+  *mean = m;
+  *p90 = samples[(uint32_t) ceil(0.9 * nof_samples) - 1];
+  *p99 = samples[(uint32_t) ceil(0.99 * nof_samples) - 1];
+  *max = samples[nof_samples - 1];
+  *stddev = nof_samples > 1 ? sqrt(sum2 / (nof_samples - 1)) : 0;
+}
+
+/** Runs fn(arg) for opts->warmup_ns, then takes opts->nof_samples samples of
+ * as many consecutive calls as needed to last opts->min_time_ns, and writes
+ * the statistics of the time per call to result.
+ */
+void bench_run(bench_opts_t *opts, char *name, uint32_t size, bench_fn_t fn, void *arg,
+               bench_result_t *result)
+{
+  double ns[BENCH_MAX_SAMPLES], cycles[BENCH_MAX_SAMPLES];
+  double t0, t;
+  uint64_t c0;
+  uint32_t i, s, calls, nof_samples;
+  double dummy;
+
+  nof_samples = opts->nof_samples;
+  if (nof_samples > BENCH_MAX_SAMPLES) {
+    nof_samples = BENCH_MAX_SAMPLES;
+  } else if (nof_samples < 1) {
+    nof_samples = 1;
+  }
+
+  t0 = bench_time_ns();
+  do {
+    fn(arg);
+  } while (bench_time_ns() - t0 < opts->warmup_ns);
+
+  calls = 1;
+  while (true) {
+    t0 = bench_time_ns();
+    for (i = 0; i < calls; i++) {
+      fn(arg);
+    }
+    t = bench_time_ns() - t0;
+    if (t >= opts->min_time_ns || calls >= (1 << 24)) {
+      break;
+    }
+    calls *= 2;
+  }
+
+  for (s = 0; s < nof_samples; s++) {
+    c0 = bench_cycles();
+    t0 = bench_time_ns();
+    for (i = 0; i < calls; i++) {
+      fn(arg);
+    }
+    ns[s] = (bench_time_ns() - t0) / calls;
+    cycles[s] = (double) (bench_cycles() - c0) / calls;
+  }
+
+  bzero(result, sizeof(bench_result_t));
+  strncpy(result->name, name, BENCH_NAME_LEN - 1);
+  result->size = size;
+  result->nof_samples = nof_samples;
+  result->calls_x_sample = calls;
+  bench_stats(ns, nof_samples, &result->ns_min, &result->ns_median, &result->ns_mean,
+              &result->ns_p90, &result->ns_p99, &result->ns_max, &result->ns_stddev);
+  bench_stats(cycles, nof_samples, &dummy, &result->cycles_median, &dummy, &dummy, &dummy,
+              &dummy, &dummy);
+}
+
+static void cpu_model(char *model, int len) {
+  char line[256], *p;
+  FILE *f;
+
+  strncpy(model, "unknown", len);
+  f = fopen("/proc/cpuinfo", "r");
+  if (!f) {
+    return;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if (!strncmp(line, "model name", 10) && (p = strchr(line, ':'))) {
+      p += 2;
+      p[strcspn(p, "\n\"")] = '\0';
+      strncpy(model, p, len - 1);
+      model[len - 1] = '\0';
+      break;
+    }
+  }
+  fclose(f);
+}
+
+void bench_fprint_json_header(FILE *f, char *bench, int cpu) {
+  char model[128], date[32];
+  time_t now = time(NULL);
+
+  cpu_model(model, sizeof(model));
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+  fprintf(f, "{\n  \"benchmark\": \"%s\",\n  \"cpu_model\": \"%s\",\n  \"cpu\": %d,\n"
+          "  \"date\": \"%s\",\n  \"results\": [\n", bench, model, cpu, date);
+}
+
+void bench_fprint_json(FILE *f, bench_result_t *r, bool last) {
+  fprintf(f, "    {\"name\": \"%s\", \"size\": %u, \"samples\": %u, \"calls\": %u, "
+          "\"ns_min\": %.1f, \"ns_median\": %.1f, \"ns_mean\": %.1f, \"ns_p90\": %.1f, "
+          "\"ns_p99\": %.1f, \"ns_max\": %.1f, \"ns_stddev\": %.1f, \"cycles_median\": %.0f}%s\n",
+          r->name, r->size, r->nof_samples, r->calls_x_sample, r->ns_min, r->ns_median,
+          r->ns_mean, r->ns_p90, r->ns_p99, r->ns_max, r->ns_stddev, r->cycles_median,
+          last ? "" : ",");
+}
+
+void bench_fprint_json_footer(FILE *f) {
+  fprintf(f, "  ]\n}\n");
+}
+
+static bool json_get_num(char *line, char *key, double *value) {
+  char pattern[64], *p;
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  p = strstr(line, pattern);
+  if (!p) {
+    return false;
+  }
+  *value = atof(p + strlen(pattern));
+  return true;
+}
+
+static bool json_get_str(char *line, char *key, char *value, int len) {
+  char pattern[64], *p, *end;
+  snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+  p = strstr(line, pattern);
+  if (!p) {
+    return false;
+  }
+  p += strlen(pattern);
+  end = strchr(p, '"');
+  if (!end || end - p >= len) {
+    return false;
+  }
+  memcpy(value, p, end - p);
+  value[end - p] = '\0';
+  return true;
+}
+
+/** Reads the results written by bench_fprint_json(). Returns the number of
+ * results, stored in a new array, or -1 on error.
+ */
+int bench_read_json(char *filename, bench_result_t **results) {
+  char line[1024];
+  bench_result_t r, *tmp;
+  double size;
+  int n = 0;
+  FILE *f;
+
+  *results = NULL;
+  f = fopen(filename, "r");
+  if (!f) {
+    perror(filename);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    bzero(&r, sizeof(bench_result_t));
+    if (!json_get_str(line, "name", r.name, BENCH_NAME_LEN) ||
+        !json_get_num(line, "size", &size) ||
+        !json_get_num(line, "ns_median", &r.ns_median)) {
+      continue;
+    }
+    r.size = (uint32_t) size;
+    json_get_num(line, "ns_min", &r.ns_min);
+    json_get_num(line, "ns_mean", &r.ns_mean);
+    json_get_num(line, "ns_p90", &r.ns_p90);
+    json_get_num(line, "ns_p99", &r.ns_p99);
+    json_get_num(line, "ns_max", &r.ns_max);
+    json_get_num(line, "ns_stddev", &r.ns_stddev);
+    json_get_num(line, "cycles_median", &r.cycles_median);
+    tmp = realloc(*results, sizeof(bench_result_t) * (n + 1));
+    if (!tmp) {
+      perror("realloc");
+      free(*results);
+      *results = NULL;
+      fclose(f);
+      return -1;
+    }
+    *results = tmp;
+    (*results)[n++] = r;
+  }
+  fclose(f);
+  return n;
+}
+
+/** Compares the median time per call of every result in current_file with
+ * the same name and size in baseline_file. Results more than threshold
+ * (relative) slower are flagged. Returns the number of slowdowns, or -1 on
+ * error.
+ */
+int bench_compare(char *baseline_file, char *current_file, float threshold) {
+  bench_result_t *base, *cur;
+  int nof_base, nof_cur, i, j, nof_slower = 0, nof_faster = 0, nof_missing = 0;
+  double ratio;
+  char *flag;
+
+  nof_base = bench_read_json(baseline_file, &base);
+  if (nof_base < 0) {
+    return -1;
+  }
+  nof_cur = bench_read_json(current_file, &cur);
+  if (nof_cur < 0) {
+    free(base);
+    return -1;
+  }
+
+  printf("%-32s %8s %12s %12s %8s\n", "name", "size", "base (ns)", "current (ns)", "ratio");
+  for (i = 0; i < nof_cur; i++) {
+    for (j = 0; j < nof_base; j++) {
+      if (!strcmp(cur[i].name, base[j].name) && cur[i].size == base[j].size) {
+        break;
+      }
+    }
+    if (j == nof_base) {
+      printf("%-32s %8u %12s %12.1f %8s\n", cur[i].name, cur[i].size, "-",
+             cur[i].ns_median, "new");
+      nof_missing++;
+      continue;
+    }
+    ratio = base[j].ns_median > 0 ? cur[i].ns_median / base[j].ns_median : 1.0;
+    flag = "";
+    if (ratio > 1 + threshold) {
+      flag = "  SLOWER";
+      nof_slower++;
+    } else if (ratio < 1 / (1 + threshold)) {
+      flag = "  faster";
+      nof_faster++;
+    }
+    printf("%-32s %8u %12.1f %12.1f %8.3f%s\n", cur[i].name, cur[i].size,
+           base[j].ns_median, cur[i].ns_median, ratio, flag);
+  }
+  printf("%d results: %d slower, %d faster than baseline by more than %.0f%%, %d not in baseline\n",
+         nof_cur, nof_slower, nof_faster, threshold * 100, nof_missing);
+
+  if (base) {
+    free(base);
+  }
+  if (cur) {
+    free(cur);
+  }
+  return nof_slower;
+}
@@ -0,0 +1,90 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef BENCH_
+#define BENCH_
+
+/* Helpers shared by the benchmarks: CPU pinning, timing with the monotonic
+ * clock and the cycle counter, statistics over repeated samples and JSON
+ * output of the results, one result per line so that they can be read back
+ * by bench_read_json() to compare against a baseline.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BENCH_NAME_LEN      48
+#define BENCH_MAX_SAMPLES   1000
+
+typedef void (*bench_fn_t)(void *arg);
+
+typedef struct {
+  uint32_t nof_samples;
+  double min_time_ns;           // minimum duration of a sample, calls are batched to reach it
+  double warmup_ns;
+} bench_opts_t;
+
+typedef struct {
+  char name[BENCH_NAME_LEN];
+  uint32_t size;
+  uint32_t nof_samples;
+  uint32_t calls_x_sample;
+  double ns_min;                // per call
+  double ns_median;
+  double ns_mean;
+  double ns_p90;
+  double ns_p99;
+  double ns_max;
+  double ns_stddev;
+  double cycles_median;         // 0 if there is no cycle counter
+} bench_result_t;
+
+bool bench_pin_cpu(int cpu);
+
+uint64_t bench_cycles();
+
+double bench_time_ns();
+
+void bench_stats(double *samples, uint32_t nof_samples, double *min, double *median,
+                 double *mean, double *p90, double *p99, double *max, double *stddev);
+
+void bench_run(bench_opts_t *opts, char *name, uint32_t size, bench_fn_t fn, void *arg,
+               bench_result_t *result);
+
+void bench_fprint_json_header(FILE *f, char *bench, int cpu);
+
+void bench_fprint_json(FILE *f, bench_result_t *result, bool last);
+
+void bench_fprint_json_footer(FILE *f);
+
+int bench_read_json(char *filename, bench_result_t **results);
+
+int bench_compare(char *baseline_file, char *current_file, float threshold);
+
+#endif // BENCH_
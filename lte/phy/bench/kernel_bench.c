@@ -0,0 +1,581 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <complex.h>
+
+#include "liblte/phy/phy.h"
+#include "bench.h"
+
+/* Microbenchmark of the signal processing kernels over the LTE sizes. The
+ * size of each result is the vector length for vec_*, the number of points
+ * for dft_run_c, the code block size for tdec_run_all, the frame length for
+ * viterbi_decode_f, the number of symbols for demod_soft_demodulate and the
+ * number of PRB for chest_ce_slot and pss_synch_find_pss.
+ *
+ * Results are written as JSON. With -b they are compared against a
+ * baseline written by a previous run, and -c compares two existing files.
+ */
+
+#define MAX_SIZES       NOF_TC_CB_SIZES
+
+uint32_t prb_full[] = {6, 15, 25, 50, 75, 100};
+uint32_t prb_quick[] = {6, 25};
+uint32_t cb_full[] = {40, 104, 256, 512, 1024, 2048, 4096, 6144};
+uint32_t cb_quick[] = {40, 1024, 6144};
+uint32_t vit_full[] = {40, 43, 57};
+uint32_t vit_quick[] = {40};
+
+uint32_t prb_list[MAX_SIZES], cb_list[MAX_SIZES], vit_list[MAX_SIZES];
+uint32_t nof_prb_list, nof_cb_list, nof_vit_list;
+
+char *output_file_name = "kernel_bench.json";
+char *baseline_file_name = NULL;
+char *compare_files[2] = {NULL, NULL};
+char *filter = NULL;
+float threshold = 0.15;
+int cpu = 0;
+bool pin = true;
+bool quick = false;
+bool all_cb = false;
+bench_opts_t opts = {20, 100e3, 10e6};
+
+bench_result_t *results = NULL;
+uint32_t nof_results = 0;
+
+void usage(char *prog) {
+  printf("Usage: %s [oqakncpubtv]\n", prog);
+  printf("\t-o output JSON file [Default %s]\n", output_file_name);
+  printf("\t-q quick run with fewer sizes and samples\n");
+  printf("\t-a all turbo code block sizes\n");
+  printf("\t-k run only the kernels whose name contains this string\n");
+  printf("\t-n samples per kernel and size [Default %d]\n", opts.nof_samples);
+  printf("\t-p pin to this CPU [Default %d]\n", cpu);
+  printf("\t-u do not pin to a CPU\n");
+  printf("\t-b compare the results against this baseline file\n");
+  printf("\t-c compare two files, baseline and current, without running\n");
+  printf("\t-t relative slowdown flagged as regression [Default %.2f]\n", threshold);
+  printf("\t-v [set verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "oqakncpubtv")) != -1) {
+    switch(opt) {
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    case 'q':
+      quick = true;
+      break;
+    case 'a':
+      all_cb = true;
+      break;
+    case 'k':
+      filter = argv[optind];
+      break;
+    case 'n':
+      opts.nof_samples = atoi(argv[optind]);
+      break;
+    case 'p':
+      cpu = atoi(argv[optind]);
+      break;
+    case 'u':
+      pin = false;
+      break;
+    case 'b':
+      baseline_file_name = argv[optind];
+      break;
+    case 'c':
+      if (optind + 1 >= argc) {
+        usage(argv[0]);
+        exit(-1);
+      }
+      compare_files[0] = argv[optind];
+      compare_files[1] = argv[optind + 1];
+      break;
+    case 't':
+      threshold = atof(argv[optind]);
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+bool selected(char *name) {
+  return !filter || strstr(name, filter);
+}
+
+void add_result(bench_result_t *r) {
+  bench_result_t *tmp = realloc(results, sizeof(bench_result_t) * (nof_results + 1));
+  if (!tmp) {
+    perror("realloc");
+    exit(-1);
+  }
+  results = tmp;
+  results[nof_results++] = *r;
+  printf("%-32s %6u %12.1f ns %12.0f cycles (p90 %.1f ns, stddev %.1f ns)\n", r->name,
+         r->size, r->ns_median, r->cycles_median, r->ns_p90, r->ns_stddev);
+}
+
+void random_c(cf_t *x, uint32_t len) {
+  uint32_t i;
+  for (i = 0; i < len; i++) {
+    x[i] = ((float) rand() / RAND_MAX - 0.5) + _Complex_I * ((float) rand() / RAND_MAX - 0.5);
+  }
+}
+
+/* vec_* */
+typedef struct {
+  cf_t *x, *y, *z;
+  float *f;
+  uint32_t len;
+} vec_args_t;
+
+volatile float sink;
+
+void run_vec_prod_ccc(void *a) {
+  vec_args_t *v = a;
+  vec_prod_ccc(v->x, v->y, v->z, v->len);
+}
+void run_vec_prod_conj_ccc(void *a) {
+  vec_args_t *v = a;
+  vec_prod_conj_ccc(v->x, v->y, v->z, v->len);
+}
+void run_vec_sum_ccc(void *a) {
+  vec_args_t *v = a;
+  vec_sum_ccc(v->x, v->y, v->z, v->len);
+}
+void run_vec_sc_prod_cfc(void *a) {
+  vec_args_t *v = a;
+  vec_sc_prod_cfc(v->x, 0.5, v->z, v->len);
+}
+void run_vec_dot_prod_conj_ccc(void *a) {
+  vec_args_t *v = a;
+  sink = crealf(vec_dot_prod_conj_ccc(v->x, v->y, v->len));
+}
+void run_vec_abs_cf(void *a) {
+  vec_args_t *v = a;
+  vec_abs_cf(v->x, v->f, v->len);
+}
+void run_vec_arg_cf(void *a) {
+  vec_args_t *v = a;
+  vec_arg_cf(v->x, v->f, v->len);
+}
+void run_vec_avg_power_cf(void *a) {
+  vec_args_t *v = a;
+  sink = vec_avg_power_cf(v->x, v->len);
+}
+
+struct {
+  char *name;
+  bench_fn_t fn;
+} vec_kernels[] = {
+  {"vec_prod_ccc", run_vec_prod_ccc},
+  {"vec_prod_conj_ccc", run_vec_prod_conj_ccc},
+  {"vec_sum_ccc", run_vec_sum_ccc},
+  {"vec_sc_prod_cfc", run_vec_sc_prod_cfc},
+  {"vec_dot_prod_conj_ccc", run_vec_dot_prod_conj_ccc},
+  {"vec_abs_cf", run_vec_abs_cf},
+  {"vec_arg_cf", run_vec_arg_cf},
+  {"vec_avg_power_cf", run_vec_avg_power_cf},
+};
+
+/* Vector lengths are the resource elements of a subframe */
+int bench_vec() {
+  vec_args_t v;
+  bench_result_t r;
+  uint32_t i, k, max_len = SF_LEN_RE(MAX_PRB, CPNORM);
+
+  v.x = malloc(sizeof(cf_t) * max_len);
+  v.y = malloc(sizeof(cf_t) * max_len);
+  v.z = malloc(sizeof(cf_t) * max_len);
+  v.f = malloc(sizeof(float) * max_len);
+  if (!v.x || !v.y || !v.z || !v.f) {
+    perror("malloc");
+    return -1;
+  }
+  random_c(v.x, max_len);
+  random_c(v.y, max_len);
+  for (k = 0; k < sizeof(vec_kernels) / sizeof(vec_kernels[0]); k++) {
+    if (!selected(vec_kernels[k].name)) {
+      continue;
+    }
+    for (i = 0; i < nof_prb_list; i++) {
+      v.len = SF_LEN_RE(prb_list[i], CPNORM);
+      bench_run(&opts, vec_kernels[k].name, v.len, vec_kernels[k].fn, &v, &r);
+      add_result(&r);
+    }
+  }
+  free(v.x);
+  free(v.y);
+  free(v.z);
+  free(v.f);
+  return 0;
+}
+
+/* dft_run_c */
+typedef struct {
+  dft_plan_t plan;
+  cf_t *in, *out;
+} dft_args_t;
+
+void run_dft(void *a) {
+  dft_args_t *d = a;
+  dft_run_c(&d->plan, d->in, d->out);
+}
+
+int bench_dft() {
+  dft_args_t d;
+  bench_result_t r;
+  uint32_t i, n;
+
+  if (!selected("dft_run_c")) {
+    return 0;
+  }
+  for (i = 0; i < nof_prb_list; i++) {
+    n = lte_symbol_sz(prb_list[i]);
+    d.in = malloc(sizeof(cf_t) * n);
+    d.out = malloc(sizeof(cf_t) * n);
+    if (!d.in || !d.out || dft_plan_c(&d.plan, n, FORWARD)) {
+      fprintf(stderr, "Error initiating DFT of %d points\n", n);
+      return -1;
+    }
+    random_c(d.in, n);
+    bench_run(&opts, "dft_run_c", n, run_dft, &d, &r);
+    add_result(&r);
+    dft_plan_free(&d.plan);
+    free(d.in);
+    free(d.out);
+  }
+  return 0;
+}
+
+/* tdec_run_all */
+typedef struct {
+  tdec_t tdec;
+  llr_t *input;
+  char *output;
+  uint32_t long_cb;
+} tdec_args_t;
+
+void run_tdec(void *a) {
+  tdec_args_t *t = a;
+  tdec_run_all(&t->tdec, t->input, t->output, TDEC_MAX_ITERATIONS, t->long_cb);
+}
+
+int bench_tdec() {
+  tdec_args_t t;
+  bench_result_t r;
+  uint32_t i, j;
+
+  if (!selected("tdec_run_all")) {
+    return 0;
+  }
+  t.input = malloc(sizeof(llr_t) * (3 * 6144 + 12));
+  t.output = malloc(sizeof(char) * 6144);
+  if (!t.input || !t.output || tdec_init(&t.tdec, 6144)) {
+    fprintf(stderr, "Error initiating turbo decoder\n");
+    return -1;
+  }
+  for (i = 0; i < nof_cb_list; i++) {
+    t.long_cb = cb_list[i];
+    /* noisy all-zero codeword, so that every iteration does some work */
+    for (j = 0; j < 3 * t.long_cb + 12; j++) {
+      t.input[j] = 1.0 + 2.0 * ((float) rand() / RAND_MAX - 0.5);
+    }
+    bench_run(&opts, "tdec_run_all", t.long_cb, run_tdec, &t, &r);
+    add_result(&r);
+  }
+  tdec_free(&t.tdec);
+  free(t.input);
+  free(t.output);
+  return 0;
+}
+
+/* viterbi_decode_f, tail-biting rate 1/3 as in PBCH and PDCCH */
+typedef struct {
+  viterbi_t vit;
+  float *symbols;
+  char *data;
+  uint32_t frame_length;
+} vit_args_t;
+
+void run_viterbi(void *a) {
+  vit_args_t *v = a;
+  viterbi_decode_f(&v->vit, v->symbols, v->data, v->frame_length);
+}
+
+int bench_viterbi() {
+  vit_args_t v;
+  bench_result_t r;
+  uint32_t poly[3] = { 0x6D, 0x4F, 0x57 };
+  uint32_t i, j;
+
+  if (!selected("viterbi_decode_f")) {
+    return 0;
+  }
+  for (i = 0; i < nof_vit_list; i++) {
+    v.frame_length = vit_list[i];
+    v.symbols = malloc(sizeof(float) * 3 * v.frame_length);
+    v.data = malloc(sizeof(char) * v.frame_length);
+    if (!v.symbols || !v.data || viterbi_init(&v.vit, viterbi_37, poly, v.frame_length, true)) {
+      fprintf(stderr, "Error initiating Viterbi decoder\n");
+      return -1;
+    }
+    for (j = 0; j < 3 * v.frame_length; j++) {
+      v.symbols[j] = 2.0 * ((float) rand() / RAND_MAX - 0.5);
+    }
+    bench_run(&opts, "viterbi_decode_f", v.frame_length, run_viterbi, &v, &r);
+    add_result(&r);
+    viterbi_free(&v.vit);
+    free(v.symbols);
+    free(v.data);
+  }
+  return 0;
+}
+
+/* demod_soft_demodulate */
+typedef struct {
+  demod_soft_t demod;
+  cf_t *symbols;
+  float *llr;
+  uint32_t nof_symbols;
+} demod_args_t;
+
+void run_demod(void *a) {
+  demod_args_t *d = a;
+  demod_soft_demodulate(&d->demod, d->symbols, d->llr, d->nof_symbols);
+}
+
+int bench_demod() {
+  demod_args_t d;
+  modem_table_t table;
+  bench_result_t r;
+  lte_mod_t mods[3] = {LTE_QPSK, LTE_QAM16, LTE_QAM64};
+  char *names[3] = {"demod_soft_demodulate_qpsk", "demod_soft_demodulate_16qam",
+                    "demod_soft_demodulate_64qam"};
+  uint32_t i, m, max_symbols = SF_LEN_RE(MAX_PRB, CPNORM);
+
+  d.symbols = malloc(sizeof(cf_t) * max_symbols);
+  d.llr = malloc(sizeof(float) * 6 * max_symbols);
+  if (!d.symbols || !d.llr) {
+    perror("malloc");
+    return -1;
+  }
+  random_c(d.symbols, max_symbols);
+  for (m = 0; m < 3; m++) {
+    if (!selected(names[m])) {
+      continue;
+    }
+    modem_table_init(&table);
+    if (modem_table_lte(&table, mods[m], true)) {
+      fprintf(stderr, "Error initiating modem table\n");
+      return -1;
+    }
+    demod_soft_init(&d.demod);
+    demod_soft_table_set(&d.demod, &table);
+    demod_soft_alg_set(&d.demod, APPROX);
+    demod_soft_sigma_set(&d.demod, 2.0 / table.nbits_x_symbol);
+    for (i = 0; i < nof_prb_list; i++) {
+      /* PDSCH symbols of a subframe with 2 control symbols, ignoring references */
+      d.nof_symbols = prb_list[i] * RE_X_RB * (2 * CPNORM_NSYMB - 2);
+      bench_run(&opts, names[m], d.nof_symbols, run_demod, &d, &r);
+      add_result(&r);
+    }
+    modem_table_free(&table);
+  }
+  free(d.symbols);
+  free(d.llr);
+  return 0;
+}
+
+/* chest_ce_slot */
+typedef struct {
+  chest_t chest;
+  cf_t *input;
+  cf_t *ce[MAX_PORTS];
+} chest_args_t;
+
+void run_chest(void *a) {
+  chest_args_t *c = a;
+  chest_ce_slot(&c->chest, c->input, c->ce, 0);
+}
+
+int bench_chest() {
+  chest_args_t c;
+  lte_cell_t cell;
+  bench_result_t r;
+  uint32_t i, n;
+
+  if (!selected("chest_ce_slot")) {
+    return 0;
+  }
+  bzero(&c, sizeof(chest_args_t));
+  for (i = 0; i < nof_prb_list; i++) {
+    cell.nof_prb = prb_list[i];
+    cell.nof_ports = 1;
+    cell.id = 1;
+    cell.cp = CPNORM;
+    n = SLOT_LEN_RE(cell.nof_prb, cell.cp);
+    c.input = malloc(sizeof(cf_t) * n);
+    c.ce[0] = malloc(sizeof(cf_t) * n);
+    if (!c.input || !c.ce[0] || chest_init_LTEDL(&c.chest, cell)) {
+      fprintf(stderr, "Error initiating channel estimator\n");
+      return -1;
+    }
+    random_c(c.input, n);
+    bench_run(&opts, "chest_ce_slot", cell.nof_prb, run_chest, &c, &r);
+    add_result(&r);
+    chest_free(&c.chest);
+    free(c.input);
+    free(c.ce[0]);
+  }
+  return 0;
+}
+
+/* pss_synch_find_pss over a subframe, as done by ue_sync while searching */
+typedef struct {
+  pss_synch_t pss;
+  cf_t *input;
+} pss_args_t;
+
+void run_pss(void *a) {
+  pss_args_t *p = a;
+  float peak;
+  pss_synch_find_pss(&p->pss, p->input, &peak);
+}
+
+int bench_pss() {
+  pss_args_t p;
+  bench_result_t r;
+  uint32_t i, fft_size;
+
+  if (!selected("pss_synch_find_pss")) {
+    return 0;
+  }
+  for (i = 0; i < nof_prb_list; i++) {
+    fft_size = lte_symbol_sz(prb_list[i]);
+    p.input = malloc(sizeof(cf_t) * SF_LEN(fft_size));
+    if (!p.input || pss_synch_init_fft(&p.pss, SF_LEN(fft_size), fft_size) ||
+        pss_synch_set_N_id_2(&p.pss, 0)) {
+      fprintf(stderr, "Error initiating PSS\n");
+      return -1;
+    }
+    random_c(p.input, SF_LEN(fft_size));
+    bench_run(&opts, "pss_synch_find_pss", prb_list[i], run_pss, &p, &r);
+    add_result(&r);
+    pss_synch_free(&p.pss);
+    free(p.input);
+  }
+  return 0;
+}
+
+void set_sizes() {
+  uint32_t i;
+
+  if (quick) {
+    nof_prb_list = sizeof(prb_quick) / sizeof(uint32_t);
+    memcpy(prb_list, prb_quick, sizeof(prb_quick));
+    nof_cb_list = sizeof(cb_quick) / sizeof(uint32_t);
+    memcpy(cb_list, cb_quick, sizeof(cb_quick));
+    nof_vit_list = sizeof(vit_quick) / sizeof(uint32_t);
+    memcpy(vit_list, vit_quick, sizeof(vit_quick));
+  } else {
+    nof_prb_list = sizeof(prb_full) / sizeof(uint32_t);
+    memcpy(prb_list, prb_full, sizeof(prb_full));
+    nof_cb_list = sizeof(cb_full) / sizeof(uint32_t);
+    memcpy(cb_list, cb_full, sizeof(cb_full));
+    nof_vit_list = sizeof(vit_full) / sizeof(uint32_t);
+    memcpy(vit_list, vit_full, sizeof(vit_full));
+  }
+  if (all_cb) {
+    nof_cb_list = NOF_TC_CB_SIZES;
+    for (i = 0; i < NOF_TC_CB_SIZES; i++) {
+      cb_list[i] = lte_cb_size(i);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  FILE *f;
+  uint32_t i;
+  int ret;
+
+  parse_args(argc, argv);
+
+  if (compare_files[0]) {
+    ret = bench_compare(compare_files[0], compare_files[1], threshold);
+    exit(ret == 0 ? 0 : -1);
+  }
+
+  if (quick) {
+    opts.nof_samples = 5;
+    opts.min_time_ns = 20e3;
+    opts.warmup_ns = 1e6;
+  }
+  set_sizes();
+  if (pin && !bench_pin_cpu(cpu)) {
+    fprintf(stderr, "Warning: could not pin to CPU %d, results will be noisier\n", cpu);
+  }
+  srand(1234);
+
+  if (bench_vec() || bench_dft() || bench_tdec() || bench_viterbi() || bench_demod() ||
+      bench_chest() || bench_pss()) {
+    exit(-1);
+  }
+
+  f = fopen(output_file_name, "w");
+  if (!f) {
+    perror(output_file_name);
+    exit(-1);
+  }
+  bench_fprint_json_header(f, "kernel_bench", pin ? cpu : -1);
+  for (i = 0; i < nof_results; i++) {
+    bench_fprint_json(f, &results[i], i == nof_results - 1);
+  }
+  bench_fprint_json_footer(f);
+  fclose(f);
+  printf("Wrote %d results to %s\n", nof_results, output_file_name);
+  free(results);
+
+  if (baseline_file_name) {
+    ret = bench_compare(baseline_file_name, output_file_name, threshold);
+    exit(ret == 0 ? 0 : -1);
+  }
+  exit(0);
+}
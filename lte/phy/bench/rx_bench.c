@@ -0,0 +1,600 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <complex.h>
+
+#include "liblte/phy/phy.h"
+#include "bench.h"
+
+/* Replays an IQ capture held in memory through the UE receiver as fast as
+ * possible: cell search and MIB decoding on the decimated signal, then
+ * ue_sync_get_buffer() and ue_dl_decode() for every subframe. Reports the
+ * subframes per second, the real-time factor (1 ms of signal over the time
+ * to process a subframe) and the latency of every stage.
+ *
+ * The capture is complex float (or complex int16 with -s) at the sampling
+ * rate of nof_prb, for instance written by rx_capture.
+ *
+ * With -w the replay is recorded as SigMF, with one annotation per aligned
+ * subframe. Inputs named *.sigmf-meta are replayed from these annotations:
+ * the cell comes from the metadata and every subframe is decoded from its
+ * recorded position, without acquisition or ue_sync, starting at the
+ * annotated subframe given with -S.
+ */
+
+#define ACQ_NOF_FRAMES_TOTAL      16      // half frames searched for each N_id_2
+#define ACQ_NOF_FRAMES_DETECTED   4
+#define ACQ_MAX_MS                200     // signal used for acquisition
+#define ACQ_FILTER_ATTEN_DB       50
+#define TRACE_LEN                 65536   // events kept in the trace
+
+char *input_file_name = NULL;
+char *output_file_name = NULL;
+char *baseline_file_name = NULL;
+char *trace_file_name = NULL;
+char *record_file_name = NULL;
+uint32_t nof_prb = 6;
+uint16_t rnti = 1234;
+uint32_t nof_replays = 1;
+bool is_short = false;
+uint32_t start_sf = 0;
+float max_bler = 1.0;
+float threshold = 0.15;
+int cpu = 0;
+bool pin = true;
+
+/* Samples of the capture, and position of the next sample delivered to ue_sync.
+ * Complex float captures are used in place from the file mapping. SigMF
+ * recordings are read subframe by subframe from their annotations. */
+typedef struct {
+  filesource_mmap_t fsrc;
+  cf_t *samples;
+  uint32_t nof_samples;
+  uint32_t pos;
+  bool is_sigmf;
+  sigmf_source_t sigmf;
+  bool end;
+} replay_t;
+
+typedef enum {
+  STAGE_SYNC = 0, STAGE_DECODE, STAGE_SUBFRAME, NOF_STAGES
+} stage_t;
+
+char *stage_names[NOF_STAGES] = {"rx_ue_sync", "rx_ue_dl_decode", "rx_subframe"};
+
+void usage(char *prog) {
+  printf("Usage: %s [ipsrnEobTwStcuv] -i input_file\n", prog);
+  printf("\t-p nof_prb of the capture [Default %d]\n", nof_prb);
+  printf("\t-s samples are complex int16 [Default complex float]\n");
+  printf("\t-r RNTI [Default %d]\n", rnti);
+  printf("\t-n number of replays of the capture [Default %d]\n", nof_replays);
+  printf("\t-E fail if the BLER is above this [Default %.2f]\n", max_bler);
+  printf("\t-o output JSON file [Default none]\n");
+  printf("\t-b compare the results against this baseline file\n");
+  printf("\t-T write a Chrome trace of the processing stages to this file\n");
+  printf("\t-w record the replay as SigMF with this base name\n");
+  printf("\t-S first annotated subframe of a SigMF input [Default %d]\n", start_sf);
+  printf("\t-t relative slowdown flagged as regression [Default %.2f]\n", threshold);
+  printf("\t-c pin to this CPU [Default %d]\n", cpu);
+  printf("\t-u do not pin to a CPU\n");
+  printf("\t-v [set verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ipsrnEobTwStcuv")) != -1) {
+    switch(opt) {
+    case 'i':
+      input_file_name = argv[optind];
+      break;
+    case 'p':
+      nof_prb = atoi(argv[optind]);
+      break;
+    case 's':
+      is_short = true;
+      break;
+    case 'r':
+      rnti = atoi(argv[optind]);
+      break;
+    case 'n':
+      nof_replays = atoi(argv[optind]);
+      break;
+    case 'E':
+      max_bler = atof(argv[optind]);
+      break;
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    case 'b':
+      baseline_file_name = argv[optind];
+      break;
+    case 'T':
+      trace_file_name = argv[optind];
+      break;
+    case 'w':
+      record_file_name = argv[optind];
+      break;
+    case 'S':
+      start_sf = atoi(argv[optind]);
+      break;
+    case 't':
+      threshold = atof(argv[optind]);
+      break;
+    case 'c':
+      cpu = atoi(argv[optind]);
+      break;
+    case 'u':
+      pin = false;
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (!input_file_name || lte_symbol_sz(nof_prb) < 0 || nof_replays < 1) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+bool is_sigmf(char *file_name) {
+  size_t len = strlen(file_name);
+  return len > 11 && (!strcmp(&file_name[len - 11], ".sigmf-meta") ||
+                      !strcmp(&file_name[len - 11], ".sigmf-data"));
+}
+
+/* Opens a SigMF recording. The cell must be in the metadata */
+int load_sigmf(replay_t *r) {
+  if (sigmf_source_init(&r->sigmf, input_file_name)) {
+    return -1;
+  }
+  if (r->sigmf.meta.cell.nof_prb == 0) {
+    fprintf(stderr, "The metadata of %s has no cell\n", input_file_name);
+    return -1;
+  }
+  if (start_sf >= sigmf_source_nof_sf(&r->sigmf)) {
+    fprintf(stderr, "The recording has %d subframes\n", sigmf_source_nof_sf(&r->sigmf));
+    return -1;
+  }
+  nof_prb = r->sigmf.meta.cell.nof_prb;
+  r->nof_samples = (uint32_t) filesource_mmap_nof_samples(&r->sigmf.fsrc);
+  return 0;
+}
+
+/* Reads the whole capture into memory, converting int16 samples to float */
+int load_capture(replay_t *r) {
+  bzero(r, sizeof(replay_t));
+  if (is_sigmf(input_file_name)) {
+    r->is_sigmf = true;
+    return load_sigmf(r);
+  }
+  if (filesource_mmap_init(&r->fsrc, input_file_name, 
+                           is_short ? COMPLEX_SHORT_BIN : COMPLEX_FLOAT_BIN)) {
+    return -1;
+  }
+  r->nof_samples = (uint32_t) filesource_mmap_nof_samples(&r->fsrc);
+  if (is_short) {
+    r->samples = vec_malloc(sizeof(cf_t) * r->nof_samples);
+    if (!r->samples) {
+      perror("malloc");
+      return -1;
+    }
+    if (filesource_mmap_read(&r->fsrc, r->samples, r->nof_samples) != r->nof_samples) {
+      fprintf(stderr, "Error reading %s\n", input_file_name);
+      return -1;
+    }
+  } else if (filesource_mmap_get(&r->fsrc, &r->samples, r->nof_samples) != r->nof_samples) {
+    fprintf(stderr, "Error reading %s\n", input_file_name);
+    return -1;
+  }
+  r->pos = 0;
+  return 0;
+}
+
+int replay_recv(void *h, void *data, uint32_t nsamples) {
+  replay_t *r = h;
+  if (r->pos + nsamples > r->nof_samples) {
+    return -1;
+  }
+  memcpy(data, &r->samples[r->pos], sizeof(cf_t) * nsamples);
+  r->pos += nsamples;
+  return nsamples;
+}
+
+/* Lowpass filters and decimates input by M. Returns the number of output samples */
+int decimate(cf_t *input, uint32_t len, cf_t *output, uint32_t M) {
+  decim_fir_t decim;
+  float *taps;
+  uint32_t nof_taps;
+  int n;
+
+  if (M == 1) {
+    memcpy(output, input, sizeof(cf_t) * len);
+    return len;
+  }
+  nof_taps = fir_kaiser_len(ACQ_FILTER_ATTEN_DB, 0.1 / M);
+  taps = malloc(sizeof(float) * nof_taps);
+  if (!taps) {
+    perror("malloc");
+    return -1;
+  }
+  if (fir_lowpass(taps, nof_taps, 0.5 / M, fir_kaiser_beta(ACQ_FILTER_ATTEN_DB)) ||
+      decim_fir_init(&decim, M, taps, nof_taps)) {
+    free(taps);
+    return -1;
+  }
+  n = decim_fir_run(&decim, input, output, len);
+  decim_fir_free(&decim);
+  free(taps);
+  return n;
+}
+
+/* Cell search at 960 KHz and MIB decoding at 1.92 MHz over the first
+ * ACQ_MAX_MS of the capture. Every N_id_2 is searched from the start of the
+ * signal. Returns 0 and the cell if the MIB was decoded.
+ */
+int acquire(replay_t *r, lte_cell_t *cell, pbch_mib_t *mib) {
+  ue_celldetect_t cs;
+  ue_celldetect_result_t found[3], *best = NULL;
+  ue_mib_t uemib;
+  cf_t *buffer;
+  uint32_t fs = lte_sampling_freq_hz(nof_prb), len, pos, i;
+  int n, ret = -1;
+
+  len = r->nof_samples < ACQ_MAX_MS * (fs / 1000) ? r->nof_samples : ACQ_MAX_MS * (fs / 1000);
+  buffer = vec_malloc(sizeof(cf_t) * (len / (fs / 1920000) + 1));
+  if (!buffer) {
+    perror("malloc");
+    return -1;
+  }
+  bzero(&cs, sizeof(ue_celldetect_t));
+  bzero(&uemib, sizeof(ue_mib_t));
+
+  n = decimate(r->samples, len, buffer, fs / 960000);
+  if (n < 0 || ue_celldetect_init(&cs) ||
+      ue_celldetect_set_nof_frames_total(&cs, ACQ_NOF_FRAMES_TOTAL) ||
+      ue_celldetect_set_nof_frames_detected(&cs, ACQ_NOF_FRAMES_DETECTED)) {
+    fprintf(stderr, "Error initiating cell search\n");
+    goto clean;
+  }
+  for (i = 0; i < 3; i++) {
+    found[i].peak = 0;
+    pos = 0;
+    do {
+      if (pos + 4800 > n) {
+        ret = CS_CELL_NOT_DETECTED;
+        ue_celldetect_reset(&cs);
+        cs.current_N_id_2 = i + 1;
+        break;
+      }
+      ret = ue_celldetect_scan(&cs, &buffer[pos], 4800, &found[i]);
+      pos += ret == CS_FRAME_UNALIGNED ? 2400 : 4800;
+    } while (ret != CS_CELL_DETECTED && ret != CS_CELL_NOT_DETECTED && ret >= 0);
+    if (ret < 0) {
+      fprintf(stderr, "Error scanning cells\n");
+      goto clean;
+    }
+    if (ret == CS_CELL_DETECTED && (!best || found[i].peak > best->peak)) {
+      best = &found[i];
+    }
+  }
+  if (!best) {
+    fprintf(stderr, "No cell found\n");
+    ret = -1;
+    goto clean;
+  }
+  INFO("Found cell %d, CP %s, peak %.2f\n", best->cell_id, lte_cp_string(best->cp), best->peak);
+
+  n = decimate(r->samples, len, buffer, fs / 1920000);
+  if (n < 0 || ue_mib_init(&uemib, best->cell_id, best->cp)) {
+    fprintf(stderr, "Error initiating MIB decoder\n");
+    ret = -1;
+    goto clean;
+  }
+  ret = MIB_NOTFOUND;
+  for (pos = 0; pos + MIB_FRAME_SIZE <= n && ret != MIB_FOUND; ) {
+    ret = ue_mib_decode(&uemib, &buffer[pos], MIB_FRAME_SIZE, mib);
+    if (ret < 0 && ret != MIB_FRAME_UNALIGNED) {
+      fprintf(stderr, "Error decoding MIB\n");
+      goto clean;
+    }
+    pos += ret == MIB_FRAME_UNALIGNED ? MIB_FRAME_SIZE / 2 : MIB_FRAME_SIZE;
+  }
+  if (ret != MIB_FOUND) {
+    fprintf(stderr, "Could not decode MIB of cell %d\n", best->cell_id);
+    ret = -1;
+    goto clean;
+  }
+  if (mib->nof_prb != nof_prb) {
+    fprintf(stderr, "The MIB says %d PRB but the capture is sampled for %d PRB\n",
+            mib->nof_prb, nof_prb);
+    ret = -1;
+    goto clean;
+  }
+  cell->id = best->cell_id;
+  cell->cp = best->cp;
+  cell->nof_prb = mib->nof_prb;
+  cell->nof_ports = mib->nof_ports;
+  ret = 0;
+
+clean:
+  ue_celldetect_free(&cs);
+  ue_mib_free(&uemib);
+  free(buffer);
+  return ret;
+}
+
+/* The cell and the MIB of a SigMF recording come from its metadata. Seeks to
+ * the first subframe to decode.
+ */
+int acquire_sigmf(replay_t *r, lte_cell_t *cell, pbch_mib_t *mib) {
+  *cell = r->sigmf.meta.cell;
+  bzero(mib, sizeof(pbch_mib_t));
+  mib->nof_prb = cell->nof_prb;
+  mib->nof_ports = cell->nof_ports;
+  mib->phich_resources = r->sigmf.meta.phich_resources;
+  mib->phich_length = r->sigmf.meta.phich_length;
+  return sigmf_source_seek(&r->sigmf, start_sf);
+}
+
+/* Returns in sf_buffer the next subframe from ue_sync or, for SigMF
+ * recordings, the next annotated one. Returns 1 if it is an aligned
+ * subframe, 0 if not, and sets r->end at the end of the capture.
+ */
+int replay_get_sf(replay_t *r, ue_sync_t *ue_sync, cf_t **sf_buffer, uint32_t *sf_idx) {
+  sigmf_annotation_t *annotation;
+  int ret;
+
+  if (r->is_sigmf) {
+    ret = sigmf_source_get_sf(&r->sigmf, sf_buffer, &annotation);
+    if (ret == 1) {
+      *sf_idx = annotation->sf_idx;
+    } else if (ret == 0) {
+      r->end = true;
+    }
+  } else {
+    ret = ue_sync_get_buffer(ue_sync, sf_buffer);
+    *sf_idx = ue_sync_get_sfidx(ue_sync);
+    /* the largest read of ue_sync is a subframe and a half */
+    r->end = r->pos + 2 * SF_LEN(lte_symbol_sz(nof_prb)) > r->nof_samples;
+  }
+  return ret;
+}
+
+int main(int argc, char **argv) {
+  replay_t replay;
+  lte_cell_t cell;
+  pbch_mib_t mib;
+  ue_sync_t ue_sync;
+  ue_dl_t ue_dl;
+  sigmf_sink_t recorder;
+  sigmf_meta_t meta;
+  bool recording = false;
+  cf_t *sf_buffer;
+  char *data;
+  double *latency[NOF_STAGES], *acq_latency, t0, t1, t2, total_ns = 0;
+  uint32_t max_sf, nof_sf = 0, nof_ok = 0, sf_len, sf_idx, rep, s, i;
+  bench_result_t results[NOF_STAGES + 1];
+  float bler, sf_x_sec;
+  int n, ret;
+  FILE *f;
+
+  parse_args(argc, argv);
+  if (load_capture(&replay)) {
+    exit(-1);
+  }
+  if (pin && !bench_pin_cpu(cpu)) {
+    fprintf(stderr, "Warning: could not pin to CPU %d, results will be noisier\n", cpu);
+  }
+
+  sf_len = SF_LEN(lte_symbol_sz(nof_prb));
+  if (replay.is_sigmf) {
+    max_sf = nof_replays * sigmf_source_nof_sf(&replay.sigmf);
+  } else {
+    max_sf = nof_replays * (replay.nof_samples / sf_len + 1);
+  }
+  for (s = 0; s < NOF_STAGES; s++) {
+    latency[s] = malloc(sizeof(double) * max_sf);
+  }
+  acq_latency = malloc(sizeof(double) * nof_replays);
+  data = malloc(sizeof(char) * 100000);
+  if (!latency[STAGE_SYNC] || !latency[STAGE_DECODE] || !latency[STAGE_SUBFRAME] ||
+      !acq_latency || !data) {
+    perror("malloc");
+    exit(-1);
+  }
+  printf("Loaded %d samples (%.1f ms) from %s\n", replay.nof_samples,
+         (float) replay.nof_samples / sf_len, input_file_name);
+
+  if (trace_file_name) {
+    if (trace_init(TRACE_LEN)) {
+      fprintf(stderr, "Error initiating trace\n");
+      exit(-1);
+    }
+    trace_thread_name("rx_bench");
+  }
+
+  for (rep = 0; rep < nof_replays; rep++) {
+    t0 = bench_time_ns();
+    if (replay.is_sigmf ? acquire_sigmf(&replay, &cell, &mib) : acquire(&replay, &cell, &mib)) {
+      exit(-1);
+    }
+    acq_latency[rep] = bench_time_ns() - t0;
+    if (rep == 0) {
+      pbch_mib_fprint(stdout, &mib, cell.id);
+    }
+
+    replay.pos = 0;
+    replay.end = false;
+    if (!replay.is_sigmf) {
+      if (ue_sync_init(&ue_sync, cell, replay_recv, &replay)) {
+        fprintf(stderr, "Error initiating ue_sync\n");
+        exit(-1);
+      }
+      replay.end = 2 * sf_len > replay.nof_samples;
+    }
+    /* only the first replay is recorded */
+    if (record_file_name && rep == 0) {
+      bzero(&meta, sizeof(sigmf_meta_t));
+      meta.type = is_short ? COMPLEX_SHORT_BIN : COMPLEX_FLOAT_BIN;
+      meta.sample_rate = lte_sampling_freq_hz(nof_prb);
+      meta.cell = cell;
+      meta.phich_resources = mib.phich_resources;
+      meta.phich_length = mib.phich_length;
+      if (replay.is_sigmf || sigmf_sink_init(&recorder, record_file_name, &meta)) {
+        fprintf(stderr, "Error recording to %s%s\n", record_file_name, 
+                replay.is_sigmf ? ": the input is already a recording" : "");
+        exit(-1);
+      }
+      ue_sync_set_recorder(&ue_sync, &recorder);
+      recording = true;
+    }
+    if (ue_dl_init(&ue_dl, cell, mib.phich_resources, mib.phich_length, rnti)) {
+      fprintf(stderr, "Error initiating UE downlink processing module\n");
+      exit(-1);
+    }
+    pdsch_set_rnti(&ue_dl.pdsch, rnti);
+
+    while (!replay.end) {
+      t0 = bench_time_ns();
+      ret = replay_get_sf(&replay, &ue_sync, &sf_buffer, &sf_idx);
+      t1 = bench_time_ns();
+      if (ret < 0) {
+        fprintf(stderr, "Error getting the next subframe\n");
+        exit(-1);
+      }
+      total_ns += t1 - t0;
+      if (ret == 1) {
+        n = ue_dl_decode(&ue_dl, sf_buffer, data, sf_idx, rnti);
+        t2 = bench_time_ns();
+        if (n < 0) {
+          fprintf(stderr, "Error calling ue_dl_decode()\n");
+          exit(-1);
+        }
+        if (recording && sf_idx == 0 && ue_dl.pbch_decoded) {
+          sigmf_sink_set_sfn(&recorder, ue_dl.sfn);
+        }
+        if (n > 0) {
+          nof_ok++;
+        }
+        latency[STAGE_SYNC][nof_sf] = t1 - t0;
+        latency[STAGE_DECODE][nof_sf] = t2 - t1;
+        latency[STAGE_SUBFRAME][nof_sf] = t2 - t0;
+        total_ns += t2 - t1;
+        nof_sf++;
+      }
+    }
+    ue_dl_free(&ue_dl);
+    if (!replay.is_sigmf) {
+      ue_sync_free(&ue_sync);
+    }
+    if (recording) {
+      printf("Recorded %lu samples (%lu dropped), %d subframes to %s\n", 
+             sigmf_sink_nof_samples(&recorder), sigmf_sink_nof_dropped(&recorder),
+             recorder.nof_annotations, record_file_name);
+      sigmf_sink_free(&recorder);
+      recording = false;
+    }
+  }
+
+  if (trace_file_name) {
+    if (trace_write_json(trace_file_name)) {
+      exit(-1);
+    }
+    trace_free();
+  }
+
+  if (nof_sf == 0) {
+    fprintf(stderr, "Could not synchronize to the capture\n");
+    exit(-1);
+  }
+  bler = 1 - (float) nof_ok / nof_sf;
+  sf_x_sec = nof_sf / (total_ns * 1e-9);
+  printf("Cell %d, %d PRB, %d ports. %d subframes, %d decoded (BLER %.3f)\n",
+         cell.id, cell.nof_prb, cell.nof_ports, nof_sf, nof_ok, bler);
+  printf("%.1f subframes/s, real-time factor %.2f\n", sf_x_sec, sf_x_sec / 1000);
+
+  printf("%-20s %10s %10s %10s %10s %10s (us)\n", "stage", "median", "mean", "p90", "p99", "max");
+  bzero(results, sizeof(results));
+  for (s = 0; s <= NOF_STAGES; s++) {
+    bench_result_t *r = &results[s];
+    strncpy(r->name, s < NOF_STAGES ? stage_names[s] : "rx_acquisition", BENCH_NAME_LEN - 1);
+    r->size = nof_prb;
+    r->nof_samples = s < NOF_STAGES ? nof_sf : nof_replays;
+    r->calls_x_sample = 1;
+    bench_stats(s < NOF_STAGES ? latency[s] : acq_latency, r->nof_samples, &r->ns_min,
+                &r->ns_median, &r->ns_mean, &r->ns_p90, &r->ns_p99, &r->ns_max, &r->ns_stddev);
+    printf("%-20s %10.1f %10.1f %10.1f %10.1f %10.1f\n", r->name, r->ns_median / 1000,
+           r->ns_mean / 1000, r->ns_p90 / 1000, r->ns_p99 / 1000, r->ns_max / 1000);
+  }
+
+  if (output_file_name) {
+    f = fopen(output_file_name, "w");
+    if (!f) {
+      perror(output_file_name);
+      exit(-1);
+    }
+    bench_fprint_json_header(f, "rx_bench", pin ? cpu : -1);
+    for (i = 0; i <= NOF_STAGES; i++) {
+      bench_fprint_json(f, &results[i], i == NOF_STAGES);
+    }
+    bench_fprint_json_footer(f);
+    fclose(f);
+  }
+
+  for (s = 0; s < NOF_STAGES; s++) {
+    free(latency[s]);
+  }
+  free(acq_latency);
+  free(data);
+  if (replay.is_sigmf) {
+    sigmf_source_free(&replay.sigmf);
+  } else {
+    if (is_short) {
+      free(replay.samples);
+    }
+    filesource_mmap_free(&replay.fsrc);
+  }
+
+  if (bler > max_bler) {
+    fprintf(stderr, "BLER %.3f above %.3f\n", bler, max_bler);
+    exit(-1);
+  }
+  if (baseline_file_name && output_file_name) {
+    exit(bench_compare(baseline_file_name, output_file_name, threshold) == 0 ? 0 : -1);
+  }
+  exit(0);
+}
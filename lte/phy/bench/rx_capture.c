@@ -0,0 +1,254 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <complex.h>
+
+#include "liblte/phy/phy.h"
+
+/* Writes a synthetic downlink capture for rx_bench: the output of enb_dl_t
+ * with a PDSCH for one RNTI in every subframe, delayed by a number of samples,
+ * rotated by a carrier frequency offset and with AWGN, as complex float
+ * samples at the sampling rate of the cell.
+ */
+
+lte_cell_t cell = {
+  6,            // nof_prb
+  1,            // nof_ports
+  1,            // cell_id
+  CPNORM        // cyclic prefix
+};
+
+uint32_t cfi = 2;
+uint32_t mcs_idx = 12;
+uint32_t nof_frames = 20;
+uint32_t delay = 1000;
+uint16_t rnti = 1234;
+float snr_db = 25.0;
+float cfo_hz = 300.0;
+uint32_t seed = 1;
+char *output_file_name = NULL;
+
+filesink_t fsink;
+ch_rand_t noise;
+cf_t *rx_buffer;
+double phase = 0;
+bool first_sf = true;
+
+void usage(char *prog) {
+  printf("Usage: %s [opcmrfsFdRv] -o output_file\n", prog);
+  printf("\t-p nof_prb [Default %d]\n", cell.nof_prb);
+  printf("\t-c cell id [Default %d]\n", cell.id);
+  printf("\t-m MCS index [Default %d]\n", mcs_idx);
+  printf("\t-r RNTI [Default %d]\n", rnti);
+  printf("\t-f number of frames [Default %d]\n", nof_frames);
+  printf("\t-s SNR in dB [Default %.1f]\n", snr_db);
+  printf("\t-F carrier frequency offset in Hz [Default %.1f]\n", cfo_hz);
+  printf("\t-d samples of noise before the first subframe [Default %d]\n", delay);
+  printf("\t-R noise seed [Default %d]\n", seed);
+  printf("\t-v [set verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "opcmrfsFdRv")) != -1) {
+    switch(opt) {
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    case 'p':
+      cell.nof_prb = atoi(argv[optind]);
+      break;
+    case 'c':
+      cell.id = atoi(argv[optind]);
+      break;
+    case 'm':
+      mcs_idx = atoi(argv[optind]);
+      break;
+    case 'r':
+      rnti = atoi(argv[optind]);
+      break;
+    case 'f':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 's':
+      snr_db = atof(argv[optind]);
+      break;
+    case 'F':
+      cfo_hz = atof(argv[optind]);
+      break;
+    case 'd':
+      delay = atoi(argv[optind]);
+      break;
+    case 'R':
+      seed = atoi(argv[optind]);
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (!output_file_name) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+/* Sender callback of enb_dl_t: applies the channel and writes the subframe */
+int write_subframe(void *arg, int16_t *samples, uint32_t nof_samples, uint64_t timestamp) {
+  uint32_t i;
+  float std;
+  double w = 2 * M_PI * cfo_hz / lte_sampling_freq_hz(cell.nof_prb);
+
+  for (i = 0; i < nof_samples; i++) {
+    __real__ rx_buffer[i] = (float) samples[2*i] / INT16_MAX;
+    __imag__ rx_buffer[i] = (float) samples[2*i+1] / INT16_MAX;
+    rx_buffer[i] *= cexp(I * phase);
+    phase = fmod(phase + w, 2 * M_PI);
+  }
+  std = sqrtf(vec_avg_power_cf(rx_buffer, nof_samples) * powf(10, -snr_db / 10) / 2);
+
+  /* noise only before the first subframe, with the power of the first subframe */
+  if (first_sf) {
+    cf_t *zeros = calloc(delay + 1, sizeof(cf_t));
+    if (!zeros) {
+      perror("calloc");
+      return -1;
+    }
+    ch_awgn_c_rand(&noise, zeros, zeros, std, delay);
+    if (filesink_write(&fsink, zeros, delay) != delay) {
+      free(zeros);
+      return -1;
+    }
+    free(zeros);
+    first_sf = false;
+  }
+  ch_awgn_c_rand(&noise, rx_buffer, rx_buffer, std, nof_samples);
+  if (filesink_write(&fsink, rx_buffer, nof_samples) != nof_samples) {
+    fprintf(stderr, "Error writing to %s\n", output_file_name);
+    return -1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  enb_dl_t enb_dl;
+  ra_pdsch_t ra_dl;
+  ra_prb_t prb_alloc;
+  dci_msg_t dci_msg;
+  dci_location_t locations[10];
+  pdsch_harq_t harq_process;
+  uint32_t tti, j;
+  char *data;
+  int ret = -1;
+
+  parse_args(argc, argv);
+
+  if (enb_dl_init(&enb_dl, cell, cfi, R_1, PHICH_NORM)) {
+    fprintf(stderr, "Error initiating eNodeB DL\n");
+    exit(-1);
+  }
+  if (pdsch_harq_init(&harq_process, &enb_dl.pdsch)) {
+    fprintf(stderr, "Error initiating HARQ process\n");
+    exit(-1);
+  }
+  if (filesink_init(&fsink, output_file_name, COMPLEX_FLOAT_BIN)) {
+    fprintf(stderr, "Error opening file %s\n", output_file_name);
+    exit(-1);
+  }
+  ch_rand_init(&noise, seed, 0);
+  srand(seed);
+
+  bzero(&ra_dl, sizeof(ra_pdsch_t));
+  ra_dl.mcs_idx = mcs_idx;
+  ra_dl.alloc_type = alloc_type0;
+  ra_dl.type0_alloc.rbg_bitmask = 0xffffffff;
+  dci_msg_pack_pdsch(&ra_dl, &dci_msg, Format1, cell.nof_prb, false);
+  ra_prb_get_dl(&prb_alloc, &ra_dl, cell.nof_prb);
+  ra_prb_get_re_dl(&prb_alloc, cell.nof_prb, 1, cell.nof_prb<10?(cfi+1):cfi, cell.cp);
+  ra_mcs_from_idx_dl(mcs_idx, cell.nof_prb, &ra_dl.mcs);
+  if (pdsch_harq_setup(&harq_process, ra_dl.mcs, &prb_alloc)) {
+    fprintf(stderr, "Error configuring HARQ process\n");
+    exit(-1);
+  }
+
+  rx_buffer = malloc(sizeof(cf_t) * enb_dl.sf_n_samples);
+  data = malloc(sizeof(char) * ra_dl.mcs.tbs);
+  if (!rx_buffer || !data) {
+    perror("malloc");
+    exit(-1);
+  }
+
+  enb_dl_set_sender(&enb_dl, write_subframe, NULL);
+  if (enb_dl_start(&enb_dl, 0)) {
+    fprintf(stderr, "Error starting eNodeB DL\n");
+    exit(-1);
+  }
+  for (tti = 0; tti < nof_frames * NSUBFRAMES_X_FRAME; tti++) {
+    if (!enb_dl_sf_begin(&enb_dl, tti)) {
+      goto quit;
+    }
+    if (!pdcch_ue_locations(&enb_dl.pdcch, locations, 10, tti % NSUBFRAMES_X_FRAME, cfi, rnti) ||
+        enb_dl_put_pdcch(&enb_dl, &dci_msg, locations[0], rnti)) {
+      fprintf(stderr, "Error encoding DCI message\n");
+      goto quit;
+    }
+    for (j = 0; j < ra_dl.mcs.tbs; j++) {
+      data[j] = rand() % 2;
+    }
+    if (enb_dl_put_pdsch(&enb_dl, &harq_process, data, 0, rnti)) {
+      fprintf(stderr, "Error encoding PDSCH\n");
+      goto quit;
+    }
+    enb_dl_sf_end(&enb_dl);
+  }
+  if (enb_dl_stop(&enb_dl) ||
+      enb_dl_nof_sf_sent(&enb_dl) != nof_frames * NSUBFRAMES_X_FRAME) {
+    fprintf(stderr, "Error writing the capture\n");
+    goto quit;
+  }
+  printf("Wrote %d frames of cell %d, %d PRB, MCS %d (TBS %d) at %.1f dB SNR to %s\n",
+         nof_frames, cell.id, cell.nof_prb, mcs_idx, ra_dl.mcs.tbs, snr_db, output_file_name);
+  ret = 0;
+
+quit:
+  pdsch_harq_free(&harq_process);
+  enb_dl_free(&enb_dl);
+  filesink_free(&fsink);
+  free(rx_buffer);
+  free(data);
+  exit(ret);
+}
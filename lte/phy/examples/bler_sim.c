@@ -0,0 +1,220 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "liblte/phy/phy.h"
+
+/* Link-level BLER simulator. Sweeps every combination of the MCS, PRB, port
+ * and channel lists over the SNR range and writes one CSV row or JSON
+ * object per point.
+ */
+
+#define MAX_LIST        32
+
+char *mcs_list = "10";
+char *prb_list = "25";
+char *ports_list = "1";
+char *channel_list = "AWGN";
+float snr_start = 0.0, snr_end = 10.0, snr_step = 1.0;
+char *output_file_name = NULL;
+bool output_json = false;
+link_sim_cfg_t cfg;
+
+void usage(char *prog) {
+  printf("Usage: %s [mpacseiEfntrojv]\n", prog);
+  printf("\t-m comma-separated MCS indexes [Default %s]\n", mcs_list);
+  printf("\t-p comma-separated number of PRB [Default %s]\n", prb_list);
+  printf("\t-a comma-separated number of transmit ports [Default %s]\n", ports_list);
+  printf("\t-c comma-separated channels, AWGN or EPA/EVA/ETU + Doppler, e.g. EVA70 [Default %s]\n",
+         channel_list);
+  printf("\t-s first SNR in dB [Default %.1f]\n", snr_start);
+  printf("\t-e last SNR in dB [Default %.1f]\n", snr_end);
+  printf("\t-i SNR step in dB [Default %.1f]\n", snr_step);
+  printf("\t-E errors to stop a point [Default %d]\n", cfg.min_errors);
+  printf("\t-f minimum subframes per point [Default %d]\n", cfg.min_frames);
+  printf("\t-n maximum subframes per point [Default %d]\n", cfg.max_frames);
+  printf("\t-t number of threads [Default %d]\n", cfg.nof_threads);
+  printf("\t-r seed [Default %lu]\n", (unsigned long) cfg.seed);
+  printf("\t-o output file [Default stdout]\n");
+  printf("\t-j output JSON instead of CSV\n");
+  printf("\t-v [set verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "mpacseiEfntrojv")) != -1) {
+    switch(opt) {
+    case 'm':
+      mcs_list = argv[optind];
+      break;
+    case 'p':
+      prb_list = argv[optind];
+      break;
+    case 'a':
+      ports_list = argv[optind];
+      break;
+    case 'c':
+      channel_list = argv[optind];
+      break;
+    case 's':
+      snr_start = atof(argv[optind]);
+      optind++;                 // skip the value, it may be negative
+      break;
+    case 'e':
+      snr_end = atof(argv[optind]);
+      optind++;                 // skip the value, it may be negative
+      break;
+    case 'i':
+      snr_step = atof(argv[optind]);
+      break;
+    case 'E':
+      cfg.min_errors = atoi(argv[optind]);
+      break;
+    case 'f':
+      cfg.min_frames = atoi(argv[optind]);
+      break;
+    case 'n':
+      cfg.max_frames = atoi(argv[optind]);
+      break;
+    case 't':
+      cfg.nof_threads = atoi(argv[optind]);
+      break;
+    case 'r':
+      cfg.seed = strtoull(argv[optind], NULL, 0);
+      break;
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    case 'j':
+      output_json = true;
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (snr_step <= 0) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+/* Splits a comma-separated list. The string is modified. */
+int split_list(char *str, char *items[MAX_LIST]) {
+  int n = 0;
+  char *tok = strtok(str, ",");
+  while (tok && n < MAX_LIST) {
+    items[n++] = tok;
+    tok = strtok(NULL, ",");
+  }
+  return n;
+}
+
+int main(int argc, char **argv) {
+  char *mcs[MAX_LIST], *prb[MAX_LIST], *ports[MAX_LIST], *channels[MAX_LIST];
+  int nof_mcs, nof_prb, nof_ports, nof_channels;
+  int i_mcs, i_prb, i_ports, i_ch, nof_points = 0;
+  link_sim_point_t point;
+  link_sim_result_t result;
+  float snr_db;
+  FILE *f = stdout;
+  int ret = -1;
+
+  link_sim_cfg_default(&cfg);
+  parse_args(argc, argv);
+
+  nof_mcs = split_list(strdup(mcs_list), mcs);
+  nof_prb = split_list(strdup(prb_list), prb);
+  nof_ports = split_list(strdup(ports_list), ports);
+  nof_channels = split_list(strdup(channel_list), channels);
+
+  if (output_file_name) {
+    f = fopen(output_file_name, "w");
+    if (!f) {
+      perror("fopen");
+      exit(-1);
+    }
+  }
+  if (output_json) {
+    fprintf(f, "[\n");
+  } else {
+    link_sim_fprint_csv_header(f);
+  }
+
+  for (i_ch = 0; i_ch < nof_channels; i_ch++) {
+    for (i_ports = 0; i_ports < nof_ports; i_ports++) {
+      for (i_prb = 0; i_prb < nof_prb; i_prb++) {
+        for (i_mcs = 0; i_mcs < nof_mcs; i_mcs++) {
+          for (snr_db = snr_start; snr_db <= snr_end + snr_step / 2; snr_db += snr_step) {
+            bzero(&point, sizeof(link_sim_point_t));
+            point.mcs_idx = atoi(mcs[i_mcs]);
+            point.nof_prb = atoi(prb[i_prb]);
+            point.nof_ports = atoi(ports[i_ports]);
+            point.snr_db = snr_db;
+            strncpy(point.channel, channels[i_ch], LINK_SIM_CHANNEL_LEN - 1);
+            if (link_sim_run(&cfg, &point, &result)) {
+              fprintf(stderr, "Error simulating MCS %d, %d PRB, %d ports, %s, SNR %.1f dB\n",
+                      point.mcs_idx, point.nof_prb, point.nof_ports, point.channel, snr_db);
+              goto quit;
+            }
+            if (output_json) {
+              fprintf(f, "%s  ", nof_points ? ",\n" : "");
+              link_sim_fprint_json(f, &result);
+            } else {
+              link_sim_fprint_csv(f, &result);
+            }
+            fflush(f);
+            nof_points++;
+            if (output_file_name) {
+              printf("MCS %2d, %3d PRB, %d ports, %-6s SNR %5.1f dB: BLER %.4f (%d/%d), %.2f Mbps\n",
+                     point.mcs_idx, point.nof_prb, point.nof_ports, point.channel, snr_db,
+                     result.bler, result.nof_errors, result.nof_frames, result.throughput_mbps);
+            }
+          }
+        }
+      }
+    }
+  }
+  ret = 0;
+quit:
+  if (output_json) {
+    fprintf(f, "\n]\n");
+  }
+  if (output_file_name) {
+    fclose(f);
+  }
+  exit(ret);
+}
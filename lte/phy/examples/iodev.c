@@ -29,11 +29,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 
 #include "iodev.h"
 
-#include "liblte/phy/io/filesource.h"
+#include "liblte/phy/io/filesource_mmap.h"
 #include "liblte/phy/ue/ue_sync.h"
 #include "liblte/phy/utils/debug.h"
 #include "liblte/phy/utils/vector.h"
@@ -50,10 +51,46 @@ int cuhd_recv_wrapper(void *h, void *data, uint32_t nsamples) {
   return cuhd_recv(h, data, nsamples, 1);
 }
 
+static bool is_sigmf(char *file_name) {
+  size_t len = strlen(file_name);
+  return len > 11 && (!strcmp(&file_name[len - 11], ".sigmf-meta") || 
+                      !strcmp(&file_name[len - 11], ".sigmf-data"));
+}
+
+static int sigmf_init(iodev_t *q, iodev_cfg_t *config, lte_cell_t *cell, pbch_mib_t *mib) {
+  
+  mib->phich_resources = R_1; 
+  mib->phich_length = PHICH_NORM;
+
+  if (sigmf_source_init(&q->sigmf, config->input_file_name)) {
+    fprintf(stderr, "Error opening SigMF recording %s\n", config->input_file_name);
+    return LIBLTE_ERROR;
+  }
+  q->mode = SIGMFSOURCE;
+  if (q->sigmf.meta.cell.nof_prb > 0) {
+    *cell = q->sigmf.meta.cell; 
+  } else {
+    cell->id = config->cell_id_file;
+    cell->cp = CPNORM; 
+    cell->nof_ports = config->nof_ports_file; 
+    cell->nof_prb = config->nof_prb_file; 
+  }
+  if (sigmf_source_seek(&q->sigmf, config->file_start_sf)) {
+    fprintf(stderr, "The recording has %d subframes\n", sigmf_source_nof_sf(&q->sigmf));
+    return LIBLTE_ERROR;
+  }
+  return LIBLTE_SUCCESS;
+}
+
 /* Setup USRP or input file */
 int iodev_init(iodev_t *q, iodev_cfg_t *config, lte_cell_t *cell, pbch_mib_t *mib) {
   
-  if (config->input_file_name) {
+  q->recording = false; 
+  if (config->input_file_name && is_sigmf(config->input_file_name)) {
+    if (sigmf_init(q, config, cell, mib)) {
+      return LIBLTE_ERROR;
+    }
+  } else if (config->input_file_name) {
     
     mib->phich_resources = R_1; 
     mib->phich_length = PHICH_NORM;
@@ -63,7 +100,8 @@ int iodev_init(iodev_t *q, iodev_cfg_t *config, lte_cell_t *cell, pbch_mib_t *mi
     cell->nof_ports = config->nof_ports_file; 
     cell->nof_prb = config->nof_prb_file; 
 
-    if (filesource_init(&q->fsrc, config->input_file_name, COMPLEX_FLOAT_BIN)) {
+    if (filesource_mmap_init(&q->fsrc, config->input_file_name, 
+                             config->file_is_short ? COMPLEX_SHORT_BIN : COMPLEX_FLOAT_BIN)) {
       return LIBLTE_ERROR;
     }
     q->mode = FILESOURCE;
@@ -75,12 +113,12 @@ int iodev_init(iodev_t *q, iodev_cfg_t *config, lte_cell_t *cell, pbch_mib_t *mi
       return LIBLTE_ERROR; 
     }
 
-    q->input_buffer_file = vec_malloc(q->sf_len * sizeof(cf_t));
-    if (!q->input_buffer_file) {
-      perror("malloc");
-      return LIBLTE_ERROR; 
+    if (filesource_mmap_seek_sf(&q->fsrc, config->file_start_sf, cell->nof_prb)) {
+      fprintf(stderr, "Subframe %d is beyond the end of the file\n", config->file_start_sf);
+      return LIBLTE_ERROR;
     }
-    q->sf_idx = 9; 
+    /* the file is assumed to start at subframe 0 */
+    q->sf_idx = (config->file_start_sf + 9) % 10; 
     
   } else {
 #ifndef DISABLE_UHD
@@ -161,6 +199,21 @@ int iodev_init(iodev_t *q, iodev_cfg_t *config, lte_cell_t *cell, pbch_mib_t *mi
     /* Decodes the SSS signal during the tracking phase. Extra overhead, but makes sure we are in the correct subframe */  
     ue_sync_decode_sss_on_track(&q->sframe, true);
 
+    if (config->record_file_name) {
+      sigmf_meta_t meta; 
+      bzero(&meta, sizeof(sigmf_meta_t));
+      meta.type = config->file_is_short ? COMPLEX_SHORT_BIN : COMPLEX_FLOAT_BIN; 
+      meta.sample_rate = srate; 
+      meta.frequency = config->uhd_freq; 
+      meta.cell = *cell; 
+      if (sigmf_sink_init(&q->recorder, config->record_file_name, &meta)) {
+        fprintf(stderr, "Error opening SigMF recording %s\n", config->record_file_name);
+        return LIBLTE_ERROR; 
+      }
+      ue_sync_set_recorder(&q->sframe, &q->recorder);
+      q->recording = true; 
+    }
+
     // Here, the subframe length and input buffer is managed by ue_sync
     q->mode = UHD; 
   
@@ -180,11 +233,18 @@ int iodev_init(iodev_t *q, iodev_cfg_t *config, lte_cell_t *cell, pbch_mib_t *mi
 void iodev_free(iodev_t *q) {
   
   if (q->mode == FILESOURCE) {
-    filesource_free(&q->fsrc);
+    filesource_mmap_free(&q->fsrc);
+  } else if (q->mode == SIGMFSOURCE) {
+    sigmf_source_free(&q->sigmf);
   } else {
 #ifndef DISABLE_UHD
     cuhd_close(q->uhd);
 #endif
+    if (q->recording) {
+      printf("Recorded %lu samples, %lu dropped because the disk was too slow\n", 
+             sigmf_sink_nof_samples(&q->recorder), sigmf_sink_nof_dropped(&q->recorder));
+      sigmf_sink_free(&q->recorder);
+    }
   }
 }
 /* Receive samples from the USRP or read from file */
@@ -192,18 +252,17 @@ int iodev_receive(iodev_t *q, cf_t **buffer) {
   int n; 
   if (q->mode == FILESOURCE) {
     INFO(" -----   READING %d SAMPLES ---- \n", q->sf_len);
-    n = filesource_read(&q->fsrc, q->input_buffer_file, q->sf_len);
-    *buffer = q->input_buffer_file; 
-    if (n == -1) {
+    n = filesource_mmap_get(&q->fsrc, buffer, q->sf_len);
+    if (n < 0) {
       fprintf(stderr, "Error reading file\n");
       /* wrap file if arrive to end */
     } else if (n < q->sf_len) {
       DEBUG("Read %d from file. Seeking to 0\n",n);
-      filesource_seek(&q->fsrc, 0);
-      n = filesource_read(&q->fsrc, q->input_buffer_file, q->sf_len);
-      if (n == -1) {
-        fprintf(stderr, "Error reading file\n");
-        /* wrap file if arrive to end */
+      filesource_mmap_seek(&q->fsrc, 0);
+      n = filesource_mmap_get(&q->fsrc, buffer, q->sf_len);
+      if (n < q->sf_len) {
+        fprintf(stderr, "File is shorter than a subframe\n");
+        n = -1;
       } else {
         n = 1; 
       }
@@ -215,6 +274,25 @@ int iodev_receive(iodev_t *q, cf_t **buffer) {
       q->sf_idx = 0;
     }
     usleep(5000);
+  } else if (q->mode == SIGMFSOURCE) {
+    sigmf_annotation_t *annotation; 
+    n = sigmf_source_get_sf(&q->sigmf, buffer, &annotation);
+    if (n == 0) {
+      /* wrap recording if arrive to end */
+      DEBUG("End of recording. Seeking to 0\n", 0);
+      sigmf_source_seek(&q->sigmf, 0);
+      n = sigmf_source_get_sf(&q->sigmf, buffer, &annotation);
+      if (n == 0) {
+        fprintf(stderr, "The recording has no complete subframes\n");
+        n = -1; 
+      }
+    }
+    if (n < 0) {
+      fprintf(stderr, "Error reading recording\n");
+    } else {
+      q->sf_idx = annotation->sf_idx;
+    }
+    usleep(5000);
   } else {
     /* Use ue_sync_work which returns a synchronized buffer of subframe samples */
 #ifndef DISABLE_UHD
@@ -236,7 +314,7 @@ void* iodev_get_cuhd(iodev_t *q) {
 }
 
 bool iodev_isfile(iodev_t *q) {
-  return q->mode == FILESOURCE;
+  return q->mode == FILESOURCE || q->mode == SIGMFSOURCE;
 }
 
 bool iodev_isUSRP(iodev_t *q) {
@@ -252,3 +330,10 @@ uint32_t iodev_get_sfidx(iodev_t *q) {
 }
 
 
+
+/* Tells the recorder the SFN of the last subframe, once the MIB is decoded */
+void iodev_set_sfn(iodev_t *q, uint32_t sfn) {
+  if (q->recording) {
+    sigmf_sink_set_sfn(&q->recorder, sfn);
+  }
+}
@@ -31,7 +31,8 @@
 #include "liblte/config.h"
 
 #include "liblte/phy/ue/ue_sync.h"
-#include "liblte/phy/io/filesource.h"
+#include "liblte/phy/io/filesource_mmap.h"
+#include "liblte/phy/io/sigmf.h"
 
 #ifndef DISABLE_UHD
 #include "liblte/cuhd/cuhd.h"
@@ -39,16 +40,22 @@
 
 /*********
  * 
- * This component is a wrapper to the cuhd or filesource modules. It uses 
- * sync_frame_t to read aligned subframes from the USRP or filesource to read 
- * subframes from a file. 
+ * This component is a wrapper to the cuhd or filesource_mmap modules. It uses 
+ * sync_frame_t to read aligned subframes from the USRP or filesource_mmap to read 
+ * subframes from a memory-mapped file, without copying them if they are 
+ * complex float. 
+ * 
+ * Input files named *.sigmf-meta or *.sigmf-data are SigMF recordings: the
+ * cell is read from the metadata and the subframes are read at the positions
+ * given by their annotations, so they are aligned without running ue_sync. 
+ * In UHD mode, the received samples can be recorded as SigMF. 
  * 
  * When created, it starts receiving/reading at 1.92 MHz. The sampling frequency 
  * can then be changed using iodev_set_srate()
  */
 
 
-typedef enum LIBLTE_API {FILESOURCE, UHD} iodev_mode_t; 
+typedef enum LIBLTE_API {FILESOURCE, SIGMFSOURCE, UHD} iodev_mode_t; 
 
 typedef _Complex float cf_t; 
 
@@ -57,6 +64,9 @@ typedef struct LIBLTE_API {
   uint32_t cell_id_file;
   uint32_t nof_prb_file;
   uint32_t nof_ports_file; 
+  bool file_is_short;        // complex int16 samples instead of complex float
+  uint32_t file_start_sf;    // subframe of the file to start reading at
+  char *record_file_name;    // SigMF base name to record to in UHD mode, or NULL
 
   float uhd_freq;
   float uhd_gain;
@@ -71,8 +81,10 @@ typedef struct LIBLTE_API {
   #endif
   uint32_t sf_len; 
   uint32_t sf_idx;
-  cf_t *input_buffer_file; // for UHD mode, the input buffer is managed by sync_frame_t
-  filesource_t fsrc;  
+  filesource_mmap_t fsrc;
+  sigmf_source_t sigmf;
+  sigmf_sink_t recorder; 
+  bool recording; 
   iodev_cfg_t config; 
   iodev_mode_t mode; 
 } iodev_t; 
@@ -92,6 +104,9 @@ LIBLTE_API void* iodev_get_cuhd(iodev_t *q);
 
 LIBLTE_API uint32_t iodev_get_sfidx(iodev_t *q);
 
+LIBLTE_API void iodev_set_sfn(iodev_t *q, 
+                              uint32_t sfn);
+
 LIBLTE_API bool iodev_isfile(iodev_t *q); 
 
 LIBLTE_API bool iodev_isUSRP(iodev_t *q); 
@@ -56,6 +56,7 @@ typedef struct {
   uint16_t rnti; 
   int nof_subframes;
   bool disable_plots;
+  char *trace_file_name;
   iodev_cfg_t io_config; 
 }prog_args_t;
 
@@ -63,9 +64,13 @@ void args_default(prog_args_t *args) {
   args->io_config.cell_id_file = 195; 
   args->io_config.nof_prb_file = 50;
   args->io_config.nof_ports_file = 2; 
+  args->io_config.file_is_short = false;
+  args->io_config.file_start_sf = 0;
+  args->io_config.record_file_name = NULL;
   args->rnti = SIRNTI;
   args->nof_subframes = -1; 
   args->disable_plots = false; 
+  args->trace_file_name = NULL;
   args->io_config.find_threshold = -1.0; 
   args->io_config.input_file_name = NULL; 
   args->io_config.uhd_args = "";
@@ -78,10 +83,14 @@ void usage(prog_args_t *args, char *prog) {
   printf("\t-c cell_id if reading from file [Default %d]\n", args->io_config.cell_id_file);
   printf("\t-p nof_prb if reading from file [Default %d]\n", args->io_config.nof_prb_file);
   printf("\t-o nof_ports if reading from file [Default %d]\n", args->io_config.nof_ports_file);
+  printf("\t-s file samples are complex int16 [Default complex float]\n");
+  printf("\t-S start reading the file at this subframe [Default %d]\n", args->io_config.file_start_sf);
+  printf("\t   *.sigmf-meta files are SigMF recordings, -S is an aligned subframe\n");
   printf("\t-r RNTI to look for [Default 0x%x]\n", args->rnti);
 #ifndef DISABLE_UHD
   printf("\t-a UHD args [Default %s]\n", args->io_config.uhd_args);
   printf("\t-g UHD RX gain [Default %.2f dB]\n", args->io_config.uhd_gain);
+  printf("\t-w record the received samples as SigMF with this base name (complex int16 with -s)\n");
 #else
   printf("\t   UHD is disabled. CUHD library not available\n");
 #endif
@@ -93,13 +102,14 @@ void usage(prog_args_t *args, char *prog) {
 #else
   printf("\t plots are disabled. Graphics library not available\n");
 #endif
+  printf("\t-T write a Chrome trace of the last subframes to this file on exit\n");
   printf("\t-v [set verbose to debug, default none]\n");
 }
 
 void parse_args(prog_args_t *args, int argc, char **argv) {
   int opt;
   args_default(args);
-  while ((opt = getopt(argc, argv, "icagfndvtbpro")) != -1) {
+  while ((opt = getopt(argc, argv, "icagfndvtbproTsSw")) != -1) {
     switch (opt) {
     case 'i':
       args->io_config.input_file_name = argv[optind];
@@ -134,6 +144,18 @@ void parse_args(prog_args_t *args, int argc, char **argv) {
     case 'd':
       args->disable_plots = true;
       break;
+    case 's':
+      args->io_config.file_is_short = true;
+      break;
+    case 'S':
+      args->io_config.file_start_sf = atoi(argv[optind]);
+      break;
+    case 'w':
+      args->io_config.record_file_name = argv[optind];
+      break;
+    case 'T':
+      args->trace_file_name = argv[optind];
+      break;
     case 'v':
       verbose++;
       break;
@@ -184,6 +206,14 @@ int main(int argc, char **argv) {
   /* Initialize subframe counter */
   sf_cnt = 0;
 
+  if (prog_args.trace_file_name) {
+    if (trace_init(1<<16)) {
+      fprintf(stderr, "Error initiating trace\n");
+      exit(-1);
+    }
+    trace_thread_name("pdsch_ue");
+  }
+
   if (iodev_init(&iodev, &prog_args.io_config, &cell, &mib)) {
     exit(-1);
   }
@@ -210,6 +240,9 @@ int main(int argc, char **argv) {
         fprintf(stderr, "\nError running receiver\n");fflush(stdout);
         exit(-1);
       }
+      if (iodev_get_sfidx(&iodev) == 0 && ue_dl.pbch_decoded) {
+        iodev_set_sfn(&iodev, ue_dl.sfn);
+      }
       if (prog_args.rnti == SIRNTI && !printed_sib && rlen > 0) {
         printf("\n\nDecoded SIB1 Message: ");
         vec_fprint_hex(stdout, data, rlen);
@@ -239,6 +272,11 @@ int main(int argc, char **argv) {
     sf_cnt++;                  
   } // Main loop
 
+  if (prog_args.trace_file_name) {
+    trace_write_json(prog_args.trace_file_name);
+    trace_free();
+  }
+
   ue_dl_free(&ue_dl);    
   iodev_free(&iodev);
 
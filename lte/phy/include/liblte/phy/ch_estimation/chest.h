@@ -64,6 +64,7 @@ typedef struct LIBLTE_API {
   interp_t interp_time[MAX_PORTS]; 
   interp_t interp_freq[MAX_PORTS]; 
   
+  float noise_estimate[MAX_PORTS];
 }chest_t;
 
 LIBLTE_API int chest_init(chest_t *q, 
@@ -119,6 +120,8 @@ LIBLTE_API int chest_ce_sf(chest_t *q,
                             cf_t *ce[MAX_PORTS], 
                             uint32_t sf_idx);
 
+LIBLTE_API float chest_get_noise_estimate(chest_t *q);
+
 LIBLTE_API void chest_fprint(chest_t *q, 
                              FILE *stream, 
                              uint32_t nslot, 
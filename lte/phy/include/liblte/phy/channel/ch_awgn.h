@@ -30,6 +30,7 @@
 #include <stdint.h>
 
 #include "liblte/config.h"
+#include "liblte/phy/channel/ch_rand.h"
 
 #ifndef CH_AWGN_
 #define CH_AWGN_
@@ -46,6 +47,23 @@ LIBLTE_API void ch_awgn_f(const float* x,
                           float variance, 
                           uint32_t len);
 
+/* ch_awgn_c() and ch_awgn_f() draw the noise from rand(), so the results 
+ * recorded for a given srand() seed can be reproduced. The _rand versions 
+ * draw it from the generator gen, which is several times faster and 
+ * reentrant, so that simulations running in parallel are reproducible. 
+ */
+LIBLTE_API void ch_awgn_c_rand(ch_rand_t *gen, 
+                               const cf_t* input, 
+                               cf_t* output, 
+                               float variance, 
+                               uint32_t len);
+
+LIBLTE_API void ch_awgn_f_rand(ch_rand_t *gen, 
+                               const float* x, 
+                               float* y, 
+                               float variance, 
+                               uint32_t len);
+
 LIBLTE_API float ch_awgn_get_variance(float ebno_db, 
                                       float rate);
 
@@ -0,0 +1,105 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef CH_FADING_
+#define CH_FADING_
+
+#include <stdint.h>
+#include <complex.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/channel/ch_rand.h"
+
+typedef _Complex float cf_t;
+
+/* Multipath fading channel with the EPA, EVA and ETU tapped delay line models 
+ * of 3GPP TS 36.101 Annex B.2. 
+ *
+ * Each path is delayed by its delay rounded to the nearest sample and 
+ * multiplied by an independent Rayleigh process with the classical (Jakes) 
+ * Doppler spectrum, generated as a sum of CH_FADING_NOF_SINUSOIDS sinusoids 
+ * with random angles of arrival and phases drawn from a ch_rand_t (Zheng and 
+ * Xiao's model). The path coefficients are updated often enough for the 
+ * Doppler frequency (at least CH_FADING_UPDATES_X_CYCLE times per Doppler 
+ * cycle) and held in between. The total power of the paths is normalized to 1.
+ */
+#define CH_FADING_MAX_PATHS         9
+#define CH_FADING_NOF_SINUSOIDS     16
+#define CH_FADING_UPDATES_X_CYCLE   256
+#define CH_FADING_CHUNK             1024
+
+typedef enum LIBLTE_API {
+  CH_FADING_EPA = 0, CH_FADING_EVA, CH_FADING_ETU
+} ch_fading_model_t;
+
+typedef struct LIBLTE_API {
+  uint32_t delay;                               // in samples
+  float gain;                                   // amplitude
+  double w_i[CH_FADING_NOF_SINUSOIDS];          // Doppler of the in-phase sinusoids, rad/sample
+  double w_q[CH_FADING_NOF_SINUSOIDS];          // Doppler of the quadrature sinusoids, rad/sample
+  float phi_i[CH_FADING_NOF_SINUSOIDS];
+  float phi_q[CH_FADING_NOF_SINUSOIDS];
+  cf_t h;                                       // current coefficient, gain included
+}ch_fading_path_t;
+
+typedef struct LIBLTE_API {
+  ch_fading_model_t model;
+  float doppler;
+  float srate;
+  uint32_t nof_paths;
+  ch_fading_path_t path[CH_FADING_MAX_PATHS];
+  uint32_t max_delay;
+  uint32_t update_len;                          // samples between coefficient updates
+  uint32_t to_update;                           // samples left with the current coefficients
+  uint64_t time;                                // samples since initialization
+  cf_t *buffer;                                 // max_delay samples of history followed by the input chunk
+}ch_fading_t;
+
+LIBLTE_API int ch_fading_init(ch_fading_t *q, 
+                              ch_fading_model_t model, 
+                              float doppler, 
+                              float srate, 
+                              ch_rand_t *gen);
+
+LIBLTE_API void ch_fading_free(ch_fading_t *q);
+
+LIBLTE_API int ch_fading_run(ch_fading_t *q, 
+                             cf_t *input, 
+                             cf_t *output, 
+                             uint32_t len);
+
+LIBLTE_API void ch_fading_set_time(ch_fading_t *q, 
+                                   uint64_t time);
+
+LIBLTE_API int ch_fading_parse(char *name, 
+                               ch_fading_model_t *model, 
+                               float *doppler);
+
+LIBLTE_API char* ch_fading_model_string(ch_fading_model_t model);
+
+#endif // CH_FADING_
@@ -0,0 +1,71 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef CH_RAND_
+#define CH_RAND_
+
+#include <stdint.h>
+
+#include "liblte/config.h"
+
+/* Reentrant random number generator for channel simulation.
+ *
+ * CH_RAND_LANES independent xoshiro128+ generators are clocked together, so 
+ * that the compiler vectorizes the state update, and Gaussian samples are 
+ * obtained from pairs of uniforms with the Box-Muller transform using 
+ * polynomial logarithm and sine/cosine, which are vectorized as well. 
+ *
+ * A generator is fully determined by its seed and stream number: threads 
+ * that simulate in parallel use the same seed and different streams, and 
+ * obtain the same samples regardless of how the work is scheduled. Samples 
+ * do not depend on the length of the calls either, since those of the last 
+ * block that are not returned are kept for the next call of the same kind. 
+ */
+#define CH_RAND_LANES   16
+
+typedef struct LIBLTE_API {
+  uint32_t s[4][CH_RAND_LANES];
+  float cache[2 * CH_RAND_LANES];   // Gaussian samples generated but not returned yet
+  uint32_t cache_len;
+  float ucache[CH_RAND_LANES];      // uniform samples generated but not returned yet
+  uint32_t ucache_len;
+}ch_rand_t;
+
+LIBLTE_API void ch_rand_init(ch_rand_t *q, 
+                             uint64_t seed, 
+                             uint32_t stream);
+
+LIBLTE_API void ch_rand_uniform(ch_rand_t *q, 
+                                float *output, 
+                                uint32_t len);
+
+LIBLTE_API void ch_rand_gauss(ch_rand_t *q, 
+                              float *output, 
+                              uint32_t len);
+
+#endif // CH_RAND_
@@ -0,0 +1,175 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef ENBDL_H
+#define ENBDL_H
+
+/*******************************************************
+ *
+ * Downlink transmitter of the eNodeB.
+ *
+ * The static signals of each subframe index (PSS, SSS, CRS and PCFICH, since
+ * the CFI is fixed) are generated once at init into per-subframe templates.
+ * Each subframe the caller takes a grid with enb_dl_sf_begin(), which starts
+ * from the template and adds the PBCH, overlays the dynamic channels
+ * (PDCCH, PDSCH) and hands it over with enb_dl_sf_end().
+ *
+ * A worker thread runs the IFFT and converts the samples to int16 and a sender
+ * thread passes them, in order and with their timestamp, to the configured
+ * sender callback or file. Both threads share a ring of ENB_DL_RING_LEN
+ * subframes.
+ ********************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/common/fft.h"
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/ch_estimation/refsignal.h"
+#include "liblte/phy/phch/dci.h"
+#include "liblte/phy/phch/pbch.h"
+#include "liblte/phy/phch/pcfich.h"
+#include "liblte/phy/phch/pdcch.h"
+#include "liblte/phy/phch/pdsch.h"
+#include "liblte/phy/phch/ra.h"
+#include "liblte/phy/phch/regs.h"
+#include "liblte/phy/io/filesink.h"
+
+#define ENB_DL_RING_LEN             8
+#define ENB_DL_DEFAULT_AMPLITUDE    0.2
+
+/* Called by the sender thread for every subframe. samples are nof_samples
+ * interleaved I/Q int16 pairs to be transmitted at timestamp (in samples).
+ * Returning a negative value stops the transmitter.
+ */
+typedef int (*enb_dl_send_t)(void *arg,
+                             int16_t *samples,
+                             uint32_t nof_samples,
+                             uint64_t timestamp);
+
+typedef enum {
+  ENB_DL_SLOT_FREE = 0, ENB_DL_SLOT_GRID, ENB_DL_SLOT_SAMPLES
+} enb_dl_slot_state_t;
+
+typedef struct LIBLTE_API {
+  enb_dl_slot_state_t state;
+  uint32_t tti;
+  uint64_t timestamp;
+  cf_t *sf_symbols;
+  int16_t *samples;
+} enb_dl_slot_t;
+
+typedef struct LIBLTE_API {
+  lte_cell_t cell;
+  uint32_t cfi;
+  pbch_mib_t mib;
+  uint32_t pbch_block;
+
+  regs_t regs;
+  pbch_t pbch;
+  pcfich_t pcfich;
+  pdcch_t pdcch;
+  pdsch_t pdsch;
+  lte_fft_t ifft;
+
+  uint32_t sf_n_re;
+  uint32_t sf_n_samples;
+  cf_t *sf_template[NSUBFRAMES_X_FRAME];
+  cf_t *sf_scratch;
+  cf_t *ifft_out;
+  float tx_scale;
+
+  /* TX ring */
+  enb_dl_slot_t ring[ENB_DL_RING_LEN];
+  uint32_t wr_idx;
+  uint32_t proc_idx;
+  uint32_t rd_idx;
+  enb_dl_slot_t *cur;
+  uint64_t start_timestamp;
+  uint32_t start_tti;
+  bool started;
+  bool first_sf;
+  bool stop;
+  bool worker_done;
+  bool send_error;
+  pthread_mutex_t mutex;
+  pthread_cond_t cvar;
+  pthread_t worker_thread;
+  pthread_t sender_thread;
+
+  enb_dl_send_t send;
+  void *send_arg;
+  filesink_t fsink;
+  bool fsink_open;
+
+  uint64_t nof_sf_sent;
+}enb_dl_t;
+
+LIBLTE_API int enb_dl_init(enb_dl_t *q,
+                           lte_cell_t cell,
+                           uint32_t cfi,
+                           phich_resources_t phich_resources,
+                           phich_length_t phich_length);
+
+LIBLTE_API void enb_dl_free(enb_dl_t *q);
+
+LIBLTE_API void enb_dl_set_amplitude(enb_dl_t *q,
+                                     float amplitude);
+
+LIBLTE_API void enb_dl_set_sender(enb_dl_t *q,
+                                  enb_dl_send_t send,
+                                  void *arg);
+
+LIBLTE_API int enb_dl_set_file_sink(enb_dl_t *q,
+                                    char *filename);
+
+LIBLTE_API int enb_dl_start(enb_dl_t *q,
+                            uint64_t start_timestamp);
+
+LIBLTE_API int enb_dl_stop(enb_dl_t *q);
+
+LIBLTE_API cf_t* enb_dl_sf_begin(enb_dl_t *q,
+                                 uint32_t tti);
+
+LIBLTE_API int enb_dl_put_pdcch(enb_dl_t *q,
+                                dci_msg_t *dci_msg,
+                                dci_location_t location,
+                                uint16_t rnti);
+
+LIBLTE_API int enb_dl_put_pdsch(enb_dl_t *q,
+                                pdsch_harq_t *harq_process,
+                                char *data,
+                                uint32_t rv_idx,
+                                uint16_t rnti);
+
+LIBLTE_API int enb_dl_sf_end(enb_dl_t *q);
+
+LIBLTE_API uint64_t enb_dl_nof_sf_sent(enb_dl_t *q);
+
+#endif
@@ -29,20 +29,63 @@
 #define RM_CONV_
 
 #include "liblte/config.h"
+#include "liblte/phy/modem/mod.h"
 
 #define RX_NULL 10000
 #define TX_NULL 80
 
+#define RM_CONV_MAX_TABLES  8
+
+/* Convolutional rate matching receiver with cached index tables.
+ * 
+ * Without the dummy bits, the circular buffer of a code block of out_len 
+ * bits is out_len bits long, so input bit k is buffer bit k % out_len for any 
+ * rate matched length. Received LLRs are accumulated over the buffer in 
+ * contiguous runs and then gathered into the code block order with a table 
+ * that depends only on out_len. Tables for up to RM_CONV_MAX_TABLES lengths
+ * are kept, the oldest one is replaced when a new length is used. 
+ */
+typedef struct LIBLTE_API {
+  uint32_t len[RM_CONV_MAX_TABLES];
+  uint16_t *table[RM_CONV_MAX_TABLES];    // buffer position of each output bit
+  uint32_t nof_tables;
+  uint32_t next;
+  float *acc;
+} rm_conv_t;
+
 LIBLTE_API int rm_conv_tx(char *input, 
                           uint32_t in_len, 
                           char *output, 
                           uint32_t out_len);
 
+LIBLTE_API int rm_conv_tx_mod(char *input, 
+                              uint32_t in_len, 
+                              mod_stream_t *s,
+                              uint32_t offset, 
+                              uint32_t out_len);
+
 LIBLTE_API int rm_conv_rx(float *input, 
                           uint32_t in_len, 
                           float *output, 
                           uint32_t out_len);
 
+LIBLTE_API int rm_conv_init(rm_conv_t *q);
+
+LIBLTE_API void rm_conv_free(rm_conv_t *q);
+
+LIBLTE_API int rm_conv_rx_cached(rm_conv_t *q, 
+                                 float *input, 
+                                 uint32_t in_len, 
+                                 float *output, 
+                                 uint32_t out_len);
+
+LIBLTE_API int rm_conv_rx_batch(rm_conv_t *q, 
+                                float **input, 
+                                uint32_t in_len, 
+                                float **output, 
+                                uint32_t out_len, 
+                                uint32_t nof_inputs);
+
 /* High-level API */
 typedef struct
   LIBLTE_API {
@@ -39,6 +39,7 @@
 #endif
 
 #include "liblte/config.h"
+#include "liblte/phy/modem/mod.h"
 
 
 LIBLTE_API int rm_turbo_tx(char *w_buff,
@@ -49,6 +50,14 @@ LIBLTE_API int rm_turbo_tx(char *w_buff,
                            uint32_t out_len, 
                            uint32_t rv_idx);
 
+LIBLTE_API int rm_turbo_tx_mod(char *w_buff,
+                               uint32_t buff_len, 
+                               char *input, 
+                               uint32_t in_len, 
+                               mod_stream_t *s,
+                               uint32_t out_len, 
+                               uint32_t rv_idx);
+
 LIBLTE_API int rm_turbo_rx(float *w_buff,
                            uint32_t buff_len, 
                            float *input, 
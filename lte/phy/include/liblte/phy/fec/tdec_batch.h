@@ -0,0 +1,117 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef TDEC_BATCH_
+#define TDEC_BATCH_
+
+/*******************************************************
+ *
+ * Batch turbo decoder.
+ *
+ * Decodes many code blocks, of one or several transport blocks and users, in
+ * one call. Jobs with the same code block size are decoded together, 
+ * TDEC_BATCH_LANES at a time: the metrics of all of them are stored 
+ * interleaved so that every step of the recursions runs the same operation 
+ * over the lanes, which the compiler turns into SIMD instructions. Groups 
+ * with less jobs than lanes are padded with zero LLRs. The results of each 
+ * lane are the same as those of tdec_t.
+ ********************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/fec/crc.h"
+#include "liblte/phy/fec/turbodecoder.h"
+
+#define TDEC_BATCH_LANES    4
+
+typedef enum {
+  TDEC_CRC_NONE = 0,          // run all the iterations
+  TDEC_CRC_24A,               // transport block CRC (one code block)
+  TDEC_CRC_24B                // code block CRC
+} tdec_crc_t;
+
+/* One code block to decode. If w_buff is not NULL, llr holds the e_len rate 
+ * matched LLRs, which are combined into the HARQ soft buffer w_buff with 
+ * rm_turbo_rx(). Otherwise llr holds the 3*long_cb+12 code block LLRs. 
+ * The CRC is checked after every iteration over the bits after the nof_filler
+ * filler bits, and decoding stops when it passes. 
+ */
+typedef struct LIBLTE_API {
+  float *llr;
+  uint32_t e_len;
+  float *w_buff;
+  uint32_t w_buff_size;
+  uint32_t rv_idx;
+  uint32_t long_cb;
+  uint32_t nof_filler;
+  tdec_crc_t crc;
+  char *output;               // long_cb decoded bits
+
+  /* results */
+  bool crc_ok;
+  uint32_t nof_iterations;
+} tdec_job_t;
+
+typedef struct LIBLTE_API {
+  uint32_t max_long_cb;
+  uint32_t *forward[NOF_TC_CB_SIZES];
+  uint32_t *reverse[NOF_TC_CB_SIZES];
+  tc_interl_t interl;
+  crc_t crc_24a;
+  crc_t crc_24b;
+
+  uint32_t *order;            // jobs sorted by code block size
+  uint32_t max_jobs;
+
+  /* one code block, before it is copied into its lane */
+  llr_t *cb;
+
+  /* lane-interleaved buffers: element i of lane l is at i*TDEC_BATCH_LANES+l */
+  llr_t *input;
+  llr_t *syst;
+  llr_t *parity;
+  llr_t *w;
+  llr_t *llr1;
+  llr_t *llr2;
+  llr_t *beta;
+  llr_t alpha[2][NUMSTATES * TDEC_BATCH_LANES];
+} tdec_batch_t;
+
+LIBLTE_API int tdec_batch_init(tdec_batch_t *q, 
+                               uint32_t max_long_cb);
+
+LIBLTE_API void tdec_batch_free(tdec_batch_t *q);
+
+LIBLTE_API int tdec_batch_run(tdec_batch_t *q, 
+                              tdec_job_t *jobs, 
+                              uint32_t nof_jobs, 
+                              uint32_t max_iterations);
+
+#endif
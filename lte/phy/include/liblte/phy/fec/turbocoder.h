@@ -28,7 +28,9 @@
 #ifndef TURBOCODER_
 #define TURBOCODER_
 
+#include <stdint.h>
 #include "liblte/config.h"
+#include "liblte/phy/common/phy_common.h"
 #include "liblte/phy/fec/tc_interl.h"
 
 #define NUMREGS     3
@@ -36,14 +38,31 @@
 #define RATE 3
 #define TOTALTAIL 12
 
+#define TCOD_NOF_STATES   8
+
+/* The constituent encoders are clocked 8 bits at a time using tables indexed
+ * by state and input byte. The QPP interleaver of each code block size is
+ * generated the first time it is used and kept until tcod_free().
+ */
 typedef struct LIBLTE_API {
   uint32_t max_long_cb;
   tc_interl_t interl;
+  uint16_t *perm[NOF_TC_CB_SIZES];
+
+  uint8_t next_state[TCOD_NOF_STATES][256];
+  uint8_t parity[TCOD_NOF_STATES][256];
+  uint32_t spread[256];         // spreads the bits of a byte every 3 bits
+
+  uint8_t *input_packed;
+  uint8_t *input_interl;
+  uint8_t *parity1;
+  uint8_t *parity2;
 } tcod_t;
 
 LIBLTE_API int tcod_init(tcod_t *h, uint32_t max_long_cb);
 LIBLTE_API void tcod_free(tcod_t *h);
 LIBLTE_API int tcod_encode(tcod_t *h, char *input, char *output, uint32_t long_cb);
+LIBLTE_API int tcod_encode_packed(tcod_t *h, uint8_t *input, uint8_t *output, uint32_t long_cb);
 
 #endif
 
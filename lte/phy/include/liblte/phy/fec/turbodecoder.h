@@ -28,6 +28,9 @@
 #ifndef TURBODECODER_
 #define TURBODECODER_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "liblte/config.h"
 #include "liblte/phy/fec/tc_interl.h"
 
@@ -49,9 +52,69 @@
 
 typedef float llr_t;
 
+typedef enum {
+  TDEC_MAP_FULL = 0,          // beta metrics of the whole code block are stored
+  TDEC_MAP_SLIDING_WINDOW     // beta metrics of one window are stored
+} tdec_map_t;
+
+/* Initialization of the beta recursion at the end of each window */
+typedef enum {
+  TDEC_BETA_TRAINING = 0,     // run training_len steps from equiprobable states
+  TDEC_BETA_STORED            // train from the values of the previous iteration (from equiprobable states in the first one)
+} tdec_beta_init_t;
+
+/* Trellis steps per recursion step of the full MAP */
+typedef enum {
+  TDEC_RADIX2 = 0,
+  TDEC_RADIX4                 // two trellis steps with 4-way ACS
+} tdec_radix_t;
+
+/* Type of the state metrics of the radix-4 MAP */
+typedef enum {
+  TDEC_METRIC_FLOAT = 0,
+  TDEC_METRIC_INT16           // LLRs scaled to 10 bits, normalized metrics
+} tdec_metric_t;
+
+/* Early stopping criteria checked by tdec_stop_check(). The decoder has 
+ * converged when any of the selected ones is met.
+ */
+#define TDEC_STOP_HDA       (1 << 0)  // hard decisions equal to those of the previous iteration
+#define TDEC_STOP_MIN_LLR   (1 << 1)  // every |LLR| is at least min_llr
+#define TDEC_STOP_SCR       (1 << 2)  // at most a fraction scr of the extrinsic LLRs changed sign
+
+typedef struct LIBLTE_API {
+  uint32_t criteria;          // TDEC_STOP_* flags, 0 disables the check
+  float min_llr;
+  float scr;
+} tdec_stop_t;
+
+typedef struct LIBLTE_API {
+  tdec_map_t map;
+  uint32_t window_len;
+  uint32_t training_len;
+  tdec_beta_init_t beta_init;
+  tdec_radix_t radix;
+  tdec_metric_t metric;
+} tdec_opts_t;
+
 typedef struct LIBLTE_API {
   int max_long_cb;
   llr_t *beta;
+
+  /* sliding window */
+  tdec_map_t map;
+  uint32_t window_len;
+  uint32_t training_len;
+  tdec_beta_init_t beta_init;
+  llr_t *beta_bound[2];       // beta at the start of each window, for each constituent decoder
+  bool beta_bound_valid[2];
+
+  /* radix-4 */
+  tdec_radix_t radix;
+  tdec_metric_t metric;
+  int16_t *beta16;
+  int16_t *input16;
+  int16_t *parity16;
 } map_gen_t;
 
 typedef struct LIBLTE_API {
@@ -66,11 +129,22 @@ typedef struct LIBLTE_API {
   llr_t *parity;
 
   tc_interl_t interleaver;
+  uint32_t interl_long_cb;    // code block size the interleaver was generated for
+
+  /* early stopping */
+  tdec_stop_t stop;
+  char *hd_prev;              // hard decisions of the previous iteration (interleaved order)
+  char *ext_prev;             // signs of the extrinsic LLRs of the previous iteration
+  uint32_t nof_checks;
 } tdec_t;
 
 LIBLTE_API int tdec_init(tdec_t * h, 
                          uint32_t max_long_cb);
 
+LIBLTE_API int tdec_init_opts(tdec_t * h, 
+                              uint32_t max_long_cb, 
+                              tdec_opts_t *opts);
+
 LIBLTE_API void tdec_free(tdec_t * h);
 
 LIBLTE_API int tdec_reset(tdec_t * h, uint32_t long_cb);
@@ -79,6 +153,12 @@ LIBLTE_API void tdec_iteration(tdec_t * h,
                                llr_t * input, 
                                uint32_t long_cb);
 
+LIBLTE_API void tdec_set_stop(tdec_t * h, 
+                              tdec_stop_t *stop);
+
+LIBLTE_API bool tdec_stop_check(tdec_t * h, 
+                                uint32_t long_cb);
+
 LIBLTE_API void tdec_decision(tdec_t * h, 
                               char *output, 
                               uint32_t long_cb);
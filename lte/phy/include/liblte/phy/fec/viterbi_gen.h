@@ -0,0 +1,125 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef VITERBI_GEN_
+#define VITERBI_GEN_
+
+/*******************************************************
+ *
+ * Generic Viterbi decoder.
+ *
+ * Decodes convolutional codes of any constraint length up to 
+ * VITERBI_GEN_MAX_K, rate 1/R with R up to 3 and any set of generator 
+ * polynomials, with the same bit conventions as convcoder_t. 
+ * 
+ * Path metrics are 16-bit integers and every trellis step runs as loops over 
+ * the states, which the compiler vectorizes. Tail biting codes are decoded by 
+ * circular wrap-around: the trellis is run over the last wrap bits of the 
+ * frame, the frame and its first wrap bits, starting with all states equally 
+ * likely, and the frame bits are traced back from the best final state. 
+ *
+ * Soft symbols are positive for bit 1 and are multiplied by gain and clipped 
+ * to +-VITERBI_GEN_MAX_SYMBOL before decoding.
+ *
+ * With soft output enabled, the decoder also keeps the difference between the 
+ * metrics of the two paths merging at every step and state. The reliability 
+ * of a frame is the smallest of these differences along the decoded path, 
+ * i.e. the metric distance to the closest competing path, divided by twice 
+ * the mean magnitude of the input symbols. It is roughly the number of coded 
+ * bits in which that competitor differs: up to the free distance of the code
+ * for clean frames and close to 0 for noise.
+ ********************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "liblte/config.h"
+
+#define VITERBI_GEN_MAX_K       9
+#define VITERBI_GEN_MAX_R       3
+#define VITERBI_GEN_MAX_WRAP    96
+#define VITERBI_GEN_MAX_SYMBOL  127
+
+typedef struct LIBLTE_API {
+  uint32_t K;
+  uint32_t R;
+  uint32_t poly[VITERBI_GEN_MAX_R];
+  bool tail_biting;
+  uint32_t max_frame_length;
+  uint32_t nof_states;
+  uint32_t wrap;
+  float gain;
+
+  int16_t *sign;                // +1/-1 per coded bit of each transition
+  int16_t *bm;                  // branch metrics of the current step
+  int16_t *metric[2];           // path metrics, swapped every step
+  uint8_t *decision;            // surviving predecessor per step and state
+  int16_t *symbols;             // quantized input
+
+  /* soft output */
+  int16_t *margin;              // metric difference per step and state
+  float reliability;            // of the last decoded frame
+}viterbi_gen_t;
+
+LIBLTE_API int viterbi_gen_init(viterbi_gen_t *q, 
+                                uint32_t K, 
+                                uint32_t R, 
+                                uint32_t poly[VITERBI_GEN_MAX_R], 
+                                uint32_t max_frame_length, 
+                                bool tail_biting);
+
+LIBLTE_API void viterbi_gen_free(viterbi_gen_t *q);
+
+LIBLTE_API int viterbi_gen_set_gain(viterbi_gen_t *q, 
+                                    float gain);
+
+LIBLTE_API int viterbi_gen_set_wrap(viterbi_gen_t *q, 
+                                    uint32_t wrap);
+
+LIBLTE_API int viterbi_gen_set_soft_output(viterbi_gen_t *q, 
+                                           bool enable);
+
+LIBLTE_API float viterbi_gen_reliability(viterbi_gen_t *q);
+
+LIBLTE_API int viterbi_gen_decode(viterbi_gen_t *q, 
+                                  float *symbols, 
+                                  char *data, 
+                                  uint32_t frame_length);
+
+LIBLTE_API int viterbi_gen_decode_s(viterbi_gen_t *q, 
+                                    int16_t *symbols, 
+                                    char *data, 
+                                    uint32_t frame_length);
+
+LIBLTE_API int viterbi_gen_decode_batch(viterbi_gen_t *q, 
+                                        float **symbols, 
+                                        char **data, 
+                                        uint32_t nof_frames, 
+                                        uint32_t frame_length);
+
+#endif
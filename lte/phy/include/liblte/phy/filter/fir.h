@@ -0,0 +1,68 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef FIR_
+#define FIR_
+
+#include <stdint.h>
+
+#include "liblte/config.h"
+
+/* FIR filter design helpers.
+ *
+ * Lowpass filters are designed with the window method and a Kaiser window.
+ * Frequencies are normalized to the sampling rate (0.5 is Nyquist).
+ */
+
+/* Kaiser window beta that gives atten_db of stopband attenuation */
+LIBLTE_API float fir_kaiser_beta(float atten_db);
+
+/* Number of taps that gives atten_db of stopband attenuation with a transition 
+ * band of width transition 
+ */
+LIBLTE_API uint32_t fir_kaiser_len(float atten_db, 
+                                   float transition);
+
+/* Lowpass of nof_taps taps with the -6 dB point at cutoff and unity DC gain */
+LIBLTE_API int fir_lowpass(float *taps, 
+                           uint32_t nof_taps, 
+                           float cutoff, 
+                           float beta);
+
+/* Complex taps of the lowpass taps shifted to center frequency freq */
+LIBLTE_API void fir_shift(float *taps, 
+                          _Complex float *taps_c, 
+                          uint32_t nof_taps, 
+                          float freq);
+
+/* Magnitude of the frequency response at freq, in dB */
+LIBLTE_API float fir_gain_db(float *taps, 
+                             uint32_t nof_taps, 
+                             float freq);
+
+#endif // FIR_
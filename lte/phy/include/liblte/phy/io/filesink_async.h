@@ -0,0 +1,109 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+
+#ifndef FILESINK_ASYNC_
+#define FILESINK_ASYNC_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/io/format.h"
+
+/* Asynchronous sink of binary samples.
+ *
+ * filesink_async_write() only copies the samples into a pool of buffers
+ * allocated at init; a background thread writes every full buffer with a
+ * single write(). It never blocks nor calls into the kernel, except to wake
+ * up the writer when a buffer is full, so it can be called from the receive
+ * loop. Buffers are aligned so that the file can be opened with O_DIRECT,
+ * bypassing the page cache.
+ *
+ * If the writer falls behind and all the buffers are full, the samples are
+ * dropped and counted: the caller is never delayed. An overflow is a run of
+ * consecutive writes that were dropped, fully or partially.
+ */
+
+#define FILESINK_ASYNC_ALIGN          4096
+#define FILESINK_ASYNC_BUFFER_SIZE    (1024*1024)
+#define FILESINK_ASYNC_NOF_BUFFERS    32
+
+typedef struct LIBLTE_API {
+  int fd;
+  bool direct;                // file opened with O_DIRECT
+  uint32_t sample_size;
+  uint32_t buffer_size;       // bytes, multiple of FILESINK_ASYNC_ALIGN
+  uint32_t nof_buffers;
+  void **buffers;
+  uint32_t *buffer_len;       // bytes to write of each buffer
+
+  /* buffer head % nof_buffers is filled by the caller, buffers tail to
+   * head - 1 are written by the writer thread */
+  uint32_t head;
+  uint32_t tail;
+  uint32_t fill;              // bytes in the buffer being filled
+  bool dropping;
+
+  uint64_t nof_samples;       // samples passed to filesink_async_write()
+  uint64_t nof_dropped;
+  uint32_t nof_overflows;
+  uint32_t max_pending;       // maximum number of full buffers waiting
+  uint64_t nof_bytes_written;
+  bool write_error;
+
+  pthread_t thread;
+  bool thread_running;
+  bool stop;
+  pthread_mutex_t mutex;
+  pthread_cond_t cvar;
+}filesink_async_t;
+
+LIBLTE_API int filesink_async_init(filesink_async_t *q,
+                                   char *filename,
+                                   data_type_t type,
+                                   uint32_t buffer_size,
+                                   uint32_t nof_buffers,
+                                   bool direct);
+
+LIBLTE_API void filesink_async_free(filesink_async_t *q);
+
+LIBLTE_API int filesink_async_write(filesink_async_t *q,
+                                    void *buffer,
+                                    uint32_t nsamples);
+
+LIBLTE_API uint64_t filesink_async_nof_dropped(filesink_async_t *q);
+
+LIBLTE_API uint32_t filesink_async_nof_overflows(filesink_async_t *q);
+
+LIBLTE_API uint32_t filesink_async_max_pending(filesink_async_t *q);
+
+LIBLTE_API bool filesink_async_error(filesink_async_t *q);
+
+#endif // FILESINK_ASYNC_
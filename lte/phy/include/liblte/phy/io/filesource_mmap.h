@@ -0,0 +1,86 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+
+#ifndef FILESOURCE_MMAP_
+#define FILESOURCE_MMAP_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/io/format.h"
+
+typedef _Complex float cf_t;
+
+/* Memory-mapped source of binary IQ samples.
+ *
+ * The whole file is mapped read-only and the kernel is told that it will be
+ * read sequentially, so it reads ahead aggressively and opening a capture of
+ * any size takes no time. COMPLEX_FLOAT_BIN files are accessed in place:
+ * filesource_mmap_get() returns a pointer into the mapping. COMPLEX_SHORT_BIN
+ * samples are converted to complex float, scaled to [-1, 1), into an internal
+ * buffer. Any sample or subframe can be accessed with filesource_mmap_seek().
+ */
+typedef struct LIBLTE_API {
+  int fd;
+  void *map;
+  size_t map_len;
+  data_type_t type;
+  uint64_t nof_samples;
+  uint64_t pos;              // next sample
+  cf_t *buffer;              // converted COMPLEX_SHORT_BIN samples
+  uint32_t buffer_len;
+}filesource_mmap_t;
+
+LIBLTE_API int filesource_mmap_init(filesource_mmap_t *q,
+                                    char *filename,
+                                    data_type_t type);
+
+LIBLTE_API void filesource_mmap_free(filesource_mmap_t *q);
+
+LIBLTE_API uint64_t filesource_mmap_nof_samples(filesource_mmap_t *q);
+
+LIBLTE_API uint64_t filesource_mmap_tell(filesource_mmap_t *q);
+
+LIBLTE_API int filesource_mmap_seek(filesource_mmap_t *q,
+                                    uint64_t sample);
+
+LIBLTE_API int filesource_mmap_seek_sf(filesource_mmap_t *q,
+                                       uint32_t nsubframe,
+                                       uint32_t nof_prb);
+
+LIBLTE_API int filesource_mmap_get(filesource_mmap_t *q,
+                                   cf_t **samples,
+                                   uint32_t nsamples);
+
+LIBLTE_API int filesource_mmap_read(filesource_mmap_t *q,
+                                    cf_t *buffer,
+                                    uint32_t nsamples);
+
+#endif // FILESOURCE_MMAP_
@@ -0,0 +1,158 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+
+#ifndef SIGMF_
+#define SIGMF_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/io/format.h"
+#include "liblte/phy/io/filesink_async.h"
+#include "liblte/phy/io/filesource_mmap.h"
+#include "liblte/phy/sync/cfo.h"
+
+/* SigMF recordings.
+ *
+ * A recording is a pair of files: <name>.sigmf-data with the raw samples
+ * (cf32_le or ci16_le) and <name>.sigmf-meta, a JSON document with the sample
+ * rate, the center frequency, the cell and its PHICH configuration, and one
+ * annotation per subframe aligned by ue_sync. Annotations use the "liblte"
+ * extension namespace to store the subframe index, the SFN (when known), the
+ * cell ID, the CFO that ue_sync corrected and whether the PSS was detected in
+ * that subframe.
+ *
+ * sigmf_sink_t writes recordings. The samples are written by a filesink_async_t
+ * thread so that recording does not slow down the receiver; if the disk
+ * cannot keep up, samples are dropped and the annotations of the subframes
+ * that lost samples are discarded, so the remaining ones still point to their
+ * subframes. The metadata is kept in memory and written by sigmf_sink_free().
+ *
+ * sigmf_source_t replays recordings: it uses the annotations as an index of
+ * aligned subframes, so decoding can start at any subframe without running the
+ * cell search and synchronization again.
+ */
+
+#define SIGMF_SFN_UNKNOWN   -1
+
+typedef struct LIBLTE_API {
+  data_type_t type;           // COMPLEX_FLOAT_BIN or COMPLEX_SHORT_BIN
+  double sample_rate;
+  double frequency;           // center frequency, 0 if unknown
+  lte_cell_t cell;            // nof_prb is 0 if the cell is unknown
+  phich_resources_t phich_resources;
+  phich_length_t phich_length;
+}sigmf_meta_t;
+
+typedef struct LIBLTE_API {
+  uint64_t sample_start;
+  uint32_t sample_count;
+  uint32_t sf_idx;
+  int sfn;                    // SIGMF_SFN_UNKNOWN if not known
+  uint32_t cell_id;
+  float cfo;                  // Hz
+  bool pss;                   // PSS detected in this subframe
+}sigmf_annotation_t;
+
+/* Each sink allocates and clears NOF_BUFFERS x BUFFER_SIZE bytes (32 MB) */
+#define SIGMF_SINK_BUFFER_SIZE    (1024*1024)
+#define SIGMF_SINK_NOF_BUFFERS    32
+
+typedef struct LIBLTE_API {
+  filesink_async_t fsink;
+  char *meta_file_name;
+  sigmf_meta_t meta;
+  uint64_t nof_samples;       // samples passed to sigmf_sink_write()
+  uint64_t nof_dropped;
+  uint64_t drop_end;          // sample after the last one dropped
+  bool last_annotated;
+  sigmf_annotation_t *annotations;
+  uint32_t nof_annotations;
+  uint32_t max_annotations;
+  int16_t *buffer;            // samples converted to ci16
+  uint32_t buffer_len;
+}sigmf_sink_t;
+
+typedef struct LIBLTE_API {
+  filesource_mmap_t fsrc;
+  sigmf_meta_t meta;
+  sigmf_annotation_t *annotations;
+  uint32_t nof_annotations;
+  uint32_t next;              // next annotation to deliver
+  cfo_t cfocorr;
+  cf_t *buffer;               // CFO corrected subframe
+  uint32_t buffer_len;
+}sigmf_source_t;
+
+LIBLTE_API int sigmf_sink_init(sigmf_sink_t *q,
+                               char *base_name,
+                               sigmf_meta_t *meta);
+
+LIBLTE_API void sigmf_sink_free(sigmf_sink_t *q);
+
+LIBLTE_API void sigmf_sink_set_cell(sigmf_sink_t *q,
+                                    lte_cell_t cell);
+
+LIBLTE_API uint64_t sigmf_sink_nof_samples(sigmf_sink_t *q);
+
+LIBLTE_API uint64_t sigmf_sink_nof_dropped(sigmf_sink_t *q);
+
+LIBLTE_API int sigmf_sink_write(sigmf_sink_t *q,
+                                cf_t *samples,
+                                uint32_t nsamples);
+
+LIBLTE_API int sigmf_sink_annotate(sigmf_sink_t *q,
+                                   sigmf_annotation_t *annotation);
+
+LIBLTE_API void sigmf_sink_set_sfn(sigmf_sink_t *q,
+                                   uint32_t sfn);
+
+LIBLTE_API int sigmf_sink_write_meta(sigmf_sink_t *q);
+
+LIBLTE_API int sigmf_source_init(sigmf_source_t *q,
+                                 char *file_name);
+
+LIBLTE_API void sigmf_source_free(sigmf_source_t *q);
+
+LIBLTE_API uint32_t sigmf_source_nof_sf(sigmf_source_t *q);
+
+LIBLTE_API int sigmf_source_seek(sigmf_source_t *q,
+                                 uint32_t sf);
+
+LIBLTE_API int sigmf_source_seek_sfn(sigmf_source_t *q,
+                                     uint32_t sfn,
+                                     uint32_t sf_idx);
+
+LIBLTE_API int sigmf_source_get_sf(sigmf_source_t *q,
+                                   cf_t **samples,
+                                   sigmf_annotation_t **annotation);
+
+#endif // SIGMF_
@@ -50,6 +50,10 @@ LIBLTE_API int precoding_type(cf_t *x[MAX_LAYERS], cf_t *y[MAX_PORTS], int nof_l
 LIBLTE_API int predecoding_single_zf(cf_t *y, cf_t *ce, cf_t *x, int nof_symbols);
 LIBLTE_API int predecoding_diversity_zf(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
     int nof_ports, int nof_symbols);
+LIBLTE_API int predecoding_single_mmse(cf_t *y, cf_t *ce, cf_t *x, float *sinr, 
+    int nof_symbols, float noise_estimate);
+LIBLTE_API int predecoding_diversity_mmse(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
+    float *sinr, int nof_ports, int nof_symbols, float noise_estimate);
 LIBLTE_API int predecoding_type(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
     int nof_ports, int nof_layers, int nof_symbols, lte_mimo_type_t type);
 
@@ -48,6 +48,8 @@ LIBLTE_API void demod_soft_table_set(demod_soft_t *q, modem_table_t *table);
 LIBLTE_API void demod_soft_alg_set(demod_soft_t *q, enum alg alg_type);
 LIBLTE_API void demod_soft_sigma_set(demod_soft_t *q, float sigma);
 LIBLTE_API int demod_soft_demodulate(demod_soft_t *q, const cf_t* symbols, float* llr, int nsymbols);
+LIBLTE_API int demod_soft_demodulate_weighted(demod_soft_t *q, const cf_t* symbols, const float *weights, 
+                                              float* llr, int nsymbols);
 
 
 /* High-level API */
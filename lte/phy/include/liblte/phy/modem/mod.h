@@ -39,6 +39,28 @@ typedef _Complex float cf_t;
 
 LIBLTE_API int mod_modulate(modem_table_t* table, const char *bits, cf_t* symbols, uint32_t nbits);
 
+/* Scrambles and modulates a bit sequence in a single pass. The sequence may be 
+ * delivered in pieces of any length (e.g. one code block at a time), a symbol
+ * can span two pieces.
+ */
+typedef struct LIBLTE_API {
+  modem_table_t *table;
+  char *c;              // scrambling bit of the next input bit
+  cf_t *symbols;        // first output symbol
+  uint32_t nof_symbols; // symbols written so far
+  uint32_t acc;         // bits of the incomplete symbol
+  uint32_t nof_acc;     
+} mod_stream_t;
+
+LIBLTE_API void mod_stream_init(mod_stream_t *s, 
+                                modem_table_t *table, 
+                                char *c, 
+                                cf_t *symbols);
+
+LIBLTE_API void mod_stream_bits(mod_stream_t *s, 
+                                const char *bits, 
+                                uint32_t nbits);
+
 /* High-level API */
 typedef struct LIBLTE_API {
   modem_table_t obj;
@@ -40,6 +40,7 @@
 #include "liblte/phy/fec/convcoder.h"
 #include "liblte/phy/fec/viterbi.h"
 #include "liblte/phy/fec/crc.h"
+#include "liblte/phy/phch/re_map.h"
 
 #define PBCH_RE_CPNORM    240
 #define PBCH_RE_CPEXT    216
@@ -68,16 +69,17 @@ typedef struct LIBLTE_API {
   float *pbch_llr;
   float *temp;
   float *pbch_rm_f;
-  char *pbch_rm_b;
   char *data;
   char *data_enc;
 
   uint32_t frame_idx;
+  re_map_t re_map;
 
   /* tx & rx objects */
   modem_table_t mod;
   demod_soft_t demod;
   sequence_t seq_pbch;
+  rm_conv_t rm_conv;
   viterbi_t decoder;
   crc_t crc;
   convcoder_t encoder;
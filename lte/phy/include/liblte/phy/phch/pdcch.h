@@ -37,7 +37,7 @@
 #include "liblte/phy/scrambling/scrambling.h"
 #include "liblte/phy/fec/rm_conv.h"
 #include "liblte/phy/fec/convcoder.h"
-#include "liblte/phy/fec/viterbi.h"
+#include "liblte/phy/fec/viterbi_gen.h"
 #include "liblte/phy/fec/crc.h"
 #include "liblte/phy/phch/dci.h"
 #include "liblte/phy/phch/regs.h"
@@ -72,8 +72,14 @@ typedef struct LIBLTE_API {
   modem_table_t mod;
   demod_soft_t demod;
   sequence_t seq_pdcch[NSUBFRAMES_X_FRAME];
-  viterbi_t decoder;
+  rm_conv_t rm_conv;
+  viterbi_gen_t decoder;
   crc_t crc;
+
+  /* candidates less reliable than the threshold are rejected before the CRC */
+  float reliability_threshold;
+  float last_reliability;
+  uint32_t nof_rejected;
 } pdcch_t;
 
 LIBLTE_API int pdcch_init(pdcch_t *q, 
@@ -106,6 +112,15 @@ LIBLTE_API int pdcch_decode_msg(pdcch_t *q,
                                 dci_format_t format,
                                 uint16_t *crc_rem);
 
+/* Rejects candidates with reliability below threshold (see viterbi_gen.h).
+ * 0 disables the check */
+LIBLTE_API int pdcch_set_reliability_threshold(pdcch_t *q, 
+                                               float threshold);
+
+/* Reliability of the last candidate decoded by pdcch_decode_msg(), computed 
+ * whether or not the threshold is enabled */
+LIBLTE_API float pdcch_get_reliability(pdcch_t *q);
+
 /* Function for generation of UE-specific search space DCI locations */
 LIBLTE_API uint32_t pdcch_ue_locations(pdcch_t *q, 
                                        dci_location_t *locations, 
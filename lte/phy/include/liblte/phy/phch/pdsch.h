@@ -42,9 +42,14 @@
 #include "liblte/phy/fec/crc.h"
 #include "liblte/phy/phch/dci.h"
 #include "liblte/phy/phch/regs.h"
+#include "liblte/phy/phch/re_map.h"
 
 #define TDEC_MAX_ITERATIONS         6
 
+#define PDSCH_RE_MAP_CACHE          8
+#define PDSCH_TB_PLAN_CACHE         16
+#define PDSCH_MAX_CB                13  // code blocks of the largest TBS of one layer
+
 typedef _Complex float cf_t;
 
 typedef struct LIBLTE_API {
@@ -68,6 +73,53 @@ typedef struct LIBLTE_API {
   
 } pdsch_harq_t;
 
+/* When to stop the turbo decoder iterations of each code block */
+typedef enum {
+  PDSCH_STOP_CRC = 0,           // check the CB CRC (TB CRC if there is one CB) after every iteration
+  PDSCH_STOP_DECODER,           // stop when the decoder criteria are met, never check the CB CRC
+  PDSCH_STOP_DECODER_AND_CRC    // check the CRC only after the decoder criteria are met
+} pdsch_stop_policy_t;
+
+/* Early stopping counters, per code block */
+typedef struct LIBLTE_API {
+  uint64_t nof_cb;
+  uint64_t nof_iterations;
+  uint64_t nof_crc_checks;
+  uint64_t stop_crc;            // stopped because the CRC passed
+  uint64_t stop_decoder;        // stopped by the decoder criteria (PDSCH_STOP_DECODER)
+  uint64_t stop_max;            // ran TDEC_MAX_ITERATIONS iterations
+} pdsch_stop_stats_t;
+
+/* RE map compiled for one (allocation, subframe) pair */
+typedef struct LIBLTE_API {
+  bool valid;
+  uint32_t hash;
+  uint32_t subframe;
+  ra_prb_t prb_alloc;
+  re_map_t map;
+} pdsch_re_map_t;
+
+/* Lengths and offsets of one code block of a transport block */
+typedef struct LIBLTE_API {
+  uint32_t cb_len;              // K
+  uint32_t rlen;                // K minus the CB CRC, if any
+  uint32_t F;                   // filler bits at the start of the code block
+  uint32_t e;                   // rate matched bits
+  uint32_t tb_offset;           // position of the first data bit in the transport block
+  uint32_t e_offset;            // position of the first rate matched bit
+} pdsch_cb_plan_t;
+
+/* Code block segmentation and rate matching lengths of a transport block of
+ * tbs bits rate matched to nb_e bits
+ */
+typedef struct LIBLTE_API {
+  bool valid;
+  uint32_t tbs;
+  uint32_t nb_e;
+  struct cb_segm cb_segm;
+  pdsch_cb_plan_t cb[PDSCH_MAX_CB];
+} pdsch_tb_plan_t;
+
 /* PDSCH object */
 typedef struct LIBLTE_API {
   lte_cell_t cell;
@@ -78,6 +130,9 @@ typedef struct LIBLTE_API {
   uint32_t nof_iterations; 
   uint64_t average_nof_iterations_n; 
   float average_nof_iterations; 
+  float noise_estimate; 
+  pdsch_stop_policy_t stop_policy;
+  pdsch_stop_stats_t stop_stats;
   
   /* buffers */
   // void buffers are shared for tx and rx
@@ -85,6 +140,7 @@ typedef struct LIBLTE_API {
   cf_t *pdsch_symbols[MAX_PORTS];
   cf_t *pdsch_x[MAX_PORTS];
   cf_t *pdsch_d;
+  float *pdsch_sinr;
   char *cb_in; 
   void *cb_out;  
   void *pdsch_e;
@@ -97,6 +153,13 @@ typedef struct LIBLTE_API {
   tdec_t decoder;  
   crc_t crc_tb;
   crc_t crc_cb;
+  
+  /* RE maps of the most recently used allocations */
+  pdsch_re_map_t re_map[PDSCH_RE_MAP_CACHE];
+  uint32_t re_map_next;
+
+  /* TB plans, indexed by the hash of (tbs, nb_e) */
+  pdsch_tb_plan_t tb_plan[PDSCH_TB_PLAN_CACHE];
 }pdsch_t;
 
 LIBLTE_API int pdsch_init(pdsch_t *q, 
@@ -107,6 +170,9 @@ LIBLTE_API void pdsch_free(pdsch_t *q);
 LIBLTE_API int pdsch_set_rnti(pdsch_t *q, 
                                uint16_t rnti);
 
+LIBLTE_API void pdsch_set_noise_estimate(pdsch_t *q, 
+                                          float noise_estimate);
+
 LIBLTE_API int pdsch_harq_init(pdsch_harq_t *p, 
                                pdsch_t *pdsch);
 
@@ -123,6 +189,14 @@ LIBLTE_API int pdsch_encode(pdsch_t *q,
                             pdsch_harq_t *harq_process, 
                             uint32_t rv_idx);
 
+LIBLTE_API int pdsch_encode_seq(pdsch_t *q, 
+                                char *data, 
+                                cf_t *sf_symbols[MAX_PORTS],
+                                uint32_t nsubframe,
+                                pdsch_harq_t *harq_process, 
+                                uint32_t rv_idx,
+                                sequence_t *seq);
+
 LIBLTE_API int pdsch_decode(pdsch_t *q, 
                             cf_t *sf_symbols, 
                             cf_t *ce[MAX_PORTS],
@@ -131,8 +205,15 @@ LIBLTE_API int pdsch_decode(pdsch_t *q,
                             pdsch_harq_t *harq_process, 
                             uint32_t rv_idx);
 
+LIBLTE_API int pdsch_set_early_stop(pdsch_t *q, 
+                                     pdsch_stop_policy_t policy, 
+                                     tdec_stop_t *criteria);
+
 LIBLTE_API float pdsch_average_noi(pdsch_t *q); 
 
+LIBLTE_API void pdsch_stop_stats(pdsch_t *q, 
+                                 pdsch_stop_stats_t *stats);
+
 LIBLTE_API uint32_t pdsch_last_noi(pdsch_t *q); 
 
 LIBLTE_API int pdsch_get(pdsch_t *q, 
@@ -141,4 +222,18 @@ LIBLTE_API int pdsch_get(pdsch_t *q,
                          ra_prb_t *prb_alloc, 
                          uint32_t subframe);
 
+LIBLTE_API int pdsch_put(pdsch_t *q, 
+                         cf_t *pdsch_symbols, 
+                         cf_t *sf_symbols,
+                         ra_prb_t *prb_alloc, 
+                         uint32_t subframe);
+
+LIBLTE_API re_map_t* pdsch_re_map(pdsch_t *q, 
+                                  ra_prb_t *prb_alloc, 
+                                  uint32_t subframe);
+
+LIBLTE_API pdsch_tb_plan_t* pdsch_tb_plan(pdsch_t *q, 
+                                          uint32_t tbs, 
+                                          uint32_t nb_e);
+
 #endif
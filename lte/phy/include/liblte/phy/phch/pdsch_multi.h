@@ -0,0 +1,107 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef PDSCH_MULTI_
+#define PDSCH_MULTI_
+
+/*******************************************************
+ *
+ * Multi-user PDSCH encoder.
+ *
+ * Encodes the transport blocks of all the users scheduled in one subframe in
+ * parallel. Each thread owns a pdsch_t, which holds its scratch buffers
+ * (code blocks, rate matching output, symbols) and its RE map cache, and a
+ * scrambling sequence generated for the RNTI of each grant it picks up.
+ * Since allocations of different grants must not overlap, every thread maps
+ * its symbols directly into the shared resource grid.
+ ********************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/common/sequence.h"
+#include "liblte/phy/phch/pdsch.h"
+#include "liblte/phy/phch/ra.h"
+
+#define PDSCH_MULTI_MAX_THREADS   16
+
+/* One transport block to encode. ra_dl gives the RNTI, the allocation (with
+ * re_sf already computed by ra_prb_get_re_dl()), the MCS and the redundancy
+ * version. For new transmissions (rv_idx 0) the HARQ process is configured
+ * from ra_dl, retransmissions use the configuration of the last new one.
+ */
+typedef struct LIBLTE_API {
+  ra_pdsch_t *ra_dl;
+  pdsch_harq_t *harq_process;
+  char *data;
+  int ret;                      // result of the encoding of this grant
+} pdsch_grant_t;
+
+typedef struct LIBLTE_API {
+  void *parent;                 // pdsch_multi_t this worker belongs to
+  pdsch_t pdsch;
+  sequence_t seq;
+  pthread_t thread;
+  bool thread_running;
+} pdsch_multi_worker_t;
+
+typedef struct LIBLTE_API {
+  lte_cell_t cell;
+  uint32_t nof_threads;
+  pdsch_multi_worker_t workers[PDSCH_MULTI_MAX_THREADS];
+
+  /* current job */
+  pdsch_grant_t *grants;
+  uint32_t nof_grants;
+  uint32_t next_grant;
+  uint32_t nof_done;
+  cf_t *sf_symbols[MAX_PORTS];
+  uint32_t subframe;
+  uint32_t job_id;
+  bool stop;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cvar_job;
+  pthread_cond_t cvar_done;
+}pdsch_multi_t;
+
+LIBLTE_API int pdsch_multi_init(pdsch_multi_t *q,
+                                lte_cell_t cell,
+                                uint32_t nof_threads);
+
+LIBLTE_API void pdsch_multi_free(pdsch_multi_t *q);
+
+LIBLTE_API int pdsch_multi_encode(pdsch_multi_t *q,
+                                  pdsch_grant_t *grants,
+                                  uint32_t nof_grants,
+                                  cf_t *sf_symbols[MAX_PORTS],
+                                  uint32_t subframe);
+
+#endif
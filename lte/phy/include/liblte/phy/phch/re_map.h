@@ -0,0 +1,80 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef _RE_MAP_H_
+#define _RE_MAP_H_
+
+#include <stdint.h>
+#include "liblte/config.h"
+
+typedef _Complex float cf_t;
+
+/* Resource element map.
+ *
+ * Stores, in mapping order, the position in the resource grid of every RE
+ * occupied by a physical channel. Positions are grouped in runs of contiguous
+ * RE, so that put/get become a sequence of block copies instead of walking
+ * the PRB/reference signal structure each time.
+ */
+typedef struct LIBLTE_API {
+  uint32_t max_re;
+  uint32_t nof_re;
+  uint32_t nof_runs;
+  uint32_t *run_start;   // grid index of the first RE of each run
+  uint32_t *run_len;     // number of contiguous RE in each run
+}re_map_t;
+
+LIBLTE_API int re_map_init(re_map_t *q,
+                           uint32_t max_re);
+
+LIBLTE_API void re_map_free(re_map_t *q);
+
+LIBLTE_API void re_map_reset(re_map_t *q);
+
+LIBLTE_API int re_map_push(re_map_t *q,
+                           uint32_t idx);
+
+LIBLTE_API int re_map_trace(re_map_t *q,
+                            int (*cp_fn)(void *arg, cf_t *grid, cf_t *symbols),
+                            void *arg,
+                            uint32_t grid_len);
+
+LIBLTE_API int re_map_get(re_map_t *q,
+                          cf_t *grid,
+                          cf_t *symbols);
+
+LIBLTE_API int re_map_put(re_map_t *q,
+                          cf_t *symbols,
+                          cf_t *grid);
+
+LIBLTE_API int re_map_get_multi(re_map_t *q,
+                                cf_t **grid,
+                                cf_t **symbols,
+                                uint32_t nof_buffers);
+
+#endif // _RE_MAP_H_
@@ -54,6 +54,7 @@ typedef struct LIBLTE_API {
 typedef struct LIBLTE_API {
   uint32_t nof_regs;
   regs_reg_t **regs;
+  uint32_t *re_idx; // flat RE index table, REGS_RE_X_REG entries per REG
 }regs_ch_t;
 
 typedef struct LIBLTE_API {
@@ -70,6 +71,7 @@ typedef struct LIBLTE_API {
   regs_ch_t *phich; // there are several phich
   regs_ch_t pdcch[3]; /* PDCCH indexing, permutation and interleaving is computed for
             the three possible CFI value */
+  regs_ch_t *pdcch_cur; // PDCCH REGs for the CFI selected with regs_set_cfi()
   
   uint32_t nof_regs;
   regs_reg_t *regs;
@@ -94,6 +96,11 @@ LIBLTE_API int regs_pcfich_get(regs_t *h,
                                cf_t *slot_symbols, 
                                cf_t pcfich_symbols[REGS_PCFICH_NSYM]);
 
+LIBLTE_API int regs_pcfich_get_multi(regs_t *h,
+                                     cf_t **slot_symbols, 
+                                     cf_t **pcfich_symbols, 
+                                     uint32_t nof_buffers);
+
 LIBLTE_API uint32_t regs_phich_nregs(regs_t *h);
 LIBLTE_API int regs_phich_add(regs_t *h, 
                               cf_t phich_symbols[REGS_PHICH_NSYM], 
@@ -105,6 +112,12 @@ LIBLTE_API int regs_phich_get(regs_t *h,
                               cf_t phich_symbols[REGS_PHICH_NSYM], 
                               uint32_t ngroup);
 
+LIBLTE_API int regs_phich_get_multi(regs_t *h, 
+                                    cf_t **slot_symbols, 
+                                    cf_t **phich_symbols, 
+                                    uint32_t ngroup, 
+                                    uint32_t nof_buffers);
+
 LIBLTE_API uint32_t regs_phich_ngroups(regs_t *h);
 LIBLTE_API int regs_phich_reset(regs_t *h, 
                                 cf_t *slot_symbols);
@@ -130,6 +143,13 @@ LIBLTE_API int regs_pdcch_get_offset(regs_t *h,
                                      uint32_t start_reg, 
                                      uint32_t nof_regs);
 
+LIBLTE_API int regs_pdcch_get_offset_multi(regs_t *h, 
+                                           cf_t **slot_symbols, 
+                                           cf_t **pdcch_symbols, 
+                                           uint32_t start_reg, 
+                                           uint32_t nof_regs, 
+                                           uint32_t nof_buffers);
+
 #endif // REGS_H_
 
 
@@ -46,6 +46,7 @@
 #include "liblte/phy/utils/mux.h"
 #include "liblte/phy/utils/cexptab.h"
 #include "liblte/phy/utils/pack.h"
+#include "liblte/phy/utils/trace.h"
 #include "liblte/phy/utils/vector.h"
 
 #include "liblte/phy/common/phy_common.h"
@@ -57,23 +58,32 @@
 #include "liblte/phy/resampling/interp.h"
 #include "liblte/phy/resampling/decim.h"
 #include "liblte/phy/resampling/resample_arb.h"
+#include "liblte/phy/resampling/channelizer.h"
 
+#include "liblte/phy/channel/ch_rand.h"
 #include "liblte/phy/channel/ch_awgn.h"
+#include "liblte/phy/channel/ch_fading.h"
 
 #include "liblte/phy/fec/viterbi.h"
+#include "liblte/phy/fec/viterbi_gen.h"
 #include "liblte/phy/fec/convcoder.h"
 #include "liblte/phy/fec/crc.h"
 #include "liblte/phy/fec/tc_interl.h"
 #include "liblte/phy/fec/turbocoder.h"
 #include "liblte/phy/fec/turbodecoder.h"
+#include "liblte/phy/fec/tdec_batch.h"
 #include "liblte/phy/fec/rm_conv.h"
 #include "liblte/phy/fec/rm_turbo.h"
 
 #include "liblte/phy/filter/filter2d.h"
+#include "liblte/phy/filter/fir.h"
 
 #include "liblte/phy/io/binsource.h"
 #include "liblte/phy/io/filesink.h"
+#include "liblte/phy/io/filesink_async.h"
 #include "liblte/phy/io/filesource.h"
+#include "liblte/phy/io/filesource_mmap.h"
+#include "liblte/phy/io/sigmf.h"
 #include "liblte/phy/io/udpsink.h"
 #include "liblte/phy/io/udpsource.h"
 
@@ -89,6 +99,7 @@
 #include "liblte/phy/phch/dci.h"
 #include "liblte/phy/phch/pdcch.h"
 #include "liblte/phy/phch/pdsch.h"
+#include "liblte/phy/phch/pdsch_multi.h"
 #include "liblte/phy/phch/pbch.h"
 #include "liblte/phy/phch/pcfich.h"
 #include "liblte/phy/phch/phich.h"
@@ -98,8 +109,12 @@
 #include "liblte/phy/ue/ue_celldetect.h"
 #include "liblte/phy/ue/ue_dl.h"
 
+#include "liblte/phy/enb/enb_dl.h"
+
 #include "liblte/phy/scrambling/scrambling.h"
 
+#include "liblte/phy/sim/link_sim.h"
+
 #include "liblte/phy/sync/pss.h"
 #include "liblte/phy/sync/sfo.h"
 #include "liblte/phy/sync/sss.h"
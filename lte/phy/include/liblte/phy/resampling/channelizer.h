@@ -0,0 +1,130 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef CHANNELIZER_
+#define CHANNELIZER_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <complex.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/utils/dft.h"
+
+typedef _Complex float cf_t;
+
+/* Polyphase FFT channelizer.
+ *
+ * Splits a wideband stream in nof_channels channels of equal bandwidth. 
+ * Channel k is centered at k/nof_channels of the input sampling rate 
+ * (channels above nof_channels/2 are the negative frequencies) and is 
+ * decimated by decim, which must divide nof_channels. With 
+ * decim < nof_channels the channels are oversampled, so that the band edges 
+ * are not aliased. 
+ * 
+ * Every output sample of all the channels is computed with nof_taps 
+ * multiplications (one pass of the prototype lowpass over the polyphase 
+ * branches) plus an nof_channels-point DFT.
+ */
+#define CHANNELIZER_MAX_CHANNELS  64
+#define CHANNELIZER_CHUNK         4096
+#define CHANNELIZER_DEFAULT_TAPS  16   // taps per branch of the default prototype
+
+typedef struct LIBLTE_API {
+  uint32_t nof_channels;
+  uint32_t decim;
+  uint32_t nof_branch_taps;  // prototype taps per polyphase branch
+  uint32_t nof_taps;         // nof_branch_taps*nof_channels
+  float *taps;               // for each branch tap, the taps of all branches reversed and repeated for I and Q
+  cf_t *buffer;              // nof_taps-1 samples of history followed by the input chunk
+  uint32_t next;             // start of the window of the next output sample
+  uint32_t rot;              // input index of the next output sample, mod nof_channels
+  float *branch;             // branch outputs, last branch first
+  cf_t *dft_in;
+  cf_t *dft_out;
+  dft_plan_t dft;
+}channelizer_t;
+
+LIBLTE_API int channelizer_init(channelizer_t *q, 
+                                uint32_t nof_channels, 
+                                uint32_t decim, 
+                                float *taps, 
+                                uint32_t nof_taps);
+
+LIBLTE_API void channelizer_free(channelizer_t *q);
+
+LIBLTE_API void channelizer_reset(channelizer_t *q);
+
+LIBLTE_API int channelizer_run(channelizer_t *q, 
+                               cf_t *input, 
+                               uint32_t len, 
+                               cf_t **output);
+
+/* Feeds a set of independent receivers (e.g. one ue_sync_t per channel) from 
+ * a single wideband source. Each receiver pulls its channel through 
+ * channelizer_stream_recv(), which has the signature of the recv callback of 
+ * ue_sync_init(), with a channelizer_port_t as the stream handler. The 
+ * wideband stream is read from recv_callback as needed, and the samples of 
+ * the other channels are queued until their receivers ask for them. 
+ */
+typedef struct LIBLTE_API {
+  void *stream;              // channelizer_stream_t
+  uint32_t channel;
+}channelizer_port_t;
+
+typedef struct LIBLTE_API {
+  channelizer_t chan;
+  int (*recv_callback)(void*, void*, uint32_t);
+  void *recv_handler;
+  cf_t *input;
+  uint32_t fifo_size;
+  cf_t *fifo[CHANNELIZER_MAX_CHANNELS];
+  uint32_t fifo_len[CHANNELIZER_MAX_CHANNELS];
+  uint32_t overflow[CHANNELIZER_MAX_CHANNELS];  // samples dropped because the receiver fell behind
+  channelizer_port_t port[CHANNELIZER_MAX_CHANNELS];
+}channelizer_stream_t;
+
+LIBLTE_API int channelizer_stream_init(channelizer_stream_t *q, 
+                                       uint32_t nof_channels, 
+                                       uint32_t decim, 
+                                       float *taps, 
+                                       uint32_t nof_taps, 
+                                       uint32_t max_recv_len, 
+                                       int (recv_callback)(void*, void*, uint32_t), 
+                                       void *recv_handler);
+
+LIBLTE_API void channelizer_stream_free(channelizer_stream_t *q);
+
+LIBLTE_API channelizer_port_t* channelizer_stream_port(channelizer_stream_t *q, 
+                                                       uint32_t channel);
+
+LIBLTE_API int channelizer_stream_recv(void *h, 
+                                       void *data, 
+                                       uint32_t nsamples);
+
+#endif // CHANNELIZER_
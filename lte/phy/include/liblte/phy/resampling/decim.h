@@ -26,7 +26,10 @@
  */
 
 #ifndef DECIM_H
-#define DECIM_H_
+#define DECIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
 
 #include "liblte/config.h"
 
@@ -36,4 +39,40 @@ typedef _Complex float cf_t;
 LIBLTE_API void decim_c(cf_t *input, cf_t *output, int M, int len);
 LIBLTE_API void decim_f(float *input, float *output, int M, int len);
 
+/* Polyphase FIR decimator. Only the samples that are kept are filtered, so 
+ * the cost is nof_taps multiplications per output sample. Taps may be real or 
+ * complex (e.g. a lowpass shifted to select a band off DC). Samples are kept 
+ * across calls, so a stream can be decimated in blocks of any size. 
+ */
+#define DECIM_FIR_CHUNK   1024
+
+typedef struct LIBLTE_API {
+  uint32_t M;
+  uint32_t nof_taps;         // padded to an even number
+  bool complex_taps;
+  float *taps_re;            // real part of the taps, reversed and repeated for I and Q
+  float *taps_im;            // imaginary part, only with complex taps
+  cf_t *buffer;              // nof_taps-1 samples of history followed by the input chunk
+  uint32_t next;             // start of the window of the next output sample
+}decim_fir_t;
+
+LIBLTE_API int decim_fir_init(decim_fir_t *q, 
+                              uint32_t M, 
+                              float *taps, 
+                              uint32_t nof_taps);
+
+LIBLTE_API int decim_fir_init_c(decim_fir_t *q, 
+                                uint32_t M, 
+                                cf_t *taps, 
+                                uint32_t nof_taps);
+
+LIBLTE_API void decim_fir_free(decim_fir_t *q);
+
+LIBLTE_API void decim_fir_reset(decim_fir_t *q);
+
+LIBLTE_API int decim_fir_run(decim_fir_t *q, 
+                             cf_t *input, 
+                             cf_t *output, 
+                             uint32_t len);
+
 #endif // DECIM_H
@@ -29,6 +29,7 @@
 #define RESAMPLE_ARB_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <complex.h>
 
 #include "liblte/config.h"
@@ -48,4 +49,39 @@ typedef struct LIBLTE_API {
 LIBLTE_API void resample_arb_init(resample_arb_t *q, float rate);
 LIBLTE_API int resample_arb_compute(resample_arb_t *q, cf_t *input, cf_t *output, int n_in);
 
+/* Block resampler with the same polyphase filter. The rate is approximated by 
+ * interp/decim, with decim up to RESAMPLE_ARB_MAX_DECIM, and the output instants 
+ * are tracked with an exact fixed-point phase accumulator, thus the output 
+ * never drifts from n_in*rate samples. The filter taps are linearly 
+ * interpolated between adjacent phases. Since the output instants repeat every 
+ * interp samples, the interpolated taps of each of them are computed once when 
+ * interp is small enough.
+ */
+#define RESAMPLE_ARB_MAX_DECIM  65536
+#define RESAMPLE_ARB_MAX_PHASES 2048  // interpolated taps are precomputed up to this interp
+
+typedef struct LIBLTE_API {
+  float rate;
+  uint32_t interp;                        // rate = interp/decim
+  uint32_t decim;
+  uint32_t step_int;                      // input samples per output sample, integer part
+  uint32_t step_frac;                     // fractional part, Q0.32
+  uint32_t step_rem;                      // what step_frac truncated, in 1/interp units
+  uint32_t frac;                          // output instant past the last input sample, Q0.32
+  uint32_t rem;
+  uint32_t pending;                       // input samples to push before the next output
+  uint32_t phase;                         // decim*n_out mod interp
+  uint32_t phase_step;                    // decim mod interp
+  uint32_t widx;
+  float *phase_taps;                      // interpolated taps of each of the interp phases, or NULL
+  float taps[RESAMPLE_ARB_N][2*RESAMPLE_ARB_M];   // real taps repeated for I and Q, oldest sample first
+  float dtaps[RESAMPLE_ARB_N][2*RESAMPLE_ARB_M];  // difference with the taps of the next phase
+  cf_t delay[2*RESAMPLE_ARB_M];           // window stored twice, always contiguous at widx
+}resample_arb_block_t;
+
+LIBLTE_API int resample_arb_block_init(resample_arb_block_t *q, float rate);
+LIBLTE_API void resample_arb_block_free(resample_arb_block_t *q);
+LIBLTE_API void resample_arb_block_reset(resample_arb_block_t *q);
+LIBLTE_API int resample_arb_block_compute(resample_arb_block_t *q, cf_t *input, cf_t *output, int n_in);
+
 #endif //RESAMPLE_ARB_
@@ -0,0 +1,120 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef LINK_SIM_
+#define LINK_SIM_
+
+/*******************************************************
+ *
+ * Monte-Carlo link-level simulation of the PDSCH.
+ *
+ * Each simulated subframe goes through the whole downlink chain: the
+ * transport block is encoded and mapped together with the cell reference
+ * signals, converted to time domain, passed through an AWGN or EPA/EVA/ETU
+ * fading channel from every transmit port to a single receive antenna, and
+ * decoded by the UE after channel estimation.
+ *
+ * The fading channel of each port is a single realization, drawn once from
+ * the seed, and subframe n sees it at time n ms, so consecutive subframes
+ * are correlated according to the Doppler frequency. The delay line starts
+ * empty in every subframe.
+ *
+ * Subframes are simulated in parallel by nof_threads workers. Subframe n
+ * draws its data and noise from a ch_rand_t generator seeded with (seed, n),
+ * and the stopping rule is evaluated on the subframes in order, so the
+ * results only depend on the seed and not on the number of threads or on
+ * how subframes were scheduled.
+ ********************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "liblte/config.h"
+
+#define LINK_SIM_MAX_THREADS    16
+#define LINK_SIM_CHANNEL_LEN    16
+
+typedef enum LIBLTE_API {
+  LINK_SIM_ENCODE = 0,          // reference signals and PDSCH encoding
+  LINK_SIM_IFFT,
+  LINK_SIM_CHANNEL,             // fading and noise
+  LINK_SIM_FFT,
+  LINK_SIM_CHEST,
+  LINK_SIM_DECODE,
+  LINK_SIM_NOF_STAGES
+} link_sim_stage_t;
+
+/* Simulation point. channel is "AWGN" or a fading channel in the format of
+ * ch_fading_parse(), e.g. "EVA70".
+ */
+typedef struct LIBLTE_API {
+  uint32_t mcs_idx;
+  uint32_t nof_prb;
+  uint32_t nof_ports;
+  float snr_db;                 // per resource element, unit power per port
+  char channel[LINK_SIM_CHANNEL_LEN];
+} link_sim_point_t;
+
+/* A point is stopped after min_errors erroneous subframes, once at least
+ * min_frames have been simulated, or after max_frames subframes.
+ */
+typedef struct LIBLTE_API {
+  uint32_t min_errors;
+  uint32_t min_frames;
+  uint32_t max_frames;
+  uint32_t nof_threads;
+  uint64_t seed;
+} link_sim_cfg_t;
+
+typedef struct LIBLTE_API {
+  link_sim_point_t point;
+  uint32_t tbs;
+  uint32_t nof_frames;
+  uint32_t nof_errors;
+  float bler;
+  float throughput_mbps;
+  float cpu_us[LINK_SIM_NOF_STAGES];    // mean thread CPU time per subframe
+} link_sim_result_t;
+
+LIBLTE_API void link_sim_cfg_default(link_sim_cfg_t *cfg);
+
+LIBLTE_API int link_sim_run(link_sim_cfg_t *cfg,
+                            link_sim_point_t *point,
+                            link_sim_result_t *result);
+
+LIBLTE_API char* link_sim_stage_string(link_sim_stage_t stage);
+
+LIBLTE_API void link_sim_fprint_csv_header(FILE *f);
+
+LIBLTE_API void link_sim_fprint_csv(FILE *f,
+                                    link_sim_result_t *result);
+
+LIBLTE_API void link_sim_fprint_json(FILE *f,
+                                     link_sim_result_t *result);
+
+#endif // LINK_SIM_
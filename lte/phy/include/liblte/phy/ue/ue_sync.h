@@ -36,6 +36,7 @@
 #include "liblte/phy/ch_estimation/chest.h"
 #include "liblte/phy/phch/pbch.h"
 #include "liblte/phy/common/fft.h"
+#include "liblte/phy/io/sigmf.h"
 
 /**************************************************************
  *
@@ -49,6 +50,10 @@
  * The function returns 1 when the signal is correctly acquired and the 
  * returned buffer is aligned with the subframe. 
  * 
+ * If a recorder is set with ue_sync_set_recorder(), every received sample is
+ * written to it and every aligned subframe is annotated with its position,
+ * subframe index and CFO.
+ * 
  *************************************************************/
 
 typedef enum LIBLTE_API { SF_FIND, SF_TRACK} ue_sync_state_t;
@@ -86,6 +91,9 @@ typedef struct LIBLTE_API {
   uint32_t peak_idx;
   int time_offset;
   float mean_time_offset; 
+  
+  sigmf_sink_t *recorder;
+  uint64_t nof_recv;          // samples received since ue_sync_init()
   #ifdef MEASURE_EXEC_TIME
   float mean_exec_time;
   #endif
@@ -115,6 +123,9 @@ LIBLTE_API float ue_sync_get_cfo(ue_sync_t *q);
 
 LIBLTE_API float ue_sync_get_sfo(ue_sync_t *q);
 
+LIBLTE_API void ue_sync_set_recorder(ue_sync_t *q, 
+                                     sigmf_sink_t *recorder);
+
 
 
 
@@ -37,6 +37,7 @@
 
 #include <sys/time.h>
 LIBLTE_API void get_time_interval(struct timeval * tdata);
+LIBLTE_API float get_time_interval_us(struct timeval * tdata);
 
 #ifndef DEBUG_DISABLED
 
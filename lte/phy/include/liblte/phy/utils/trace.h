@@ -0,0 +1,116 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "liblte/config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-stage execution tracing.
+ *
+ * Each thread records begin/end events of the processing stages into its own
+ * ring buffer, stamped with the CPU time-stamp counter (CLOCK_MONOTONIC on
+ * architectures without one). Recording takes no locks: a thread only writes
+ * its own buffer and publishes the new head with a release store. When the
+ * buffer is full the oldest events are overwritten, so it keeps the last
+ * nof_events_x_thread events before the dump, which is what is needed to see
+ * where a latency spike came from.
+ *
+ * trace_write_json() writes the recorded events in the Chrome trace event
+ * format, which can be opened in chrome://tracing or ui.perfetto.dev. It must
+ * be called when the traced threads are not running any instrumented stage.
+ * trace_init() and trace_free() free the buffers of all threads, so they must
+ * only be called when no other thread can record events (e.g. before the
+ * traced threads start or after they are joined).
+ *
+ * Tracing is off until trace_init() is called, and can be turned on and off
+ * at runtime with trace_set_enabled(). When disabled, each instrumentation
+ * point costs a load and a branch. Compiling with TRACE_DISABLED defined
+ * (cmake -DDISABLE_TRACE=1) removes the instrumentation points altogether.
+ */
+
+typedef enum {
+  TRACE_CUHD_RECV = 0,
+  TRACE_UE_SYNC,
+  TRACE_SYNC_FIND,
+  TRACE_FFT,
+  TRACE_CHEST,
+  TRACE_PBCH,
+  TRACE_PCFICH,
+  TRACE_PDCCH,
+  TRACE_PDSCH,
+  TRACE_TURBO_ITER,
+  TRACE_UE_DL,
+  TRACE_NOF_STAGES
+} trace_stage_t;
+
+typedef enum {
+  TRACE_EV_BEGIN = 0,
+  TRACE_EV_END
+} trace_ev_t;
+
+LIBLTE_API extern bool trace_enabled;
+
+#ifndef TRACE_DISABLED
+
+#define TRACE_BEGIN(stage) do { if (trace_enabled) trace_event(stage, TRACE_EV_BEGIN); } while (0)
+#define TRACE_END(stage)   do { if (trace_enabled) trace_event(stage, TRACE_EV_END); } while (0)
+
+#else // TRACE_DISABLED
+
+#define TRACE_BEGIN(stage) do {} while (0)
+#define TRACE_END(stage)   do {} while (0)
+
+#endif // TRACE_DISABLED
+
+LIBLTE_API int trace_init(uint32_t nof_events_x_thread);
+
+LIBLTE_API void trace_free();
+
+LIBLTE_API void trace_set_enabled(bool enabled);
+
+LIBLTE_API int trace_thread_name(const char *name);
+
+LIBLTE_API void trace_event(trace_stage_t stage,
+                            trace_ev_t type);
+
+LIBLTE_API const char* trace_stage_name(trace_stage_t stage);
+
+LIBLTE_API int trace_write_json(const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H_
@@ -73,6 +73,7 @@ LIBLTE_API void vec_sc_prod_ccc(cf_t *x, cf_t h, cf_t *z, uint32_t len);
 LIBLTE_API void vec_sc_prod_fff(float *x, float h, float *z, uint32_t len); 
 
 LIBLTE_API void vec_convert_fi(float *x, int16_t *z, float scale, uint32_t len);
+LIBLTE_API void vec_convert_if(int16_t *x, float *z, float scale, uint32_t len);
 
 LIBLTE_API void vec_deinterleave_cf(cf_t *x, float *real, float *imag, uint32_t len); 
 LIBLTE_API void vec_deinterleave_real_cf(cf_t *x, float *real, uint32_t len);
@@ -91,6 +92,10 @@ LIBLTE_API cf_t vec_dot_prod_ccc(cf_t *x, cf_t *y, uint32_t len);
 LIBLTE_API cf_t vec_dot_prod_conj_ccc(cf_t *x, cf_t *y, uint32_t len);
 LIBLTE_API float vec_dot_prod_fff(float *x, float *y, uint32_t len);
 
+/* Dot-product of complex x and real coefficients given for I and Q, 
+ * y = [c0 c0 c1 c1 ...] (2*len floats). len must be even */
+LIBLTE_API cf_t vec_dot_prod_cfc_iq(cf_t *x, float *y, uint32_t len);
+
 /* z=x/y vector division (element-wise) */
 LIBLTE_API void vec_div_ccc(cf_t *x, cf_t *y, cf_t *z, uint32_t len);
 
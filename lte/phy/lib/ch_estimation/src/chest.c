@@ -34,6 +34,7 @@
 #include "liblte/phy/ch_estimation/chest.h"
 #include "liblte/phy/utils/vector.h"
 #include "liblte/phy/utils/debug.h"
+#include "liblte/phy/utils/trace.h"
 
 #define SLOT_SZ(q) (q->nof_symbols * q->symbol_sz)
 #define SF_SZ(q) (2 * SLOT_SZ(q))
@@ -130,6 +131,33 @@ int chest_ce_ref(chest_t *q, cf_t *input, uint32_t nslot, uint32_t port_id, uint
   return ret;
 }
 
+/* Estimates the noise variance from the residuals of the LS estimates at the 
+ * reference positions. Each estimate is compared with the average of its two 
+ * neighbours in frequency. For white noise the residual has 1.5 times the noise 
+ * variance, which is compensated at the end. 
+ */
+static float chest_noise_ref(refsignal_t *r) {
+  uint32_t i, k, nof_refs_x_symbol;
+  cf_t *ls, res;
+  float power = 0;
+  uint32_t n = 0;
+
+  nof_refs_x_symbol = r->nof_refs / r->nsymbols;
+  for (i=0;i<r->nsymbols;i++) {
+    ls = &r->ch_est[i * nof_refs_x_symbol];
+    for (k=1;k<nof_refs_x_symbol-1;k++) {
+      res = ls[k] - (ls[k-1] + ls[k+1]) / 2;
+      power += crealf(res) * crealf(res) + cimagf(res) * cimagf(res);
+      n++;
+    }
+  }
+  if (n > 0) {
+    return power / n / 1.5;
+  } else {
+    return 0;
+  }
+}
+
 /* Computes channel estimates for each reference in a slot and port.
  * Saves the nof_prb * 12 * nof_symbols channel estimates in the array ce
  */
@@ -153,6 +181,8 @@ int chest_ce_slot_port(chest_t *q, cf_t *input, cf_t *ce, uint32_t nslot, uint32
       for (i=0;i<r->nof_refs;i++) {
         chest_ce_ref(q, input, nslot, port_id, i);
       }
+      
+      q->noise_estimate[port_id] = chest_noise_ref(r);
 
       /* interpolate the symbols with references
       * in the freq domain */
@@ -200,43 +230,53 @@ int chest_ce_slot_port(chest_t *q, cf_t *input, cf_t *ce, uint32_t nslot, uint32
  */
 int chest_ce_sf_port(chest_t *q, cf_t *input, cf_t *ce, uint32_t sf_idx, uint32_t port_id) {
   int n, slotsz, ret;
+  float noise = 0;
   slotsz = q->nof_symbols*q->nof_re;
   for (n=0;n<2;n++) {
     ret = chest_ce_slot_port(q, &input[n*slotsz], &ce[n*slotsz], 2*sf_idx+n, port_id);
     if (ret != LIBLTE_SUCCESS) {
       return ret;
     }
+    noise += q->noise_estimate[port_id] / 2;
   }
+  q->noise_estimate[port_id] = noise;
   return LIBLTE_SUCCESS;
 }
 
 /* Computes channel estimates for each reference in a slot for all ports.
  */
 int chest_ce_slot(chest_t *q, cf_t *input, cf_t **ce, uint32_t nslot) {
-  int p, ret;
-  for (p=0;p<q->nof_ports;p++) {
+  int p, ret = LIBLTE_SUCCESS;
+  TRACE_BEGIN(TRACE_CHEST);
+  for (p=0;p<q->nof_ports && ret == LIBLTE_SUCCESS;p++) {
     ret = chest_ce_slot_port(q, input, ce[p], nslot, p);
-    if (ret != LIBLTE_SUCCESS) {
-      return ret;
-    }
   }
-  return LIBLTE_SUCCESS;
+  TRACE_END(TRACE_CHEST);
+  return ret;
 }
 
 /* Computes channel estimates for each reference in a subframe for all ports.
  */
 int chest_ce_sf(chest_t *q, cf_t *input, cf_t *ce[MAX_PORTS], uint32_t sf_idx) {
-  int p, n, slotsz, ret;
-  slotsz = q->nof_symbols*q->nof_re;
+  int p, ret = LIBLTE_SUCCESS;
+  TRACE_BEGIN(TRACE_CHEST);
+  for (p=0;p<q->nof_ports && ret == LIBLTE_SUCCESS;p++) {
+    ret = chest_ce_sf_port(q, input, ce[p], sf_idx, p);
+  }
+  TRACE_END(TRACE_CHEST);
+  return ret;
+}
+
+/* Returns the noise variance per RE, averaged over all ports, estimated during 
+ * the last call to any of the chest_ce_* functions.
+ */
+float chest_get_noise_estimate(chest_t *q) {
+  uint32_t p;
+  float noise = 0;
   for (p=0;p<q->nof_ports;p++) {
-    for (n=0;n<2;n++) {
-      ret = chest_ce_slot_port(q, &input[n*slotsz], &ce[p][n*slotsz], 2*sf_idx+n, p);
-      if (ret != LIBLTE_SUCCESS) {
-        return ret;
-      }
-    }
+    noise += q->noise_estimate[p];
   }
-  return LIBLTE_SUCCESS;
+  return noise / q->nof_ports;
 }
 
 int chest_init(chest_t *q, uint32_t nof_re, uint32_t nof_symbols, uint32_t nof_ports) {
@@ -34,11 +34,31 @@
 #include "gauss.h"
 #include "liblte/phy/channel/ch_awgn.h"
 
+#define NOISE_BLOCK   512
+
 float ch_awgn_get_variance(float ebno_db, float rate) {
   float esno_db = ebno_db + 10 * log10f(rate);
   return sqrtf(1 / (powf(10, esno_db / 10)));
 }
 
+void ch_awgn_f_rand(ch_rand_t *gen, const float* x, float* y, float variance, uint32_t len) {
+  float noise[NOISE_BLOCK];
+  uint32_t i, n;
+  int j;
+
+  for (i = 0; i < len; i += n) {
+    n = len - i < NOISE_BLOCK ? len - i : NOISE_BLOCK;
+    ch_rand_gauss(gen, noise, n);
+    for (j = 0; j < (int) n; j++) {
+      y[i + j] = x[i + j] + variance * noise[j];
+    }
+  }
+}
+
+void ch_awgn_c_rand(ch_rand_t *gen, const cf_t* x, cf_t* y, float variance, uint32_t len) {
+  ch_awgn_f_rand(gen, (const float*) x, (float*) y, variance, 2 * len);
+}
+
 void ch_awgn_c(const cf_t* x, cf_t* y, float variance, uint32_t len) {
   cf_t tmp;
   uint32_t i;
@@ -0,0 +1,252 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <complex.h>
+#include <math.h>
+
+#include "liblte/phy/channel/ch_fading.h"
+#include "liblte/phy/utils/debug.h"
+
+/* 3GPP TS 36.101 Table B.2.1-2 to B.2.1-4 */
+typedef struct {
+  uint32_t nof_paths;
+  float delay_ns[CH_FADING_MAX_PATHS];
+  float power_db[CH_FADING_MAX_PATHS];
+} ch_fading_profile_t;
+
+static const ch_fading_profile_t profiles[3] = {
+  /* EPA */
+  {7, {0, 30, 70, 90, 110, 190, 410}, 
+      {0.0, -1.0, -2.0, -3.0, -8.0, -17.2, -20.8}},
+  /* EVA */
+  {9, {0, 30, 150, 310, 370, 710, 1090, 1730, 2510}, 
+      {0.0, -1.5, -1.4, -3.6, -0.6, -9.1, -7.0, -12.0, -16.9}},
+  /* ETU */
+  {9, {0, 50, 120, 200, 230, 500, 1600, 2300, 5000}, 
+      {-1.0, -1.0, -1.0, 0.0, 0.0, 0.0, -3.0, -5.0, -7.0}},
+};
+
+static char *model_names[3] = {"EPA", "EVA", "ETU"};
+
+char* ch_fading_model_string(ch_fading_model_t model) {
+  if (model <= CH_FADING_ETU) {
+    return model_names[model];
+  }
+  return "N/A";
+}
+
+/** Parses the usual names of the models with their Doppler in Hz, such as 
+ * EPA5, EVA70 or ETU300. 
+ */
+int ch_fading_parse(char *name, ch_fading_model_t *model, float *doppler) {
+  uint32_t i;
+  char *end;
+
+  if (name == NULL || model == NULL || doppler == NULL || strlen(name) < 4) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  for (i = 0; i < 3; i++) {
+    if (!strncasecmp(name, model_names[i], 3)) {
+      *doppler = strtof(&name[3], &end);
+      if (*end != '\0' || *doppler < 0) {
+        return LIBLTE_ERROR_INVALID_INPUTS;
+      }
+      *model = (ch_fading_model_t) i;
+      return LIBLTE_SUCCESS;
+    }
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
+/* Computes the coefficient of every path at the current time */
+static void ch_fading_update(ch_fading_t *q) {
+  ch_fading_path_t *p;
+  double t = (double) q->time;
+  float re, im;
+  uint32_t i, m;
+
+  for (i = 0; i < q->nof_paths; i++) {
+    p = &q->path[i];
+    re = 0;
+    im = 0;
+    for (m = 0; m < CH_FADING_NOF_SINUSOIDS; m++) {
+      re += cosf((float) fmod(p->w_i[m] * t, 2 * M_PI) + p->phi_i[m]);
+      im += sinf((float) fmod(p->w_q[m] * t, 2 * M_PI) + p->phi_q[m]);
+    }
+    p->h = p->gain * (re + im * I);
+  }
+}
+
+/** Initializes a channel of model with a maximum Doppler frequency of doppler 
+ * Hz for signals sampled at srate Hz. The random angles and phases of the 
+ * paths are drawn from gen. 
+ */
+int ch_fading_init(ch_fading_t *q, ch_fading_model_t model, float doppler, float srate, 
+                   ch_rand_t *gen) 
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  const ch_fading_profile_t *prof;
+  float u[2 * CH_FADING_NOF_SINUSOIDS + 1];
+  double total = 0, wd, alpha;
+  uint32_t i, m;
+
+  if (q                 != NULL &&
+      gen               != NULL &&
+      model             <= CH_FADING_ETU &&
+      doppler           >= 0    &&
+      srate             >  0)
+  {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(ch_fading_t));
+    prof = &profiles[model];
+    q->model = model;
+    q->doppler = doppler;
+    q->srate = srate;
+    q->nof_paths = prof->nof_paths;
+
+    for (i = 0; i < q->nof_paths; i++) {
+      total += pow(10, prof->power_db[i] / 10);
+    }
+    wd = 2 * M_PI * doppler / srate;
+    for (i = 0; i < q->nof_paths; i++) {
+      q->path[i].delay = (uint32_t) roundf(prof->delay_ns[i] * 1e-9 * srate);
+      if (q->path[i].delay > q->max_delay) {
+        q->max_delay = q->path[i].delay;
+      }
+      /* every sinusoid has unit power, thus the path has power nof_sinusoids */
+      q->path[i].gain = (float) sqrt(pow(10, prof->power_db[i] / 10) / total 
+                                     / CH_FADING_NOF_SINUSOIDS);
+      ch_rand_uniform(gen, u, 2 * CH_FADING_NOF_SINUSOIDS + 1);
+      for (m = 0; m < CH_FADING_NOF_SINUSOIDS; m++) {
+        alpha = (2 * M_PI * (m + 1) - M_PI + 2 * M_PI * (u[0] - 0.5)) / (4 * CH_FADING_NOF_SINUSOIDS);
+        q->path[i].w_i[m] = wd * cos(alpha);
+        q->path[i].w_q[m] = wd * sin(alpha);
+        q->path[i].phi_i[m] = (float) (2 * M_PI * u[1 + 2 * m]);
+        q->path[i].phi_q[m] = (float) (2 * M_PI * u[2 + 2 * m]);
+      }
+    }
+    if (doppler > 0) {
+      q->update_len = (uint32_t) (srate / doppler / CH_FADING_UPDATES_X_CYCLE);
+    } else {
+      q->update_len = CH_FADING_CHUNK;
+    }
+    if (q->update_len < 1) {
+      q->update_len = 1;
+    } else if (q->update_len > CH_FADING_CHUNK) {
+      q->update_len = CH_FADING_CHUNK;
+    }
+    q->buffer = calloc(q->max_delay + CH_FADING_CHUNK, sizeof(cf_t));
+    if (!q->buffer) {
+      perror("malloc");
+      goto clean;
+    }
+    INFO("Init %s fading channel: %d paths, %.1f Hz Doppler, max delay %d samples\n", 
+         model_names[model], q->nof_paths, doppler, q->max_delay);
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    ch_fading_free(q);
+  }
+  return ret;
+}
+
+void ch_fading_free(ch_fading_t *q) {
+  if (q->buffer) {
+    free(q->buffer);
+  }
+  bzero(q, sizeof(ch_fading_t));
+}
+
+/* y[i] += h*x[i] over len interleaved I/Q samples */
+static void ch_fading_mac(float *x, float *y, cf_t h, int len) {
+  float hr = crealf(h), hi = cimagf(h);
+  int i;
+
+  for (i = 0; i < len; i++) {
+    y[2 * i] += hr * x[2 * i] - hi * x[2 * i + 1];
+    y[2 * i + 1] += hr * x[2 * i + 1] + hi * x[2 * i];
+  }
+}
+
+/** Passes len samples through the channel. input and output may be the same 
+ * buffer. The channel state is kept across calls, so a stream can be 
+ * processed in blocks of any size. 
+ */
+int ch_fading_run(ch_fading_t *q, cf_t *input, cf_t *output, uint32_t len) {
+  uint32_t hist, n, i, seg, p;
+  cf_t *x;
+
+  if (q == NULL || input == NULL || output == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  hist = q->max_delay;
+  while (len > 0) {
+    n = len > CH_FADING_CHUNK ? CH_FADING_CHUNK : len;
+    memcpy(&q->buffer[hist], input, sizeof(cf_t) * n);
+    x = &q->buffer[hist];
+    bzero(output, sizeof(cf_t) * n);
+    for (i = 0; i < n; i += seg) {
+      if (!q->to_update) {
+        ch_fading_update(q);
+        q->to_update = q->update_len;
+      }
+      seg = n - i < q->to_update ? n - i : q->to_update;
+      for (p = 0; p < q->nof_paths; p++) {
+        ch_fading_mac((float*) &x[(int) i - (int) q->path[p].delay], (float*) &output[i], 
+                      q->path[p].h, (int) seg);
+      }
+      q->to_update -= seg;
+      q->time += seg;
+    }
+    memmove(q->buffer, &q->buffer[n], sizeof(cf_t) * hist);
+    input += n;
+    output += n;
+    len -= n;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/** Moves the channel to time samples since initialization and clears the 
+ * delay line. The following samples see the same coefficients as if the 
+ * channel had processed time zero samples, so blocks of a stream that are not 
+ * contiguous can be processed with one channel realization. 
+ */
+void ch_fading_set_time(ch_fading_t *q, uint64_t time) {
+  uint32_t offset = (uint32_t) (time % q->update_len);
+
+  q->time = time - offset;
+  ch_fading_update(q);
+  q->time = time;
+  q->to_update = q->update_len - offset;
+  bzero(q->buffer, sizeof(cf_t) * q->max_delay);
+}
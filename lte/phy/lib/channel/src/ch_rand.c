@@ -0,0 +1,216 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "liblte/phy/channel/ch_rand.h"
+
+#define CH_RAND_2POW_M24  5.9604644775390625e-08f   // 2^-24
+
+/* splitmix64, to expand the seed into the generator states */
+static uint64_t splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/** Initializes the generator of stream number stream of seed. */
+void ch_rand_init(ch_rand_t *q, uint64_t seed, uint32_t stream) {
+  uint64_t x, z;
+  uint32_t k;
+
+  bzero(q, sizeof(ch_rand_t));
+  x = seed ^ ((uint64_t) stream * 0xD1B54A32D192ED03ULL);
+  /* mix the stream into the seed so that close seeds/streams diverge */
+  splitmix64(&x);
+  for (k = 0; k < CH_RAND_LANES; k++) {
+    z = splitmix64(&x);
+    q->s[0][k] = (uint32_t) z;
+    q->s[1][k] = (uint32_t) (z >> 32);
+    z = splitmix64(&x);
+    q->s[2][k] = (uint32_t) z;
+    q->s[3][k] = (uint32_t) (z >> 32);
+    if (!(q->s[0][k] | q->s[1][k] | q->s[2][k] | q->s[3][k])) {
+      q->s[0][k] = 1;
+    }
+  }
+}
+
+/* Clocks all the lanes once (xoshiro128+) */
+static void ch_rand_next(ch_rand_t *q, uint32_t *output) {
+  uint32_t s0, s1, s2, s3, t;
+  int k;
+
+  for (k = 0; k < CH_RAND_LANES; k++) {
+    s0 = q->s[0][k];
+    s1 = q->s[1][k];
+    s2 = q->s[2][k];
+    s3 = q->s[3][k];
+    output[k] = s0 + s3;
+    t = s1 << 9;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = (s3 << 11) | (s3 >> 21);
+    q->s[0][k] = s0;
+    q->s[1][k] = s1;
+    q->s[2][k] = s2;
+    q->s[3][k] = s3;
+  }
+}
+
+/* Generates CH_RAND_LANES samples uniformly distributed in [0,1) */
+static void ch_rand_uniform_block(ch_rand_t *q, float *output) {
+  uint32_t u[CH_RAND_LANES];
+  int k;
+
+  ch_rand_next(q, u);
+  for (k = 0; k < CH_RAND_LANES; k++) {
+    output[k] = (float) (u[k] >> 8) * CH_RAND_2POW_M24;
+  }
+}
+
+/** Writes len samples uniformly distributed in [0,1). Whole blocks of 
+ * CH_RAND_LANES samples are drawn from the generator, the ones not returned 
+ * are kept for the next call. 
+ */
+void ch_rand_uniform(ch_rand_t *q, float *output, uint32_t len) {
+  uint32_t n;
+
+  /* samples left by the previous call */
+  n = len < q->ucache_len ? len : q->ucache_len;
+  memcpy(output, &q->ucache[CH_RAND_LANES - q->ucache_len], sizeof(float) * n);
+  q->ucache_len -= n;
+  output += n;
+  len -= n;
+
+  while (len >= CH_RAND_LANES) {
+    ch_rand_uniform_block(q, output);
+    output += CH_RAND_LANES;
+    len -= CH_RAND_LANES;
+  }
+  if (len > 0) {
+    ch_rand_uniform_block(q, q->ucache);
+    memcpy(output, q->ucache, sizeof(float) * len);
+    q->ucache_len = CH_RAND_LANES - len;
+  }
+}
+
+/* Natural logarithm of x > 0: x = 2^e*m with m in [sqrt(2)/2, sqrt(2)), and 
+ * log(m) = 2*atanh((m-1)/(m+1)), whose series converges fast in that range. 
+ * Relative error below 1e-7 
+ */
+static inline float ch_rand_log(float x) {
+  uint32_t bits, mbits;
+  int32_t e, adj;
+  float m, t, t2;
+
+  memcpy(&bits, &x, sizeof(float));
+  e = (int32_t) (bits >> 23) - 127;
+  mbits = (bits & 0x7fffff) | 0x3f800000;
+  /* m in [1,2): halve it when above sqrt(2) */
+  adj = mbits > 0x3fb504f3;
+  mbits -= (uint32_t) adj << 23;
+  e += adj;
+  memcpy(&m, &mbits, sizeof(float));
+  t = (m - 1) / (m + 1);
+  t2 = t * t;
+  return e * (float) M_LN2 + 2 * t * (1 + t2 * (1.0f / 3 + t2 * (1.0f / 5 + t2 * (1.0f / 7 + t2 * (1.0f / 9)))));
+}
+
+/* Square root of x >= 0 as x/sqrt(x), with three Newton iterations of the 
+ * inverse square root. Unlike sqrtf() it does not set errno, so it is 
+ * vectorized 
+ */
+static inline float ch_rand_sqrt(float x) {
+  uint32_t bits;
+  float y;
+
+  memcpy(&bits, &x, sizeof(float));
+  bits = 0x5f3759df - (bits >> 1);
+  memcpy(&y, &bits, sizeof(float));
+  y = y * (1.5f - 0.5f * x * y * y);
+  y = y * (1.5f - 0.5f * x * y * y);
+  y = y * (1.5f - 0.5f * x * y * y);
+  return x * y;
+}
+
+/* Generates 2*CH_RAND_LANES Gaussian samples of unit variance */
+static void ch_rand_gauss_block(ch_rand_t *q, float *output) {
+  uint32_t u1[CH_RAND_LANES], u2[CH_RAND_LANES];
+  float a, r, x, x2, s, c;
+  int k;
+
+  ch_rand_next(q, u1);
+  ch_rand_next(q, u2);
+  for (k = 0; k < CH_RAND_LANES; k++) {
+    /* radius from a uniform in (0,1] */
+    a = (float) ((u1[k] >> 8) + 1) * CH_RAND_2POW_M24;
+    r = ch_rand_sqrt(-2 * ch_rand_log(a));
+    /* half of an angle uniform in [-pi,pi) */
+    x = ((float) (u2[k] >> 8) * CH_RAND_2POW_M24 - 0.5f) * (float) M_PI;
+    x2 = x * x;
+    s = x * (1 - x2 / 6 * (1 - x2 / 20 * (1 - x2 / 42 * (1 - x2 / 72 * (1 - x2 / 110)))));
+    c = 1 - x2 / 2 * (1 - x2 / 12 * (1 - x2 / 30 * (1 - x2 / 56 * (1 - x2 / 90 * (1 - x2 / 132)))));
+    /* cos and sin of the angle */
+    output[2 * k] = r * (c * c - s * s);
+    output[2 * k + 1] = r * (2 * s * c);
+  }
+}
+
+/** Writes len Gaussian samples of zero mean and unit variance. Pairs of 
+ * consecutive samples (the real and imaginary parts of complex samples) are 
+ * independent. The radius is truncated at 5.7 standard deviations. 
+ */
+void ch_rand_gauss(ch_rand_t *q, float *output, uint32_t len) {
+  uint32_t n;
+
+  /* samples left by the previous call */
+  n = len < q->cache_len ? len : q->cache_len;
+  memcpy(output, &q->cache[2 * CH_RAND_LANES - q->cache_len], sizeof(float) * n);
+  q->cache_len -= n;
+  output += n;
+  len -= n;
+
+  while (len >= 2 * CH_RAND_LANES) {
+    ch_rand_gauss_block(q, output);
+    output += 2 * CH_RAND_LANES;
+    len -= 2 * CH_RAND_LANES;
+  }
+  if (len > 0) {
+    ch_rand_gauss_block(q, q->cache);
+    memcpy(output, q->cache, sizeof(float) * len);
+    q->cache_len = 2 * CH_RAND_LANES - len;
+  }
+}
@@ -0,0 +1,264 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Checks ch_fading_run() for the EPA, EVA and ETU models: the power delay 
+ * profile averaged over many channel realizations must match the model, the 
+ * autocorrelation of the channel in time must follow the Bessel function of 
+ * the classical Doppler spectrum, and processing in blocks of random size must 
+ * give the same samples as in a single call. Moving the channel to a time with 
+ * ch_fading_set_time() must give the same samples as running it from zero.
+ */
+
+#define SRATE         7.68e6
+#define NOF_LAGS      3
+
+uint32_t nof_realizations = 1000;
+uint64_t seed = 0;
+
+/* 36.101 Table B.2.1-2 to B.2.1-4 */
+uint32_t nof_paths[3] = {7, 9, 9};
+float path_delay_ns[3][9] = {
+  {0, 30, 70, 90, 110, 190, 410},
+  {0, 30, 150, 310, 370, 710, 1090, 1730, 2510},
+  {0, 50, 120, 200, 230, 500, 1600, 2300, 5000},
+};
+float path_power_db[3][9] = {
+  {0.0, -1.0, -2.0, -3.0, -8.0, -17.2, -20.8}, 
+  {0.0, -1.5, -1.4, -3.6, -0.6, -9.1, -7.0, -12.0, -16.9},
+  {-1.0, -1.0, -1.0, 0.0, 0.0, 0.0, -3.0, -5.0, -7.0},
+};
+
+void usage(char *prog) {
+  printf("Usage: %s [ns]\n", prog);
+  printf("\t-n nof_realizations [Default %d]\n", nof_realizations);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ns")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_realizations = atoi(argv[optind]);
+      break;
+    case 's':
+      seed = strtoull(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* Expected power at each delay rounded to SRATE, normalized to a total 
+ * power of 1 */
+void expected_pdp(ch_fading_model_t model, float *pdp, uint32_t len) {
+  float total = 0;
+  uint32_t i;
+
+  bzero(pdp, sizeof(float) * len);
+  for (i = 0; i < nof_paths[model]; i++) {
+    pdp[(uint32_t) roundf(path_delay_ns[model][i] * 1e-9 * SRATE)] += 
+        powf(10, path_power_db[model][i] / 10);
+  }
+  for (i = 0; i < len; i++) {
+    total += pdp[i];
+  }
+  for (i = 0; i < len; i++) {
+    pdp[i] /= total;
+  }
+}
+
+int main(int argc, char **argv) {
+  ch_fading_t ch;
+  ch_rand_t gen;
+  ch_fading_model_t model, parsed_model;
+  cf_t *input, *output, *output_blk;
+  float pdp[64], pdp_ref[64], doppler;
+  double total, r0, r[NOF_LAGS];
+  float lag_ms[NOF_LAGS] = {1, 2, 4};
+  uint32_t i, j, n, len, lag, nof_samples, srate_doppler = 1920000;
+  int ret = -1;
+
+  bzero(&ch, sizeof(ch_fading_t));
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand((unsigned int) seed);
+
+  nof_samples = srate_doppler / 20;
+  input = malloc(sizeof(cf_t) * nof_samples);
+  output = malloc(sizeof(cf_t) * nof_samples);
+  output_blk = malloc(sizeof(cf_t) * nof_samples);
+  if (!input || !output || !output_blk) {
+    perror("malloc");
+    exit(-1);
+  }
+
+  if (ch_fading_parse("EVA70", &parsed_model, &doppler) || 
+      parsed_model != CH_FADING_EVA || doppler != 70 ||
+      !ch_fading_parse("EXA5", &parsed_model, &doppler)) 
+  {
+    fprintf(stderr, "Error parsing model names\n");
+    goto quit;
+  }
+
+  for (model = CH_FADING_EPA; model <= CH_FADING_ETU; model++) {
+    /* power delay profile of the impulse response at a random time */
+    bzero(pdp, sizeof(pdp));
+    for (n = 0; n < nof_realizations; n++) {
+      ch_rand_init(&gen, seed, n);
+      if (ch_fading_init(&ch, model, 5, SRATE, &gen)) {
+        fprintf(stderr, "Error initiating channel\n");
+        goto quit;
+      }
+      bzero(input, sizeof(cf_t) * 1000);
+      ch_fading_run(&ch, input, output, rand() % 1000);
+      input[0] = 1;
+      ch_fading_run(&ch, input, output, 64);
+      for (i = 0; i < 64; i++) {
+        pdp[i] += crealf(output[i] * conjf(output[i])) / nof_realizations;
+      }
+      ch_fading_free(&ch);
+    }
+    expected_pdp(model, pdp_ref, 64);
+    total = 0;
+    for (i = 0; i < 64; i++) {
+      total += pdp[i];
+      if (fabsf(pdp[i] - pdp_ref[i]) > 0.15 * pdp_ref[i] + 0.002) {
+        fprintf(stderr, "%s: power at delay %d is %.4f, expected %.4f\n", 
+            ch_fading_model_string(model), i, pdp[i], pdp_ref[i]);
+        goto quit;
+      }
+    }
+    printf("%s: total power %.3f\n", ch_fading_model_string(model), total);
+
+    /* autocorrelation at 100 Hz Doppler */
+    r0 = 0;
+    bzero(r, sizeof(r));
+    for (i = 0; i < nof_samples; i++) {
+      input[i] = 1;
+    }
+    for (n = 0; n < nof_realizations / 5; n++) {
+      ch_rand_init(&gen, seed, n);
+      if (ch_fading_init(&ch, model, 100, srate_doppler, &gen)) {
+        goto quit;
+      }
+      ch_fading_run(&ch, input, output, nof_samples);
+      for (j = 0; j < NOF_LAGS; j++) {
+        lag = (uint32_t) (lag_ms[j] * 1e-3 * srate_doppler);
+        for (i = 0; i + lag < nof_samples; i += 16) {
+          r[j] += crealf(output[i + lag] * conjf(output[i]));
+        }
+      }
+      for (i = 0; i < nof_samples; i += 16) {
+        r0 += crealf(output[i] * conjf(output[i]));
+      }
+      ch_fading_free(&ch);
+    }
+    for (j = 0; j < NOF_LAGS; j++) {
+      lag = (uint32_t) (lag_ms[j] * 1e-3 * srate_doppler);
+      r[j] = r[j] / r0 * nof_samples / (nof_samples - lag);
+      printf("%s: autocorrelation at %.0f ms %.3f, J0 %.3f\n", ch_fading_model_string(model), 
+          lag_ms[j], r[j], j0(2 * M_PI * 100 * lag_ms[j] * 1e-3));
+      if (fabs(r[j] - j0(2 * M_PI * 100 * lag_ms[j] * 1e-3)) > 0.08) {
+        fprintf(stderr, "Autocorrelation does not match the Doppler spectrum\n");
+        goto quit;
+      }
+    }
+
+    /* random signal in blocks of random length */
+    for (i = 0; i < nof_samples; i++) {
+      input[i] = ((float) rand() / RAND_MAX - 0.5) + ((float) rand() / RAND_MAX - 0.5) * I;
+    }
+    ch_rand_init(&gen, seed, 0);
+    ch_fading_init(&ch, model, 300, SRATE, &gen);
+    ch_fading_run(&ch, input, output, nof_samples);
+    ch_fading_free(&ch);
+    ch_rand_init(&gen, seed, 0);
+    ch_fading_init(&ch, model, 300, SRATE, &gen);
+    for (i = 0; i < nof_samples; i += len) {
+      len = rand() % 3000;
+      if (i + len > nof_samples) {
+        len = nof_samples - i;
+      }
+      memcpy(&output_blk[i], &input[i], sizeof(cf_t) * len);
+      ch_fading_run(&ch, &output_blk[i], &output_blk[i], len);
+    }
+    ch_fading_free(&ch);
+    if (memcmp(output, output_blk, sizeof(cf_t) * nof_samples)) {
+      fprintf(stderr, "%s: output in blocks differs\n", ch_fading_model_string(model));
+      goto quit;
+    }
+
+    /* zeros up to a random time, then the channel is moved there */
+    n = rand() % (nof_samples / 2);
+    bzero(input, sizeof(cf_t) * n);
+    ch_rand_init(&gen, seed, 0);
+    ch_fading_init(&ch, model, 300, SRATE, &gen);
+    ch_fading_run(&ch, input, output, nof_samples);
+    ch_fading_free(&ch);
+    ch_rand_init(&gen, seed, 0);
+    ch_fading_init(&ch, model, 300, SRATE, &gen);
+    ch_fading_run(&ch, &input[n], output_blk, rand() % 3000);
+    ch_fading_set_time(&ch, n);
+    ch_fading_run(&ch, &input[n], &output_blk[n], nof_samples - n);
+    ch_fading_free(&ch);
+    if (memcmp(&output[n], &output_blk[n], sizeof(cf_t) * (nof_samples - n))) {
+      fprintf(stderr, "%s: output after ch_fading_set_time() differs\n", 
+          ch_fading_model_string(model));
+      goto quit;
+    }
+  }
+  ret = 0;
+quit:
+  ch_fading_free(&ch);
+  free(input);
+  free(output);
+  free(output_blk);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
@@ -0,0 +1,235 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Checks the statistics of ch_rand_gauss() (mean, variance, kurtosis, 
+ * correlation of the real and imaginary parts and tail probability), that 
+ * a seed and stream always give the same samples regardless of the length of 
+ * the calls, also for ch_rand_uniform(), that different streams are 
+ * uncorrelated and that ch_awgn_c_rand() adds the samples of the generator. 
+ * Reports the throughput of ch_rand_gauss() and of the polar method with 
+ * rand().
+ */
+
+uint32_t nof_samples = 4000000;
+uint64_t seed = 0;
+
+void usage(char *prog) {
+  printf("Usage: %s [ns]\n", prog);
+  printf("\t-n nof_samples [Default %d]\n", nof_samples);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ns")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_samples = atoi(argv[optind]);
+      break;
+    case 's':
+      seed = strtoull(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* Marsaglia's polar method with rand(), as a reference */
+float rand_gauss_ref(void) {
+  float v1, v2, s;
+
+  do {
+    v1 = 2.0 * ((float) rand() / RAND_MAX) - 1;
+    v2 = 2.0 * ((float) rand() / RAND_MAX) - 1;
+    s = v1 * v1 + v2 * v2;
+  } while (s >= 1.0 || s == 0.0);
+  return v1 * sqrt(-2.0 * log(s) / s);
+}
+
+int check(const char *what, double value, double expected, double tol) {
+  printf("%-28s %9.5f (expected %.5f)\n", what, value, expected);
+  if (fabs(value - expected) > tol) {
+    fprintf(stderr, "%s out of tolerance %f\n", what, tol);
+    return -1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  ch_rand_t gen;
+  float *x, *y;
+  cf_t *sig, *noisy;
+  uint32_t i, len;
+  struct timeval t[3];
+  double m1 = 0, m2 = 0, m4 = 0, c = 0, cs = 0, tail = 0;
+  float t_gen, t_ref;
+  int ret = -1;
+
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  nof_samples += nof_samples % 2;
+
+  x = malloc(sizeof(float) * nof_samples);
+  y = malloc(sizeof(float) * nof_samples);
+  sig = malloc(sizeof(cf_t) * nof_samples / 2);
+  noisy = malloc(sizeof(cf_t) * nof_samples / 2);
+  if (!x || !y || !sig || !noisy) {
+    perror("malloc");
+    exit(-1);
+  }
+
+  ch_rand_init(&gen, seed, 0);
+  gettimeofday(&t[1], NULL);
+  ch_rand_gauss(&gen, x, nof_samples);
+  gettimeofday(&t[2], NULL);
+  t_gen = get_time_interval_us(t);
+
+  srand((unsigned int) seed);
+  gettimeofday(&t[1], NULL);
+  for (i = 0; i < nof_samples; i++) {
+    y[i] = rand_gauss_ref();
+  }
+  gettimeofday(&t[2], NULL);
+  t_ref = get_time_interval_us(t);
+
+  for (i = 0; i < nof_samples; i++) {
+    m1 += x[i];
+    m2 += x[i] * x[i];
+    m4 += x[i] * x[i] * x[i] * x[i];
+    if (fabsf(x[i]) > 3) {
+      tail++;
+    }
+  }
+  for (i = 0; i < nof_samples; i += 2) {
+    c += x[i] * x[i + 1];
+  }
+  m1 /= nof_samples;
+  m2 /= nof_samples;
+  m4 /= nof_samples;
+  tail /= nof_samples;
+  c /= nof_samples / 2;
+  if (check("Mean", m1, 0, 5 / sqrt(nof_samples)) || 
+      check("Variance", m2, 1, 10 / sqrt(nof_samples)) || 
+      check("Kurtosis", m4 / (m2 * m2), 3, 100 / sqrt(nof_samples)) ||
+      check("Real/imaginary correlation", c, 0, 10 / sqrt(nof_samples)) ||
+      check("P(|x|>3)", tail, 2 * 0.0013499, 0.0003)) 
+  {
+    goto quit;
+  }
+
+  /* same samples in calls of random length */
+  ch_rand_init(&gen, seed, 0);
+  srand((unsigned int) seed);
+  for (i = 0; i < nof_samples; i += len) {
+    len = rand() % 100;
+    if (i + len > nof_samples) {
+      len = nof_samples - i;
+    }
+    ch_rand_gauss(&gen, &y[i], len);
+  }
+  if (memcmp(x, y, sizeof(float) * nof_samples)) {
+    fprintf(stderr, "Samples generated in calls of random length differ\n");
+    goto quit;
+  }
+
+  /* another stream of the same seed */
+  ch_rand_init(&gen, seed, 1);
+  ch_rand_gauss(&gen, y, nof_samples);
+  for (i = 0; i < nof_samples; i++) {
+    cs += x[i] * y[i];
+  }
+  if (check("Stream 0/1 correlation", cs / nof_samples, 0, 10 / sqrt(nof_samples))) {
+    goto quit;
+  }
+
+  /* AWGN channel */
+  for (i = 0; i < nof_samples / 2; i++) {
+    sig[i] = (rand() % 2 ? 1 : -1) + (rand() % 2 ? 1 : -1) * I;
+  }
+  ch_rand_init(&gen, seed, 0);
+  ch_awgn_c_rand(&gen, sig, noisy, 0.5, nof_samples / 2);
+  for (i = 0; i < nof_samples / 2; i++) {
+    if (cabsf(noisy[i] - sig[i] - 0.5 * (x[2 * i] + x[2 * i + 1] * I)) > 1e-5) {
+      fprintf(stderr, "ch_awgn_c_rand() sample %d differs\n", i);
+      goto quit;
+    }
+  }
+
+  /* uniform samples do not depend on the length of the calls either */
+  ch_rand_init(&gen, seed, 0);
+  ch_rand_uniform(&gen, x, nof_samples);
+  ch_rand_init(&gen, seed, 0);
+  for (i = 0; i < nof_samples; i += len) {
+    len = rand() % 100;
+    if (i + len > nof_samples) {
+      len = nof_samples - i;
+    }
+    ch_rand_uniform(&gen, &y[i], len);
+  }
+  if (memcmp(x, y, sizeof(float) * nof_samples)) {
+    fprintf(stderr, "Uniform samples generated in calls of random length differ\n");
+    goto quit;
+  }
+  for (i = 0; i < nof_samples; i++) {
+    if (x[i] < 0 || x[i] >= 1) {
+      fprintf(stderr, "Uniform sample %d out of [0,1): %f\n", i, x[i]);
+      goto quit;
+    }
+  }
+
+  printf("ch_rand_gauss: %.1f Msamples/s, polar method with rand(): %.1f Msamples/s\n", 
+      nof_samples / t_gen, nof_samples / t_ref);
+  ret = 0;
+quit:
+  free(x);
+  free(y);
+  free(sig);
+  free(noisy);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
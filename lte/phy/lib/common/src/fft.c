@@ -34,6 +34,7 @@
 #include "liblte/phy/common/fft.h"
 #include "liblte/phy/utils/debug.h"
 #include "liblte/phy/utils/vector.h"
+#include "liblte/phy/utils/trace.h"
 
 int lte_fft_init_(lte_fft_t *q, lte_cp_t cp, uint32_t nof_prb, dft_dir_t dir) {
   int symbol_sz = lte_symbol_sz(nof_prb);
@@ -111,6 +112,7 @@ void lte_ifft_free(lte_fft_t *q) {
  */
 void lte_fft_run_slot(lte_fft_t *q, cf_t *input, cf_t *output) {
   uint32_t i;
+  TRACE_BEGIN(TRACE_FFT);
   for (i=0;i<q->nof_symbols;i++) {
     input += CP_ISNORM(q->cp)?CP_NORM(i, q->symbol_sz):CP_EXT(q->symbol_sz);
     dft_run_c(&q->fft_plan, input, q->tmp);
@@ -118,6 +120,7 @@ void lte_fft_run_slot(lte_fft_t *q, cf_t *input, cf_t *output) {
     input += q->symbol_sz;
     output += q->nof_re;
   }
+  TRACE_END(TRACE_FFT);
 }
 
 void lte_fft_run_sf(lte_fft_t *q, cf_t *input, cf_t *output) {
@@ -87,6 +87,7 @@ int sequence_LTEPRS(sequence_t *q, uint32_t len, uint32_t seed) {
 int sequence_init(sequence_t *q, uint32_t len) {
   if (q->c && (q->len != len)) {
     free(q->c);
+    q->c = NULL;
   }
   if (!q->c) {
     q->c = malloc(len * sizeof(char));
@@ -0,0 +1,516 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <complex.h>
+
+#include "liblte/phy/enb/enb_dl.h"
+#include "liblte/phy/sync/pss.h"
+#include "liblte/phy/sync/sss.h"
+#include "liblte/phy/utils/vector.h"
+#include "liblte/phy/utils/debug.h"
+
+#define CURRENT_FFTSIZE   lte_symbol_sz(q->cell.nof_prb)
+#define CURRENT_SFLEN     SF_LEN(CURRENT_FFTSIZE)
+
+#define CURRENT_SFLEN_RE SF_LEN_RE(q->cell.nof_prb, q->cell.cp)
+
+/* Generates the signals that only depend on the subframe index: PSS/SSS, CRS
+ * and, since the CFI does not change, the PCFICH.
+ */
+static int enb_dl_gen_templates(enb_dl_t *q) {
+  cf_t pss_signal[PSS_LEN];
+  float sss_signal0[SSS_LEN];
+  float sss_signal5[SSS_LEN];
+  cf_t *sf_symbols[MAX_PORTS];
+  refsignal_t refs;
+  uint32_t sf_idx, n, i;
+
+  pss_generate(pss_signal, q->cell.id % 3);
+  sss_generate(sss_signal0, sss_signal5, q->cell.id);
+
+  for (sf_idx = 0; sf_idx < NSUBFRAMES_X_FRAME; sf_idx++) {
+    bzero(q->sf_template[sf_idx], sizeof(cf_t) * q->sf_n_re);
+
+    if (sf_idx == 0 || sf_idx == 5) {
+      pss_put_slot(pss_signal, q->sf_template[sf_idx], q->cell.nof_prb, q->cell.cp);
+      sss_put_slot(sf_idx ? sss_signal5 : sss_signal0, q->sf_template[sf_idx],
+          q->cell.nof_prb, q->cell.cp);
+    }
+
+    for (n = 0; n < 2; n++) {
+      if (refsignal_init_LTEDL(&refs, 0, 2 * sf_idx + n, q->cell)) {
+        fprintf(stderr, "Error initiating CRS slot=%d\n", 2 * sf_idx + n);
+        return LIBLTE_ERROR;
+      }
+      refsignal_put(&refs, &q->sf_template[sf_idx][n * q->sf_n_re / 2]);
+      refsignal_free(&refs);
+    }
+
+    for (i = 0; i < MAX_PORTS; i++) {
+      sf_symbols[i] = q->sf_template[sf_idx];
+    }
+    if (pcfich_encode(&q->pcfich, q->cfi, sf_symbols, sf_idx)) {
+      fprintf(stderr, "Error encoding PCFICH\n");
+      return LIBLTE_ERROR;
+    }
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/* The transmitter supports a single antenna port. */
+int enb_dl_init(enb_dl_t *q, lte_cell_t cell, uint32_t cfi,
+                phich_resources_t phich_resources, phich_length_t phich_length)
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  uint32_t i;
+
+  if (q                 != NULL &&
+      lte_cell_isvalid(&cell) &&
+      cell.nof_ports    == 1    &&
+      cfi               >  0    &&
+      cfi               <= 3)
+  {
+    ret = LIBLTE_ERROR;
+
+    bzero(q, sizeof(enb_dl_t));
+    q->cell = cell;
+    q->cfi = cfi;
+    q->sf_n_re = CURRENT_SFLEN_RE;
+    q->sf_n_samples = CURRENT_SFLEN;
+    q->tx_scale = ENB_DL_DEFAULT_AMPLITUDE * INT16_MAX;
+    q->pbch_block = UINT32_MAX;
+
+    q->mib.nof_ports = cell.nof_ports;
+    q->mib.nof_prb = cell.nof_prb;
+    q->mib.phich_length = phich_length;
+    q->mib.phich_resources = phich_resources;
+
+    if (pthread_mutex_init(&q->mutex, NULL)) {
+      perror("pthread_mutex_init");
+      goto clean_exit;
+    }
+    if (pthread_cond_init(&q->cvar, NULL)) {
+      perror("pthread_cond_init");
+      goto clean_exit;
+    }
+    if (lte_ifft_init(&q->ifft, q->cell.cp, q->cell.nof_prb)) {
+      fprintf(stderr, "Error initiating iFFT\n");
+      goto clean_exit;
+    }
+    if (regs_init(&q->regs, phich_resources, phich_length, q->cell)) {
+      fprintf(stderr, "Error initiating REGs\n");
+      goto clean_exit;
+    }
+    if (regs_set_cfi(&q->regs, cfi)) {
+      fprintf(stderr, "Error setting CFI\n");
+      goto clean_exit;
+    }
+    if (pbch_init(&q->pbch, q->cell)) {
+      fprintf(stderr, "Error creating PBCH object\n");
+      goto clean_exit;
+    }
+    if (pcfich_init(&q->pcfich, &q->regs, q->cell)) {
+      fprintf(stderr, "Error creating PCFICH object\n");
+      goto clean_exit;
+    }
+    if (pdcch_init(&q->pdcch, &q->regs, q->cell)) {
+      fprintf(stderr, "Error creating PDCCH object\n");
+      goto clean_exit;
+    }
+    if (pdsch_init(&q->pdsch, q->cell)) {
+      fprintf(stderr, "Error creating PDSCH object\n");
+      goto clean_exit;
+    }
+
+    for (i = 0; i < NSUBFRAMES_X_FRAME; i++) {
+      q->sf_template[i] = vec_malloc(sizeof(cf_t) * q->sf_n_re);
+      if (!q->sf_template[i]) {
+        perror("malloc");
+        goto clean_exit;
+      }
+    }
+    q->sf_scratch = vec_malloc(sizeof(cf_t) * q->sf_n_re);
+    if (!q->sf_scratch) {
+      perror("malloc");
+      goto clean_exit;
+    }
+    q->ifft_out = vec_malloc(sizeof(cf_t) * q->sf_n_samples);
+    if (!q->ifft_out) {
+      perror("malloc");
+      goto clean_exit;
+    }
+    for (i = 0; i < ENB_DL_RING_LEN; i++) {
+      q->ring[i].sf_symbols = vec_malloc(sizeof(cf_t) * q->sf_n_re);
+      if (!q->ring[i].sf_symbols) {
+        perror("malloc");
+        goto clean_exit;
+      }
+      q->ring[i].samples = vec_malloc(2 * sizeof(int16_t) * q->sf_n_samples);
+      if (!q->ring[i].samples) {
+        perror("malloc");
+        goto clean_exit;
+      }
+    }
+
+    if (enb_dl_gen_templates(q)) {
+      goto clean_exit;
+    }
+
+    ret = LIBLTE_SUCCESS;
+  } else {
+    fprintf(stderr, "Invalid cell properties: Id=%d, Ports=%d, PRBs=%d, CFI=%d\n",
+            cell.id, cell.nof_ports, cell.nof_prb, cfi);
+  }
+
+clean_exit:
+  if (ret == LIBLTE_ERROR) {
+    enb_dl_free(q);
+  }
+  return ret;
+}
+
+void enb_dl_free(enb_dl_t *q) {
+  uint32_t i;
+  if (q) {
+    if (q->started) {
+      enb_dl_stop(q);
+    }
+    lte_ifft_free(&q->ifft);
+    regs_free(&q->regs);
+    pbch_free(&q->pbch);
+    pcfich_free(&q->pcfich);
+    pdcch_free(&q->pdcch);
+    pdsch_free(&q->pdsch);
+    for (i = 0; i < NSUBFRAMES_X_FRAME; i++) {
+      if (q->sf_template[i]) {
+        free(q->sf_template[i]);
+      }
+    }
+    if (q->sf_scratch) {
+      free(q->sf_scratch);
+    }
+    if (q->ifft_out) {
+      free(q->ifft_out);
+    }
+    for (i = 0; i < ENB_DL_RING_LEN; i++) {
+      if (q->ring[i].sf_symbols) {
+        free(q->ring[i].sf_symbols);
+      }
+      if (q->ring[i].samples) {
+        free(q->ring[i].samples);
+      }
+    }
+    if (q->fsink_open) {
+      filesink_free(&q->fsink);
+    }
+    pthread_cond_destroy(&q->cvar);
+    pthread_mutex_destroy(&q->mutex);
+    bzero(q, sizeof(enb_dl_t));
+  }
+}
+
+/* Sets the amplitude of the int16 output relative to full scale. The time-domain
+ * samples are the output of the normalized IFFT, so their peak is a few times larger
+ * than their RMS; choose the amplitude to avoid clipping.
+ */
+void enb_dl_set_amplitude(enb_dl_t *q, float amplitude) {
+  q->tx_scale = amplitude * INT16_MAX;
+}
+
+void enb_dl_set_sender(enb_dl_t *q, enb_dl_send_t send, void *arg) {
+  q->send = send;
+  q->send_arg = arg;
+}
+
+/* Writes the transmitted samples to a file as complex int16 (COMPLEX_SHORT_BIN).
+ * Can be combined with a sender callback.
+ */
+int enb_dl_set_file_sink(enb_dl_t *q, char *filename) {
+  if (q->fsink_open) {
+    filesink_free(&q->fsink);
+    q->fsink_open = false;
+  }
+  if (filesink_init(&q->fsink, filename, COMPLEX_SHORT_BIN)) {
+    fprintf(stderr, "Error opening file %s\n", filename);
+    return LIBLTE_ERROR;
+  }
+  q->fsink_open = true;
+  return LIBLTE_SUCCESS;
+}
+
+/* Worker thread: IFFT and int16 conversion of the grids in the ring, in order */
+static void *enb_dl_worker(void *arg) {
+  enb_dl_t *q = (enb_dl_t*) arg;
+  enb_dl_slot_t *slot;
+
+  pthread_mutex_lock(&q->mutex);
+  while (1) {
+    slot = &q->ring[q->proc_idx];
+    while (slot->state != ENB_DL_SLOT_GRID && !q->stop) {
+      pthread_cond_wait(&q->cvar, &q->mutex);
+    }
+    if (slot->state != ENB_DL_SLOT_GRID) {
+      break;
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    lte_ifft_run_sf(&q->ifft, slot->sf_symbols, q->ifft_out);
+    vec_convert_fi((float*) q->ifft_out, slot->samples, q->tx_scale, 2 * q->sf_n_samples);
+
+    pthread_mutex_lock(&q->mutex);
+    slot->state = ENB_DL_SLOT_SAMPLES;
+    q->proc_idx = (q->proc_idx + 1) % ENB_DL_RING_LEN;
+    pthread_cond_broadcast(&q->cvar);
+  }
+  q->worker_done = true;
+  pthread_cond_broadcast(&q->cvar);
+  pthread_mutex_unlock(&q->mutex);
+  return NULL;
+}
+
+/* Sender thread: passes the converted subframes to the file sink and/or the
+ * sender callback, in order, and returns the slots to the producer.
+ */
+static void *enb_dl_sender(void *arg) {
+  enb_dl_t *q = (enb_dl_t*) arg;
+  enb_dl_slot_t *slot;
+  int n;
+
+  pthread_mutex_lock(&q->mutex);
+  while (1) {
+    slot = &q->ring[q->rd_idx];
+    while (slot->state != ENB_DL_SLOT_SAMPLES && !q->worker_done) {
+      pthread_cond_wait(&q->cvar, &q->mutex);
+    }
+    if (slot->state != ENB_DL_SLOT_SAMPLES) {
+      break;
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    n = 0;
+    if (q->fsink_open) {
+      if (filesink_write(&q->fsink, slot->samples, q->sf_n_samples) != q->sf_n_samples) {
+        n = -1;
+      }
+    }
+    if (q->send && n >= 0) {
+      n = q->send(q->send_arg, slot->samples, q->sf_n_samples, slot->timestamp);
+    }
+    DEBUG("Sent TTI %d timestamp %lu\n", slot->tti, slot->timestamp);
+
+    pthread_mutex_lock(&q->mutex);
+    if (n < 0) {
+      fprintf(stderr, "Error sending TTI %d\n", slot->tti);
+      q->send_error = true;
+      q->stop = true;
+    }
+    slot->state = ENB_DL_SLOT_FREE;
+    q->rd_idx = (q->rd_idx + 1) % ENB_DL_RING_LEN;
+    q->nof_sf_sent++;
+    pthread_cond_broadcast(&q->cvar);
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return NULL;
+}
+
+/* Starts the worker and sender threads. start_timestamp is the timestamp, in
+ * samples, of the first subframe passed to enb_dl_sf_begin().
+ */
+int enb_dl_start(enb_dl_t *q, uint64_t start_timestamp) {
+  uint32_t i;
+  if (q->started) {
+    return LIBLTE_ERROR;
+  }
+  for (i = 0; i < ENB_DL_RING_LEN; i++) {
+    q->ring[i].state = ENB_DL_SLOT_FREE;
+  }
+  q->wr_idx = q->proc_idx = q->rd_idx = 0;
+  q->start_timestamp = start_timestamp;
+  q->first_sf = true;
+  q->stop = false;
+  q->worker_done = false;
+  q->send_error = false;
+  q->cur = NULL;
+
+  if (pthread_create(&q->worker_thread, NULL, enb_dl_worker, q)) {
+    perror("pthread_create");
+    return LIBLTE_ERROR;
+  }
+  if (pthread_create(&q->sender_thread, NULL, enb_dl_sender, q)) {
+    perror("pthread_create");
+    pthread_mutex_lock(&q->mutex);
+    q->stop = true;
+    pthread_cond_broadcast(&q->cvar);
+    pthread_mutex_unlock(&q->mutex);
+    pthread_join(q->worker_thread, NULL);
+    return LIBLTE_ERROR;
+  }
+  q->started = true;
+  return LIBLTE_SUCCESS;
+}
+
+/* Waits until all the queued subframes have been sent and stops the threads.
+ * Returns LIBLTE_ERROR if the sender failed.
+ */
+int enb_dl_stop(enb_dl_t *q) {
+  if (!q->started) {
+    return LIBLTE_ERROR;
+  }
+  pthread_mutex_lock(&q->mutex);
+  q->stop = true;
+  pthread_cond_broadcast(&q->cvar);
+  pthread_mutex_unlock(&q->mutex);
+  pthread_join(q->worker_thread, NULL);
+  pthread_join(q->sender_thread, NULL);
+  q->started = false;
+  return q->send_error ? LIBLTE_ERROR : LIBLTE_SUCCESS;
+}
+
+static void enb_dl_put_pbch(enb_dl_t *q, cf_t *sf_symbols, uint32_t sfn) {
+  cf_t *slot1_symbols[MAX_PORTS];
+  uint32_t i;
+
+  q->mib.sfn = sfn;
+  if (sfn % 4 && q->pbch_block != sfn / 4) {
+    /* The coded MIB is computed in the first frame of each 40 ms period. If we
+     * start in the middle of one, encode it first on a scratch grid */
+    for (i = 0; i < MAX_PORTS; i++) {
+      slot1_symbols[i] = q->sf_scratch;
+    }
+    q->pbch.frame_idx = 0;
+    pbch_encode(&q->pbch, &q->mib, slot1_symbols);
+  }
+  for (i = 0; i < MAX_PORTS; i++) {
+    slot1_symbols[i] = &sf_symbols[q->sf_n_re / 2];
+  }
+  q->pbch.frame_idx = sfn % 4;
+  pbch_encode(&q->pbch, &q->mib, slot1_symbols);
+  q->pbch_block = sfn / 4;
+}
+
+/* Returns the resource grid for the subframe tti (a subframe counter: the subframe
+ * index is tti%10 and the SFN (tti/10)%1024) initialized with the static signals and
+ * the PBCH. The dynamic channels are then added with enb_dl_put_pdcch() and
+ * enb_dl_put_pdsch(), and the subframe queued with enb_dl_sf_end().
+ *
+ * Blocks while the TX ring is full. Returns NULL on error.
+ */
+cf_t* enb_dl_sf_begin(enb_dl_t *q, uint32_t tti) {
+  enb_dl_slot_t *slot;
+  uint32_t sf_idx = tti % NSUBFRAMES_X_FRAME;
+  bool send_error;
+
+  if (!q->started || q->cur) {
+    fprintf(stderr, "Must call enb_dl_start() and enb_dl_sf_end() before a new subframe\n");
+    return NULL;
+  }
+
+  pthread_mutex_lock(&q->mutex);
+  slot = &q->ring[q->wr_idx];
+  while (slot->state != ENB_DL_SLOT_FREE && !q->send_error) {
+    pthread_cond_wait(&q->cvar, &q->mutex);
+  }
+  send_error = q->send_error;
+  pthread_mutex_unlock(&q->mutex);
+  if (send_error) {
+    return NULL;
+  }
+
+  if (q->first_sf) {
+    q->start_tti = tti;
+    q->first_sf = false;
+  }
+  slot->tti = tti;
+  slot->timestamp = q->start_timestamp + (uint64_t) (tti - q->start_tti) * q->sf_n_samples;
+
+  memcpy(slot->sf_symbols, q->sf_template[sf_idx], sizeof(cf_t) * q->sf_n_re);
+  if (sf_idx == 0) {
+    enb_dl_put_pbch(q, slot->sf_symbols, (tti / NSUBFRAMES_X_FRAME) % 1024);
+  }
+  q->cur = slot;
+  return slot->sf_symbols;
+}
+
+int enb_dl_put_pdcch(enb_dl_t *q, dci_msg_t *dci_msg, dci_location_t location, uint16_t rnti) {
+  cf_t *sf_symbols[MAX_PORTS];
+  uint32_t i;
+
+  if (!q->cur) {
+    return LIBLTE_ERROR;
+  }
+  for (i = 0; i < MAX_PORTS; i++) {
+    sf_symbols[i] = q->cur->sf_symbols;
+  }
+  return pdcch_encode(&q->pdcch, dci_msg, location, rnti, sf_symbols,
+                      q->cur->tti % NSUBFRAMES_X_FRAME, q->cfi);
+}
+
+/* harq_process must have been initialized with pdsch_harq_init() using q->pdsch */
+int enb_dl_put_pdsch(enb_dl_t *q, pdsch_harq_t *harq_process, char *data, uint32_t rv_idx, uint16_t rnti) {
+  cf_t *sf_symbols[MAX_PORTS];
+  uint32_t i;
+
+  if (!q->cur) {
+    return LIBLTE_ERROR;
+  }
+  if (!q->pdsch.rnti_is_set || q->pdsch.rnti != rnti) {
+    if (pdsch_set_rnti(&q->pdsch, rnti)) {
+      return LIBLTE_ERROR;
+    }
+  }
+  for (i = 0; i < MAX_PORTS; i++) {
+    sf_symbols[i] = q->cur->sf_symbols;
+  }
+  return pdsch_encode(&q->pdsch, data, sf_symbols, q->cur->tti % NSUBFRAMES_X_FRAME,
+                      harq_process, rv_idx);
+}
+
+/* Queues the current subframe for transmission */
+int enb_dl_sf_end(enb_dl_t *q) {
+  if (!q->cur) {
+    return LIBLTE_ERROR;
+  }
+  pthread_mutex_lock(&q->mutex);
+  q->cur->state = ENB_DL_SLOT_GRID;
+  q->wr_idx = (q->wr_idx + 1) % ENB_DL_RING_LEN;
+  pthread_cond_broadcast(&q->cvar);
+  pthread_mutex_unlock(&q->mutex);
+  q->cur = NULL;
+  return LIBLTE_SUCCESS;
+}
+
+uint64_t enb_dl_nof_sf_sent(enb_dl_t *q) {
+  uint64_t n;
+  pthread_mutex_lock(&q->mutex);
+  n = q->nof_sf_sent;
+  pthread_mutex_unlock(&q->mutex);
+  return n;
+}
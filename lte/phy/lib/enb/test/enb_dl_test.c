@@ -0,0 +1,245 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <complex.h>
+
+#include "liblte/phy/phy.h"
+
+/* Transmits nof_frames with enb_dl_t and decodes every subframe with ue_dl_t
+ * from the sender callback, checking the timestamps, the SFN and the PDSCH data.
+ */
+
+lte_cell_t cell = {
+  6,            // nof_prb
+  1,            // nof_ports
+  1,            // cell_id
+  CPNORM        // cyclic prefix
+};
+
+uint32_t cfi = 2;
+uint32_t mcs_idx = 12;
+uint32_t nof_frames = 4;
+uint32_t start_tti = 20;
+char *output_file_name = NULL;
+
+#define RNTI          1234
+#define NOF_TX_DATA   16
+
+enb_dl_t enb_dl;
+ue_dl_t ue_dl;
+cf_t *rx_buffer;
+char *tx_data[NOF_TX_DATA];
+char *rx_data;
+uint32_t tbs;
+uint64_t next_timestamp;
+uint32_t next_tti;
+uint32_t nof_errors;
+
+void usage(char *prog) {
+  printf("Usage: %s [cnmfov]\n", prog);
+  printf("\t-c cell id [Default %d]\n", cell.id);
+  printf("\t-n cell.nof_prb [Default %d]\n", cell.nof_prb);
+  printf("\t-m MCS index [Default %d]\n", mcs_idx);
+  printf("\t-f number of frames [Default %d]\n", nof_frames);
+  printf("\t-o also write the samples to file [Default no]\n");
+  printf("\t-v [set verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "cnmfov")) != -1) {
+    switch(opt) {
+    case 'c':
+      cell.id = atoi(argv[optind]);
+      break;
+    case 'n':
+      cell.nof_prb = atoi(argv[optind]);
+      break;
+    case 'm':
+      mcs_idx = atoi(argv[optind]);
+      break;
+    case 'f':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+int rx_subframe(void *arg, int16_t *samples, uint32_t nof_samples, uint64_t timestamp) {
+  uint32_t i, sf_idx = next_tti % NSUBFRAMES_X_FRAME;
+  int n;
+
+  if (timestamp != next_timestamp) {
+    fprintf(stderr, "TTI %d: expected timestamp %lu but got %lu\n", next_tti,
+        next_timestamp, timestamp);
+    nof_errors++;
+  }
+  for (i = 0; i < nof_samples; i++) {
+    __real__ rx_buffer[i] = (float) samples[2*i] / INT16_MAX;
+    __imag__ rx_buffer[i] = (float) samples[2*i+1] / INT16_MAX;
+  }
+  n = ue_dl_decode(&ue_dl, rx_buffer, rx_data, sf_idx, RNTI);
+  if (n != tbs || memcmp(rx_data, tx_data[next_tti % NOF_TX_DATA], tbs)) {
+    fprintf(stderr, "TTI %d: error decoding PDSCH (%d)\n", next_tti, n);
+    nof_errors++;
+  }
+  if (sf_idx == 0 && ue_dl.sfn != (next_tti / NSUBFRAMES_X_FRAME) % 1024) {
+    fprintf(stderr, "TTI %d: decoded SFN %d\n", next_tti, ue_dl.sfn);
+    nof_errors++;
+  }
+  next_timestamp += nof_samples;
+  next_tti++;
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  ra_pdsch_t ra_dl;
+  ra_prb_t prb_alloc;
+  dci_msg_t dci_msg;
+  dci_location_t locations[10];
+  pdsch_harq_t harq_process;
+  uint32_t tti, i, j, nof_locations;
+  int ret = -1;
+
+  parse_args(argc, argv);
+
+  if (enb_dl_init(&enb_dl, cell, cfi, R_1, PHICH_NORM)) {
+    fprintf(stderr, "Error initiating eNodeB DL\n");
+    exit(-1);
+  }
+  if (ue_dl_init(&ue_dl, cell, R_1, PHICH_NORM, RNTI)) {
+    fprintf(stderr, "Error initiating UE DL\n");
+    exit(-1);
+  }
+  pdsch_set_rnti(&ue_dl.pdsch, RNTI);
+  if (pdsch_harq_init(&harq_process, &enb_dl.pdsch)) {
+    fprintf(stderr, "Error initiating HARQ process\n");
+    exit(-1);
+  }
+
+  bzero(&ra_dl, sizeof(ra_pdsch_t));
+  ra_dl.mcs_idx = mcs_idx;
+  ra_dl.alloc_type = alloc_type0;
+  ra_dl.type0_alloc.rbg_bitmask = 0xffffffff;
+  dci_msg_pack_pdsch(&ra_dl, &dci_msg, Format1, cell.nof_prb, false);
+  ra_prb_get_dl(&prb_alloc, &ra_dl, cell.nof_prb);
+  ra_prb_get_re_dl(&prb_alloc, cell.nof_prb, 1, cell.nof_prb<10?(cfi+1):cfi, cell.cp);
+  ra_mcs_from_idx_dl(mcs_idx, cell.nof_prb, &ra_dl.mcs);
+  if (pdsch_harq_setup(&harq_process, ra_dl.mcs, &prb_alloc)) {
+    fprintf(stderr, "Error configuring HARQ process\n");
+    exit(-1);
+  }
+  tbs = ra_dl.mcs.tbs;
+
+  rx_buffer = malloc(sizeof(cf_t) * enb_dl.sf_n_samples);
+  rx_data = malloc(sizeof(char) * tbs);
+  if (!rx_buffer || !rx_data) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (i = 0; i < NOF_TX_DATA; i++) {
+    tx_data[i] = malloc(sizeof(char) * tbs);
+    if (!tx_data[i]) {
+      perror("malloc");
+      exit(-1);
+    }
+  }
+
+  enb_dl_set_sender(&enb_dl, rx_subframe, NULL);
+  if (output_file_name) {
+    if (enb_dl_set_file_sink(&enb_dl, output_file_name)) {
+      exit(-1);
+    }
+  }
+
+  next_timestamp = 1000;
+  next_tti = start_tti;
+  if (enb_dl_start(&enb_dl, next_timestamp)) {
+    fprintf(stderr, "Error starting eNodeB DL\n");
+    exit(-1);
+  }
+
+  for (tti = start_tti; tti < start_tti + nof_frames * NSUBFRAMES_X_FRAME; tti++) {
+    if (!enb_dl_sf_begin(&enb_dl, tti)) {
+      goto quit;
+    }
+    nof_locations = pdcch_ue_locations(&enb_dl.pdcch, locations, 10,
+        tti % NSUBFRAMES_X_FRAME, cfi, RNTI);
+    if (!nof_locations ||
+        enb_dl_put_pdcch(&enb_dl, &dci_msg, locations[0], RNTI)) {
+      fprintf(stderr, "Error encoding DCI message\n");
+      goto quit;
+    }
+    for (j = 0; j < tbs; j++) {
+      tx_data[tti % NOF_TX_DATA][j] = rand() % 2;
+    }
+    if (enb_dl_put_pdsch(&enb_dl, &harq_process, tx_data[tti % NOF_TX_DATA], 0, RNTI)) {
+      fprintf(stderr, "Error encoding PDSCH\n");
+      goto quit;
+    }
+    enb_dl_sf_end(&enb_dl);
+  }
+  if (enb_dl_stop(&enb_dl)) {
+    goto quit;
+  }
+
+  if (enb_dl_nof_sf_sent(&enb_dl) != nof_frames * NSUBFRAMES_X_FRAME) {
+    fprintf(stderr, "Sent %lu subframes\n", enb_dl_nof_sf_sent(&enb_dl));
+  } else if (nof_errors == 0) {
+    ret = 0;
+  }
+
+quit:
+  pdsch_harq_free(&harq_process);
+  enb_dl_free(&enb_dl);
+  ue_dl_free(&ue_dl);
+  for (i = 0; i < NOF_TX_DATA; i++) {
+    free(tx_data[i]);
+  }
+  free(rx_buffer);
+  free(rx_data);
+  if (ret) {
+    printf("Error (%d errors)\n", nof_errors);
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
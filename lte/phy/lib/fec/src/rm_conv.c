@@ -26,8 +26,10 @@
  */
 
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "liblte/phy/fec/rm_conv.h"
 
@@ -40,11 +42,11 @@ uint8_t RM_PERM_CC_INV[NCOLS] =
     { 16, 0, 24, 8, 20, 4, 28, 12, 18, 2, 26, 10, 22, 6, 30, 14, 17, 1, 25, 9,
         21, 5, 29, 13, 19, 3, 27, 11, 23, 7, 31, 15 };
 
-int rm_conv_tx(char *input, uint32_t in_len, char *output, uint32_t out_len) {
-
-  char tmp[3 * NCOLS * NROWS_MAX];
+/* Sub-block interleaver 5.1.4.2.1. Writes 3*K_p bits to tmp, dummy bits are 
+ * set to TX_NULL. Returns K_p or -1 if the input is too large.
+ */
+static int rm_conv_interleave(char *input, uint32_t in_len, char *tmp) {
   int nrows, ndummy, K_p;
-
   int i, j, k, s;
 
   nrows = (uint32_t) (in_len / 3 - 1) / NCOLS + 1;
@@ -58,7 +60,6 @@ int rm_conv_tx(char *input, uint32_t in_len, char *output, uint32_t out_len) {
   if (ndummy < 0) {
     ndummy = 0;
   }
-  /* Sub-block interleaver 5.1.4.2.1 */
   k = 0;
   for (s = 0; s < 3; s++) {
     for (j = 0; j < NCOLS; j++) {
@@ -72,6 +73,20 @@ int rm_conv_tx(char *input, uint32_t in_len, char *output, uint32_t out_len) {
       }
     }
   }
+  return K_p;
+}
+
+int rm_conv_tx(char *input, uint32_t in_len, char *output, uint32_t out_len) {
+
+  char tmp[3 * NCOLS * NROWS_MAX];
+  int K_p;
+
+  int j, k;
+
+  K_p = rm_conv_interleave(input, in_len, tmp);
+  if (K_p < 0) {
+    return -1;
+  }
   /* Bit collection, selection and transmission 5.1.4.2.2 */
   k = 0;
   j = 0;
@@ -88,6 +103,43 @@ int rm_conv_tx(char *input, uint32_t in_len, char *output, uint32_t out_len) {
   return 0;
 }
 
+/* Same as rm_conv_tx() but passes the bits offset to offset+out_len-1 of the 
+ * rate matched sequence to the modulation stream s, which scrambles and 
+ * modulates them. Since the circular buffer without the dummy bits is in_len 
+ * bits long, it is read in runs of up to in_len bits. 
+ */
+int rm_conv_tx_mod(char *input, uint32_t in_len, mod_stream_t *s, uint32_t offset, 
+    uint32_t out_len) {
+
+  char tmp[3 * NCOLS * NROWS_MAX];
+  uint32_t j, k, n;
+  int K_p;
+
+  K_p = rm_conv_interleave(input, in_len, tmp);
+  if (K_p < 0) {
+    return -1;
+  }
+  /* remove the dummy bits */
+  k = 0;
+  for (j = 0; j < 3 * K_p; j++) {
+    if (tmp[j] != TX_NULL) {
+      tmp[k++] = tmp[j];
+    }
+  }
+  k = 0;
+  j = offset % in_len;
+  while (k < out_len) {
+    n = in_len - j;
+    if (n > out_len - k) {
+      n = out_len - k;
+    }
+    mod_stream_bits(s, &tmp[j], n);
+    k += n;
+    j = 0;
+  }
+  return 0;
+}
+
 /* Undoes Convolutional Code Rate Matching.
  * 3GPP TS 36.212 v10.1.0 section 5.1.4.2
  */
@@ -153,6 +205,146 @@ int rm_conv_rx(float *input, uint32_t in_len, float *output, uint32_t out_len) {
   return 0;
 }
 
+int rm_conv_init(rm_conv_t *q) {
+  bzero(q, sizeof(rm_conv_t));
+  q->acc = malloc(sizeof(float) * 3 * NCOLS * NROWS_MAX);
+  if (!q->acc) {
+    perror("malloc");
+    return LIBLTE_ERROR;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+void rm_conv_free(rm_conv_t *q) {
+  uint32_t i;
+
+  for (i = 0; i < RM_CONV_MAX_TABLES; i++) {
+    if (q->table[i]) {
+      free(q->table[i]);
+    }
+  }
+  if (q->acc) {
+    free(q->acc);
+  }
+  bzero(q, sizeof(rm_conv_t));
+}
+
+/* Generates the table of the circular buffer position of every bit of a code
+ * block of out_len bits, following the bit collection of rm_conv_rx() 
+ */
+static void rm_conv_gen_table(uint16_t *table, uint32_t out_len) {
+  uint32_t nrows, ndummy, K_p, j, p, idx;
+
+  nrows = (out_len / 3 - 1) / NCOLS + 1;
+  K_p = nrows * NCOLS;
+  ndummy = K_p - out_len / 3;
+  p = 0;
+  for (j = 0; j < 3 * K_p; j++) {
+    idx = ((j % K_p) % nrows) * NCOLS + RM_PERM_CC[(j % K_p) / nrows];
+    if (idx >= ndummy) {
+      table[3 * (idx - ndummy) + j / K_p] = p++;
+    }
+  }
+}
+
+/* Returns the table for out_len, generating it if it is not cached */
+static uint16_t* rm_conv_get_table(rm_conv_t *q, uint32_t out_len) {
+  uint32_t i;
+
+  for (i = 0; i < q->nof_tables; i++) {
+    if (q->len[i] == out_len) {
+      return q->table[i];
+    }
+  }
+  if (q->nof_tables < RM_CONV_MAX_TABLES) {
+    i = q->nof_tables++;
+    q->table[i] = malloc(sizeof(uint16_t) * 3 * NCOLS * NROWS_MAX);
+    if (!q->table[i]) {
+      perror("malloc");
+      q->nof_tables--;
+      return NULL;
+    }
+  } else {
+    i = q->next;
+    q->next = (q->next + 1) % RM_CONV_MAX_TABLES;
+  }
+  rm_conv_gen_table(q->table[i], out_len);
+  q->len[i] = out_len;
+  return q->table[i];
+}
+
+static void rm_conv_rx_table(float * restrict acc, uint16_t *table, float *input, 
+                             uint32_t in_len, float * restrict output, uint32_t out_len) 
+{
+  uint32_t i, k, n;
+  float x;
+
+  bzero(acc, sizeof(float) * out_len);
+  for (k = 0; k < in_len; k += n) {
+    n = in_len - k < out_len ? in_len - k : out_len;
+    for (i = 0; i < n; i++) {
+      x = input[k + i];
+      acc[i] += x == RX_NULL ? 0 : x;
+    }
+  }
+  for (i = 0; i < out_len; i++) {
+    output[i] = acc[table[i]];
+  }
+}
+
+/* Same as rm_conv_rx() using the cached table for out_len, which must be a 
+ * multiple of 3. Bits not received are 0 in the output. 
+ */
+int rm_conv_rx_cached(rm_conv_t *q, float *input, uint32_t in_len, float *output, 
+                      uint32_t out_len) 
+{
+  uint16_t *table;
+
+  if (q                 != NULL   &&
+      input             != NULL   &&
+      output            != NULL   &&
+      out_len           >  0      &&
+      out_len % 3       == 0      &&
+      out_len           <= 3 * NCOLS * NROWS_MAX)
+  {
+    table = rm_conv_get_table(q, out_len);
+    if (!table) {
+      return LIBLTE_ERROR;
+    }
+    rm_conv_rx_table(q->acc, table, input, in_len, output, out_len);
+    return LIBLTE_SUCCESS;
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
+/* Undoes the rate matching of nof_inputs sequences of in_len LLRs, for 
+ * instance all the candidates of one aggregation level and DCI format 
+ */
+int rm_conv_rx_batch(rm_conv_t *q, float **input, uint32_t in_len, float **output, 
+                     uint32_t out_len, uint32_t nof_inputs) 
+{
+  uint16_t *table;
+  uint32_t i;
+
+  if (q                 != NULL   &&
+      input             != NULL   &&
+      output            != NULL   &&
+      out_len           >  0      &&
+      out_len % 3       == 0      &&
+      out_len           <= 3 * NCOLS * NROWS_MAX)
+  {
+    table = rm_conv_get_table(q, out_len);
+    if (!table) {
+      return LIBLTE_ERROR;
+    }
+    for (i = 0; i < nof_inputs; i++) {
+      rm_conv_rx_table(q->acc, table, input[i], in_len, output[i], out_len);
+    }
+    return LIBLTE_SUCCESS;
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
 /** High-level API */
 
 int rm_conv_initialize(rm_conv_hl* h) {
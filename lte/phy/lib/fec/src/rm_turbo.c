@@ -41,25 +41,17 @@ uint8_t RM_PERM_TC[NCOLS] = { 0, 16, 8, 24, 4, 20, 12, 28, 2, 18, 10, 26,
     6, 22, 14, 30, 1, 17, 9, 25, 5, 21, 13, 29, 3, 19, 11, 27, 7, 23, 15, 31 };
 
 
-/* Turbo Code Rate Matching.
- * 3GPP TS 36.212 v10.1.0 section 5.1.4.1
- *
- * If rv_idx==0, the circular buffer w_buff is filled with all redundancy versions and 
- * the corresponding version of length out_len is saved in the output buffer.  
- * Otherwise, the corresponding version is directly obtained from w_buff and saved into output. 
- * 
- * Note that calling this function with rv_idx!=0 without having called it first with rv_idx=0
- * will produce unwanted results. 
- * 
- * TODO: Soft buffer size limitation according to UE category
+/* Fills the circular buffer w_buff with all the redundancy versions of input
+ * (sub-block interleaving and bit collection, 5.1.4.1.1) if rv_idx==0 and 
+ * returns in N_cb and k0 its length and the starting position of rv_idx. 
  */
-int rm_turbo_tx(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, char *output,
-    uint32_t out_len, uint32_t rv_idx) {
+static int rm_turbo_tx_buff(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, 
+    uint32_t rv_idx, uint32_t *N_cb, uint32_t *k0) {
 
   int ndummy, kidx; 
   int nrows, K_p;
 
-  int i, j, k, s, N_cb, k0;
+  int i, j, k, s;
 
   nrows = (uint32_t) (in_len / 3 - 1) / NCOLS + 1;
   K_p = nrows * NCOLS;
@@ -107,11 +99,35 @@ int rm_turbo_tx(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len,
     }
   }
 
-  /* Bit selection and transmission 5.1.4.1.2 */
-  N_cb = 3 * K_p;       // TODO: Soft buffer size limitation
+  *N_cb = 3 * K_p;       // TODO: Soft buffer size limitation
 
-  k0 = nrows
-      * (2 * (uint32_t) ceilf((float) N_cb / (float) (8 * nrows)) * rv_idx + 2);
+  *k0 = nrows
+      * (2 * (uint32_t) ceilf((float) *N_cb / (float) (8 * nrows)) * rv_idx + 2);
+  return 0;
+}
+
+/* Turbo Code Rate Matching.
+ * 3GPP TS 36.212 v10.1.0 section 5.1.4.1
+ *
+ * If rv_idx==0, the circular buffer w_buff is filled with all redundancy versions and 
+ * the corresponding version of length out_len is saved in the output buffer.  
+ * Otherwise, the corresponding version is directly obtained from w_buff and saved into output. 
+ * 
+ * Note that calling this function with rv_idx!=0 without having called it first with rv_idx=0
+ * will produce unwanted results. 
+ * 
+ * TODO: Soft buffer size limitation according to UE category
+ */
+int rm_turbo_tx(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, char *output,
+    uint32_t out_len, uint32_t rv_idx) {
+
+  uint32_t j, k, N_cb, k0;
+
+  if (rm_turbo_tx_buff(w_buff, w_buff_len, input, in_len, rv_idx, &N_cb, &k0)) {
+    return -1;
+  }
+
+  /* Bit selection and transmission 5.1.4.1.2 */
   k = 0;
   j = 0;
 
@@ -125,6 +141,42 @@ int rm_turbo_tx(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len,
   return 0;
 }
 
+/* Same as rm_turbo_tx() but, instead of writing the out_len selected bits, 
+ * passes them to the modulation stream s, which scrambles and modulates them.
+ * The circular buffer is read in runs of consecutive non-dummy bits.
+ */
+int rm_turbo_tx_mod(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, 
+    mod_stream_t *s, uint32_t out_len, uint32_t rv_idx) {
+
+  uint32_t j, k, n, N_cb, k0;
+  char *null;
+
+  if (rm_turbo_tx_buff(w_buff, w_buff_len, input, in_len, rv_idx, &N_cb, &k0)) {
+    return -1;
+  }
+
+  /* Bit selection and transmission 5.1.4.1.2 */
+  k = 0;
+  j = k0 % N_cb;
+  while (k < out_len) {
+    null = memchr(&w_buff[j], TX_NULL, N_cb - j);
+    n = null ? (uint32_t) (null - &w_buff[j]) : N_cb - j;
+    if (n > out_len - k) {
+      n = out_len - k;
+    }
+    mod_stream_bits(s, &w_buff[j], n);
+    k += n;
+    j += n;
+    if (null && j == (uint32_t) (null - w_buff)) {
+      j++;
+    }
+    if (j == N_cb) {
+      j = 0;
+    }
+  }
+  return 0;
+}
+
 /* Undoes Turbo Code Rate Matching.
  * 3GPP TS 36.212 v10.1.0 section 5.1.4.1
  * 
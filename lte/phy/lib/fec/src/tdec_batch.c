@@ -0,0 +1,417 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "liblte/phy/fec/tdec_batch.h"
+#include "liblte/phy/fec/rm_turbo.h"
+#include "liblte/phy/utils/debug.h"
+#include "liblte/phy/utils/trace.h"
+
+#define L TDEC_BATCH_LANES
+
+/* The recursions are those of map_gen_beta() and map_gen_alpha() with every
+ * metric replaced by a vector of L lanes, in the same order of operations, so
+ * that each lane gives the same result as tdec_t. Every statement is a loop 
+ * over the lanes of metrics kept in memory, which the compiler vectorizes.
+ */
+#define LANES(stmt) for (l = 0; l < L; l++) { stmt; }
+#define BMAX(a, b)  ((a) > (b) ? (a) : (b))
+
+/* Computes the beta metrics of step k (new) from those of step k+1 (old) */
+static inline void batch_beta_step(const llr_t * restrict old, llr_t * restrict new, 
+                                   const llr_t * restrict x, const llr_t * restrict y)
+{
+  llr_t xy[L];
+  uint32_t l;
+
+  LANES(xy[l] = x[l] + y[l]);
+
+  LANES(new[0 * L + l] = BMAX(old[4 * L + l] + xy[l], old[0 * L + l]));
+  LANES(new[1 * L + l] = BMAX(old[4 * L + l], old[0 * L + l] + xy[l]));
+  LANES(new[2 * L + l] = BMAX(old[5 * L + l] + y[l], old[1 * L + l] + x[l]));
+  LANES(new[3 * L + l] = BMAX(old[5 * L + l] + x[l], old[1 * L + l] + y[l]));
+  LANES(new[4 * L + l] = BMAX(old[6 * L + l] + x[l], old[2 * L + l] + y[l]));
+  LANES(new[5 * L + l] = BMAX(old[6 * L + l] + y[l], old[2 * L + l] + x[l]));
+  LANES(new[6 * L + l] = BMAX(old[7 * L + l], old[3 * L + l] + xy[l]));
+  LANES(new[7 * L + l] = BMAX(old[7 * L + l] + xy[l], old[3 * L + l]));
+}
+
+/* Paths into state s of step k+1 with bit 0 (a) and 1 (b): accumulates the 
+ * LLR metrics with beta[k+1] and computes alpha[k+1] 
+ */
+#define ALPHA_STATE(s, a, b)                                    \
+  LANES(m0[l] = BMAX((a) + beta[s * L + l], m0[l]);             \
+        m1[l] = BMAX((b) + beta[s * L + l], m1[l]);             \
+        new[s * L + l] = BMAX((a), (b)))
+
+/* Computes the alpha metrics of step k+1 (new) from those of step k (old) and 
+ * the LLR of bit k using beta[k+1] 
+ */
+static inline void batch_alpha_step(const llr_t * restrict old, llr_t * restrict new, 
+                                    const llr_t * restrict x, const llr_t * restrict y, 
+                                    const llr_t * restrict beta, llr_t * restrict output)
+{
+  llr_t xy[L], m0[L], m1[L];
+  uint32_t l;
+
+  LANES(xy[l] = x[l] + y[l]);
+
+  LANES(m0[l] = old[0 * L + l] + beta[l];
+        m1[l] = old[1 * L + l] + xy[l] + beta[l];
+        new[l] = BMAX(old[0 * L + l], old[1 * L + l] + xy[l]));
+  ALPHA_STATE(1, old[3 * L + l] + y[l], old[2 * L + l] + x[l]);
+  ALPHA_STATE(2, old[4 * L + l] + y[l], old[5 * L + l] + x[l]);
+  ALPHA_STATE(3, old[7 * L + l], old[6 * L + l] + xy[l]);
+  ALPHA_STATE(4, old[1 * L + l], old[0 * L + l] + xy[l]);
+  ALPHA_STATE(5, old[2 * L + l] + y[l], old[3 * L + l] + x[l]);
+  ALPHA_STATE(6, old[5 * L + l] + y[l], old[4 * L + l] + x[l]);
+  ALPHA_STATE(7, old[6 * L + l], old[7 * L + l] + xy[l]);
+
+  LANES(output[l] = m1[l] - m0[l]);
+}
+
+static void batch_map(tdec_batch_t *q, llr_t *output, uint32_t long_cb)
+{
+  uint32_t i, l, k;
+  int j;
+  llr_t *beta = q->beta;
+
+  for (i = 0; i < 8; i++) {
+    LANES(beta[8 * L * (long_cb + TAIL) + i * L + l] = i ? -INF : 0);
+    LANES(q->alpha[0][i * L + l] = i ? -INF : 0);
+  }
+  for (j = long_cb + TAIL - 1; j >= 0; j--) {
+    batch_beta_step(&beta[8 * L * (j + 1)], &beta[8 * L * j], &q->syst[j * L], 
+                    &q->parity[j * L]);
+  }
+  for (k = 0; k < long_cb; k++) {
+    batch_alpha_step(q->alpha[k % 2], q->alpha[(k + 1) % 2], &q->syst[k * L], 
+                     &q->parity[k * L], &beta[8 * L * (k + 1)], &output[k * L]);
+  }
+}
+
+/* Same as tdec_iteration() for the L lanes */
+static void batch_iteration(tdec_batch_t *q, uint32_t *forward, uint32_t *reverse, 
+                            uint32_t long_cb)
+{
+  uint32_t i, l;
+  llr_t *in = q->input;
+
+  TRACE_BEGIN(TRACE_TURBO_ITER);
+  for (i = 0; i < long_cb; i++) {
+    for (l = 0; l < L; l++) {
+      q->syst[i * L + l] = in[RATE * i * L + l] + q->w[i * L + l];
+      q->parity[i * L + l] = in[(RATE * i + 1) * L + l];
+    }
+  }
+  for (i = long_cb; i < long_cb + RATE; i++) {
+    for (l = 0; l < L; l++) {
+      q->syst[i * L + l] = in[(RATE * long_cb + NINPUTS * (i - long_cb)) * L + l];
+      q->parity[i * L + l] = in[(RATE * long_cb + NINPUTS * (i - long_cb) + 1) * L + l];
+    }
+  }
+  batch_map(q, q->llr1, long_cb);
+
+  for (i = 0; i < long_cb; i++) {
+    for (l = 0; l < L; l++) {
+      q->syst[i * L + l] = q->llr1[forward[i] * L + l] - q->w[forward[i] * L + l];
+      q->parity[i * L + l] = in[(RATE * i + 2) * L + l];
+    }
+  }
+  for (i = long_cb; i < long_cb + RATE; i++) {
+    for (l = 0; l < L; l++) {
+      q->syst[i * L + l] = 
+          in[(RATE * long_cb + NINPUTS * RATE + NINPUTS * (i - long_cb)) * L + l];
+      q->parity[i * L + l] = 
+          in[(RATE * long_cb + NINPUTS * RATE + NINPUTS * (i - long_cb) + 1) * L + l];
+    }
+  }
+  batch_map(q, q->llr2, long_cb);
+
+  for (i = 0; i < long_cb; i++) {
+    for (l = 0; l < L; l++) {
+      q->w[i * L + l] += q->llr2[reverse[i] * L + l] - q->llr1[i * L + l];
+    }
+  }
+  TRACE_END(TRACE_TURBO_ITER);
+}
+
+int tdec_batch_init(tdec_batch_t *q, uint32_t max_long_cb)
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  uint32_t len = max_long_cb + TOTALTAIL;
+
+  if (q != NULL && max_long_cb > 0) {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(tdec_batch_t));
+    q->max_long_cb = max_long_cb;
+
+    if (tc_interl_init(&q->interl, max_long_cb)) {
+      goto clean;
+    }
+    if (crc_init(&q->crc_24a, LTE_CRC24A, 24) || crc_init(&q->crc_24b, LTE_CRC24B, 24)) {
+      goto clean;
+    }
+    q->cb = malloc(sizeof(llr_t) * (RATE * max_long_cb + TOTALTAIL));
+    q->input = malloc(sizeof(llr_t) * L * (RATE * max_long_cb + TOTALTAIL));
+    q->syst = malloc(sizeof(llr_t) * L * len);
+    q->parity = malloc(sizeof(llr_t) * L * len);
+    q->w = malloc(sizeof(llr_t) * L * len);
+    q->llr1 = malloc(sizeof(llr_t) * L * len);
+    q->llr2 = malloc(sizeof(llr_t) * L * len);
+    q->beta = malloc(sizeof(llr_t) * L * NUMSTATES * (len + 1));
+    if (!q->cb || !q->input || !q->syst || !q->parity || !q->w || !q->llr1 || 
+        !q->llr2 || !q->beta) 
+    {
+      perror("malloc");
+      goto clean;
+    }
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    tdec_batch_free(q);
+  }
+  return ret;
+}
+
+void tdec_batch_free(tdec_batch_t *q)
+{
+  uint32_t i;
+
+  for (i = 0; i < NOF_TC_CB_SIZES; i++) {
+    if (q->forward[i]) {
+      free(q->forward[i]);
+    }
+    if (q->reverse[i]) {
+      free(q->reverse[i]);
+    }
+  }
+  tc_interl_free(&q->interl);
+  if (q->order) {
+    free(q->order);
+  }
+  if (q->cb) {
+    free(q->cb);
+  }
+  if (q->input) {
+    free(q->input);
+  }
+  if (q->syst) {
+    free(q->syst);
+  }
+  if (q->parity) {
+    free(q->parity);
+  }
+  if (q->w) {
+    free(q->w);
+  }
+  if (q->llr1) {
+    free(q->llr1);
+  }
+  if (q->llr2) {
+    free(q->llr2);
+  }
+  if (q->beta) {
+    free(q->beta);
+  }
+  bzero(q, sizeof(tdec_batch_t));
+}
+
+/* Generates the interleaver of code block size index idx the first time it is used */
+static int batch_interleaver(tdec_batch_t *q, uint32_t idx)
+{
+  uint32_t long_cb = lte_cb_size(idx);
+
+  if (!q->forward[idx]) {
+    if (tc_interl_LTE_gen(&q->interl, long_cb)) {
+      return LIBLTE_ERROR;
+    }
+    q->forward[idx] = malloc(sizeof(uint32_t) * long_cb);
+    q->reverse[idx] = malloc(sizeof(uint32_t) * long_cb);
+    if (!q->forward[idx] || !q->reverse[idx]) {
+      perror("malloc");
+      return LIBLTE_ERROR;
+    }
+    memcpy(q->forward[idx], q->interl.forward, sizeof(uint32_t) * long_cb);
+    memcpy(q->reverse[idx], q->interl.reverse, sizeof(uint32_t) * long_cb);
+  }
+  return LIBLTE_SUCCESS;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t*) a, y = *(const uint32_t*) b;
+  return x < y ? -1 : x > y;
+}
+
+static bool batch_check_job(tdec_batch_t *q, tdec_job_t *job)
+{
+  int idx;
+
+  if (job->llr == NULL || job->output == NULL || job->long_cb > q->max_long_cb || 
+      job->nof_filler >= job->long_cb || job->crc > TDEC_CRC_24B) 
+  {
+    return false;
+  }
+  idx = lte_find_cb_index(job->long_cb);
+  return idx >= 0 && lte_cb_size(idx) == job->long_cb;
+}
+
+/* Copies the code block LLRs of the job into lane l, rate dematching them if
+ * the job has a HARQ buffer 
+ */
+static int batch_load(tdec_batch_t *q, tdec_job_t *job, uint32_t l)
+{
+  uint32_t i, len = RATE * job->long_cb + TOTALTAIL;
+  llr_t *cb = job->llr;
+
+  if (job->w_buff) {
+    if (rm_turbo_rx(job->w_buff, job->w_buff_size, job->llr, job->e_len, q->cb, len, 
+                    job->rv_idx)) 
+    {
+      return LIBLTE_ERROR;
+    }
+    cb = q->cb;
+  }
+  for (i = 0; i < len; i++) {
+    q->input[i * L + l] = cb[i];
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/* Decodes up to L jobs of the same code block size */
+static int batch_decode_group(tdec_batch_t *q, tdec_job_t **jobs, uint32_t nof_jobs,
+                              uint32_t idx, uint32_t max_iterations)
+{
+  uint32_t i, l, it, nof_done, long_cb = lte_cb_size(idx);
+  uint32_t *reverse;
+  bool done[L];
+  crc_t *crc;
+  tdec_job_t *job;
+
+  if (batch_interleaver(q, idx)) {
+    return LIBLTE_ERROR;
+  }
+  reverse = q->reverse[idx];
+
+  /* padding lanes decode zero LLRs */
+  bzero(q->input, sizeof(llr_t) * L * (RATE * long_cb + TOTALTAIL));
+  bzero(q->w, sizeof(llr_t) * L * long_cb);
+  for (l = 0; l < nof_jobs; l++) {
+    jobs[l]->crc_ok = false;
+    jobs[l]->nof_iterations = 0;
+    if (batch_load(q, jobs[l], l)) {
+      return LIBLTE_ERROR;
+    }
+    done[l] = false;
+  }
+
+  nof_done = 0;
+  for (it = 0; it < max_iterations && nof_done < nof_jobs; it++) {
+    batch_iteration(q, q->forward[idx], reverse, long_cb);
+
+    for (l = 0; l < nof_jobs; l++) {
+      if (done[l]) {
+        continue;
+      }
+      job = jobs[l];
+      job->nof_iterations++;
+      for (i = 0; i < long_cb; i++) {
+        job->output[i] = q->llr2[reverse[i] * L + l] > 0 ? 1 : 0;
+      }
+      if (job->crc != TDEC_CRC_NONE) {
+        crc = job->crc == TDEC_CRC_24A ? &q->crc_24a : &q->crc_24b;
+        if (!crc_checksum(crc, &job->output[job->nof_filler], long_cb - job->nof_filler)) {
+          job->crc_ok = true;
+          done[l] = true;
+          nof_done++;
+        }
+      }
+    }
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/** Decodes nof_jobs code blocks with up to max_iterations iterations each. 
+ * Sets crc_ok and nof_iterations of every job. Returns LIBLTE_ERROR_INVALID_INPUTS
+ * without decoding if any job is not valid, and LIBLTE_ERROR if the rate 
+ * dematching of a job fails.
+ */
+int tdec_batch_run(tdec_batch_t *q, tdec_job_t *jobs, uint32_t nof_jobs, uint32_t max_iterations)
+{
+  tdec_job_t *group[L];
+  uint32_t i, j, n, idx;
+
+  if (q == NULL || jobs == NULL || nof_jobs > 0xffff) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  for (i = 0; i < nof_jobs; i++) {
+    if (!batch_check_job(q, &jobs[i])) {
+      fprintf(stderr, "Invalid turbo decoder job %d\n", i);
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
+  }
+  if (nof_jobs > q->max_jobs) {
+    if (q->order) {
+      free(q->order);
+    }
+    q->order = malloc(sizeof(uint32_t) * nof_jobs);
+    if (!q->order) {
+      perror("malloc");
+      q->max_jobs = 0;
+      return LIBLTE_ERROR;
+    }
+    q->max_jobs = nof_jobs;
+  }
+
+  /* sort the jobs by code block size index, then by position */
+  for (i = 0; i < nof_jobs; i++) {
+    q->order[i] = (lte_find_cb_index(jobs[i].long_cb) << 16) | i;
+  }
+  qsort(q->order, nof_jobs, sizeof(uint32_t), compare_u32);
+
+  i = 0;
+  while (i < nof_jobs) {
+    idx = q->order[i] >> 16;
+    n = 0;
+    for (j = i; j < nof_jobs && n < L && (q->order[j] >> 16) == idx; j++) {
+      group[n++] = &jobs[q->order[j] & 0xffff];
+    }
+    DEBUG("Decoding %d code blocks of %d bits\n", n, lte_cb_size(idx));
+    if (batch_decode_group(q, group, n, idx, max_iterations)) {
+      return LIBLTE_ERROR;
+    }
+    i = j;
+  }
+  return LIBLTE_SUCCESS;
+}
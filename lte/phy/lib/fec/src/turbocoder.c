@@ -25,124 +25,259 @@
  *
  */
 
-
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 
+#include "liblte/phy/common/phy_common.h"
 #include "liblte/phy/fec/turbocoder.h"
 
 #define NOF_REGS 3
 
+/* The state of each constituent encoder is coded as reg0 | reg1 << 1 | reg2 << 2 */
+#define STATE_REG0(s)  ((s) & 1)
+#define STATE_REG1(s)  (((s) >> 1) & 1)
+#define STATE_REG2(s)  (((s) >> 2) & 1)
+
+/* Clocks the constituent encoder once with input bit. Returns the parity bit */
+static inline uint8_t rsc_step(uint8_t *state, uint8_t bit) {
+  uint8_t s = *state;
+  uint8_t in = bit ^ STATE_REG2(s) ^ STATE_REG1(s);
+  uint8_t out = STATE_REG2(s) ^ STATE_REG0(s) ^ in;
+  *state = ((s << 1) | in) & 0x7;
+  return out;
+}
+
+/* Generates the tables that clock the encoder 8 times (MSB first) for every
+ * state and input byte, and the table that interleaves 3 bytes bit by bit
+ */
+static void tcod_gen_tables(tcod_t *h) {
+  uint32_t s, b, j;
+  uint8_t state, parity;
+
+  for (s = 0; s < TCOD_NOF_STATES; s++) {
+    for (b = 0; b < 256; b++) {
+      state = (uint8_t) s;
+      parity = 0;
+      for (j = 0; j < 8; j++) {
+        parity = (parity << 1) | rsc_step(&state, (b >> (7 - j)) & 1);
+      }
+      h->next_state[s][b] = state;
+      h->parity[s][b] = parity;
+    }
+  }
+  for (b = 0; b < 256; b++) {
+    h->spread[b] = 0;
+    for (j = 0; j < 8; j++) {
+      if (b & (1 << (7 - j))) {
+        h->spread[b] |= 1 << (23 - 3 * j);
+      }
+    }
+  }
+}
+
 int tcod_init(tcod_t *h, uint32_t max_long_cb) {
 
+  bzero(h, sizeof(tcod_t));
   if (tc_interl_init(&h->interl, max_long_cb)) {
     return -1;
   }
   h->max_long_cb = max_long_cb;
+
+  h->input_packed = malloc(sizeof(uint8_t) * (max_long_cb / 8 + 1));
+  h->input_interl = malloc(sizeof(uint8_t) * (max_long_cb / 8 + 1));
+  h->parity1 = malloc(sizeof(uint8_t) * (max_long_cb / 8 + 1));
+  h->parity2 = malloc(sizeof(uint8_t) * (max_long_cb / 8 + 1));
+  if (!h->input_packed || !h->input_interl || !h->parity1 || !h->parity2) {
+    perror("malloc");
+    tcod_free(h);
+    return -1;
+  }
+  tcod_gen_tables(h);
   return 0;
 }
 
 void tcod_free(tcod_t *h) {
+  uint32_t i;
+
   tc_interl_free(&h->interl);
-  h->max_long_cb = 0;
+  for (i = 0; i < NOF_TC_CB_SIZES; i++) {
+    if (h->perm[i]) {
+      free(h->perm[i]);
+    }
+  }
+  if (h->input_packed) {
+    free(h->input_packed);
+  }
+  if (h->input_interl) {
+    free(h->input_interl);
+  }
+  if (h->parity1) {
+    free(h->parity1);
+  }
+  if (h->parity2) {
+    free(h->parity2);
+  }
+  bzero(h, sizeof(tcod_t));
 }
 
-int tcod_encode(tcod_t *h, char *input, char *output, uint32_t long_cb) {
-
-  char reg1_0, reg1_1, reg1_2, reg2_0, reg2_1, reg2_2;
-  uint32_t i, k = 0, j;
-  char bit;
-  char in, out;
-  uint32_t *per;
+/* Returns the QPP interleaver for long_cb, generating it the first time that
+ * this code block size is used.
+ */
+static uint16_t* tcod_get_perm(tcod_t *h, uint32_t long_cb) {
+  uint32_t i;
+  int idx;
 
   if (long_cb > h->max_long_cb) {
     fprintf(stderr, "Turbo coder initiated for max_long_cb=%d\n",
         h->max_long_cb);
-    return -1;
+    return NULL;
   }
-
-  if (tc_interl_LTE_gen(&h->interl, long_cb)) {
-    fprintf(stderr, "Error initiating TC interleaver\n");
-    return -1;
+  idx = lte_find_cb_index(long_cb);
+  if (idx < 0 || lte_cb_size(idx) != long_cb) {
+    fprintf(stderr, "Invalid code block size %d\n", long_cb);
+    return NULL;
   }
+  if (!h->perm[idx]) {
+    if (tc_interl_LTE_gen(&h->interl, long_cb)) {
+      fprintf(stderr, "Error initiating TC interleaver\n");
+      return NULL;
+    }
+    h->perm[idx] = malloc(sizeof(uint16_t) * long_cb);
+    if (!h->perm[idx]) {
+      perror("malloc");
+      return NULL;
+    }
+    for (i = 0; i < long_cb; i++) {
+      h->perm[idx][i] = (uint16_t) h->interl.forward[i];
+    }
+  }
+  return h->perm[idx];
+}
 
-  per = h->interl.forward;
-
-  reg1_0 = 0;
-  reg1_1 = 0;
-  reg1_2 = 0;
-
-  reg2_0 = 0;
-  reg2_1 = 0;
-  reg2_2 = 0;
-
-  k = 0;
-  for (i = 0; i < long_cb; i++) {
-    bit = input[i];
-
-    output[k] = bit;
-    k++;
-
-    in = bit ^ (reg1_2 ^ reg1_1);
-    out = reg1_2 ^ (reg1_0 ^ in);
-
-    reg1_2 = reg1_1;
-    reg1_1 = reg1_0;
-    reg1_0 = in;
-
-    output[k] = out;
-    k++;
-
-    bit = input[per[i]];
-
-    in = bit ^ (reg2_2 ^ reg2_1);
-    out = reg2_2 ^ (reg2_0 ^ in);
-
-    reg2_2 = reg2_1;
-    reg2_1 = reg2_0;
-    reg2_0 = in;
+/* Runs the constituent encoder over nof_bytes packed input bytes. Returns the
+ * final state.
+ */
+static uint8_t tcod_rsc_bytes(tcod_t *h, uint8_t *input, uint8_t *parity, uint32_t nof_bytes) {
+  uint32_t i;
+  uint8_t state = 0;
 
-    output[k] = out;
-    k++;
+  for (i = 0; i < nof_bytes; i++) {
+    parity[i] = h->parity[state][input[i]];
+    state = h->next_state[state][input[i]];
   }
+  return state;
+}
 
-  k = 3 * long_cb;
+/* Trellis termination of one constituent encoder. Writes 6 bits */
+static void tcod_tail(uint8_t state, char *output) {
+  uint32_t j;
+  uint8_t bit;
 
-  /* TAILING CODER #1 */
   for (j = 0; j < NOF_REGS; j++) {
-    bit = reg1_2 ^ reg1_1;
-
-    output[k] = bit;
-    k++;
+    bit = STATE_REG2(state) ^ STATE_REG1(state);
+    output[2 * j] = bit;
+    output[2 * j + 1] = rsc_step(&state, bit);
+  }
+}
 
-    in = bit ^ (reg1_2 ^ reg1_1);
-    out = reg1_2 ^ (reg1_0 ^ in);
+/** Encodes a code block of long_cb bits with both input and output packed in
+ * bytes, MSB first. The output bit sequence is the same as in tcod_encode():
+ * 3*long_cb systematic/parity1/parity2 triplets followed by the 12 tail bits,
+ * so output must have room for (3*long_cb+12)/8 rounded up bytes.
+ */
+int tcod_encode_packed(tcod_t *h, uint8_t *input, uint8_t *output, uint32_t long_cb) {
+  uint16_t *per;
+  uint32_t i, j, nof_bytes, p, w;
+  uint8_t state1, state2, byte;
+  char tail[TOTALTAIL];
+
+  per = tcod_get_perm(h, long_cb);
+  if (!per) {
+    return -1;
+  }
+  nof_bytes = long_cb / 8;
+
+  /* gather the interleaved input */
+  for (i = 0; i < nof_bytes; i++) {
+    byte = 0;
+    for (j = 0; j < 8; j++) {
+      p = per[8 * i + j];
+      byte = (byte << 1) | ((input[p / 8] >> (7 - p % 8)) & 1);
+    }
+    h->input_interl[i] = byte;
+  }
 
-    reg1_2 = reg1_1;
-    reg1_1 = reg1_0;
-    reg1_0 = in;
+  state1 = tcod_rsc_bytes(h, input, h->parity1, nof_bytes);
+  state2 = tcod_rsc_bytes(h, h->input_interl, h->parity2, nof_bytes);
 
-    output[k] = out;
-    k++;
+  for (i = 0; i < nof_bytes; i++) {
+    w = h->spread[input[i]] | (h->spread[h->parity1[i]] >> 1) | (h->spread[h->parity2[i]] >> 2);
+    output[3 * i] = (uint8_t) (w >> 16);
+    output[3 * i + 1] = (uint8_t) (w >> 8);
+    output[3 * i + 2] = (uint8_t) w;
   }
 
-  /* TAILING CODER #2 */
-  for (j = 0; j < NOF_REGS; j++) {
-    bit = reg2_2 ^ reg2_1;
+  tcod_tail(state1, tail);
+  tcod_tail(state2, &tail[2 * NOF_REGS]);
+  byte = 0;
+  for (j = 0; j < 8; j++) {
+    byte = (byte << 1) | tail[j];
+  }
+  output[3 * nof_bytes] = byte;
+  byte = 0;
+  for (j = 8; j < TOTALTAIL; j++) {
+    byte = (byte << 1) | tail[j];
+  }
+  output[3 * nof_bytes + 1] = byte << 4;
+  return 0;
+}
 
-    output[k] = bit;
-    k++;
+/** Encodes a code block of long_cb bits, one bit per char in input and output.
+ * Writes 3*long_cb+12 bits.
+ */
+int tcod_encode(tcod_t *h, char *input, char *output, uint32_t long_cb) {
+  uint16_t *per;
+  uint32_t i, j, k, nof_bytes;
+  uint8_t state1, state2, byte, s, p1, p2;
 
-    in = bit ^ (reg2_2 ^ reg2_1);
-    out = reg2_2 ^ (reg2_0 ^ in);
+  per = tcod_get_perm(h, long_cb);
+  if (!per) {
+    return -1;
+  }
+  nof_bytes = long_cb / 8;
+
+  for (i = 0; i < nof_bytes; i++) {
+    byte = 0;
+    for (j = 0; j < 8; j++) {
+      byte = (byte << 1) | (input[8 * i + j] & 1);
+    }
+    h->input_packed[i] = byte;
+    byte = 0;
+    for (j = 0; j < 8; j++) {
+      byte = (byte << 1) | (input[per[8 * i + j]] & 1);
+    }
+    h->input_interl[i] = byte;
+  }
 
-    reg2_2 = reg2_1;
-    reg2_1 = reg2_0;
-    reg2_0 = in;
+  state1 = tcod_rsc_bytes(h, h->input_packed, h->parity1, nof_bytes);
+  state2 = tcod_rsc_bytes(h, h->input_interl, h->parity2, nof_bytes);
 
-    output[k] = out;
-    k++;
+  k = 0;
+  for (i = 0; i < nof_bytes; i++) {
+    s = h->input_packed[i];
+    p1 = h->parity1[i];
+    p2 = h->parity2[i];
+    for (j = 0; j < 8; j++) {
+      output[k++] = (s >> (7 - j)) & 1;
+      output[k++] = (p1 >> (7 - j)) & 1;
+      output[k++] = (p2 >> (7 - j)) & 1;
+    }
   }
+
+  tcod_tail(state1, &output[k]);
+  tcod_tail(state2, &output[k + 2 * NOF_REGS]);
   return 0;
 }
-
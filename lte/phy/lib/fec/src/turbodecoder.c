@@ -33,6 +33,7 @@
 #include <math.h>
 
 #include "liblte/phy/fec/turbodecoder.h"
+#include "liblte/phy/utils/trace.h"
 
 /************************************************
  *
@@ -40,11 +41,95 @@
  *  Decoder
  *
  ************************************************/
+
+/* One step of the backward recursion: computes beta[k] from beta[k+1] (in old) */
+static inline void beta_step(llr_t old[8], llr_t x, llr_t y)
+{
+  llr_t m_b[8], new[8];
+  llr_t xy = x + y;
+  uint32_t i;
+
+  m_b[0] = old[4] + xy;
+  m_b[1] = old[4];
+  m_b[2] = old[5] + y;
+  m_b[3] = old[5] + x;
+  m_b[4] = old[6] + x;
+  m_b[5] = old[6] + y;
+  m_b[6] = old[7];
+  m_b[7] = old[7] + xy;
+
+  new[0] = old[0];
+  new[1] = old[0] + xy;
+  new[2] = old[1] + x;
+  new[3] = old[1] + y;
+  new[4] = old[2] + y;
+  new[5] = old[2] + x;
+  new[6] = old[3] + xy;
+  new[7] = old[3];
+
+  for (i = 0; i < 8; i++) {
+    if (m_b[i] > new[i])
+      new[i] = m_b[i];
+    old[i] = new[i];
+  }
+}
+
+/* One step of the forward recursion: computes alpha[k+1] from alpha[k] (in old)
+ * and returns the LLR of bit k using beta[k+1] 
+ */
+static inline llr_t alpha_step(llr_t old[8], llr_t x, llr_t y, llr_t *beta)
+{
+  llr_t m_b[8], new[8], max1[8], max0[8];
+  llr_t m1, m0;
+  llr_t xy = x + y;
+  uint32_t i;
+
+  m_b[0] = old[0];
+  m_b[1] = old[3] + y;
+  m_b[2] = old[4] + y;
+  m_b[3] = old[7];
+  m_b[4] = old[1];
+  m_b[5] = old[2] + y;
+  m_b[6] = old[5] + y;
+  m_b[7] = old[6];
+
+  new[0] = old[1] + xy;
+  new[1] = old[2] + x;
+  new[2] = old[5] + x;
+  new[3] = old[6] + xy;
+  new[4] = old[0] + xy;
+  new[5] = old[3] + x;
+  new[6] = old[4] + x;
+  new[7] = old[7] + xy;
+
+  for (i = 0; i < 8; i++) {
+    max0[i] = m_b[i] + beta[i];
+    max1[i] = new[i] + beta[i];
+  }
+
+  m1 = max1[0];
+  m0 = max0[0];
+
+  for (i = 1; i < 8; i++) {
+    if (max1[i] > m1)
+      m1 = max1[i];
+    if (max0[i] > m0)
+      m0 = max0[i];
+  }
+
+  for (i = 0; i < 8; i++) {
+    if (m_b[i] > new[i])
+      new[i] = m_b[i];
+    old[i] = new[i];
+  }
+
+  return m1 - m0;
+}
+
 void map_gen_beta(map_gen_t * s, llr_t * input, llr_t * parity,
                   uint32_t long_cb)
 {
-  llr_t m_b[8], new[8], old[8];
-  llr_t x, y, xy;
+  llr_t old[8];
   int k;
   uint32_t end = long_cb + RATE;
   llr_t *beta = s->beta;
@@ -55,34 +140,9 @@ void map_gen_beta(map_gen_t * s, llr_t * input, llr_t * parity,
   }
 
   for (k = end - 1; k >= 0; k--) {
-    x = input[k];
-    y = parity[k];
-
-    xy = x + y;
-
-    m_b[0] = old[4] + xy;
-    m_b[1] = old[4];
-    m_b[2] = old[5] + y;
-    m_b[3] = old[5] + x;
-    m_b[4] = old[6] + x;
-    m_b[5] = old[6] + y;
-    m_b[6] = old[7];
-    m_b[7] = old[7] + xy;
-
-    new[0] = old[0];
-    new[1] = old[0] + xy;
-    new[2] = old[1] + x;
-    new[3] = old[1] + y;
-    new[4] = old[2] + y;
-    new[5] = old[2] + x;
-    new[6] = old[3] + xy;
-    new[7] = old[3];
-
+    beta_step(old, input[k], parity[k]);
     for (i = 0; i < 8; i++) {
-      if (m_b[i] > new[i])
-        new[i] = m_b[i];
-      beta[8 * k + i] = new[i];
-      old[i] = new[i];
+      beta[8 * k + i] = old[i];
     }
   }
 }
@@ -90,10 +150,7 @@ void map_gen_beta(map_gen_t * s, llr_t * input, llr_t * parity,
 void map_gen_alpha(map_gen_t * s, llr_t * input, llr_t * parity, llr_t * output,
                    uint32_t long_cb)
 {
-  llr_t m_b[8], new[8], old[8], max1[8], max0[8];
-  llr_t m1, m0;
-  llr_t x, y, xy;
-  llr_t out;
+  llr_t old[8];
   uint32_t k;
   uint32_t end = long_cb;
   llr_t *beta = s->beta;
@@ -105,86 +162,426 @@ void map_gen_alpha(map_gen_t * s, llr_t * input, llr_t * parity, llr_t * output,
   }
 
   for (k = 1; k < end + 1; k++) {
-    x = input[k - 1];
-    y = parity[k - 1];
-
-    xy = x + y;
-
-    m_b[0] = old[0];
-    m_b[1] = old[3] + y;
-    m_b[2] = old[4] + y;
-    m_b[3] = old[7];
-    m_b[4] = old[1];
-    m_b[5] = old[2] + y;
-    m_b[6] = old[5] + y;
-    m_b[7] = old[6];
-
-    new[0] = old[1] + xy;
-    new[1] = old[2] + x;
-    new[2] = old[5] + x;
-    new[3] = old[6] + xy;
-    new[4] = old[0] + xy;
-    new[5] = old[3] + x;
-    new[6] = old[4] + x;
-    new[7] = old[7] + xy;
+    output[k - 1] = alpha_step(old, input[k - 1], parity[k - 1], &beta[8 * k]);
+  }
+}
+
+/* Sliding window MAP. The code block is processed in windows of window_len 
+ * bits. For each window, the backward recursion is initialized at the end of 
+ * the window by a training recursion of training_len steps, started from 
+ * equiprobable states or, with TDEC_BETA_STORED, from the value obtained at 
+ * that position in the previous iteration (rounding training_len up to whole
+ * windows, 0 means no training). Training that reaches the end of the code 
+ * block starts from the terminated trellis. Then the beta metrics of the 
+ * window are stored and the forward recursion, which runs continuously 
+ * across windows, computes the window output. 
+ */
+static void map_gen_win(map_gen_t * h, llr_t * input, llr_t * parity, llr_t * output,
+                        uint32_t long_cb, uint32_t dec_idx)
+{
+  llr_t alpha[8], beta[8];
+  uint32_t i, k, w, s, e, t, nof_windows;
+  uint32_t end = long_cb + TAIL;
+  llr_t *bound = h->beta_bound[dec_idx];
+  bool stored = h->beta_init == TDEC_BETA_STORED && h->beta_bound_valid[dec_idx];
+
+  nof_windows = (long_cb + h->window_len - 1) / h->window_len;
+
+  alpha[0] = 0;
+  for (i = 1; i < 8; i++) {
+    alpha[i] = -INF;
+  }
+
+  for (w = 0; w < nof_windows; w++) {
+    s = w * h->window_len;
+    e = s + h->window_len;
+    if (e > long_cb) {
+      e = long_cb;
+    }
+
+    /* beta at the end of the window */
+    if (stored) {
+      /* start the training at the start of a window, with the previous iteration value */
+      t = (w + 1 + (h->training_len + h->window_len - 1) / h->window_len) * h->window_len;
+    } else {
+      t = e + h->training_len;
+    }
+    if (t >= long_cb || e == long_cb) {
+      t = end;
+      beta[0] = 0;
+      for (i = 1; i < 8; i++) {
+        beta[i] = -INF;
+      }
+    } else if (stored) {
+      memcpy(beta, &bound[8 * (t / h->window_len)], sizeof(llr_t) * 8);
+    } else {
+      for (i = 0; i < 8; i++) {
+        beta[i] = 0;
+      }
+    }
+    for (k = t; k > e; k--) {
+      beta_step(beta, input[k - 1], parity[k - 1]);
+    }
+
+    /* beta of the window, h->beta[8*(k-s)] holds beta[k] */
+    memcpy(&h->beta[8 * (e - s)], beta, sizeof(llr_t) * 8);
+    for (k = e; k > s; k--) {
+      beta_step(beta, input[k - 1], parity[k - 1]);
+      memcpy(&h->beta[8 * (k - 1 - s)], beta, sizeof(llr_t) * 8);
+    }
+    memcpy(&bound[8 * w], beta, sizeof(llr_t) * 8);
 
+    /* alpha and output of the window */
+    for (k = s; k < e; k++) {
+      output[k] = alpha_step(alpha, input[k], parity[k], &h->beta[8 * (k + 1 - s)]);
+    }
+  }
+  h->beta_bound_valid[dec_idx] = true;
+}
+
+/* Radix-4 MAP. Each recursion step goes over two trellis steps: every state
+ * is connected to 4 states two steps apart, so the 4 paths are compared at
+ * once (4-way ACS) and the recursions are half as long. Paths are described
+ * by the state at the other end and by the branch metric indices of both 
+ * steps, where index u*2+p selects 0, y, x or x+y.
+ */
+
+/* For each state at step k: state at step k+2 of the 4 paths. Path p carries
+ * the bits u1*2+u2 = p, so the LLRs of both bits come from the maximum of each
+ * column.
+ */
+static const uint8_t r4_beta_ns[8][4] = {
+  {0, 4, 2, 6}, {2, 6, 0, 4}, {6, 2, 4, 0}, {4, 0, 6, 2},
+  {5, 1, 7, 3}, {7, 3, 5, 1}, {3, 7, 1, 5}, {1, 5, 3, 7}};
+
+/* For each state at step k: branch metric index of the 4 paths (first*4+second) */
+static const uint8_t r4_beta_g[8][4] = {
+  {0, 3, 13, 14}, {1, 2, 12, 15}, {5, 6, 8, 11}, {4, 7, 9, 10},
+  {5, 6, 8, 11}, {4, 7, 9, 10}, {0, 3, 13, 14}, {1, 2, 12, 15}};
+
+/* For each state at step k+2: state at step k of the 4 paths */
+static const uint8_t r4_alpha_s[8][4] = {
+  {0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 2, 3}, {4, 5, 6, 7},
+  {0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 2, 3}, {4, 5, 6, 7}};
+
+/* For each state at step k+2: branch metric index of the 4 paths */
+static const uint8_t r4_alpha_g[8][4] = {
+  {0, 12, 11, 7}, {6, 10, 13, 1}, {13, 1, 6, 10}, {11, 7, 0, 12},
+  {3, 15, 8, 4}, {5, 9, 14, 2}, {14, 2, 5, 9}, {8, 4, 3, 15}};
+
+/* Branch metrics of the 16 combinations of two trellis steps */
+#define R4_GAMMA(g, type, x0, y0, x1, y1)                     \
+  do {                                                        \
+    type g0[4], g1[4];                                        \
+    uint32_t _i, _j;                                          \
+    g0[0] = 0; g0[1] = y0; g0[2] = x0; g0[3] = x0 + y0;       \
+    g1[0] = 0; g1[1] = y1; g1[2] = x1; g1[3] = x1 + y1;       \
+    for (_i = 0; _i < 4; _i++) {                              \
+      for (_j = 0; _j < 4; _j++) {                            \
+        g[4 * _i + _j] = g0[_i] + g1[_j];                     \
+      }                                                       \
+    }                                                         \
+  } while (0)
+
+#define R4_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* One radix-4 step of the backward recursion: beta[k] from beta[k+2] (in old) */
+static inline void r4_beta_step(llr_t old[8], llr_t g[16])
+{
+  llr_t c[4][8];
+  uint32_t i, p;
+
+  for (p = 0; p < 4; p++) {
     for (i = 0; i < 8; i++) {
-      max0[i] = m_b[i] + beta[8 * k + i];
-      max1[i] = new[i] + beta[8 * k + i];
+      c[p][i] = g[r4_beta_g[i][p]] + old[r4_beta_ns[i][p]];
     }
+  }
+  for (i = 0; i < 8; i++) {
+    old[i] = R4_MAX(R4_MAX(c[0][i], c[1][i]), R4_MAX(c[2][i], c[3][i]));
+  }
+}
 
-    m1 = max1[0];
-    m0 = max0[0];
+/* One radix-4 step of the forward recursion: alpha[k+2] from alpha[k] (in old).
+ * Writes the LLRs of bits k and k+1 using beta[k+2]
+ */
+static inline void r4_alpha_step(llr_t old[8], llr_t g[16], llr_t *beta, llr_t *output)
+{
+  llr_t c[4][8], m[4];
+  uint32_t i, p;
 
+  for (p = 0; p < 4; p++) {
+    for (i = 0; i < 8; i++) {
+      c[p][i] = old[i] + g[r4_beta_g[i][p]] + beta[r4_beta_ns[i][p]];
+    }
+    m[p] = c[p][0];
     for (i = 1; i < 8; i++) {
-      if (max1[i] > m1)
-        m1 = max1[i];
-      if (max0[i] > m0)
-        m0 = max0[i];
+      m[p] = R4_MAX(m[p], c[p][i]);
     }
+  }
+  output[0] = R4_MAX(m[2], m[3]) - R4_MAX(m[0], m[1]);
+  output[1] = R4_MAX(m[1], m[3]) - R4_MAX(m[0], m[2]);
 
+  for (p = 0; p < 4; p++) {
     for (i = 0; i < 8; i++) {
-      if (m_b[i] > new[i])
-        new[i] = m_b[i];
-      old[i] = new[i];
+      c[p][i] = g[r4_alpha_g[i][p]] + old[r4_alpha_s[i][p]];
     }
+  }
+  for (i = 0; i < 8; i++) {
+    old[i] = R4_MAX(R4_MAX(c[0][i], c[1][i]), R4_MAX(c[2][i], c[3][i]));
+  }
+}
+
+static void map_r4_beta(map_gen_t * h, llr_t * input, llr_t * parity, uint32_t long_cb)
+{
+  llr_t old[8], g[16];
+  uint32_t i, k;
+  uint32_t end = long_cb + TAIL;
+  llr_t *beta = h->beta;     // beta[8*(k/2)] holds beta at even step k
 
-    out = m1 - m0;
-    output[k - 1] = out;
+  old[0] = 0;
+  for (i = 1; i < 8; i++) {
+    old[i] = -INF;
+  }
+  /* the tail has an odd number of steps, start with a radix-2 step */
+  beta_step(old, input[end - 1], parity[end - 1]);
+  memcpy(&beta[8 * ((end - 1) / 2)], old, sizeof(llr_t) * 8);
+
+  for (k = end - 1; k > 2; k -= 2) {
+    R4_GAMMA(g, llr_t, input[k - 2], parity[k - 2], input[k - 1], parity[k - 1]);
+    r4_beta_step(old, g);
+    memcpy(&beta[8 * ((k - 2) / 2)], old, sizeof(llr_t) * 8);
   }
 }
 
-int map_gen_init(map_gen_t * h, int max_long_cb)
+static void map_r4_alpha(map_gen_t * h, llr_t * input, llr_t * parity, llr_t * output,
+                         uint32_t long_cb)
 {
+  llr_t old[8], g[16];
+  uint32_t i, k;
+
+  old[0] = 0;
+  for (i = 1; i < 8; i++) {
+    old[i] = -INF;
+  }
+  for (k = 0; k < long_cb; k += 2) {
+    R4_GAMMA(g, llr_t, input[k], parity[k], input[k + 1], parity[k + 1]);
+    r4_alpha_step(old, g, &h->beta[8 * (k / 2 + 1)], &output[k]);
+  }
+}
+
+/* int16 version: metrics are 16 bits wide and normalized to state 0 after
+ * every step. The branch metrics use the LLRs scaled so that the largest one 
+ * is R4_INT16_MAX, which keeps every sum of a state metric, a branch metric and
+ * the metric of the other recursion within range. 
+ */
+#define R4_INT16_MAX  1023
+#define R4_INT16_INF  8192
+
+static inline void r4_beta_step16(int16_t old[8], int16_t g[16])
+{
+  int16_t c[4][8];
+  uint32_t i, p;
+
+  for (p = 0; p < 4; p++) {
+    for (i = 0; i < 8; i++) {
+      c[p][i] = g[r4_beta_g[i][p]] + old[r4_beta_ns[i][p]];
+    }
+  }
+  for (i = 0; i < 8; i++) {
+    c[0][i] = R4_MAX(R4_MAX(c[0][i], c[1][i]), R4_MAX(c[2][i], c[3][i]));
+  }
+  for (i = 0; i < 8; i++) {
+    old[i] = c[0][i] - c[0][0];
+  }
+}
+
+static inline void r4_alpha_step16(int16_t old[8], int16_t g[16], int16_t *beta, 
+                                   llr_t *output, float scale)
+{
+  int16_t c[4][8], m[4];
+  uint32_t i, p;
+
+  for (p = 0; p < 4; p++) {
+    for (i = 0; i < 8; i++) {
+      c[p][i] = old[i] + g[r4_beta_g[i][p]] + beta[r4_beta_ns[i][p]];
+    }
+    m[p] = c[p][0];
+    for (i = 1; i < 8; i++) {
+      m[p] = R4_MAX(m[p], c[p][i]);
+    }
+  }
+  output[0] = (R4_MAX(m[2], m[3]) - R4_MAX(m[0], m[1])) * scale;
+  output[1] = (R4_MAX(m[1], m[3]) - R4_MAX(m[0], m[2])) * scale;
+
+  for (p = 0; p < 4; p++) {
+    for (i = 0; i < 8; i++) {
+      c[p][i] = g[r4_alpha_g[i][p]] + old[r4_alpha_s[i][p]];
+    }
+  }
+  for (i = 0; i < 8; i++) {
+    c[0][i] = R4_MAX(R4_MAX(c[0][i], c[1][i]), R4_MAX(c[2][i], c[3][i]));
+  }
+  for (i = 0; i < 8; i++) {
+    old[i] = c[0][i] - c[0][0];
+  }
+}
+
+static void map_r4_beta16(map_gen_t * h, int16_t * input, int16_t * parity, uint32_t long_cb)
+{
+  int16_t old[8], g[16];
+  llr_t old_f[8];
+  uint32_t i, k;
+  uint32_t end = long_cb + TAIL;
+  int16_t *beta = h->beta16;
+
+  /* radix-2 step of the tail */
+  old_f[0] = 0;
+  for (i = 1; i < 8; i++) {
+    old_f[i] = -R4_INT16_INF;
+  }
+  beta_step(old_f, input[end - 1], parity[end - 1]);
+  for (i = 0; i < 8; i++) {
+    old[i] = (int16_t) (old_f[i] - old_f[0]);
+  }
+  memcpy(&beta[8 * ((end - 1) / 2)], old, sizeof(int16_t) * 8);
+
+  for (k = end - 1; k > 2; k -= 2) {
+    R4_GAMMA(g, int16_t, input[k - 2], parity[k - 2], input[k - 1], parity[k - 1]);
+    r4_beta_step16(old, g);
+    memcpy(&beta[8 * ((k - 2) / 2)], old, sizeof(int16_t) * 8);
+  }
+}
+
+static void map_r4_alpha16(map_gen_t * h, int16_t * input, int16_t * parity, llr_t * output,
+                           uint32_t long_cb, float scale)
+{
+  int16_t old[8], g[16];
+  uint32_t i, k;
+
+  old[0] = 0;
+  for (i = 1; i < 8; i++) {
+    old[i] = -R4_INT16_INF;
+  }
+  for (k = 0; k < long_cb; k += 2) {
+    R4_GAMMA(g, int16_t, input[k], parity[k], input[k + 1], parity[k + 1]);
+    r4_alpha_step16(old, g, &h->beta16[8 * (k / 2 + 1)], &output[k], scale);
+  }
+}
+
+/* Quantizes the LLRs to int16 and runs the int16 radix-4 MAP */
+static void map_r4_dec16(map_gen_t * h, llr_t * input, llr_t * parity, llr_t * output,
+                         uint32_t long_cb)
+{
+  uint32_t i, len = long_cb + TAIL;
+  float max = 0, a, scale;
+
+  for (i = 0; i < len; i++) {
+    a = fabsf(input[i]);
+    if (a > max) 
+      max = a;
+    a = fabsf(parity[i]);
+    if (a > max) 
+      max = a;
+  }
+  if (max == 0) {
+    max = 1;
+  }
+  scale = R4_INT16_MAX / max;
+  for (i = 0; i < len; i++) {
+    h->input16[i] = (int16_t) lrintf(input[i] * scale);
+    h->parity16[i] = (int16_t) lrintf(parity[i] * scale);
+  }
+  map_r4_beta16(h, h->input16, h->parity16, long_cb);
+  map_r4_alpha16(h, h->input16, h->parity16, output, long_cb, 1 / scale);
+}
+
+int map_gen_init(map_gen_t * h, int max_long_cb, tdec_opts_t *opts)
+{
+  uint32_t i, nof_windows;
+
   bzero(h, sizeof(map_gen_t));
-  h->beta = malloc(sizeof(llr_t) * (max_long_cb + TOTALTAIL + 1) * NUMSTATES);
+  h->max_long_cb = max_long_cb;
+  if (opts && opts->map == TDEC_MAP_SLIDING_WINDOW) {
+    h->map = TDEC_MAP_SLIDING_WINDOW;
+    h->window_len = opts->window_len;
+    h->training_len = opts->training_len;
+    h->beta_init = opts->beta_init;
+    h->beta = malloc(sizeof(llr_t) * (h->window_len + 1) * NUMSTATES);
+    nof_windows = (max_long_cb + h->window_len - 1) / h->window_len + 1;
+    for (i = 0; i < 2; i++) {
+      h->beta_bound[i] = malloc(sizeof(llr_t) * nof_windows * NUMSTATES);
+      if (!h->beta_bound[i]) {
+        perror("malloc");
+        return -1;
+      }
+    }
+  } else {
+    h->map = TDEC_MAP_FULL;
+    h->beta = malloc(sizeof(llr_t) * (max_long_cb + TOTALTAIL + 1) * NUMSTATES);
+    if (opts && opts->radix == TDEC_RADIX4) {
+      h->radix = TDEC_RADIX4;
+      h->metric = opts->metric;
+      if (h->metric == TDEC_METRIC_INT16) {
+        h->beta16 = malloc(sizeof(int16_t) * ((max_long_cb + TOTALTAIL) / 2 + 1) * NUMSTATES);
+        h->input16 = malloc(sizeof(int16_t) * (max_long_cb + TOTALTAIL));
+        h->parity16 = malloc(sizeof(int16_t) * (max_long_cb + TOTALTAIL));
+        if (!h->beta16 || !h->input16 || !h->parity16) {
+          perror("malloc");
+          return -1;
+        }
+      }
+    }
+  }
   if (!h->beta) {
     perror("malloc");
     return -1;
   }
-  h->max_long_cb = max_long_cb;
   return 0;
 }
 
 void map_gen_free(map_gen_t * h)
 {
+  uint32_t i;
   if (h->beta) {
     free(h->beta);
   }
+  for (i = 0; i < 2; i++) {
+    if (h->beta_bound[i]) {
+      free(h->beta_bound[i]);
+    }
+  }
+  if (h->beta16) {
+    free(h->beta16);
+  }
+  if (h->input16) {
+    free(h->input16);
+  }
+  if (h->parity16) {
+    free(h->parity16);
+  }
   bzero(h, sizeof(map_gen_t));
 }
 
 void map_gen_dec(map_gen_t * h, llr_t * input, llr_t * parity, llr_t * output,
-                 uint32_t long_cb)
+                 uint32_t long_cb, uint32_t dec_idx)
 {
   uint32_t k;
 
-  h->beta[(long_cb + TAIL) * NUMSTATES] = 0;
-  for (k = 1; k < NUMSTATES; k++)
-    h->beta[(long_cb + TAIL) * NUMSTATES + k] = -INF;
-
-  map_gen_beta(h, input, parity, long_cb);
-  map_gen_alpha(h, input, parity, output, long_cb);
+  if (h->map == TDEC_MAP_SLIDING_WINDOW) {
+    map_gen_win(h, input, parity, output, long_cb, dec_idx);
+  } else if (h->radix == TDEC_RADIX4 && h->metric == TDEC_METRIC_INT16) {
+    map_r4_dec16(h, input, parity, output, long_cb);
+  } else if (h->radix == TDEC_RADIX4) {
+    map_r4_beta(h, input, parity, long_cb);
+    map_r4_alpha(h, input, parity, output, long_cb);
+  } else {
+    h->beta[(long_cb + TAIL) * NUMSTATES] = 0;
+    for (k = 1; k < NUMSTATES; k++)
+      h->beta[(long_cb + TAIL) * NUMSTATES + k] = -INF;
+
+    map_gen_beta(h, input, parity, long_cb);
+    map_gen_alpha(h, input, parity, output, long_cb);
+  }
 }
 
 /************************************************
@@ -193,6 +590,14 @@ void map_gen_dec(map_gen_t * h, llr_t * input, llr_t * parity, llr_t * output,
  *
  ************************************************/
 int tdec_init(tdec_t * h, uint32_t max_long_cb)
+{
+  return tdec_init_opts(h, max_long_cb, NULL);
+}
+
+/** Initializes the decoder with the MAP algorithm selected in opts. With 
+ * opts=NULL, the full code block MAP is used (same as tdec_init()).
+ */
+int tdec_init_opts(tdec_t * h, uint32_t max_long_cb, tdec_opts_t *opts)
 {
   int ret = -1;
   bzero(h, sizeof(tdec_t));
@@ -200,6 +605,15 @@ int tdec_init(tdec_t * h, uint32_t max_long_cb)
 
   h->max_long_cb = max_long_cb;
 
+  if (opts && opts->map == TDEC_MAP_SLIDING_WINDOW && opts->window_len == 0) {
+    fprintf(stderr, "Invalid sliding window length\n");
+    return -1;
+  }
+  if (opts && opts->map == TDEC_MAP_SLIDING_WINDOW && opts->radix == TDEC_RADIX4) {
+    fprintf(stderr, "Radix-4 is only supported by the full MAP\n");
+    return -1;
+  }
+
   h->llr1 = malloc(sizeof(llr_t) * len);
   if (!h->llr1) {
     perror("malloc");
@@ -225,8 +639,18 @@ int tdec_init(tdec_t * h, uint32_t max_long_cb)
     perror("malloc");
     goto clean_and_exit;
   }
+  h->hd_prev = malloc(sizeof(char) * max_long_cb);
+  if (!h->hd_prev) {
+    perror("malloc");
+    goto clean_and_exit;
+  }
+  h->ext_prev = malloc(sizeof(char) * max_long_cb);
+  if (!h->ext_prev) {
+    perror("malloc");
+    goto clean_and_exit;
+  }
 
-  if (map_gen_init(&h->dec, h->max_long_cb)) {
+  if (map_gen_init(&h->dec, h->max_long_cb, opts)) {
     goto clean_and_exit;
   }
 
@@ -258,6 +682,12 @@ void tdec_free(tdec_t * h)
   if (h->parity) {
     free(h->parity);
   }
+  if (h->hd_prev) {
+    free(h->hd_prev);
+  }
+  if (h->ext_prev) {
+    free(h->ext_prev);
+  }
 
   map_gen_free(&h->dec);
 
@@ -270,6 +700,8 @@ void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
 {
   uint32_t i;
 
+  TRACE_BEGIN(TRACE_TURBO_ITER);
+
   // Prepare systematic and parity bits for MAP DEC #1
   for (i = 0; i < long_cb; i++) {
     h->syst[i] = input[RATE * i] + h->w[i];
@@ -281,7 +713,7 @@ void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
   }
 
   // Run MAP DEC #1
-  map_gen_dec(&h->dec, h->syst, h->parity, h->llr1, long_cb);
+  map_gen_dec(&h->dec, h->syst, h->parity, h->llr1, long_cb, 0);
 
   // Prepare systematic and parity bits for MAP DEC #1
   for (i = 0; i < long_cb; i++) {
@@ -297,13 +729,14 @@ void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
   }
 
   // Run MAP DEC #1
-  map_gen_dec(&h->dec, h->syst, h->parity, h->llr2, long_cb);
+  map_gen_dec(&h->dec, h->syst, h->parity, h->llr2, long_cb, 1);
  
   // Update a-priori LLR from the last iteration
   for (i = 0; i < long_cb; i++) {
     h->w[i] += h->llr2[h->interleaver.reverse[i]] - h->llr1[i];
   }
 
+  TRACE_END(TRACE_TURBO_ITER);
 }
 
 int tdec_reset(tdec_t * h, uint32_t long_cb)
@@ -314,7 +747,77 @@ int tdec_reset(tdec_t * h, uint32_t long_cb)
     return -1;
   }
   memset(h->w, 0, sizeof(llr_t) * long_cb);
-  return tc_interl_LTE_gen(&h->interleaver, long_cb);
+  h->dec.beta_bound_valid[0] = false;
+  h->dec.beta_bound_valid[1] = false;
+  h->nof_checks = 0;
+  /* consecutive code blocks of a transport block usually have the same size */
+  if (h->interl_long_cb != long_cb) {
+    h->interl_long_cb = 0;
+    if (tc_interl_LTE_gen(&h->interleaver, long_cb)) {
+      return -1;
+    }
+    h->interl_long_cb = long_cb;
+  }
+  return 0;
+}
+
+/** Selects the early stopping criteria checked by tdec_stop_check(). 
+ * stop=NULL disables them.
+ */
+void tdec_set_stop(tdec_t * h, tdec_stop_t *stop)
+{
+  if (stop) {
+    h->stop = *stop;
+  } else {
+    bzero(&h->stop, sizeof(tdec_stop_t));
+  }
+}
+
+/** Checks the early stopping criteria after tdec_iteration(). Returns true if
+ * any of them is met. HDA and SCR compare with the previous call, so they 
+ * can not be met before the second iteration after tdec_reset(). 
+ */
+bool tdec_stop_check(tdec_t * h, uint32_t long_cb)
+{
+  uint32_t i, nof_changes;
+  char s;
+  llr_t min;
+  bool converged = false;
+
+  if (h->stop.criteria & TDEC_STOP_HDA) {
+    nof_changes = 0;
+    for (i = 0; i < long_cb; i++) {
+      s = h->llr2[i] > 0;
+      nof_changes += s != h->hd_prev[i];
+      h->hd_prev[i] = s;
+    }
+    if (h->nof_checks > 0 && nof_changes == 0) {
+      converged = true;
+    }
+  }
+  if (h->stop.criteria & TDEC_STOP_MIN_LLR) {
+    min = fabsf(h->llr2[0]);
+    for (i = 1; i < long_cb; i++) {
+      if (fabsf(h->llr2[i]) < min) 
+        min = fabsf(h->llr2[i]);
+    }
+    if (min >= h->stop.min_llr) {
+      converged = true;
+    }
+  }
+  if (h->stop.criteria & TDEC_STOP_SCR) {
+    nof_changes = 0;
+    for (i = 0; i < long_cb; i++) {
+      s = h->w[i] > 0;
+      nof_changes += s != h->ext_prev[i];
+      h->ext_prev[i] = s;
+    }
+    if (h->nof_checks > 0 && nof_changes <= h->stop.scr * long_cb) {
+      converged = true;
+    }
+  }
+  h->nof_checks++;
+  return converged;
 }
 
 void tdec_decision(tdec_t * h, char *output, uint32_t long_cb)
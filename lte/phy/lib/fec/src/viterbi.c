@@ -34,6 +34,7 @@
 
 #include "liblte/phy/utils/vector.h"
 #include "liblte/phy/fec/viterbi.h"
+#include "liblte/phy/fec/viterbi_gen.h"
 #include "parity.h"
 #include "viterbi37.h"
 #include "viterbi39.h"
@@ -96,6 +97,24 @@ int decode39(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
   return q->framebits;
 }
 
+/* Symbols quantized to 0..255 are centered around 0 for the generic decoder */
+int decode_gen(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
+  viterbi_t *q = o;
+  viterbi_gen_t *gen = q->ptr;
+  uint32_t i, len;
+
+  if (frame_length > q->framebits) {
+    fprintf(stderr, "Initialized decoder for max frame length %d bits\n",
+        q->framebits);
+    return -1;
+  }
+  len = q->R * (q->tail_biting ? frame_length : frame_length + q->K - 1);
+  for (i = 0; i < len; i++) {
+    gen->symbols[i] = (int16_t) symbols[i] - 127;
+  }
+  return viterbi_gen_decode_s(gen, gen->symbols, data, frame_length);
+}
+
 void free37(void *o) {
   viterbi_t *q = o;
   if (q->symbols_uc) {
@@ -115,6 +134,43 @@ void free39(void *o) {
   delete_viterbi39_port(q->ptr);
 }
 
+void free_gen(void *o) {
+  viterbi_t *q = o;
+  if (q->symbols_uc) {
+    free(q->symbols_uc);
+  }
+  if (q->ptr) {
+    viterbi_gen_free(q->ptr);
+    free(q->ptr);
+  }
+}
+
+int init_gen(viterbi_t *q, uint32_t R, uint32_t K, uint32_t poly[3], uint32_t framebits, 
+             bool tail_biting) {
+  q->K = K;
+  q->R = R;
+  q->framebits = framebits;
+  q->tail_biting = tail_biting;
+  q->decode = decode_gen;
+  q->free = free_gen;
+  q->tmp = NULL;
+  q->symbols_uc = malloc(R * (q->framebits + q->K - 1) * sizeof(char));
+  q->ptr = malloc(sizeof(viterbi_gen_t));
+  if (!q->symbols_uc || !q->ptr) {
+    perror("malloc");
+    free_gen(q);
+    return -1;
+  }
+  if (viterbi_gen_init(q->ptr, K, R, poly, framebits, tail_biting)) {
+    fprintf(stderr, "Error initiating generic Viterbi decoder\n");
+    free(q->ptr);
+    q->ptr = NULL;
+    free_gen(q);
+    return -1;
+  }
+  return 0;
+}
+
 int init37(viterbi_t *q, uint32_t poly[3], uint32_t framebits, bool tail_biting) {
   q->K = 7;
   q->R = 3;
@@ -148,17 +204,15 @@ int init37(viterbi_t *q, uint32_t poly[3], uint32_t framebits, bool tail_biting)
 }
 
 int init39(viterbi_t *q, uint32_t poly[3], uint32_t framebits, bool tail_biting) {
+  if (tail_biting) {
+    return init_gen(q, 3, 9, poly, framebits, tail_biting);
+  }
   q->K = 9;
   q->R = 3;
   q->framebits = framebits;
   q->tail_biting = tail_biting;
   q->decode = decode39;
   q->free = free39;
-  if (q->tail_biting) {
-    fprintf(stderr,
-        "Error: Tailbitting not supported in 1/3 K=9 decoder\n");
-    return -1;
-  }
   q->symbols_uc = malloc(3 * (q->framebits + q->K - 1) * sizeof(char));
   if (!q->symbols_uc) {
     perror("malloc");
@@ -176,6 +230,10 @@ int init39(viterbi_t *q, uint32_t poly[3], uint32_t framebits, bool tail_biting)
 int viterbi_init(viterbi_t *q, viterbi_type_t type, uint32_t poly[3],
     uint32_t max_frame_length, bool tail_bitting) {
   switch (type) {
+  case viterbi_27:
+    return init_gen(q, 2, 7, poly, max_frame_length, tail_bitting);
+  case viterbi_29:
+    return init_gen(q, 2, 9, poly, max_frame_length, tail_bitting);
   case viterbi_37:
     return init37(q, poly, max_frame_length, tail_bitting);
   case viterbi_39:
@@ -201,9 +259,9 @@ int viterbi_decode_f(viterbi_t *q, float *symbols, char *data, uint32_t frame_le
     return -1;
   }
   if (q->tail_biting) {
-    len = 3 * frame_length;
+    len = q->R * frame_length;
   } else {
-    len = 3 * (frame_length + q->K - 1);
+    len = q->R * (frame_length + q->K - 1);
   }
   vec_quant_fuc(symbols, q->symbols_uc, 32, 127.5, 255, len);
   return q->decode(q, q->symbols_uc, data, frame_length);
@@ -0,0 +1,349 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/fec/viterbi_gen.h"
+#include "parity.h"
+
+#define INF   8192
+
+/* Transitions of the butterfly of old states i and i+S/2 into new states 2i 
+ * and 2i+1. The shift register r holds the K bits that produce the coded bits,
+ * the newest in the LSB as in convcoder_encode(): r = 2i, 2i+1, 2i+S, 2i+1+S. 
+ * Branch metrics are stored in this order in 4 blocks of S/2.
+ */
+static uint32_t butterfly_reg(uint32_t block, uint32_t i, uint32_t nof_states) {
+  return 2 * i + (block & 1) + (block >> 1) * nof_states;
+}
+
+static uint32_t max_steps(viterbi_gen_t *q) {
+  return q->max_frame_length + (q->tail_biting ? 2 * VITERBI_GEN_MAX_WRAP : q->K - 1);
+}
+
+int viterbi_gen_init(viterbi_gen_t *q, uint32_t K, uint32_t R, uint32_t poly[VITERBI_GEN_MAX_R], 
+                     uint32_t max_frame_length, bool tail_biting) 
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  uint32_t i, j, b, S, nof_steps;
+
+  if (q                 != NULL   &&
+      poly              != NULL   &&
+      K                 >= 3      &&
+      K                 <= VITERBI_GEN_MAX_K &&
+      R                 >= 1      &&
+      R                 <= VITERBI_GEN_MAX_R &&
+      max_frame_length  >  0)
+  {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(viterbi_gen_t));
+    S = 1 << (K - 1);
+    q->K = K;
+    q->R = R;
+    q->nof_states = S;
+    q->tail_biting = tail_biting;
+    q->max_frame_length = max_frame_length;
+    q->wrap = 6 * K;
+    q->gain = 32;
+    for (j = 0; j < R; j++) {
+      q->poly[j] = poly[j];
+    }
+
+    nof_steps = max_steps(q);
+    q->sign = malloc(sizeof(int16_t) * 2 * S * R);
+    q->bm = malloc(sizeof(int16_t) * 2 * S);
+    q->metric[0] = malloc(sizeof(int16_t) * S);
+    q->metric[1] = malloc(sizeof(int16_t) * S);
+    q->decision = malloc(sizeof(uint8_t) * S * nof_steps);
+    q->symbols = malloc(sizeof(int16_t) * R * (max_frame_length + K - 1));
+    if (!q->sign || !q->bm || !q->metric[0] || !q->metric[1] || !q->decision || !q->symbols) {
+      perror("malloc");
+      goto clean;
+    }
+    for (j = 0; j < R; j++) {
+      for (b = 0; b < 4; b++) {
+        for (i = 0; i < S / 2; i++) {
+          q->sign[2 * S * j + b * S / 2 + i] = 
+              parity(butterfly_reg(b, i, S) & poly[j]) ? 1 : -1;
+        }
+      }
+    }
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    viterbi_gen_free(q);
+  }
+  return ret;
+}
+
+void viterbi_gen_free(viterbi_gen_t *q) {
+  if (q->sign) {
+    free(q->sign);
+  }
+  if (q->bm) {
+    free(q->bm);
+  }
+  if (q->metric[0]) {
+    free(q->metric[0]);
+  }
+  if (q->metric[1]) {
+    free(q->metric[1]);
+  }
+  if (q->decision) {
+    free(q->decision);
+  }
+  if (q->symbols) {
+    free(q->symbols);
+  }
+  if (q->margin) {
+    free(q->margin);
+  }
+  bzero(q, sizeof(viterbi_gen_t));
+}
+
+/* Soft symbols are multiplied by gain before clipping */
+int viterbi_gen_set_gain(viterbi_gen_t *q, float gain) {
+  if (gain > 0) {
+    q->gain = gain;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/* Number of bits decoded before and after the frame with tail biting */
+int viterbi_gen_set_wrap(viterbi_gen_t *q, uint32_t wrap) {
+  if (wrap <= VITERBI_GEN_MAX_WRAP) {
+    q->wrap = wrap;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/* Enables or disables the computation of the reliability of decoded frames */
+int viterbi_gen_set_soft_output(viterbi_gen_t *q, bool enable) {
+  if (enable && !q->margin) {
+    q->margin = malloc(sizeof(int16_t) * q->nof_states * max_steps(q));
+    if (!q->margin) {
+      perror("malloc");
+      return LIBLTE_ERROR;
+    }
+  } else if (!enable && q->margin) {
+    free(q->margin);
+    q->margin = NULL;
+  }
+  q->reliability = 0;
+  return LIBLTE_SUCCESS;
+}
+
+/* Reliability of the last decoded frame, 0 if soft output is not enabled */
+float viterbi_gen_reliability(viterbi_gen_t *q) {
+  return q->reliability;
+}
+
+/* One trellis step with the R symbols y. The metrics are normalized by 
+ * subtracting the old metric of state 0 from all the branch metrics. Signed 
+ * indices let the compiler vectorize the interleaved store of new. 
+ */
+static void viterbi_gen_step(viterbi_gen_t *q, int16_t *y, int16_t * restrict old, 
+                             int16_t * restrict new, uint8_t * restrict dec, 
+                             int16_t * restrict margin) 
+{
+  int i, j;
+  int half = q->nof_states / 2;
+  int len = 2 * q->nof_states;
+  int16_t * restrict bm = q->bm;
+  int16_t * restrict sign = q->sign;
+  int16_t * restrict old1 = &old[half];
+  int16_t * restrict bm1 = &bm[half];
+  int16_t * restrict bm2 = &bm[2 * half];
+  int16_t * restrict bm3 = &bm[3 * half];
+  uint8_t * restrict dec1 = &dec[half];
+  int16_t * restrict margin1 = &margin[half];
+  int16_t norm = old[0];
+  int16_t yj, a0, a1, b0, b1;
+
+  yj = y[0];
+  for (i = 0; i < len; i++) {
+    bm[i] = sign[i] * yj - norm;
+  }
+  for (j = 1; j < q->R; j++) {
+    yj = y[j];
+    for (i = 0; i < len; i++) {
+      bm[i] += sign[j * len + i] * yj;
+    }
+  }
+  for (i = 0; i < half; i++) {
+    a0 = old[i] + bm[i];
+    a1 = old[i] + bm1[i];
+    b0 = old1[i] + bm2[i];
+    b1 = old1[i] + bm3[i];
+    new[2 * i] = b0 > a0 ? b0 : a0;
+    new[2 * i + 1] = b1 > a1 ? b1 : a1;
+    dec[i] = b0 > a0;
+    dec1[i] = b1 > a1;
+  }
+  if (margin) {
+    for (i = 0; i < half; i++) {
+      a0 = old[i] + bm[i];
+      a1 = old[i] + bm1[i];
+      b0 = old1[i] + bm2[i];
+      b1 = old1[i] + bm3[i];
+      margin[i] = b0 > a0 ? b0 - a0 : a0 - b0;
+      margin1[i] = b1 > a1 ? b1 - a1 : a1 - b1;
+    }
+  }
+}
+
+/* Decodes R*frame_length symbols with tail biting or R*(frame_length+K-1) 
+ * otherwise, already quantized. symbols are not copied nor modified. 
+ * Returns frame_length. 
+ */
+int viterbi_gen_decode_s(viterbi_gen_t *q, int16_t *symbols, char *data, uint32_t frame_length) 
+{
+  uint32_t i, t, S, nof_steps, first, offset, state, idx, len;
+  int16_t *old, *new, *tmp;
+  int16_t best, min_margin;
+  int sum;
+
+  if (q                 != NULL   &&
+      symbols           != NULL   &&
+      data              != NULL   &&
+      frame_length      >  0      &&
+      frame_length      <= q->max_frame_length)
+  {
+    S = q->nof_states;
+    old = q->metric[0];
+    new = q->metric[1];
+    if (q->tail_biting) {
+      first = q->wrap;
+      nof_steps = frame_length + 2 * q->wrap;
+      offset = frame_length - q->wrap % frame_length;
+      for (i = 0; i < S; i++) {
+        old[i] = 0;
+      }
+    } else {
+      first = 0;
+      nof_steps = frame_length + q->K - 1;
+      offset = 0;
+      for (i = 0; i < S; i++) {
+        old[i] = i ? -INF : 0;
+      }
+    }
+
+    for (t = 0; t < nof_steps; t++) {
+      viterbi_gen_step(q, &symbols[q->R * (q->tail_biting ? (t + offset) % frame_length : t)], 
+                       old, new, &q->decision[t * S], q->margin ? &q->margin[t * S] : NULL);
+      tmp = old;
+      old = new;
+      new = tmp;
+    }
+
+    state = 0;
+    if (q->tail_biting) {
+      best = old[0];
+      for (i = 1; i < S; i++) {
+        if (old[i] > best) {
+          best = old[i];
+          state = i;
+        }
+      }
+    }
+    min_margin = INF;
+    for (t = nof_steps; t-- > first;) {
+      if (t < first + frame_length) {
+        data[t - first] = state & 1;
+      }
+      idx = t * S + (state & 1) * S / 2 + (state >> 1);
+      if (q->margin && q->margin[idx] < min_margin) {
+        min_margin = q->margin[idx];
+      }
+      state = (state >> 1) | (q->decision[idx] << (q->K - 2));
+    }
+    if (q->margin) {
+      len = q->R * (q->tail_biting ? frame_length : frame_length + q->K - 1);
+      sum = 0;
+      for (i = 0; i < len; i++) {
+        sum += abs(symbols[i]);
+      }
+      q->reliability = sum ? (float) min_margin * len / (2 * sum) : 0;
+    }
+    return frame_length;
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
+int viterbi_gen_decode(viterbi_gen_t *q, float *symbols, char *data, uint32_t frame_length) 
+{
+  uint32_t i, len;
+  float v, max = VITERBI_GEN_MAX_SYMBOL;
+
+  if (q                 != NULL   &&
+      symbols           != NULL   &&
+      frame_length      <= q->max_frame_length)
+  {
+    len = q->R * (q->tail_biting ? frame_length : frame_length + q->K - 1);
+    for (i = 0; i < len; i++) {
+      v = q->gain * symbols[i];
+      v = v > max ? max : v;
+      v = v < -max ? -max : v;
+      q->symbols[i] = (int16_t) v;
+    }
+    return viterbi_gen_decode_s(q, q->symbols, data, frame_length);
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
+/* Decodes nof_frames frames of the same length and code, one after the other, 
+ * reusing the tables and buffers of q. Returns the number of frames decoded. 
+ */
+int viterbi_gen_decode_batch(viterbi_gen_t *q, float **symbols, char **data, 
+                             uint32_t nof_frames, uint32_t frame_length) 
+{
+  uint32_t i;
+
+  if (q                 != NULL   &&
+      symbols           != NULL   &&
+      data              != NULL)
+  {
+    for (i = 0; i < nof_frames; i++) {
+      if (viterbi_gen_decode(q, symbols[i], data[i], frame_length) < 0) {
+        return LIBLTE_ERROR;
+      }
+    }
+    return nof_frames;
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
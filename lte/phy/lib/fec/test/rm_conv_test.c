@@ -33,11 +33,15 @@
 #include <math.h>
 #include <time.h>
 #include <stdbool.h>
+#include <sys/time.h>
 
 #include "liblte/phy/phy.h"
 
 int nof_tx_bits=-1, nof_rx_bits=-1;
 
+#define NOF_BATCH     16
+#define NOF_REPS      1000
+
 void usage(char *prog) {
   printf("Usage: %s -t nof_tx_bits -r nof_rx_bits\n", prog);
 }
@@ -67,6 +71,68 @@ void parse_args(int argc, char **argv) {
   }
 }
 
+/* Checks rm_conv_rx_cached() and rm_conv_rx_batch() against rm_conv_rx() with
+ * random LLRs, some of them RX_NULL, and reports the time of each 
+ */
+int test_cached(float *rm_symbols) {
+  rm_conv_t rm;
+  float *input[NOF_BATCH], *output[NOF_BATCH], *output_ref;
+  struct timeval t[3];
+  float t_ref, t_cached;
+  int i, n, ret = -1;
+
+  if (rm_conv_init(&rm)) {
+    return -1;
+  }
+  output_ref = malloc(sizeof(float) * nof_tx_bits);
+  for (n = 0; n < NOF_BATCH; n++) {
+    input[n] = malloc(sizeof(float) * nof_rx_bits);
+    output[n] = malloc(sizeof(float) * nof_tx_bits);
+    for (i = 0; i < nof_rx_bits; i++) {
+      input[n][i] = rand() % 8 ? (float) rand() / RAND_MAX - 0.5 : RX_NULL;
+    }
+  }
+  memcpy(input[0], rm_symbols, sizeof(float) * nof_rx_bits);
+
+  if (rm_conv_rx_batch(&rm, input, nof_rx_bits, output, nof_tx_bits, NOF_BATCH)) {
+    goto quit;
+  }
+  for (n = 0; n < NOF_BATCH; n++) {
+    rm_conv_rx(input[n], nof_rx_bits, output_ref, nof_tx_bits);
+    for (i = 0; i < nof_tx_bits; i++) {
+      if (output[n][i] != output_ref[i]) {
+        printf("Input %d: rm_conv_rx_batch() output %d is %f instead of %f\n", n, i, 
+               output[n][i], output_ref[i]);
+        goto quit;
+      }
+    }
+  }
+
+  gettimeofday(&t[1], NULL);
+  for (n = 0; n < NOF_REPS; n++) {
+    rm_conv_rx(input[n % NOF_BATCH], nof_rx_bits, output_ref, nof_tx_bits);
+  }
+  gettimeofday(&t[2], NULL);
+  t_ref = get_time_interval_us(t);
+  gettimeofday(&t[1], NULL);
+  for (n = 0; n < NOF_REPS; n++) {
+    rm_conv_rx_cached(&rm, input[n % NOF_BATCH], nof_rx_bits, output[0], nof_tx_bits);
+  }
+  gettimeofday(&t[2], NULL);
+  t_cached = get_time_interval_us(t);
+  printf("rm_conv_rx: %.2f us, rm_conv_rx_cached: %.2f us\n", t_ref / NOF_REPS, 
+         t_cached / NOF_REPS);
+  ret = 0;
+quit:
+  rm_conv_free(&rm);
+  free(output_ref);
+  for (n = 0; n < NOF_BATCH; n++) {
+    free(input[n]);
+    free(output[n]);
+  }
+  return ret;
+}
+
 int main(int argc, char **argv) {
   int i;
   char *bits, *rm_bits;
@@ -125,6 +191,10 @@ int main(int argc, char **argv) {
     }
   }
 
+  if (nof_tx_bits % 3 == 0 && test_cached(rm_symbols)) {
+    exit(-1);
+  }
+
   free(bits);
   free(rm_bits);
   free(rm_symbols);
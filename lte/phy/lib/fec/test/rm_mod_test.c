@@ -0,0 +1,241 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <complex.h>
+
+#include "liblte/phy/phy.h"
+
+/* Checks that rm_turbo_tx_mod() and rm_conv_tx_mod() produce the same symbols
+ * as rate matching with rm_turbo_tx()/rm_conv_tx(), scrambling with
+ * scrambling_b_offset() and modulating with mod_modulate(), for every
+ * modulation and redundancy version, random code block sizes, rate matching
+ * lengths and scrambling offsets, and transport blocks split in several code
+ * blocks. Reports the throughput of both chains.
+ */
+
+#define MAX_CB          3
+#define MAX_E           (3 * 6144 + 12)
+
+uint32_t nof_frames = 200;
+uint32_t seed = 0;
+
+lte_mod_t modulations[4] = { LTE_BPSK, LTE_QPSK, LTE_QAM16, LTE_QAM64 };
+
+void usage(char *prog) {
+  printf("Usage: %s [ns]\n", prog);
+  printf("\t-n nof_frames per modulation [Default %d]\n", nof_frames);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ns")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  modem_table_t modem[4];
+  mod_stream_t stream;
+  sequence_t seq;
+  char *cb[MAX_CB], *w_buff[MAX_CB], *w_buff_ref[MAX_CB], *e;
+  cf_t *symbols, *symbols_ref;
+  uint32_t i, m, n, c, rv, K, C, E, E_cb, wp, offset, q_m, nof_symbols;
+  uint32_t w_buff_len = 3 * (6144 / 32 + 1) * 32;
+  struct timeval t[3];
+  float t_ref = 0, t_fused = 0;
+  uint64_t total_bits = 0;
+  int ret = -1;
+
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+
+  bzero(&seq, sizeof(sequence_t));
+  bzero(modem, sizeof(modem_table_t) * 4);
+  bzero(cb, sizeof(char*) * MAX_CB);
+  bzero(w_buff, sizeof(char*) * MAX_CB);
+  bzero(w_buff_ref, sizeof(char*) * MAX_CB);
+  e = malloc(sizeof(char) * MAX_CB * MAX_E);
+  symbols = malloc(sizeof(cf_t) * MAX_CB * MAX_E);
+  symbols_ref = malloc(sizeof(cf_t) * MAX_CB * MAX_E);
+  if (!e || !symbols || !symbols_ref) {
+    perror("malloc");
+    goto quit;
+  }
+  for (c = 0; c < MAX_CB; c++) {
+    cb[c] = malloc(sizeof(char) * (3 * 6144 + 12));
+    w_buff[c] = malloc(sizeof(char) * w_buff_len);
+    w_buff_ref[c] = malloc(sizeof(char) * w_buff_len);
+    if (!cb[c] || !w_buff[c] || !w_buff_ref[c]) {
+      perror("malloc");
+      goto quit;
+    }
+  }
+  for (m = 0; m < 4; m++) {
+    if (modem_table_lte(&modem[m], modulations[m], false)) {
+      fprintf(stderr, "Error initializing modem table\n");
+      goto quit;
+    }
+  }
+  if (sequence_LTEPRS(&seq, MAX_CB * MAX_E + 1000, 0x1234)) {
+    fprintf(stderr, "Error generating scrambling sequence\n");
+    goto quit;
+  }
+
+  for (m = 0; m < 4; m++) {
+    q_m = modem[m].nbits_x_symbol;
+    for (n = 0; n < nof_frames; n++) {
+      /* Turbo: C code blocks of K bits rate matched to E bits in total */
+      K = lte_cb_size(rand() % NOF_TC_CB_SIZES);
+      C = 1 + rand() % MAX_CB;
+      nof_symbols = 1 + rand() % ((C * (3 * K + 12)) / q_m);
+      E = nof_symbols * q_m;
+      offset = rand() % 1000;
+      for (c = 0; c < C; c++) {
+        for (i = 0; i < 3 * K + 12; i++) {
+          cb[c][i] = rand() % 2;
+        }
+      }
+      for (rv = 0; rv < 4; rv++) {
+        gettimeofday(&t[1], NULL);
+        wp = 0;
+        for (c = 0; c < C; c++) {
+          E_cb = c < C - 1 ? E / C : E - wp;
+          if (rm_turbo_tx(w_buff_ref[c], w_buff_len, cb[c], 3 * K + 12, &e[wp], E_cb, rv)) {
+            goto quit;
+          }
+          wp += E_cb;
+        }
+        scrambling_b_offset(&seq, e, offset, E);
+        mod_modulate(&modem[m], e, symbols_ref, E);
+        gettimeofday(&t[2], NULL);
+        t_ref += get_time_interval_us(t);
+
+        gettimeofday(&t[1], NULL);
+        mod_stream_init(&stream, &modem[m], &seq.c[offset], symbols);
+        wp = 0;
+        for (c = 0; c < C; c++) {
+          E_cb = c < C - 1 ? E / C : E - wp;
+          if (rm_turbo_tx_mod(w_buff[c], w_buff_len, cb[c], 3 * K + 12, &stream, E_cb, rv)) {
+            goto quit;
+          }
+          wp += E_cb;
+        }
+        gettimeofday(&t[2], NULL);
+        t_fused += get_time_interval_us(t);
+        total_bits += E;
+
+        if (stream.nof_symbols != nof_symbols ||
+            memcmp(symbols, symbols_ref, sizeof(cf_t) * nof_symbols)) {
+          fprintf(stderr, "Turbo: Qm=%d, K=%d, C=%d, E=%d, rv=%d: symbols differ\n",
+              q_m, K, C, E, rv);
+          goto quit;
+        }
+      }
+
+      /* Convolutional: bits offset to offset+E-1 of the rate matched sequence */
+      K = 1 + rand() % 400;
+      nof_symbols = 1 + rand() % (4 * 3 * K / q_m);
+      E = nof_symbols * q_m;
+      offset = rand() % (3 * E);
+      for (i = 0; i < 3 * K; i++) {
+        cb[0][i] = rand() % 2;
+      }
+      if (rm_conv_tx(cb[0], 3 * K, e, offset + E)) {
+        goto quit;
+      }
+      scrambling_b_offset(&seq, &e[offset], offset, E);
+      mod_modulate(&modem[m], &e[offset], symbols_ref, E);
+
+      mod_stream_init(&stream, &modem[m], &seq.c[offset], symbols);
+      if (rm_conv_tx_mod(cb[0], 3 * K, &stream, offset, E)) {
+        goto quit;
+      }
+      if (stream.nof_symbols != nof_symbols ||
+          memcmp(symbols, symbols_ref, sizeof(cf_t) * nof_symbols)) {
+        fprintf(stderr, "Conv: Qm=%d, in_len=%d, E=%d, offset=%d: symbols differ\n",
+            q_m, 3 * K, E, offset);
+        goto quit;
+      }
+    }
+  }
+
+  printf("Rate matched %lu bits. Separate passes: %.1f Mbps, fused: %.1f Mbps\n",
+      total_bits, total_bits / t_ref, total_bits / t_fused);
+  ret = 0;
+quit:
+  for (m = 0; m < 4; m++) {
+    modem_table_free(&modem[m]);
+  }
+  sequence_free(&seq);
+  for (c = 0; c < MAX_CB; c++) {
+    if (cb[c]) {
+      free(cb[c]);
+    }
+    if (w_buff[c]) {
+      free(w_buff[c]);
+    }
+    if (w_buff_ref[c]) {
+      free(w_buff_ref[c]);
+    }
+  }
+  if (e) {
+    free(e);
+  }
+  if (symbols) {
+    free(symbols);
+  }
+  if (symbols_ref) {
+    free(symbols_ref);
+  }
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
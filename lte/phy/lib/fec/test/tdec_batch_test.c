@@ -0,0 +1,310 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Decodes the code blocks of nof_users users in every TTI with tdec_batch_run()
+ * and one by one with tdec_t, and checks that the decoded bits, CRC results, 
+ * number of iterations and HARQ buffers are the same. Each user has a fixed 
+ * code block size (some of them shared) and retransmits each block with 
+ * redundancy versions 0, 2, 3 and 1 in consecutive TTIs. Odd users use 
+ * rate matching and HARQ buffers, even users pass the code block LLRs.
+ * With -f, each user sends a one code block transport block whose size is not
+ * a code block size, so the block starts with filler bits and is checked with
+ * the transport block CRC.
+ */
+
+#define MAX_USERS       64
+#define W_BUFF_LEN      (3 * (6144 / 32 + 1) * 32)
+
+uint32_t nof_tti = 20;
+uint32_t nof_users = 16;
+uint32_t max_iterations = 6;
+float ebno_db = 1.0;
+uint32_t seed = 0;
+bool filler = false;
+
+uint32_t rv_seq[4] = {0, 2, 3, 1};
+
+void usage(char *prog) {
+  printf("Usage: %s [nuiesf]\n", prog);
+  printf("\t-n nof_tti [Default %d]\n", nof_tti);
+  printf("\t-u nof_users (code blocks per TTI) [Default %d]\n", nof_users);
+  printf("\t-i max_iterations [Default %d]\n", max_iterations);
+  printf("\t-e Eb/No in dB [Default %.1f]\n", ebno_db);
+  printf("\t-s seed [Default 0=time]\n");
+  printf("\t-f transport blocks with filler bits [Default %s]\n", filler ? "yes" : "no");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "nuiesf")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_tti = atoi(argv[optind]);
+      break;
+    case 'u':
+      nof_users = atoi(argv[optind]);
+      break;
+    case 'i':
+      max_iterations = atoi(argv[optind]);
+      break;
+    case 'e':
+      ebno_db = atof(argv[optind]);
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    case 'f':
+      filler = true;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (nof_users > MAX_USERS) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+typedef struct {
+  uint32_t K;
+  uint32_t F;
+  uint32_t E;
+  bool harq;
+  char *data;
+  char *coded;
+  char *w_buff_tx;
+  float *llr;
+  float *w_buff;
+  float *w_buff_ref;
+  char *output;
+  char *output_ref;
+} user_t;
+
+int main(int argc, char **argv) {
+  tdec_batch_t batch;
+  tdec_t tdec;
+  tcod_t tcod;
+  crc_t crc, crc_tb, *crc_ref;
+  user_t users[MAX_USERS];
+  tdec_job_t jobs[MAX_USERS];
+  char *e_bits;
+  float *cb;
+  uint32_t sizes[5];
+  uint32_t i, j, n, u, rv, len, it, nof_llr, tbs;
+  uint32_t iterations_ref, nof_crc_ok = 0;
+  bool crc_ok_ref;
+  float var, t_batch = 0, t_ref = 0;
+  struct timeval t[3];
+  uint64_t total_bits = 0;
+  int ret = -1;
+
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+  crc_ref = filler ? &crc_tb : &crc;
+  var = sqrt(1 / pow(10, (ebno_db + 10 * log10(1.0 / 3)) / 10));
+
+  bzero(users, sizeof(users));
+  e_bits = malloc(sizeof(char) * 2 * (3 * 6144 + 12));
+  cb = malloc(sizeof(float) * (3 * 6144 + 12));
+  if (!e_bits || !cb) {
+    perror("malloc");
+    exit(-1);
+  }
+  if (tdec_batch_init(&batch, 6144) || tdec_init(&tdec, 6144) || tcod_init(&tcod, 6144) ||
+      crc_init(&crc, LTE_CRC24B, 24) || crc_init(&crc_tb, LTE_CRC24A, 24)) 
+  {
+    fprintf(stderr, "Error initiating turbo decoder\n");
+    exit(-1);
+  }
+
+  /* a few code block sizes shared by the users, plus some unique ones */
+  for (i = 0; i < 5; i++) {
+    sizes[i] = lte_cb_size(rand() % NOF_TC_CB_SIZES);
+  }
+  for (u = 0; u < nof_users; u++) {
+    if (filler) {
+      /* the smallest code block that fits the transport block and its CRC */
+      do {
+        tbs = 16 + rand() % (6144 - 24 - 16 + 1);
+        users[u].K = lte_cb_size(lte_find_cb_index(tbs + 24));
+      } while (users[u].K == tbs + 24);
+      users[u].F = users[u].K - tbs - 24;
+    } else {
+      users[u].K = u % 3 ? sizes[rand() % 5] : lte_cb_size(rand() % NOF_TC_CB_SIZES);
+    }
+    users[u].harq = u % 2;
+    users[u].E = (3 * users[u].K + 12) / 2 + rand() % (3 * users[u].K);
+    len = 3 * users[u].K + 12;
+    users[u].data = malloc(sizeof(char) * users[u].K);
+    users[u].coded = malloc(sizeof(char) * len);
+    users[u].w_buff_tx = malloc(sizeof(char) * W_BUFF_LEN);
+    users[u].llr = malloc(sizeof(float) * 2 * len);
+    users[u].w_buff = malloc(sizeof(float) * W_BUFF_LEN);
+    users[u].w_buff_ref = malloc(sizeof(float) * W_BUFF_LEN);
+    users[u].output = malloc(sizeof(char) * users[u].K);
+    users[u].output_ref = malloc(sizeof(char) * users[u].K);
+    if (!users[u].data || !users[u].coded || !users[u].w_buff_tx || !users[u].llr || 
+        !users[u].w_buff || !users[u].w_buff_ref || !users[u].output || !users[u].output_ref) 
+    {
+      perror("malloc");
+      goto quit;
+    }
+  }
+
+  for (n = 0; n < nof_tti; n++) {
+    rv = rv_seq[n % 4];
+    bzero(jobs, sizeof(tdec_job_t) * nof_users);
+    for (u = 0; u < nof_users; u++) {
+      user_t *us = &users[u];
+      len = 3 * us->K + 12;
+      if (rv == 0) {
+        /* the filler bits are random too, so that a CRC check that includes
+         * them fails */
+        for (i = 0; i < us->K - 24; i++) {
+          us->data[i] = rand() % 2;
+        }
+        crc_attach(crc_ref, &us->data[us->F], us->K - us->F - 24);
+        tcod_encode(&tcod, us->data, us->coded, us->K);
+      }
+      if (us->harq) {
+        if (rm_turbo_tx(us->w_buff_tx, W_BUFF_LEN, us->coded, len, e_bits, us->E, rv)) {
+          goto quit;
+        }
+        nof_llr = us->E;
+      } else {
+        memcpy(e_bits, us->coded, len);
+        nof_llr = len;
+      }
+      for (i = 0; i < nof_llr; i++) {
+        us->llr[i] = e_bits[i] ? sqrt(2) : -sqrt(2);
+      }
+      ch_awgn_f(us->llr, us->llr, var, nof_llr);
+
+      jobs[u].llr = us->llr;
+      jobs[u].long_cb = us->K;
+      jobs[u].nof_filler = us->F;
+      jobs[u].crc = filler ? TDEC_CRC_24A : TDEC_CRC_24B;
+      jobs[u].output = us->output;
+      if (us->harq) {
+        jobs[u].e_len = us->E;
+        jobs[u].w_buff = us->w_buff;
+        jobs[u].w_buff_size = W_BUFF_LEN;
+        jobs[u].rv_idx = rv;
+      }
+      total_bits += us->K;
+    }
+
+    gettimeofday(&t[1], NULL);
+    if (tdec_batch_run(&batch, jobs, nof_users, max_iterations)) {
+      fprintf(stderr, "Error in batch decoder\n");
+      goto quit;
+    }
+    gettimeofday(&t[2], NULL);
+    t_batch += get_time_interval_us(t);
+
+    for (u = 0; u < nof_users; u++) {
+      user_t *us = &users[u];
+      len = 3 * us->K + 12;
+
+      gettimeofday(&t[1], NULL);
+      if (us->harq) {
+        if (rm_turbo_rx(us->w_buff_ref, W_BUFF_LEN, us->llr, us->E, cb, len, rv)) {
+          goto quit;
+        }
+      } else {
+        memcpy(cb, us->llr, sizeof(float) * len);
+      }
+      tdec_reset(&tdec, us->K);
+      crc_ok_ref = false;
+      for (it = 0; it < max_iterations && !crc_ok_ref; it++) {
+        tdec_iteration(&tdec, cb, us->K);
+        tdec_decision(&tdec, us->output_ref, us->K);
+        crc_ok_ref = !crc_checksum(crc_ref, &us->output_ref[us->F], us->K - us->F);
+      }
+      iterations_ref = it;
+      gettimeofday(&t[2], NULL);
+      t_ref += get_time_interval_us(t);
+
+      if (jobs[u].crc_ok != crc_ok_ref || jobs[u].nof_iterations != iterations_ref || 
+          memcmp(us->output, us->output_ref, us->K) || 
+          (us->harq && memcmp(us->w_buff, us->w_buff_ref, sizeof(float) * len))) 
+      {
+        fprintf(stderr, "TTI %d, user %d, K=%d, F=%d: batch CRC %d, %d iterations, "
+                "tdec CRC %d, %d iterations\n", n, u, us->K, us->F, jobs[u].crc_ok, 
+                jobs[u].nof_iterations, crc_ok_ref, iterations_ref);
+        for (j = 0; j < us->K && us->output[j] == us->output_ref[j]; j++);
+        if (j < us->K) {
+          fprintf(stderr, "First different bit: %d\n", j);
+        }
+        goto quit;
+      }
+      nof_crc_ok += crc_ok_ref;
+    }
+  }
+
+  printf("Decoded %d code blocks, %d with CRC ok. Batch: %.1f Mbps, one by one: %.1f Mbps\n",
+         nof_tti * nof_users, nof_crc_ok, total_bits / t_batch, total_bits / t_ref);
+  ret = 0;
+quit:
+  for (u = 0; u < nof_users; u++) {
+    if (users[u].data) free(users[u].data);
+    if (users[u].coded) free(users[u].coded);
+    if (users[u].w_buff_tx) free(users[u].w_buff_tx);
+    if (users[u].llr) free(users[u].llr);
+    if (users[u].w_buff) free(users[u].w_buff);
+    if (users[u].w_buff_ref) free(users[u].w_buff_ref);
+    if (users[u].output) free(users[u].output);
+    if (users[u].output_ref) free(users[u].output_ref);
+  }
+  free(e_bits);
+  free(cb);
+  tdec_batch_free(&batch);
+  tdec_free(&tdec);
+  tcod_free(&tcod);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
@@ -0,0 +1,236 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Checks tcod_encode() and tcod_encode_packed() against a bit-by-bit
+ * shift-register encoder for every code block size (or the one given with -l)
+ * and reports the throughput of each.
+ */
+
+uint32_t long_cb = 0;
+uint32_t nof_frames = 100;
+uint32_t seed = 0;
+
+void usage(char *prog) {
+  printf("Usage: %s [lns]\n", prog);
+  printf("\t-l code block size [Default all]\n");
+  printf("\t-n nof_frames per size [Default %d]\n", nof_frames);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "lns")) != -1) {
+    switch (opt) {
+    case 'l':
+      long_cb = atoi(argv[optind]);
+      break;
+    case 'n':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* Reference encoder clocking the shift registers one bit at a time */
+void tcod_encode_ref(tc_interl_t *interl, char *input, char *output, uint32_t long_cb) {
+  char reg1_0 = 0, reg1_1 = 0, reg1_2 = 0, reg2_0 = 0, reg2_1 = 0, reg2_2 = 0;
+  char bit, in, out;
+  uint32_t i, j, k = 0;
+
+  tc_interl_LTE_gen(interl, long_cb);
+  for (i = 0; i < long_cb; i++) {
+    bit = input[i];
+    output[k++] = bit;
+    in = bit ^ (reg1_2 ^ reg1_1);
+    out = reg1_2 ^ (reg1_0 ^ in);
+    reg1_2 = reg1_1;
+    reg1_1 = reg1_0;
+    reg1_0 = in;
+    output[k++] = out;
+
+    bit = input[interl->forward[i]];
+    in = bit ^ (reg2_2 ^ reg2_1);
+    out = reg2_2 ^ (reg2_0 ^ in);
+    reg2_2 = reg2_1;
+    reg2_1 = reg2_0;
+    reg2_0 = in;
+    output[k++] = out;
+  }
+  for (j = 0; j < 3; j++) {
+    bit = reg1_2 ^ reg1_1;
+    output[k++] = bit;
+    in = bit ^ (reg1_2 ^ reg1_1);
+    out = reg1_2 ^ (reg1_0 ^ in);
+    reg1_2 = reg1_1;
+    reg1_1 = reg1_0;
+    reg1_0 = in;
+    output[k++] = out;
+  }
+  for (j = 0; j < 3; j++) {
+    bit = reg2_2 ^ reg2_1;
+    output[k++] = bit;
+    in = bit ^ (reg2_2 ^ reg2_1);
+    out = reg2_2 ^ (reg2_0 ^ in);
+    reg2_2 = reg2_1;
+    reg2_1 = reg2_0;
+    reg2_0 = in;
+    output[k++] = out;
+  }
+}
+
+void bits_to_bytes(char *bits, uint8_t *bytes, uint32_t nof_bits) {
+  uint32_t i;
+  bzero(bytes, (nof_bits + 7) / 8);
+  for (i = 0; i < nof_bits; i++) {
+    bytes[i / 8] |= (bits[i] & 1) << (7 - i % 8);
+  }
+}
+
+void bytes_to_bits(uint8_t *bytes, char *bits, uint32_t nof_bits) {
+  uint32_t i;
+  for (i = 0; i < nof_bits; i++) {
+    bits[i] = (bytes[i / 8] >> (7 - i % 8)) & 1;
+  }
+}
+
+int main(int argc, char **argv) {
+  tcod_t tcod;
+  tc_interl_t interl;
+  char *input, *output, *output_ref;
+  uint8_t *input_packed, *output_packed;
+  uint32_t i, n, cb_idx, first, last, K, coded_len;
+  struct timeval t[3];
+  float t_ref = 0, t_char = 0, t_packed = 0;
+  uint64_t total_bits = 0;
+  int ret = -1;
+
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+
+  if (long_cb) {
+    if (lte_find_cb_index(long_cb) < 0 || lte_cb_size(lte_find_cb_index(long_cb)) != long_cb) {
+      fprintf(stderr, "Invalid code block size %d\n", long_cb);
+      exit(-1);
+    }
+    first = last = lte_find_cb_index(long_cb);
+  } else {
+    first = 0;
+    last = NOF_TC_CB_SIZES - 1;
+  }
+
+  input = malloc(sizeof(char) * 6144);
+  output = malloc(sizeof(char) * (3 * 6144 + TOTALTAIL));
+  output_ref = malloc(sizeof(char) * (3 * 6144 + TOTALTAIL));
+  input_packed = malloc(sizeof(uint8_t) * 6144 / 8);
+  output_packed = malloc(sizeof(uint8_t) * ((3 * 6144 + TOTALTAIL) / 8 + 1));
+  if (!input || !output || !output_ref || !input_packed || !output_packed) {
+    perror("malloc");
+    exit(-1);
+  }
+  if (tcod_init(&tcod, 6144) || tc_interl_init(&interl, 6144)) {
+    fprintf(stderr, "Error initiating turbo coder\n");
+    exit(-1);
+  }
+
+  for (cb_idx = first; cb_idx <= last; cb_idx++) {
+    K = lte_cb_size(cb_idx);
+    coded_len = 3 * K + TOTALTAIL;
+    for (n = 0; n < nof_frames; n++) {
+      for (i = 0; i < K; i++) {
+        input[i] = rand() % 2;
+      }
+      bits_to_bytes(input, input_packed, K);
+
+      gettimeofday(&t[1], NULL);
+      tcod_encode_ref(&interl, input, output_ref, K);
+      gettimeofday(&t[2], NULL);
+      t_ref += get_time_interval_us(t);
+
+      gettimeofday(&t[1], NULL);
+      if (tcod_encode(&tcod, input, output, K)) {
+        goto quit;
+      }
+      gettimeofday(&t[2], NULL);
+      t_char += get_time_interval_us(t);
+      if (memcmp(output, output_ref, coded_len)) {
+        fprintf(stderr, "K=%d: tcod_encode() output differs from reference\n", K);
+        goto quit;
+      }
+
+      gettimeofday(&t[1], NULL);
+      if (tcod_encode_packed(&tcod, input_packed, output_packed, K)) {
+        goto quit;
+      }
+      gettimeofday(&t[2], NULL);
+      t_packed += get_time_interval_us(t);
+      bytes_to_bits(output_packed, output, coded_len);
+      if (memcmp(output, output_ref, coded_len)) {
+        fprintf(stderr, "K=%d: tcod_encode_packed() output differs from reference\n", K);
+        goto quit;
+      }
+      total_bits += K;
+    }
+  }
+
+  printf("Encoded %lu bits. Reference: %.1f Mbps, tcod_encode: %.1f Mbps, "
+      "tcod_encode_packed: %.1f Mbps\n", total_bits, total_bits / t_ref,
+      total_bits / t_char, total_bits / t_packed);
+  ret = 0;
+quit:
+  tcod_free(&tcod);
+  tc_interl_free(&interl);
+  free(input);
+  free(output);
+  free(output_ref);
+  free(input_packed);
+  free(output_packed);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
@@ -50,13 +50,22 @@ int K = -1;
 int nof_iterations = MAX_ITERATIONS;
 int test_known_data = 0;
 int test_errors = 0;
+uint32_t window_len = 0;
+uint32_t training_len = 32;
+int beta_stored = 0;
+int radix4 = 0;
+int metric_int16 = 0;
+int bench_all = 0;
+uint32_t stop_criteria = 0;
+float stop_min_llr = 20.0;
+float stop_scr = 0.0;
 
 #define SNR_POINTS      8
 #define SNR_MIN         0.0
 #define SNR_MAX         4.0
 
 void usage(char *prog) {
-  printf("Usage: %s [nlesv]\n", prog);
+  printf("Usage: %s [nlesvwrbxqacmg]\n", prog);
   printf(
       "\t-k Test with known data (ignores frame_length) [Default disabled]\n");
   printf("\t-i nof_iterations [Default %d]\n", nof_iterations);
@@ -65,11 +74,21 @@ void usage(char *prog) {
   printf("\t-e ebno in dB [Default scan]\n");
   printf("\t-t test: check errors on exit [Default disabled]\n");
   printf("\t-s seed [Default 0=time]\n");
+  printf("\t-w sliding window length, compared against the full MAP [Default disabled]\n");
+  printf("\t-r sliding window training length [Default %d]\n", training_len);
+  printf("\t-b sliding window beta from previous iteration [Default training]\n");
+  printf("\t-x radix-4 MAP, compared against the radix-2 MAP [Default radix-2]\n");
+  printf("\t-q int16 metrics for the radix-4 MAP [Default float]\n");
+  printf("\t-a benchmark radix-2, radix-4 and radix-4 int16 MAP for all code block sizes\n");
+  printf("\t-c early stopping criteria (1: HDA, 2: min |LLR|, 4: SCR, OR of them), compared "
+      "against nof_iterations [Default disabled]\n");
+  printf("\t-m early stopping min |LLR| [Default %.1f]\n", stop_min_llr);
+  printf("\t-g early stopping sign change ratio [Default %g]\n", stop_scr);
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "inlstvekt")) != -1) {
+  while ((opt = getopt(argc, argv, "inlstvektwrbxqacmg")) != -1) {
     switch (opt) {
     case 'n':
       nof_frames = atoi(argv[optind]);
@@ -92,6 +111,33 @@ void parse_args(int argc, char **argv) {
     case 's':
       seed = (unsigned int) strtoul(argv[optind], NULL, 0);
       break;
+    case 'w':
+      window_len = atoi(argv[optind]);
+      break;
+    case 'r':
+      training_len = atoi(argv[optind]);
+      break;
+    case 'b':
+      beta_stored = 1;
+      break;
+    case 'x':
+      radix4 = 1;
+      break;
+    case 'q':
+      metric_int16 = 1;
+      break;
+    case 'a':
+      bench_all = 1;
+      break;
+    case 'c':
+      stop_criteria = atoi(argv[optind]);
+      break;
+    case 'm':
+      stop_min_llr = atof(argv[optind]);
+      break;
+    case 'g':
+      stop_scr = atof(argv[optind]);
+      break;
     case 'v':
       verbose++;
       break;
@@ -126,6 +172,199 @@ void output_matlab(float ber[MAX_ITERATIONS][SNR_POINTS], int snr_points) {
   fclose(f);
 }
 
+#define NOF_KERNELS 3
+
+/* Decodes nof_frames frames of every code block size with the radix-2, radix-4 
+ * and radix-4 int16 MAP. Prints the throughput of each one and checks that
+ * the number of errors of the radix-4 kernels is close to the radix-2 one.
+ */
+int bench_all_sizes(float var) {
+  char *names[NOF_KERNELS] = {"radix-2", "radix-4", "radix-4 int16"};
+  tdec_t tdec[NOF_KERNELS];
+  tdec_opts_t opts;
+  tcod_t tcod;
+  float *llr;
+  char *data_tx, *data_rx, *symbols;
+  uint32_t i, j, n, cb_idx, long_cb;
+  uint32_t errors[NOF_KERNELS], total_errors[NOF_KERNELS];
+  float usec[NOF_KERNELS], total_usec[NOF_KERNELS];
+  struct timeval t[3];
+  uint64_t total_bits = 0;
+  int ret = -1;
+
+  data_tx = malloc(sizeof(char) * 6144);
+  data_rx = malloc(sizeof(char) * 6144);
+  symbols = malloc(sizeof(char) * (3 * 6144 + TOTALTAIL));
+  llr = malloc(sizeof(float) * (3 * 6144 + TOTALTAIL));
+  if (!data_tx || !data_rx || !symbols || !llr) {
+    perror("malloc");
+    exit(-1);
+  }
+  if (tcod_init(&tcod, 6144)) {
+    fprintf(stderr, "Error initiating Turbo coder\n");
+    exit(-1);
+  }
+  for (i = 0; i < NOF_KERNELS; i++) {
+    bzero(&opts, sizeof(tdec_opts_t));
+    opts.radix = i ? TDEC_RADIX4 : TDEC_RADIX2;
+    opts.metric = i == 2 ? TDEC_METRIC_INT16 : TDEC_METRIC_FLOAT;
+    if (tdec_init_opts(&tdec[i], 6144, &opts)) {
+      fprintf(stderr, "Error initiating Turbo decoder\n");
+      exit(-1);
+    }
+    total_errors[i] = 0;
+    total_usec[i] = 0;
+  }
+
+  printf("%6s", "K");
+  for (i = 0; i < NOF_KERNELS; i++) {
+    printf("%22s", names[i]);
+  }
+  printf("  (Mbps / errors)\n");
+  for (cb_idx = 0; cb_idx < NOF_TC_CB_SIZES; cb_idx++) {
+    long_cb = lte_cb_size(cb_idx);
+    bzero(errors, sizeof(uint32_t) * NOF_KERNELS);
+    bzero(usec, sizeof(float) * NOF_KERNELS);
+    for (n = 0; n < nof_frames; n++) {
+      for (j = 0; j < long_cb; j++) {
+        data_tx[j] = rand() % 2;
+      }
+      tcod_encode(&tcod, data_tx, symbols, long_cb);
+      for (j = 0; j < 3 * long_cb + TOTALTAIL; j++) {
+        llr[j] = symbols[j] ? sqrt(2) : -sqrt(2);
+      }
+      ch_awgn_f(llr, llr, var, 3 * long_cb + TOTALTAIL);
+      for (i = 0; i < NOF_KERNELS; i++) {
+        gettimeofday(&t[1], NULL);
+        tdec_run_all(&tdec[i], llr, data_rx, nof_iterations, long_cb);
+        gettimeofday(&t[2], NULL);
+        get_time_interval(t);
+        usec[i] += t[0].tv_sec * 1e6 + t[0].tv_usec;
+        errors[i] += bit_diff(data_tx, data_rx, long_cb);
+      }
+    }
+    printf("%6d", long_cb);
+    for (i = 0; i < NOF_KERNELS; i++) {
+      printf("%14.1f /%6d", (float) long_cb * nof_frames / usec[i], errors[i]);
+      total_errors[i] += errors[i];
+      total_usec[i] += usec[i];
+    }
+    printf("\n");
+    total_bits += long_cb * nof_frames;
+  }
+  printf("%6s", "total");
+  for (i = 0; i < NOF_KERNELS; i++) {
+    printf("%14.1f /%6d", total_bits / total_usec[i], total_errors[i]);
+  }
+  printf("\n");
+
+  ret = 0;
+  for (i = 1; i < NOF_KERNELS; i++) {
+    if (total_errors[i] > 1.1 * total_errors[0] + 10) {
+      fprintf(stderr, "%s MAP got %d errors, radix-2 %d\n", names[i], total_errors[i],
+          total_errors[0]);
+      ret = -1;
+    }
+  }
+
+  for (i = 0; i < NOF_KERNELS; i++) {
+    tdec_free(&tdec[i]);
+  }
+  tcod_free(&tcod);
+  free(data_tx);
+  free(data_rx);
+  free(symbols);
+  free(llr);
+  return ret;
+}
+
+/* Decodes nof_frames frames stopping when the selected criteria are met and 
+ * compares the errors with those of running all the iterations on the same
+ * frames. Prints the average number of iterations and the throughput of both.
+ */
+int early_stop_test(float var, uint32_t max_iterations) {
+  tdec_t tdec;
+  tdec_stop_t stop;
+  tcod_t tcod;
+  float *llr;
+  char *data_tx, *data_rx, *symbols;
+  uint32_t i, n, it, errors = 0, errors_ref = 0;
+  uint32_t coded_length = 3 * frame_length + TOTALTAIL;
+  uint64_t total_iterations = 0;
+  float usec = 0, usec_ref = 0;
+  struct timeval t[3];
+  int ret = 0;
+
+  data_tx = malloc(sizeof(char) * frame_length);
+  data_rx = malloc(sizeof(char) * frame_length);
+  symbols = malloc(sizeof(char) * coded_length);
+  llr = malloc(sizeof(float) * coded_length);
+  if (!data_tx || !data_rx || !symbols || !llr) {
+    perror("malloc");
+    exit(-1);
+  }
+  if (tcod_init(&tcod, frame_length) || tdec_init(&tdec, frame_length)) {
+    fprintf(stderr, "Error initiating Turbo coder/decoder\n");
+    exit(-1);
+  }
+  bzero(&stop, sizeof(tdec_stop_t));
+  stop.criteria = stop_criteria;
+  stop.min_llr = stop_min_llr;
+  stop.scr = stop_scr;
+
+  for (n = 0; n < nof_frames; n++) {
+    for (i = 0; i < frame_length; i++) {
+      data_tx[i] = rand() % 2;
+    }
+    tcod_encode(&tcod, data_tx, symbols, frame_length);
+    for (i = 0; i < coded_length; i++) {
+      llr[i] = symbols[i] ? sqrt(2) : -sqrt(2);
+    }
+    ch_awgn_f(llr, llr, var, coded_length);
+
+    tdec_set_stop(&tdec, NULL);
+    gettimeofday(&t[1], NULL);
+    tdec_run_all(&tdec, llr, data_rx, max_iterations, frame_length);
+    gettimeofday(&t[2], NULL);
+    get_time_interval(t);
+    usec_ref += t[0].tv_sec * 1e6 + t[0].tv_usec;
+    errors_ref += bit_diff(data_tx, data_rx, frame_length);
+
+    tdec_set_stop(&tdec, &stop);
+    gettimeofday(&t[1], NULL);
+    tdec_reset(&tdec, frame_length);
+    it = 0;
+    do {
+      tdec_iteration(&tdec, llr, frame_length);
+      it++;
+    } while (it < max_iterations && !tdec_stop_check(&tdec, frame_length));
+    tdec_decision(&tdec, data_rx, frame_length);
+    gettimeofday(&t[2], NULL);
+    get_time_interval(t);
+    usec += t[0].tv_sec * 1e6 + t[0].tv_usec;
+    errors += bit_diff(data_tx, data_rx, frame_length);
+    total_iterations += it;
+  }
+
+  printf("Early stopping: %u errors, %.2f iterations, %.1f Mbps\n", errors, 
+      (float) total_iterations / nof_frames, (float) frame_length * nof_frames / usec);
+  printf("%d iterations:    %u errors, %.1f Mbps\n", max_iterations, errors_ref, 
+      (float) frame_length * nof_frames / usec_ref);
+  /* allow 10% more errors than running all the iterations plus some margin */
+  if (test_errors && errors > 1.1 * errors_ref + 10) {
+    fprintf(stderr, "Got %d errors, %d without early stopping\n", errors, errors_ref);
+    ret = -1;
+  }
+
+  tdec_free(&tdec);
+  tcod_free(&tcod);
+  free(data_tx);
+  free(data_rx);
+  free(symbols);
+  free(llr);
+  return ret;
+}
+
 int main(int argc, char **argv) {
   uint32_t frame_cnt;
   float *llr;
@@ -139,8 +378,11 @@ int main(int argc, char **argv) {
   uint32_t coded_length;
   struct timeval tdata[3];
   float mean_usec;
-  tdec_t tdec;
+  float ebno_inc, esno_db;
+  tdec_t tdec, tdec_ref;
+  tdec_opts_t opts;
   tcod_t tcod;
+  uint32_t errors_ref = 0;
 
   parse_args(argc, argv);
 
@@ -149,6 +391,20 @@ int main(int argc, char **argv) {
   }
   srand(seed);
 
+  if (stop_criteria) {
+    esno_db = ebno_db + 10 * log10((double) 1 / 3);
+    exit(early_stop_test(sqrt(1 / (pow(10, esno_db / 10))), 
+        nof_iterations == -1 ? MAX_ITERATIONS : nof_iterations));
+  }
+
+  if (bench_all) {
+    esno_db = ebno_db + 10 * log10((double) 1 / 3);
+    if (nof_iterations == -1) {
+      nof_iterations = MAX_ITERATIONS;
+    }
+    exit(bench_all_sizes(sqrt(1 / (pow(10, esno_db / 10)))));
+  }
+
   if (test_known_data) {
     frame_length = KNOWN_DATA_LEN;
   } else {
@@ -195,12 +451,31 @@ int main(int argc, char **argv) {
     exit(-1);
   }
 
-  if (tdec_init(&tdec, frame_length)) {
+  if (window_len || radix4) {
+    /* tdec uses the sliding window or radix-4 MAP, tdec_ref decodes the same 
+     * frames with the full radix-2 MAP */
+    bzero(&opts, sizeof(tdec_opts_t));
+    if (window_len) {
+      opts.map = TDEC_MAP_SLIDING_WINDOW;
+      opts.window_len = window_len;
+      opts.training_len = training_len;
+      opts.beta_init = beta_stored ? TDEC_BETA_STORED : TDEC_BETA_TRAINING;
+      printf("  Sliding window: %d, training: %d, beta init: %s\n", window_len, training_len,
+          beta_stored ? "previous iteration" : "training");
+    } else {
+      opts.radix = TDEC_RADIX4;
+      opts.metric = metric_int16 ? TDEC_METRIC_INT16 : TDEC_METRIC_FLOAT;
+      printf("  Radix-4 MAP, %s metrics\n", metric_int16 ? "int16" : "float");
+    }
+    if (tdec_init_opts(&tdec, frame_length, &opts) || tdec_init(&tdec_ref, frame_length)) {
+      fprintf(stderr, "Error initiating Turbo decoder\n");
+      exit(-1);
+    }
+  } else if (tdec_init(&tdec, frame_length)) {
     fprintf(stderr, "Error initiating Turbo decoder\n");
     exit(-1);
   }
 
-  float ebno_inc, esno_db;
   ebno_inc = (SNR_MAX - SNR_MIN) / SNR_POINTS;
   if (ebno_db == 100.0) {
     snr_points = SNR_POINTS;
@@ -218,6 +493,7 @@ int main(int argc, char **argv) {
     mean_usec = 0;
     frame_cnt = 0;
     bzero(errors, sizeof(int) * MAX_ITERATIONS);
+    errors_ref = 0;
     while (frame_cnt < nof_frames) {
 
       /* generate data_tx */
@@ -272,6 +548,10 @@ int main(int argc, char **argv) {
           ber[j][i] = (float) errors[j] / (frame_cnt * frame_length);
         }
       }
+      if (window_len || radix4) {
+        tdec_run_all(&tdec_ref, llr, data_rx, t, frame_length);
+        errors_ref += bit_diff(data_tx, data_rx, frame_length);
+      }
       frame_cnt++;
       printf("Eb/No: %3.2f %10d/%d   ",
       SNR_MIN + i * ebno_inc, frame_cnt, nof_frames);
@@ -284,7 +564,18 @@ int main(int argc, char **argv) {
     printf("\n");
 
     if (snr_points == 1) {
-      if (test_known_data && seed == KNOWN_DATA_SEED
+      if (window_len || radix4) {
+        /* BER parity: allow 10% more errors than the full MAP plus some margin */
+        j = (nof_iterations == -1 ? MAX_ITERATIONS : nof_iterations) - 1;
+        printf("BER: %g\t%u errors (full radix-2 MAP: %g\t%u errors)\n",
+            (float) errors[j] / (frame_cnt * frame_length), 
+            errors[j], (float) errors_ref / (frame_cnt * frame_length), errors_ref);
+        if (test_errors && errors[j] > 1.1 * errors_ref + 10) {
+          fprintf(stderr, "Got %d errors, full radix-2 MAP %d\n", 
+              errors[j], errors_ref);
+          exit(-1);
+        }
+      } else if (test_known_data && seed == KNOWN_DATA_SEED
           && ebno_db == KNOWN_DATA_EBNO && frame_cnt == KNOWN_DATA_NFRAMES) {
         for (j = 0; j < MAX_ITERATIONS; j++) {
           if (errors[j] > known_data_errors[j]) {
@@ -323,6 +614,9 @@ int main(int argc, char **argv) {
   free(data_rx);
 
   tdec_free(&tdec);
+  if (window_len || radix4) {
+    tdec_free(&tdec_ref);
+  }
   tcod_free(&tcod);
 
   printf("\n");
@@ -0,0 +1,276 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Checks viterbi_gen_t for several constraint lengths, rates and polynomials,
+ * with and without tail biting: noiseless frames must be decoded without 
+ * errors, batch decoding must give the same bits as decoding one frame at a 
+ * time and, at the given Eb/No, the bit errors of the K=7 rate 1/3 code must 
+ * not exceed those of viterbi_37 by more than 25%. Noiseless frames must also
+ * be reliable with soft output enabled. Reports the throughput of both 
+ * decoders.
+ */
+
+#define MAX_FRAMES  16
+#define NOF_CODES   7
+
+typedef struct {
+  uint32_t K;
+  uint32_t R;
+  uint32_t poly[3];
+  bool tail_biting;
+} code_t;
+
+code_t codes[NOF_CODES] = {
+  {7, 3, {0x6D, 0x4F, 0x57}, true},
+  {7, 3, {0x6D, 0x4F, 0x57}, false},
+  {9, 3, {0x1ed, 0x19b, 0x127}, true},
+  {9, 3, {0x1ed, 0x19b, 0x127}, false},
+  {7, 2, {0x79, 0x5b, 0}, true},
+  {9, 2, {0x1af, 0x11d, 0}, false},
+  {5, 2, {0x17, 0x19, 0}, true},
+};
+
+uint32_t frame_length = 100;
+uint32_t nof_frames = 64;
+float ebno_db = 2.0;
+uint32_t seed = 0;
+
+void usage(char *prog) {
+  printf("Usage: %s [nles]\n", prog);
+  printf("\t-n nof_frames [Default %d]\n", nof_frames);
+  printf("\t-l frame_length [Default %d]\n", frame_length);
+  printf("\t-e ebno in dB [Default %.1f]\n", ebno_db);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "nles")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 'l':
+      frame_length = atoi(argv[optind]);
+      break;
+    case 'e':
+      ebno_db = atof(argv[optind]);
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* Encodes nof random frames and modulates them to +-1 with noise of the given 
+ * standard deviation. Returns the coded length. 
+ */
+uint32_t gen_frames(convcoder_t *cod, char **data, char *bits, float **llr, 
+                    uint32_t nof, float std) {
+  uint32_t i, n, len = 0;
+
+  for (n = 0; n < nof; n++) {
+    for (i = 0; i < frame_length; i++) {
+      data[n][i] = rand() % 2;
+    }
+    len = convcoder_encode(cod, data[n], bits, frame_length);
+    for (i = 0; i < len; i++) {
+      llr[n][i] = bits[i] ? 1.0 : -1.0;
+    }
+    if (std > 0) {
+      ch_awgn_f(llr[n], llr[n], std, len);
+    }
+  }
+  return len;
+}
+
+int main(int argc, char **argv) {
+  viterbi_gen_t gen;
+  viterbi_t ref;
+  convcoder_t cod;
+  char *data[MAX_FRAMES], *decoded[MAX_FRAMES], *bits, *out;
+  float *llr[MAX_FRAMES];
+  uint8_t *llr_uc;
+  uint32_t c, n, i, len, errors, errors_ref, total_bits;
+  float std, t_gen = 0, t_ref = 0;
+  struct timeval t[3];
+  int ret = -1;
+
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+  if (nof_frames > MAX_FRAMES) {
+    nof_frames = MAX_FRAMES;
+  }
+
+  bzero(&gen, sizeof(viterbi_gen_t));
+  bzero(&ref, sizeof(viterbi_t));
+  len = 3 * (frame_length + VITERBI_GEN_MAX_K);
+  bits = malloc(sizeof(char) * len);
+  out = malloc(sizeof(char) * frame_length);
+  llr_uc = malloc(sizeof(uint8_t) * len);
+  if (!bits || !out || !llr_uc) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (n = 0; n < MAX_FRAMES; n++) {
+    data[n] = malloc(sizeof(char) * frame_length);
+    decoded[n] = malloc(sizeof(char) * frame_length);
+    llr[n] = malloc(sizeof(float) * len);
+    if (!data[n] || !decoded[n] || !llr[n]) {
+      perror("malloc");
+      exit(-1);
+    }
+  }
+
+  /* Noiseless frames and batch decoding */
+  for (c = 0; c < NOF_CODES; c++) {
+    cod.K = codes[c].K;
+    cod.R = codes[c].R;
+    cod.tail_biting = codes[c].tail_biting;
+    memcpy(cod.poly, codes[c].poly, sizeof(cod.poly));
+    if (viterbi_gen_init(&gen, cod.K, cod.R, cod.poly, frame_length, cod.tail_biting)) {
+      fprintf(stderr, "Error initiating Viterbi decoder\n");
+      goto quit;
+    }
+    gen_frames(&cod, data, bits, llr, nof_frames, 0);
+    if (viterbi_gen_decode_batch(&gen, llr, decoded, nof_frames, frame_length) != nof_frames) {
+      fprintf(stderr, "Error decoding\n");
+      goto quit;
+    }
+    for (n = 0; n < nof_frames; n++) {
+      if (bit_diff(data[n], decoded[n], frame_length)) {
+        fprintf(stderr, "1/%d K=%d%s: errors without noise in frame %d\n", cod.R, cod.K, 
+                cod.tail_biting ? " tb" : "", n);
+        goto quit;
+      }
+    }
+    if (viterbi_gen_set_soft_output(&gen, true)) {
+      goto quit;
+    }
+    for (n = 0; n < nof_frames; n++) {
+      viterbi_gen_decode(&gen, llr[n], out, frame_length);
+      if (memcmp(out, decoded[n], frame_length) || viterbi_gen_reliability(&gen) < 2) {
+        fprintf(stderr, "1/%d K=%d%s: soft output frame %d not reliable (%.2f)\n", cod.R, 
+                cod.K, cod.tail_biting ? " tb" : "", n, viterbi_gen_reliability(&gen));
+        goto quit;
+      }
+    }
+    viterbi_gen_set_soft_output(&gen, false);
+
+    std = sqrtf(1 / powf(10, (ebno_db + 10 * log10f(1.0 / cod.R)) / 10) / 2);
+    gen_frames(&cod, data, bits, llr, nof_frames, std);
+    viterbi_gen_decode_batch(&gen, llr, decoded, nof_frames, frame_length);
+    errors = 0;
+    for (n = 0; n < nof_frames; n++) {
+      viterbi_gen_decode(&gen, llr[n], out, frame_length);
+      if (memcmp(out, decoded[n], frame_length)) {
+        fprintf(stderr, "1/%d K=%d%s: batch and single frame decoding differ\n", cod.R, 
+                cod.K, cod.tail_biting ? " tb" : "");
+        goto quit;
+      }
+      errors += bit_diff(data[n], decoded[n], frame_length);
+    }
+    printf("1/%d K=%d %s: BER %.2e at Eb/No %.1f dB\n", cod.R, cod.K, 
+           cod.tail_biting ? "tail biting" : "terminated ", 
+           (float) errors / (nof_frames * frame_length), ebno_db);
+    viterbi_gen_free(&gen);
+  }
+
+  /* Comparison with viterbi_37 */
+  cod.K = 7;
+  cod.R = 3;
+  cod.tail_biting = true;
+  memcpy(cod.poly, codes[0].poly, sizeof(cod.poly));
+  if (viterbi_gen_init(&gen, cod.K, cod.R, cod.poly, frame_length, true) ||
+      viterbi_init(&ref, viterbi_37, cod.poly, frame_length, true)) {
+    fprintf(stderr, "Error initiating Viterbi decoder\n");
+    goto quit;
+  }
+  std = sqrtf(1 / powf(10, (ebno_db + 10 * log10f(1.0 / 3)) / 10) / 2);
+  errors = errors_ref = total_bits = 0;
+  for (i = 0; i < 10; i++) {
+    len = gen_frames(&cod, data, bits, llr, nof_frames, std);
+    for (n = 0; n < nof_frames; n++) {
+      gettimeofday(&t[1], NULL);
+      viterbi_gen_decode(&gen, llr[n], decoded[n], frame_length);
+      gettimeofday(&t[2], NULL);
+      t_gen += get_time_interval_us(t);
+      errors += bit_diff(data[n], decoded[n], frame_length);
+
+      gettimeofday(&t[1], NULL);
+      vec_quant_fuc(llr[n], llr_uc, 32, 127.5, 255, len);
+      viterbi_decode_uc(&ref, llr_uc, decoded[n], frame_length);
+      gettimeofday(&t[2], NULL);
+      t_ref += get_time_interval_us(t);
+      errors_ref += bit_diff(data[n], decoded[n], frame_length);
+      total_bits += frame_length;
+    }
+  }
+  printf("1/3 K=7 tail biting: viterbi_gen %d errors %.1f Mbps, viterbi_37 %d errors %.1f Mbps\n",
+         errors, total_bits / t_gen, errors_ref, total_bits / t_ref);
+  if (errors > errors_ref + errors_ref / 4 + 2) {
+    fprintf(stderr, "Too many errors\n");
+    goto quit;
+  }
+  ret = 0;
+quit:
+  viterbi_gen_free(&gen);
+  viterbi_free(&ref);
+  for (n = 0; n < MAX_FRAMES; n++) {
+    free(data[n]);
+    free(decoded[n]);
+    free(llr[n]);
+  }
+  free(bits);
+  free(out);
+  free(llr_uc);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
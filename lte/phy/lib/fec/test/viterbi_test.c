@@ -148,7 +148,7 @@ int main(int argc, char **argv) {
     cod[0].poly[0] = 0x1ed;
     cod[0].poly[1] = 0x19b;
     cod[0].poly[2] = 0x127;
-    cod[0].tail_biting = false;
+    cod[0].tail_biting = tail_biting;
     cod[0].K = 9;
     viterbi_type[0] = viterbi_39;
     ncods=1;
@@ -0,0 +1,112 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <complex.h>
+
+#include "liblte/phy/filter/fir.h"
+#include "liblte/phy/utils/debug.h"
+
+/* Modified Bessel function of the first kind, order 0 */
+static double bessel_i0(double x) {
+  double sum = 1, term = 1;
+  uint32_t k;
+
+  for (k = 1; k < 50; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+    if (term < 1e-12 * sum) {
+      break;
+    }
+  }
+  return sum;
+}
+
+float fir_kaiser_beta(float atten_db) {
+  if (atten_db > 50) {
+    return 0.1102 * (atten_db - 8.7);
+  } else if (atten_db >= 21) {
+    return 0.5842 * powf(atten_db - 21, 0.4) + 0.07886 * (atten_db - 21);
+  } else {
+    return 0;
+  }
+}
+
+uint32_t fir_kaiser_len(float atten_db, float transition) {
+  if (transition <= 0) {
+    return 0;
+  }
+  return (uint32_t) ceilf((atten_db - 7.95) / (14.36 * transition)) + 1;
+}
+
+int fir_lowpass(float *taps, uint32_t nof_taps, float cutoff, float beta) {
+  uint32_t i;
+  double t, w, sum = 0;
+  double center = (double) (nof_taps - 1) / 2;
+
+  if (taps == NULL || nof_taps == 0 || cutoff <= 0 || cutoff > 0.5) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  for (i = 0; i < nof_taps; i++) {
+    t = i - center;
+    if (nof_taps > 1) {
+      w = bessel_i0(beta * sqrt(1 - pow(t / center, 2))) / bessel_i0(beta);
+    } else {
+      w = 1;
+    }
+    if (fabs(t) < 1e-9) {
+      taps[i] = (float) (2 * cutoff * w);
+    } else {
+      taps[i] = (float) (sin(2 * M_PI * cutoff * t) / (M_PI * t) * w);
+    }
+    sum += taps[i];
+  }
+  for (i = 0; i < nof_taps; i++) {
+    taps[i] /= sum;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+void fir_shift(float *taps, _Complex float *taps_c, uint32_t nof_taps, float freq) {
+  uint32_t i;
+  for (i = 0; i < nof_taps; i++) {
+    taps_c[i] = taps[i] * cexpf(_Complex_I * 2 * M_PI * freq * i);
+  }
+}
+
+float fir_gain_db(float *taps, uint32_t nof_taps, float freq) {
+  uint32_t i;
+  _Complex double h = 0;
+
+  for (i = 0; i < nof_taps; i++) {
+    h += taps[i] * cexp(-_Complex_I * 2 * M_PI * freq * i);
+  }
+  return (float) (20 * log10(cabs(h) + 1e-30));
+}
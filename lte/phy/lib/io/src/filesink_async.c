@@ -0,0 +1,299 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "liblte/phy/io/filesink_async.h"
+#include "liblte/phy/utils/debug.h"
+
+static uint32_t sample_size(data_type_t type) {
+  switch(type) {
+  case FLOAT_BIN:
+  case COMPLEX_SHORT_BIN:
+    return 4;
+  case COMPLEX_FLOAT_BIN:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+/* Writes len bytes. If the file system rejects the O_DIRECT write, retries
+ * it through the page cache.
+ */
+static int write_all(filesink_async_t *q, char *buffer, uint32_t len) {
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(q->fd, buffer, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EINVAL && q->direct) {
+        INFO("O_DIRECT write rejected, writing through the page cache\n", 0);
+        fcntl(q->fd, F_SETFL, fcntl(q->fd, F_GETFL) & ~O_DIRECT);
+        q->direct = false;
+        continue;
+      }
+      perror("write");
+      return LIBLTE_ERROR;
+    }
+    buffer += n;
+    len -= n;
+    q->nof_bytes_written += n;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+static void write_buffer(filesink_async_t *q, uint32_t idx) {
+  if (q->write_error) {
+    return;
+  }
+  /* only the last buffer can be partial and break the O_DIRECT alignment */
+  if (q->direct && q->buffer_len[idx] % FILESINK_ASYNC_ALIGN) {
+    fcntl(q->fd, F_SETFL, fcntl(q->fd, F_GETFL) & ~O_DIRECT);
+    q->direct = false;
+  }
+  if (write_all(q, q->buffers[idx], q->buffer_len[idx])) {
+    q->write_error = true;
+  }
+}
+
+static void* writer_thread(void *arg) {
+  filesink_async_t *q = (filesink_async_t*) arg;
+  uint32_t head, tail;
+
+  pthread_mutex_lock(&q->mutex);
+  while (true) {
+    while (!q->stop && __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == q->tail) {
+      pthread_cond_wait(&q->cvar, &q->mutex);
+    }
+    head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    if (head == q->tail && q->stop) {
+      break;
+    }
+    pthread_mutex_unlock(&q->mutex);
+    for (tail = q->tail; tail != head; tail++) {
+      write_buffer(q, tail % q->nof_buffers);
+      /* hands the buffer back to the caller */
+      __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_lock(&q->mutex);
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return NULL;
+}
+
+/* Hands the buffer being filled to the writer thread */
+static void publish(filesink_async_t *q) {
+  uint32_t pending;
+
+  q->buffer_len[q->head % q->nof_buffers] = q->fill;
+  q->fill = 0;
+  __atomic_store_n(&q->head, q->head + 1, __ATOMIC_RELEASE);
+  pending = q->head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+  if (pending > q->max_pending) {
+    q->max_pending = pending;
+  }
+  pthread_mutex_lock(&q->mutex);
+  pthread_cond_signal(&q->cvar);
+  pthread_mutex_unlock(&q->mutex);
+}
+
+/** Only binary types are supported. buffer_size is rounded up to a multiple
+ * of FILESINK_ASYNC_ALIGN; nof_buffers of them are allocated and touched here
+ * so that writing samples never faults a page in. If direct is true and the
+ * file system does not support O_DIRECT, the page cache is used.
+ */
+int filesink_async_init(filesink_async_t *q, char *filename, data_type_t type,
+                        uint32_t buffer_size, uint32_t nof_buffers, bool direct)
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  uint32_t i;
+
+  if (q               != NULL &&
+      filename        != NULL &&
+      sample_size(type) > 0   &&
+      buffer_size     >  0    &&
+      nof_buffers     >  0)
+  {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(filesink_async_t));
+    q->fd = -1;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->cvar, NULL);
+
+    q->sample_size = sample_size(type);
+    q->buffer_size = ((buffer_size + FILESINK_ASYNC_ALIGN - 1) / FILESINK_ASYNC_ALIGN) *
+                     FILESINK_ASYNC_ALIGN;
+    q->nof_buffers = nof_buffers;
+
+    q->fd = open(filename, direct ? flags | O_DIRECT : flags, 0644);
+    if (q->fd < 0 && direct && errno == EINVAL) {
+      INFO("O_DIRECT not supported for %s\n", filename);
+      direct = false;
+      q->fd = open(filename, flags, 0644);
+    }
+    if (q->fd < 0) {
+      perror(filename);
+      goto clean;
+    }
+    q->direct = direct;
+
+    q->buffers = calloc(nof_buffers, sizeof(void*));
+    q->buffer_len = calloc(nof_buffers, sizeof(uint32_t));
+    if (!q->buffers || !q->buffer_len) {
+      perror("malloc");
+      goto clean;
+    }
+    for (i = 0; i < nof_buffers; i++) {
+      if (posix_memalign(&q->buffers[i], FILESINK_ASYNC_ALIGN, q->buffer_size)) {
+        q->buffers[i] = NULL;
+        perror("posix_memalign");
+        goto clean;
+      }
+      bzero(q->buffers[i], q->buffer_size);
+    }
+
+    if (pthread_create(&q->thread, NULL, writer_thread, q)) {
+      perror("pthread_create");
+      goto clean;
+    }
+    q->thread_running = true;
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    filesink_async_free(q);
+  }
+  return ret;
+}
+
+/* Writes the samples that are still buffered and closes the file */
+void filesink_async_free(filesink_async_t *q) {
+  uint32_t i;
+
+  if (q->thread_running) {
+    /* a partially filled buffer was free when it was filled */
+    if (q->fill > 0) {
+      publish(q);
+    }
+    pthread_mutex_lock(&q->mutex);
+    q->stop = true;
+    pthread_cond_signal(&q->cvar);
+    pthread_mutex_unlock(&q->mutex);
+    pthread_join(q->thread, NULL);
+  }
+  if (q->fd >= 0) {
+    close(q->fd);
+  }
+  if (q->buffers) {
+    for (i = 0; i < q->nof_buffers; i++) {
+      if (q->buffers[i]) {
+        free(q->buffers[i]);
+      }
+    }
+    free(q->buffers);
+  }
+  if (q->buffer_len) {
+    free(q->buffer_len);
+  }
+  pthread_cond_destroy(&q->cvar);
+  pthread_mutex_destroy(&q->mutex);
+  bzero(q, sizeof(filesink_async_t));
+}
+
+/** Copies nsamples samples into the buffer pool. Samples that do not fit
+ * because the writer thread is behind are dropped. Returns the number of
+ * samples accepted, which are the first ones of buffer.
+ */
+int filesink_async_write(filesink_async_t *q, void *buffer, uint32_t nsamples) {
+  uint32_t len, n, copied = 0;
+
+  if (q == NULL || buffer == NULL || !q->thread_running) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  len = nsamples * q->sample_size;
+  q->nof_samples += nsamples;
+  while (copied < len) {
+    /* when head - tail == nof_buffers the writer is still using this buffer */
+    if (q->head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) >= q->nof_buffers) {
+      break;
+    }
+    n = len - copied;
+    if (n > q->buffer_size - q->fill) {
+      n = q->buffer_size - q->fill;
+    }
+    memcpy((char*) q->buffers[q->head % q->nof_buffers] + q->fill, (char*) buffer + copied, n);
+    q->fill += n;
+    copied += n;
+    if (q->fill == q->buffer_size) {
+      publish(q);
+    }
+  }
+  if (copied < len) {
+    if (!q->dropping) {
+      q->nof_overflows++;
+      q->dropping = true;
+    }
+    q->nof_dropped += (len - copied) / q->sample_size;
+  } else {
+    q->dropping = false;
+  }
+  return copied / q->sample_size;
+}
+
+uint64_t filesink_async_nof_dropped(filesink_async_t *q) {
+  return q->nof_dropped;
+}
+
+uint32_t filesink_async_nof_overflows(filesink_async_t *q) {
+  return q->nof_overflows;
+}
+
+/* Maximum number of full buffers that were waiting to be written. If it
+ * approaches nof_buffers, the pool is too small for the disk.
+ */
+uint32_t filesink_async_max_pending(filesink_async_t *q) {
+  return q->max_pending;
+}
+
+/* True if a write to the file failed. The following samples are discarded */
+bool filesink_async_error(filesink_async_t *q) {
+  return q->write_error;
+}
@@ -0,0 +1,207 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "liblte/phy/io/filesource_mmap.h"
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/utils/vector.h"
+
+/* Bytes prefetched after a seek */
+#define MMAP_WILLNEED_LEN   (4*1024*1024)
+
+static uint32_t sample_size(data_type_t type) {
+  return type == COMPLEX_SHORT_BIN ? 2 * sizeof(int16_t) : sizeof(cf_t);
+}
+
+/* Asks the kernel to start reading the file from the current position */
+static void prefetch(filesource_mmap_t *q) {
+  size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  size_t offset = (q->pos * sample_size(q->type)) & ~(page - 1);
+  size_t len = MMAP_WILLNEED_LEN;
+
+  if (offset < q->map_len) {
+    if (offset + len > q->map_len) {
+      len = q->map_len - offset;
+    }
+    madvise((char*) q->map + offset, len, MADV_WILLNEED);
+  }
+}
+
+/* Only COMPLEX_FLOAT_BIN and COMPLEX_SHORT_BIN files are supported.
+ */
+int filesource_mmap_init(filesource_mmap_t *q, char *filename, data_type_t type) {
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  struct stat st;
+
+  if (q        != NULL &&
+      filename != NULL &&
+      (type == COMPLEX_FLOAT_BIN || type == COMPLEX_SHORT_BIN))
+  {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(filesource_mmap_t));
+    q->type = type;
+    q->fd = open(filename, O_RDONLY);
+    if (q->fd < 0) {
+      perror(filename);
+      goto clean;
+    }
+    if (fstat(q->fd, &st)) {
+      perror("fstat");
+      goto clean;
+    }
+    q->nof_samples = st.st_size / sample_size(type);
+    q->map_len = q->nof_samples * sample_size(type);
+    if (q->map_len == 0) {
+      fprintf(stderr, "File %s has no samples\n", filename);
+      goto clean;
+    }
+    q->map = mmap(NULL, q->map_len, PROT_READ, MAP_SHARED, q->fd, 0);
+    if (q->map == MAP_FAILED) {
+      q->map = NULL;
+      perror("mmap");
+      goto clean;
+    }
+    madvise(q->map, q->map_len, MADV_SEQUENTIAL);
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    filesource_mmap_free(q);
+  }
+  return ret;
+}
+
+void filesource_mmap_free(filesource_mmap_t *q) {
+  if (q->map) {
+    munmap(q->map, q->map_len);
+  }
+  if (q->fd >= 0) {
+    close(q->fd);
+  }
+  if (q->buffer) {
+    free(q->buffer);
+  }
+  bzero(q, sizeof(filesource_mmap_t));
+  q->fd = -1;
+}
+
+uint64_t filesource_mmap_nof_samples(filesource_mmap_t *q) {
+  return q->nof_samples;
+}
+
+uint64_t filesource_mmap_tell(filesource_mmap_t *q) {
+  return q->pos;
+}
+
+/* Sets the next sample to read. Seeking to the end of the file is allowed */
+int filesource_mmap_seek(filesource_mmap_t *q, uint64_t sample) {
+  if (sample > q->nof_samples) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  q->pos = sample;
+  prefetch(q);
+  return LIBLTE_SUCCESS;
+}
+
+/* Seeks to the start of subframe nsubframe of a capture of nof_prb PRB
+ * starting at a subframe boundary.
+ */
+int filesource_mmap_seek_sf(filesource_mmap_t *q, uint32_t nsubframe, uint32_t nof_prb) {
+  int symbol_sz = lte_symbol_sz(nof_prb);
+  if (symbol_sz < 0) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  return filesource_mmap_seek(q, (uint64_t) nsubframe * SF_LEN(symbol_sz));
+}
+
+/** Points samples to the next nsamples samples (or less, at the end of the
+ * file) and advances the position. COMPLEX_FLOAT_BIN samples are not copied,
+ * COMPLEX_SHORT_BIN samples are converted into an internal buffer which is
+ * overwritten in the next call. Returns the number of samples, 0 at the end of
+ * the file.
+ */
+int filesource_mmap_get(filesource_mmap_t *q, cf_t **samples, uint32_t nsamples) {
+  if (q == NULL || samples == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (nsamples > q->nof_samples - q->pos) {
+    nsamples = (uint32_t) (q->nof_samples - q->pos);
+  }
+  if (q->type == COMPLEX_FLOAT_BIN) {
+    *samples = &((cf_t*) q->map)[q->pos];
+  } else {
+    if (nsamples > q->buffer_len) {
+      if (q->buffer) {
+        free(q->buffer);
+      }
+      q->buffer = vec_malloc(sizeof(cf_t) * nsamples);
+      if (!q->buffer) {
+        perror("malloc");
+        q->buffer_len = 0;
+        return LIBLTE_ERROR;
+      }
+      q->buffer_len = nsamples;
+    }
+    vec_convert_if(&((int16_t*) q->map)[2 * q->pos], (float*) q->buffer, 
+                   INT16_MAX, 2 * nsamples);
+    *samples = q->buffer;
+  }
+  q->pos += nsamples;
+  return nsamples;
+}
+
+/** Copies (or converts) the next nsamples samples to buffer, as
+ * filesource_read() does. Returns the number of samples, 0 at the end of the
+ * file.
+ */
+int filesource_mmap_read(filesource_mmap_t *q, cf_t *buffer, uint32_t nsamples) {
+  if (q == NULL || buffer == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (nsamples > q->nof_samples - q->pos) {
+    nsamples = (uint32_t) (q->nof_samples - q->pos);
+  }
+  if (q->type == COMPLEX_FLOAT_BIN) {
+    memcpy(buffer, &((cf_t*) q->map)[q->pos], sizeof(cf_t) * nsamples);
+  } else {
+    vec_convert_if(&((int16_t*) q->map)[2 * q->pos], (float*) buffer, 
+                   INT16_MAX, 2 * nsamples);
+  }
+  q->pos += nsamples;
+  return nsamples;
+}
@@ -0,0 +1,293 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+
+#include "liblte/phy/io/sigmf.h"
+#include "liblte/phy/utils/vector.h"
+#include "sigmf_file.h"
+
+#define SIGMF_VERSION         "1.0.0"
+#define INITIAL_ANNOTATIONS   1024
+
+char *sigmf_phich_resources[4] = {"1/6", "1/2", "1", "2"};
+
+/* Returns a new string with base_name, without any SigMF extension, followed by ext */
+char* sigmf_file_name(char *base_name, char *ext) {
+  char *name;
+  size_t len = strlen(base_name);
+
+  if (len > 11 && (!strcmp(&base_name[len - 11], ".sigmf-data") ||
+                   !strcmp(&base_name[len - 11], ".sigmf-meta"))) {
+    len -= 11;
+  }
+  name = malloc(len + strlen(ext) + 1);
+  if (name) {
+    memcpy(name, base_name, len);
+    strcpy(&name[len], ext);
+  }
+  return name;
+}
+
+int sigmf_sink_init(sigmf_sink_t *q, char *base_name, sigmf_meta_t *meta) {
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  char *data_file_name = NULL;
+
+  if (q         != NULL &&
+      base_name != NULL &&
+      meta      != NULL &&
+      (meta->type == COMPLEX_FLOAT_BIN || meta->type == COMPLEX_SHORT_BIN))
+  {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(sigmf_sink_t));
+    q->meta = *meta;
+    q->meta_file_name = sigmf_file_name(base_name, ".sigmf-meta");
+    data_file_name = sigmf_file_name(base_name, ".sigmf-data");
+    if (!q->meta_file_name || !data_file_name) {
+      perror("malloc");
+      goto clean;
+    }
+    if (filesink_async_init(&q->fsink, data_file_name, meta->type, SIGMF_SINK_BUFFER_SIZE, 
+                            SIGMF_SINK_NOF_BUFFERS, true)) {
+      goto clean;
+    }
+    q->max_annotations = INITIAL_ANNOTATIONS;
+    q->annotations = malloc(sizeof(sigmf_annotation_t) * q->max_annotations);
+    if (!q->annotations) {
+      perror("malloc");
+      goto clean;
+    }
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (data_file_name) {
+    free(data_file_name);
+  }
+  if (ret == LIBLTE_ERROR) {
+    sigmf_sink_free(q);
+  }
+  return ret;
+}
+
+/* Writes the metadata and closes the recording */
+void sigmf_sink_free(sigmf_sink_t *q) {
+  if (q->fsink.thread_running) {
+    filesink_async_free(&q->fsink);
+    sigmf_sink_write_meta(q);
+  }
+  if (q->meta_file_name) {
+    free(q->meta_file_name);
+  }
+  if (q->annotations) {
+    free(q->annotations);
+  }
+  if (q->buffer) {
+    free(q->buffer);
+  }
+  bzero(q, sizeof(sigmf_sink_t));
+}
+
+/* Sets the cell once it has been found */
+void sigmf_sink_set_cell(sigmf_sink_t *q, lte_cell_t cell) {
+  q->meta.cell = cell;
+}
+
+/* Returns the number of samples passed to sigmf_sink_write() so far, i.e.
+ * the index of the next one. Annotations are given in this count, which
+ * includes the samples dropped.
+ */
+uint64_t sigmf_sink_nof_samples(sigmf_sink_t *q) {
+  return q->nof_samples;
+}
+
+/* Returns the number of samples that were dropped because the disk was too slow */
+uint64_t sigmf_sink_nof_dropped(sigmf_sink_t *q) {
+  return q->nof_dropped;
+}
+
+/* Never blocks on the disk. Dropped samples are not an error, they are counted */
+int sigmf_sink_write(sigmf_sink_t *q, cf_t *samples, uint32_t nsamples) {
+  int n;
+
+  if (q == NULL || !q->fsink.thread_running || samples == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (q->meta.type == COMPLEX_FLOAT_BIN) {
+    n = filesink_async_write(&q->fsink, samples, nsamples);
+  } else {
+    if (nsamples > q->buffer_len) {
+      if (q->buffer) {
+        free(q->buffer);
+      }
+      q->buffer = malloc(sizeof(int16_t) * 2 * nsamples);
+      if (!q->buffer) {
+        perror("malloc");
+        q->buffer_len = 0;
+        return LIBLTE_ERROR;
+      }
+      q->buffer_len = nsamples;
+    }
+    vec_convert_fi((float*) samples, q->buffer, INT16_MAX, 2 * nsamples);
+    n = filesink_async_write(&q->fsink, q->buffer, nsamples);
+  }
+  if (n < 0) {
+    return LIBLTE_ERROR;
+  }
+  q->nof_samples += nsamples;
+  if (n < nsamples) {
+    q->nof_dropped += nsamples - n;
+    q->drop_end = q->nof_samples;
+  }
+  return filesink_async_error(&q->fsink) ? LIBLTE_ERROR : LIBLTE_SUCCESS;
+}
+
+/* Annotations must be added in order of sample_start, in the count of
+ * sigmf_sink_nof_samples(), after writing their samples.
+ */
+int sigmf_sink_annotate(sigmf_sink_t *q, sigmf_annotation_t *annotation) {
+  sigmf_annotation_t *tmp;
+
+  if (q == NULL || annotation == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  /* some samples of this subframe were dropped */
+  q->last_annotated = annotation->sample_start >= q->drop_end;
+  if (!q->last_annotated) {
+    return LIBLTE_SUCCESS;
+  }
+  if (q->nof_annotations == q->max_annotations) {
+    tmp = realloc(q->annotations, sizeof(sigmf_annotation_t) * 2 * q->max_annotations);
+    if (!tmp) {
+      perror("realloc");
+      return LIBLTE_ERROR;
+    }
+    q->annotations = tmp;
+    q->max_annotations *= 2;
+  }
+  q->annotations[q->nof_annotations] = *annotation;
+  /* position in the file, all the samples dropped so far were before it */
+  q->annotations[q->nof_annotations].sample_start -= q->nof_dropped;
+  q->nof_annotations++;
+  return LIBLTE_SUCCESS;
+}
+
+/* Sets the SFN of the last annotation, e.g. after decoding the MIB in it */
+void sigmf_sink_set_sfn(sigmf_sink_t *q, uint32_t sfn) {
+  if (q->nof_annotations > 0 && q->last_annotated) {
+    q->annotations[q->nof_annotations - 1].sfn = (int) sfn;
+  }
+}
+
+/* True if b is the subframe that follows a */
+static bool consecutive(sigmf_annotation_t *a, sigmf_annotation_t *b) {
+  return b->sf_idx == (a->sf_idx + 1) % 10 &&
+         b->sample_start > a->sample_start &&
+         b->sample_start - a->sample_start < 2 * (uint64_t) a->sample_count;
+}
+
+/* Extends the known SFNs to the consecutive subframes before and after them */
+static void propagate_sfn(sigmf_sink_t *q) {
+  sigmf_annotation_t *a = q->annotations;
+  uint32_t i;
+
+  for (i = 1; i < q->nof_annotations; i++) {
+    if (a[i].sfn == SIGMF_SFN_UNKNOWN && a[i - 1].sfn != SIGMF_SFN_UNKNOWN &&
+        consecutive(&a[i - 1], &a[i])) {
+      a[i].sfn = a[i].sf_idx == 0 ? (a[i - 1].sfn + 1) % 1024 : a[i - 1].sfn;
+    }
+  }
+  for (i = q->nof_annotations - 1; i > 0; i--) {
+    if (a[i - 1].sfn == SIGMF_SFN_UNKNOWN && a[i].sfn != SIGMF_SFN_UNKNOWN &&
+        consecutive(&a[i - 1], &a[i])) {
+      a[i - 1].sfn = a[i].sf_idx == 0 ? (a[i].sfn + 1023) % 1024 : a[i].sfn;
+    }
+  }
+}
+
+/** Writes the .sigmf-meta file. Called by sigmf_sink_free(), it can also be
+ * called at any time to save the metadata of the samples written so far.
+ */
+int sigmf_sink_write_meta(sigmf_sink_t *q) {
+  FILE *f;
+  sigmf_annotation_t *a;
+  uint32_t i;
+
+  f = fopen(q->meta_file_name, "w");
+  if (!f) {
+    perror(q->meta_file_name);
+    return LIBLTE_ERROR;
+  }
+  propagate_sfn(q);
+
+  fprintf(f, "{\n  \"global\": {\n");
+  fprintf(f, "    \"core:datatype\": \"%s\",\n", 
+          q->meta.type == COMPLEX_FLOAT_BIN ? "cf32_le" : "ci16_le");
+  fprintf(f, "    \"core:sample_rate\": %.1f,\n", q->meta.sample_rate);
+  fprintf(f, "    \"core:version\": \"%s\",\n", SIGMF_VERSION);
+  fprintf(f, "    \"core:recorder\": \"libLTE\",\n");
+  fprintf(f, "    \"core:extensions\": [{\"name\": \"liblte\", \"version\": \"%s\", "
+          "\"optional\": true}]", SIGMF_VERSION);
+  if (q->meta.cell.nof_prb > 0) {
+    fprintf(f, ",\n    \"liblte:cell_id\": %d,\n", q->meta.cell.id);
+    fprintf(f, "    \"liblte:nof_prb\": %d,\n", q->meta.cell.nof_prb);
+    fprintf(f, "    \"liblte:nof_ports\": %d,\n", q->meta.cell.nof_ports);
+    fprintf(f, "    \"liblte:cp\": \"%s\",\n", CP_ISNORM(q->meta.cell.cp) ? "normal" : "extended");
+    fprintf(f, "    \"liblte:phich_resources\": \"%s\",\n", 
+            sigmf_phich_resources[q->meta.phich_resources]);
+    fprintf(f, "    \"liblte:phich_length\": \"%s\"", 
+            q->meta.phich_length == PHICH_NORM ? "normal" : "extended");
+  }
+  if (q->nof_dropped > 0) {
+    fprintf(f, ",\n    \"liblte:dropped_samples\": %lu", q->nof_dropped);
+  }
+  fprintf(f, "\n  },\n");
+
+  fprintf(f, "  \"captures\": [\n    {\"core:sample_start\": 0");
+  if (q->meta.frequency > 0) {
+    fprintf(f, ", \"core:frequency\": %.1f", q->meta.frequency);
+  }
+  fprintf(f, "}\n  ],\n");
+
+  fprintf(f, "  \"annotations\": [");
+  for (i = 0; i < q->nof_annotations; i++) {
+    a = &q->annotations[i];
+    fprintf(f, "%s\n    {\"core:sample_start\": %lu, \"core:sample_count\": %d, "
+            "\"core:label\": \"SF %d%s\", \"liblte:sf_idx\": %d, \"liblte:sfn\": %d, "
+            "\"liblte:cell_id\": %d, \"liblte:cfo\": %.2f, \"liblte:pss\": %s}",
+            i ? "," : "", a->sample_start, a->sample_count, a->sf_idx, a->pss ? " PSS" : "",
+            a->sf_idx, a->sfn, a->cell_id, a->cfo, a->pss ? "true" : "false");
+  }
+  fprintf(f, "\n  ]\n}\n");
+  fclose(f);
+  return LIBLTE_SUCCESS;
+}
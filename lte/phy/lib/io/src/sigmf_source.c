@@ -0,0 +1,440 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <sys/stat.h>
+
+#include "liblte/phy/io/sigmf.h"
+#include "liblte/phy/utils/vector.h"
+#include "sigmf_file.h"
+
+/* The metadata is read with a minimal JSON parser: values are looked up by
+ * key within the object or array that contains them, which is enough for
+ * SigMF since keys are namespaced and unique within each object.
+ */
+
+static char* read_file(char *file_name) {
+  struct stat st;
+  FILE *f;
+  char *buf;
+
+  if (stat(file_name, &st)) {
+    perror(file_name);
+    return NULL;
+  }
+  f = fopen(file_name, "r");
+  if (!f) {
+    perror(file_name);
+    return NULL;
+  }
+  buf = malloc(st.st_size + 1);
+  if (buf) {
+    if (fread(buf, 1, st.st_size, f) != st.st_size) {
+      free(buf);
+      buf = NULL;
+    } else {
+      buf[st.st_size] = '\0';
+    }
+  }
+  fclose(f);
+  return buf;
+}
+
+/* p points to a '{' or '['. Returns a pointer to the matching closing character */
+static char* json_skip(char *p) {
+  int depth = 0;
+  bool in_str = false;
+
+  for (; *p; p++) {
+    if (in_str) {
+      if (*p == '\\' && p[1]) {
+        p++;
+      } else if (*p == '"') {
+        in_str = false;
+      }
+    } else if (*p == '"') {
+      in_str = true;
+    } else if (*p == '{' || *p == '[') {
+      depth++;
+    } else if (*p == '}' || *p == ']') {
+      if (--depth == 0) {
+        return p;
+      }
+    }
+  }
+  return NULL;
+}
+
+/* Returns a pointer to the value of key within the NUL-terminated string obj */
+static char* json_value(char *obj, char *key) {
+  char pattern[64], *p;
+
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+  p = strstr(obj, pattern);
+  if (!p) {
+    return NULL;
+  }
+  p += strlen(pattern);
+  while (isspace(*p)) {
+    p++;
+  }
+  if (*p != ':') {
+    return NULL;
+  }
+  p++;
+  while (isspace(*p)) {
+    p++;
+  }
+  return p;
+}
+
+static bool json_num(char *obj, char *key, double *value) {
+  char *p = json_value(obj, key);
+  if (!p || !(isdigit(*p) || *p == '-')) {
+    return false;
+  }
+  *value = strtod(p, NULL);
+  return true;
+}
+
+static bool json_str(char *obj, char *key, char *value, uint32_t len) {
+  char *p = json_value(obj, key), *end;
+  if (!p || *p != '"') {
+    return false;
+  }
+  p++;
+  end = strchr(p, '"');
+  if (!end || end - p >= len) {
+    return false;
+  }
+  memcpy(value, p, end - p);
+  value[end - p] = '\0';
+  return true;
+}
+
+static bool json_bool(char *obj, char *key) {
+  char *p = json_value(obj, key);
+  return p && !strncmp(p, "true", 4);
+}
+
+/* Returns the object or array that is the value of key in doc, terminating it
+ * with a NUL. *saved and *end are used to restore doc afterwards.
+ */
+static char* json_section(char *doc, char *key, char open, char **end, char *saved) {
+  char *p = json_value(doc, key);
+  if (!p || *p != open) {
+    return NULL;
+  }
+  *end = json_skip(p);
+  if (!*end) {
+    return NULL;
+  }
+  (*end)++;
+  *saved = **end;
+  **end = '\0';
+  return p;
+}
+
+static int parse_global(sigmf_source_t *q, char *global) {
+  char str[32];
+  double v;
+  uint32_t i;
+
+  if (!json_str(global, "core:datatype", str, 32)) {
+    fprintf(stderr, "SigMF: missing core:datatype\n");
+    return LIBLTE_ERROR;
+  }
+  if (!strcmp(str, "cf32_le") || !strcmp(str, "cf32")) {
+    q->meta.type = COMPLEX_FLOAT_BIN;
+  } else if (!strcmp(str, "ci16_le") || !strcmp(str, "ci16")) {
+    q->meta.type = COMPLEX_SHORT_BIN;
+  } else {
+    fprintf(stderr, "SigMF: unsupported datatype %s\n", str);
+    return LIBLTE_ERROR;
+  }
+  if (json_num(global, "core:sample_rate", &v)) {
+    q->meta.sample_rate = v;
+  }
+  if (json_num(global, "liblte:nof_prb", &v)) {
+    q->meta.cell.nof_prb = (uint32_t) v;
+    q->meta.cell.nof_ports = json_num(global, "liblte:nof_ports", &v) ? (uint32_t) v : 1;
+    q->meta.cell.id = json_num(global, "liblte:cell_id", &v) ? (uint32_t) v : 0;
+    q->meta.cell.cp = json_str(global, "liblte:cp", str, 32) && 
+                      !strcmp(str, "extended") ? CPEXT : CPNORM;
+    q->meta.phich_resources = R_1;
+    if (json_str(global, "liblte:phich_resources", str, 32)) {
+      for (i = 0; i < 4; i++) {
+        if (!strcmp(str, sigmf_phich_resources[i])) {
+          q->meta.phich_resources = (phich_resources_t) i;
+        }
+      }
+    }
+    q->meta.phich_length = json_str(global, "liblte:phich_length", str, 32) && 
+                           !strcmp(str, "extended") ? PHICH_EXT : PHICH_NORM;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/* Stores the valid subframe annotations, the others are ignored */
+static int parse_annotations(sigmf_source_t *q, char *p) {
+  sigmf_annotation_t *a;
+  char *end;
+  double v;
+  uint32_t max = 0;
+
+  for (p++; *p; p = end + 1) {
+    while (*p && *p != '{' && *p != ']') {
+      p++;
+    }
+    if (*p != '{' || !(end = json_skip(p))) {
+      break;
+    }
+    *end = '\0';
+    if (json_num(p, "liblte:sf_idx", &v)) {
+      if (q->nof_annotations == max) {
+        max = max ? 2 * max : 1024;
+        a = realloc(q->annotations, sizeof(sigmf_annotation_t) * max);
+        if (!a) {
+          perror("realloc");
+          return LIBLTE_ERROR;
+        }
+        q->annotations = a;
+      }
+      a = &q->annotations[q->nof_annotations];
+      bzero(a, sizeof(sigmf_annotation_t));
+      a->sf_idx = (uint32_t) v;
+      a->sample_start = json_num(p, "core:sample_start", &v) ? (uint64_t) v : 0;
+      a->sample_count = json_num(p, "core:sample_count", &v) ? (uint32_t) v : 0;
+      a->sfn = json_num(p, "liblte:sfn", &v) ? (int) v : SIGMF_SFN_UNKNOWN;
+      a->cell_id = json_num(p, "liblte:cell_id", &v) ? (uint32_t) v : q->meta.cell.id;
+      a->cfo = json_num(p, "liblte:cfo", &v) ? (float) v : 0;
+      a->pss = json_bool(p, "liblte:pss");
+      /* a subframe has 15 FFT windows worth of samples */
+      if (a->sf_idx < NSUBFRAMES_X_FRAME && a->sample_count > 0 && a->sample_count % 15 == 0) {
+        q->nof_annotations++;
+      }
+    }
+    *end = '}';
+  }
+  return LIBLTE_SUCCESS;
+}
+
+static int parse_meta(sigmf_source_t *q, char *doc) {
+  char *section, *end, saved;
+  double v;
+  int ret;
+
+  section = json_section(doc, "global", '{', &end, &saved);
+  if (!section) {
+    fprintf(stderr, "SigMF: missing global object\n");
+    return LIBLTE_ERROR;
+  }
+  ret = parse_global(q, section);
+  *end = saved;
+  if (ret) {
+    return ret;
+  }
+
+  section = json_section(doc, "captures", '[', &end, &saved);
+  if (section) {
+    if (json_num(section, "core:frequency", &v)) {
+      q->meta.frequency = v;
+    }
+    *end = saved;
+  }
+
+  section = json_section(doc, "annotations", '[', &end, &saved);
+  if (section) {
+    ret = parse_annotations(q, section);
+    *end = saved;
+  }
+  return ret;
+}
+
+/** Opens a recording given its base name or the name of either of its files.
+ * The recording must have subframe annotations.
+ */
+int sigmf_source_init(sigmf_source_t *q, char *file_name) {
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  char *meta_file_name = NULL, *data_file_name = NULL, *doc = NULL;
+  uint32_t i, max_count = 0;
+
+  if (q != NULL && file_name != NULL) {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(sigmf_source_t));
+    meta_file_name = sigmf_file_name(file_name, ".sigmf-meta");
+    data_file_name = sigmf_file_name(file_name, ".sigmf-data");
+    if (!meta_file_name || !data_file_name) {
+      perror("malloc");
+      goto clean;
+    }
+    doc = read_file(meta_file_name);
+    if (!doc) {
+      goto clean;
+    }
+    if (parse_meta(q, doc)) {
+      goto clean;
+    }
+    if (q->nof_annotations == 0) {
+      fprintf(stderr, "SigMF: %s has no subframe annotations\n", meta_file_name);
+      goto clean;
+    }
+    if (filesource_mmap_init(&q->fsrc, data_file_name, q->meta.type)) {
+      goto clean;
+    }
+    for (i = 0; i < q->nof_annotations; i++) {
+      if (q->annotations[i].sample_count > max_count) {
+        max_count = q->annotations[i].sample_count;
+      }
+    }
+    q->buffer = vec_malloc(sizeof(cf_t) * max_count);
+    if (!q->buffer) {
+      perror("malloc");
+      goto clean;
+    }
+    q->buffer_len = max_count;
+    if (cfo_init(&q->cfocorr, q->annotations[0].sample_count)) {
+      fprintf(stderr, "Error initiating CFO\n");
+      goto clean;
+    }
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (meta_file_name) {
+    free(meta_file_name);
+  }
+  if (data_file_name) {
+    free(data_file_name);
+  }
+  if (doc) {
+    free(doc);
+  }
+  if (ret == LIBLTE_ERROR) {
+    sigmf_source_free(q);
+  }
+  return ret;
+}
+
+void sigmf_source_free(sigmf_source_t *q) {
+  if (q->fsrc.map) {
+    filesource_mmap_free(&q->fsrc);
+  }
+  if (q->cfocorr.cur_cexp) {
+    cfo_free(&q->cfocorr);
+  }
+  if (q->annotations) {
+    free(q->annotations);
+  }
+  if (q->buffer) {
+    free(q->buffer);
+  }
+  bzero(q, sizeof(sigmf_source_t));
+}
+
+uint32_t sigmf_source_nof_sf(sigmf_source_t *q) {
+  return q->nof_annotations;
+}
+
+/* Sets the next subframe to deliver, as an index of the annotations */
+int sigmf_source_seek(sigmf_source_t *q, uint32_t sf) {
+  if (q == NULL || sf > q->nof_annotations) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  q->next = sf;
+  return LIBLTE_SUCCESS;
+}
+
+/* Seeks to the first subframe sf_idx of frame sfn. Returns LIBLTE_ERROR if
+ * the recording does not have it.
+ */
+int sigmf_source_seek_sfn(sigmf_source_t *q, uint32_t sfn, uint32_t sf_idx) {
+  uint32_t i;
+
+  if (q == NULL || sf_idx >= NSUBFRAMES_X_FRAME) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  for (i = 0; i < q->nof_annotations; i++) {
+    if (q->annotations[i].sfn == (int) sfn && q->annotations[i].sf_idx == sf_idx) {
+      q->next = i;
+      return LIBLTE_SUCCESS;
+    }
+  }
+  return LIBLTE_ERROR;
+}
+
+/** Points samples to the next aligned subframe and annotation to its
+ * annotation. The CFO that ue_sync corrected when it was recorded is
+ * corrected again, so the samples are the ones that the receiver decoded.
+ * The samples are valid until the next call. Returns 1 if a subframe was
+ * read, 0 at the end of the recording.
+ */
+int sigmf_source_get_sf(sigmf_source_t *q, cf_t **samples, sigmf_annotation_t **annotation) {
+  sigmf_annotation_t *a;
+  cf_t *s;
+  int n;
+
+  if (q == NULL || samples == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (q->next >= q->nof_annotations) {
+    return 0;
+  }
+  a = &q->annotations[q->next];
+  if (filesource_mmap_seek(&q->fsrc, a->sample_start)) {
+    return 0;
+  }
+  n = filesource_mmap_get(&q->fsrc, &s, a->sample_count);
+  if (n < 0) {
+    return LIBLTE_ERROR;
+  }
+  if (n < a->sample_count) {
+    /* the data file is shorter than the metadata, e.g. recording interrupted */
+    return 0;
+  }
+  if (a->cfo != 0) {
+    if (a->sample_count != q->cfocorr.nsamples) {
+      if (cfo_realloc(&q->cfocorr, a->sample_count)) {
+        return LIBLTE_ERROR;
+      }
+    }
+    /* the CFO is in Hz, ue_sync corrects it normalized by the FFT size */
+    cfo_correct(&q->cfocorr, s, q->buffer, -a->cfo / 15000 / (a->sample_count / 15));
+    s = q->buffer;
+  }
+  *samples = s;
+  if (annotation) {
+    *annotation = a;
+  }
+  q->next++;
+  return 1;
+}
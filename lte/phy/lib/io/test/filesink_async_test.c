@@ -0,0 +1,212 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Writes nof_samples complex float samples, each one holding its index, in
+ * chunks of random length with filesink_async_write() and checks the file:
+ * the samples must be in order and the missing ones must be the ones counted
+ * as dropped. If the pool is at least as large as the data no sample can be
+ * dropped. Reports the mean and maximum time of filesink_async_write().
+ */
+
+char *output_file_name = "filesink_async_test.bin";
+uint32_t nof_samples = 2000000;
+uint32_t buffer_size = FILESINK_ASYNC_BUFFER_SIZE;
+uint32_t nof_buffers = FILESINK_ASYNC_NOF_BUFFERS;
+uint32_t max_chunk = 4000;
+bool direct = false;
+uint32_t seed = 0;
+
+void usage(char *prog) {
+  printf("Usage: %s [nbkcdso]\n", prog);
+  printf("\t-n nof_samples [Default %d]\n", nof_samples);
+  printf("\t-b buffer size in bytes [Default %d]\n", buffer_size);
+  printf("\t-k nof_buffers [Default %d]\n", nof_buffers);
+  printf("\t-c maximum samples per write [Default %d]\n", max_chunk);
+  printf("\t-d open the file with O_DIRECT [Default no]\n");
+  printf("\t-s seed [Default 0=time]\n");
+  printf("\t-o file name [Default %s]\n", output_file_name);
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "nbkcdso")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_samples = atoi(argv[optind]);
+      break;
+    case 'b':
+      buffer_size = atoi(argv[optind]);
+      break;
+    case 'k':
+      nof_buffers = atoi(argv[optind]);
+      break;
+    case 'c':
+      max_chunk = atoi(argv[optind]);
+      break;
+    case 'd':
+      direct = true;
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (max_chunk < 1) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+/* Checks that the file has the samples not dropped, in order */
+int check_file(uint64_t nof_dropped) {
+  FILE *f;
+  uint64_t idx, expected = 0, missing = 0, nof_read = 0;
+  int ret = -1;
+
+  f = fopen(output_file_name, "r");
+  if (!f) {
+    perror(output_file_name);
+    return -1;
+  }
+  while (fread(&idx, sizeof(uint64_t), 1, f) == 1) {
+    if (idx < expected || idx >= nof_samples) {
+      fprintf(stderr, "Sample %lu of the file is %lu, expected at least %lu\n",
+              nof_read, idx, expected);
+      goto clean;
+    }
+    missing += idx - expected;
+    expected = idx + 1;
+    nof_read++;
+  }
+  missing += nof_samples - expected;
+  if (missing != nof_dropped || nof_read != nof_samples - nof_dropped) {
+    fprintf(stderr, "The file has %lu samples and %lu are missing, but %lu were dropped\n",
+            nof_read, missing, nof_dropped);
+    goto clean;
+  }
+  ret = 0;
+clean:
+  fclose(f);
+  return ret;
+}
+
+int main(int argc, char **argv) {
+  filesink_async_t fsink;
+  uint64_t *samples;
+  uint64_t nof_dropped, pool_size;
+  uint32_t i, n, overflows, max_pending;
+  struct timeval t[3];
+  double t_us, t_total = 0, t_max = 0;
+  uint32_t nof_writes = 0;
+  int ret = -1;
+
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+
+  samples = malloc(sizeof(uint64_t) * nof_samples);
+  if (!samples) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (i = 0; i < nof_samples; i++) {
+    samples[i] = i;
+  }
+
+  if (filesink_async_init(&fsink, output_file_name, COMPLEX_FLOAT_BIN, buffer_size,
+                          nof_buffers, direct)) {
+    fprintf(stderr, "Error initiating async file sink\n");
+    exit(-1);
+  }
+  pool_size = (uint64_t) fsink.buffer_size * fsink.nof_buffers;
+  printf("Writing %d samples in a pool of %d buffers of %d bytes%s\n", nof_samples,
+         fsink.nof_buffers, fsink.buffer_size, fsink.direct ? " with O_DIRECT" : "");
+
+  for (i = 0; i < nof_samples; i += n) {
+    n = 1 + rand() % max_chunk;
+    if (n > nof_samples - i) {
+      n = nof_samples - i;
+    }
+    gettimeofday(&t[1], NULL);
+    if (filesink_async_write(&fsink, &samples[i], n) < 0) {
+      fprintf(stderr, "Error writing samples\n");
+      goto quit;
+    }
+    gettimeofday(&t[2], NULL);
+    get_time_interval(t);
+    t_us = (double) t[0].tv_sec * 1e6 + t[0].tv_usec;
+    t_total += t_us;
+    if (t_us > t_max) {
+      t_max = t_us;
+    }
+    nof_writes++;
+  }
+  nof_dropped = filesink_async_nof_dropped(&fsink);
+  overflows = filesink_async_nof_overflows(&fsink);
+  max_pending = filesink_async_max_pending(&fsink);
+  filesink_async_free(&fsink);
+
+  printf("%d writes, mean %.2f us, max %.0f us. Up to %d buffers pending, "
+         "dropped %lu samples in %d overflows\n", nof_writes, t_total / nof_writes, t_max,
+         max_pending, nof_dropped, overflows);
+
+  if (nof_dropped > 0 && pool_size >= (uint64_t) nof_samples * sizeof(uint64_t)) {
+    fprintf(stderr, "Samples dropped with a pool larger than the data\n");
+    goto quit;
+  }
+  if (check_file(nof_dropped)) {
+    goto quit;
+  }
+  ret = 0;
+quit:
+  free(samples);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
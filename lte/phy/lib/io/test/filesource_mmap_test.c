@@ -0,0 +1,229 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <complex.h>
+
+#include "liblte/phy/phy.h"
+
+/* Writes a capture of random samples, complex float or complex int16, and
+ * checks the samples returned by filesource_mmap_get() and
+ * filesource_mmap_read() when reading it sequentially subframe by subframe,
+ * past the end of the file and after seeking to random subframes. Complex
+ * float samples must be returned in place.
+ */
+
+char *output_file_name = "filesource_mmap_test.bin";
+uint32_t nof_prb = 6;
+uint32_t nof_subframes = 100;
+uint32_t nof_seeks = 50;
+bool is_short = false;
+
+void usage(char *prog) {
+  printf("Usage: %s [pnkso]\n", prog);
+  printf("\t-p nof_prb [Default %d]\n", nof_prb);
+  printf("\t-n nof_subframes in the file [Default %d]\n", nof_subframes);
+  printf("\t-k nof_seeks [Default %d]\n", nof_seeks);
+  printf("\t-s complex int16 samples [Default complex float]\n");
+  printf("\t-o file name [Default %s]\n", output_file_name);
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "pnkso")) != -1) {
+    switch (opt) {
+    case 'p':
+      nof_prb = atoi(argv[optind]);
+      break;
+    case 'n':
+      nof_subframes = atoi(argv[optind]);
+      break;
+    case 'k':
+      nof_seeks = atoi(argv[optind]);
+      break;
+    case 's':
+      is_short = true;
+      break;
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (lte_symbol_sz(nof_prb) < 0 || nof_subframes < 1) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+/* Writes nof_samples random samples and stores their value as complex float in ref */
+int write_capture(cf_t *ref, uint32_t nof_samples) {
+  FILE *f;
+  int16_t s[2];
+  uint32_t i;
+
+  f = fopen(output_file_name, "w");
+  if (!f) {
+    perror(output_file_name);
+    return -1;
+  }
+  for (i = 0; i < nof_samples; i++) {
+    if (is_short) {
+      s[0] = (int16_t) (rand() % 65536 - 32768);
+      s[1] = (int16_t) (rand() % 65536 - 32768);
+      ref[i] = (float) s[0] / INT16_MAX + _Complex_I * (float) s[1] / INT16_MAX;
+      fwrite(s, sizeof(int16_t), 2, f);
+    } else {
+      ref[i] = (float) rand() / RAND_MAX - 0.5 + _Complex_I * ((float) rand() / RAND_MAX - 0.5);
+      fwrite(&ref[i], sizeof(cf_t), 1, f);
+    }
+  }
+  fclose(f);
+  return 0;
+}
+
+/* Converted int16 samples may differ from ref in the last bit */
+bool equal(cf_t *samples, cf_t *ref, uint32_t n) {
+  uint32_t i;
+  if (!is_short) {
+    return !memcmp(samples, ref, sizeof(cf_t) * n);
+  }
+  for (i = 0; i < n; i++) {
+    if (cabsf(samples[i] - ref[i]) > 1e-6) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int check(filesource_mmap_t *q, cf_t *samples, cf_t *ref, uint32_t n, uint64_t pos) {
+  if (!is_short && samples != &((cf_t*) q->map)[pos]) {
+    fprintf(stderr, "Sample %lu: complex float samples were copied\n", pos);
+    return -1;
+  }
+  if (!equal(samples, &ref[pos], n)) {
+    fprintf(stderr, "Sample %lu: %d samples differ\n", pos, n);
+    return -1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  filesource_mmap_t fsrc;
+  cf_t *ref, *buffer, *samples;
+  uint32_t sf_len, nof_samples, i, sf;
+  uint64_t pos;
+  struct timeval t[3];
+  int n, ret = -1;
+
+  parse_args(argc, argv);
+  srand(time(NULL));
+
+  sf_len = SF_LEN(lte_symbol_sz(nof_prb));
+  /* the last subframe is incomplete */
+  nof_samples = nof_subframes * sf_len + sf_len / 2;
+  ref = vec_malloc(sizeof(cf_t) * nof_samples);
+  buffer = vec_malloc(sizeof(cf_t) * sf_len);
+  if (!ref || !buffer) {
+    perror("malloc");
+    exit(-1);
+  }
+  if (write_capture(ref, nof_samples)) {
+    exit(-1);
+  }
+  if (filesource_mmap_init(&fsrc, output_file_name, is_short ? COMPLEX_SHORT_BIN : COMPLEX_FLOAT_BIN)) {
+    fprintf(stderr, "Error opening %s\n", output_file_name);
+    exit(-1);
+  }
+  if (filesource_mmap_nof_samples(&fsrc) != nof_samples) {
+    fprintf(stderr, "File has %lu samples, expected %d\n", filesource_mmap_nof_samples(&fsrc),
+            nof_samples);
+    goto quit;
+  }
+
+  /* sequential reading */
+  pos = 0;
+  gettimeofday(&t[1], NULL);
+  while ((n = filesource_mmap_get(&fsrc, &samples, sf_len)) > 0) {
+    if (check(&fsrc, samples, ref, n, pos)) {
+      goto quit;
+    }
+    pos += n;
+  }
+  gettimeofday(&t[2], NULL);
+  get_time_interval(t);
+  if (n < 0 || pos != nof_samples || filesource_mmap_tell(&fsrc) != nof_samples) {
+    fprintf(stderr, "Read %lu samples, expected %d\n", pos, nof_samples);
+    goto quit;
+  }
+  printf("Read %d samples, %.1f Msamples/s\n", nof_samples,
+         (float) nof_samples / (t[0].tv_sec * 1e6 + t[0].tv_usec));
+
+  /* random access */
+  for (i = 0; i < nof_seeks; i++) {
+    sf = rand() % nof_subframes;
+    if (filesource_mmap_seek_sf(&fsrc, sf, nof_prb)) {
+      fprintf(stderr, "Error seeking to subframe %d\n", sf);
+      goto quit;
+    }
+    pos = (uint64_t) sf * sf_len;
+    if (filesource_mmap_get(&fsrc, &samples, sf_len) != sf_len ||
+        check(&fsrc, samples, ref, sf_len, pos)) {
+      goto quit;
+    }
+    if (filesource_mmap_read(&fsrc, buffer, sf_len) != (sf == nof_subframes - 1 ? sf_len / 2 : sf_len) ||
+        !equal(buffer, &ref[pos + sf_len], sf == nof_subframes - 1 ? sf_len / 2 : sf_len)) {
+      fprintf(stderr, "Subframe %d: filesource_mmap_read() samples differ\n", sf + 1);
+      goto quit;
+    }
+  }
+  if (filesource_mmap_seek(&fsrc, nof_samples + 1) != LIBLTE_ERROR_INVALID_INPUTS) {
+    fprintf(stderr, "Seeking beyond the end of the file should fail\n");
+    goto quit;
+  }
+  ret = 0;
+quit:
+  filesource_mmap_free(&fsrc);
+  unlink(output_file_name);
+  free(ref);
+  free(buffer);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
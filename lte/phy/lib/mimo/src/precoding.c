@@ -185,6 +185,110 @@ int predecoding_diversity_zf(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
   }
 }
 
+/* MMSE detector. For a single stream, the bias-corrected MMSE estimate equals 
+ * the ZF one. The difference is that the post-detection SINR of each RE, 
+ * |h|^2/N0, is returned in sinr so that the soft demodulator can weight the 
+ * LLRs and faded RE do not produce overconfident bits. 
+ */
+int predecoding_single_mmse(cf_t *y, cf_t *ce, cf_t *x, float *sinr, 
+    int nof_symbols, float noise_estimate) {
+  int i;
+  float hh;
+  if (noise_estimate <= 0) {
+    fprintf(stderr, "Noise estimate must be positive for the MMSE detector\n");
+    return -1;
+  }
+  for (i = 0; i < nof_symbols; i++) {
+    hh = crealf(ce[i]) * crealf(ce[i]) + cimagf(ce[i]) * cimagf(ce[i]);
+    if (hh > 0) {
+      x[i] = conjf(ce[i]) * y[i] / hh;
+    } else {
+      x[i] = 0;
+    }
+    sinr[i] = hh / noise_estimate;
+  }
+  return nof_symbols;
+}
+
+/* MMSE detector for transmit diversity. The post-detection SINR is 
+ * written in sinr in the order of the layer-demapped symbols, that is, 
+ * aligned with the output of layerdemap_diversity(). 
+ */
+int predecoding_diversity_mmse(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
+    float *sinr, int nof_ports, int nof_symbols, float noise_estimate) {
+  int i;
+  cf_t h0, h1, h2, h3, r0, r1, r2, r3;
+  float hh, hh02, hh13;
+  if (noise_estimate <= 0) {
+    fprintf(stderr, "Noise estimate must be positive for the MMSE detector\n");
+    return -1;
+  }
+  if (nof_ports == 2) {
+    for (i = 0; i < nof_symbols / 2; i++) {
+      h0 = ce[0][2 * i];
+      h1 = ce[1][2 * i];
+      hh = crealf(h0) * crealf(h0) + cimagf(h0) * cimagf(h0)
+          + crealf(h1) * crealf(h1) + cimagf(h1) * cimagf(h1);
+      r0 = y[2 * i];
+      r1 = y[2 * i + 1];
+      if (hh > 0) {
+        x[0][i] = (conjf(h0) * r0 + h1 * conjf(r1)) / hh * sqrt(2);
+        x[1][i] = (-h1 * conjf(r0) + conjf(h0) * r1) / hh * sqrt(2);
+      } else {
+        x[0][i] = 0;
+        x[1][i] = 0;
+      }
+      /* each antenna transmits with half the power */
+      sinr[2 * i] = hh / (2 * noise_estimate);
+      sinr[2 * i + 1] = sinr[2 * i];
+    }
+    return i;
+  } else if (nof_ports == 4) {
+
+    int m_ap = (nof_symbols % 4) ? ((nof_symbols - 2) / 4) : nof_symbols / 4;
+    for (i = 0; i < m_ap; i++) {
+      h0 = ce[0][4 * i];
+      h1 = ce[1][4 * i + 2];
+      h2 = ce[2][4 * i];
+      h3 = ce[3][4 * i + 2];
+      hh02 = crealf(h0) * crealf(h0) + cimagf(h0) * cimagf(h0)
+          + crealf(h2) * crealf(h2) + cimagf(h2) * cimagf(h2);
+      hh13 = crealf(h1) * crealf(h1) + cimagf(h1) * cimagf(h1)
+          + crealf(h3) * crealf(h3) + cimagf(h3) * cimagf(h3);
+      r0 = y[4 * i];
+      r1 = y[4 * i + 1];
+      r2 = y[4 * i + 2];
+      r3 = y[4 * i + 3];
+
+      if (hh02 > 0) {
+        x[0][i] = (conjf(h0) * r0 + h2 * conjf(r1)) / hh02 * sqrt(2);
+        x[1][i] = (-h2 * conjf(r0) + conjf(h0) * r1) / hh02 * sqrt(2);
+      } else {
+        x[0][i] = 0;
+        x[1][i] = 0;
+      }
+      if (hh13 > 0) {
+        x[2][i] = (conjf(h1) * r2 + h3 * conjf(r3)) / hh13 * sqrt(2);
+        x[3][i] = (-h3 * conjf(r2) + conjf(h1) * r3) / hh13 * sqrt(2);
+      } else {
+        x[2][i] = 0;
+        x[3][i] = 0;
+      }
+      sinr[4 * i] = hh02 / (2 * noise_estimate);
+      sinr[4 * i + 1] = sinr[4 * i];
+      sinr[4 * i + 2] = hh13 / (2 * noise_estimate);
+      sinr[4 * i + 3] = sinr[4 * i + 2];
+    }
+    for (i = 4 * m_ap; i < nof_symbols; i++) {
+      sinr[i] = 0;
+    }
+    return m_ap;
+  } else {
+    fprintf(stderr, "Number of ports must be 2 or 4 for transmit diversity\n");
+    return -1;
+  }
+}
+
 /* 36.211 v10.3.0 Section 6.3.4 */
 int predecoding_type(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
     int nof_ports, int nof_layers, int nof_symbols, lte_mimo_type_t type) {
@@ -67,6 +67,21 @@ int demod_soft_demodulate(demod_soft_t *q, const cf_t* symbols, float* llr, int
   return nsymbols*q->table->nbits_x_symbol;
 }
 
+/* Same as demod_soft_demodulate() but the LLRs of the i-th symbol are multiplied by weights[i]. 
+ * Used with the per-RE SINR given by the MMSE detector, so that each LLR is scaled by the 
+ * reliability of the RE it was received in. 
+ */
+int demod_soft_demodulate_weighted(demod_soft_t *q, const cf_t* symbols, const float *weights, 
+                                   float* llr, int nsymbols) {
+  int i, b, nbits;
+  nbits = demod_soft_demodulate(q, symbols, llr, nsymbols);
+  for (i=0;i<nsymbols;i++) {
+    for (b=0;b<q->table->nbits_x_symbol;b++) {
+      llr[i*q->table->nbits_x_symbol+b] *= weights[i];
+    }
+  }
+  return nbits;
+}
 
 
 /* High-Level API */
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <strings.h>
 #include <assert.h>
+#include <string.h>
 
 #include "liblte/phy/utils/bit.h"
 #include "liblte/phy/modem/mod.h"
@@ -51,6 +52,69 @@ int mod_modulate(modem_table_t* q, const char *bits, cf_t* symbols, uint32_t nbi
   return j;
 }
 
+void mod_stream_init(mod_stream_t *s, modem_table_t *table, char *c, cf_t *symbols) {
+  s->table = table;
+  s->c = c;
+  s->symbols = symbols;
+  s->nof_symbols = 0;
+  s->acc = 0;
+  s->nof_acc = 0;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/* Packs 8 chars holding one bit each into a byte, first bit in the MSB */
+static inline uint32_t pack_byte(const char *bits, const char *c) {
+  uint64_t b, s; 
+  memcpy(&b, bits, 8);
+  memcpy(&s, c, 8);
+  return (uint32_t) ((((b ^ s) & 0x0101010101010101ULL) * 0x8040201008040201ULL) >> 56);
+}
+#else
+static inline uint32_t pack_byte(const char *bits, const char *c) {
+  uint32_t i, byte = 0; 
+  for (i = 0; i < 8; i++) {
+    byte = (byte << 1) | ((bits[i] ^ c[i]) & 1);
+  }
+  return byte;
+}
+#endif
+
+/** Modulates nbits bits XORed with the scrambling sequence. Bits are taken
+ * 8 at a time and symbols are read from the modem table as soon as enough bits 
+ * have been accumulated. The result is the same as scrambling_b_offset() 
+ * followed by mod_modulate() on the whole sequence.
+ */
+void mod_stream_bits(mod_stream_t *s, const char *bits, uint32_t nbits) {
+  uint32_t i;
+  uint32_t q_m = s->table->nbits_x_symbol;
+  uint32_t mask = (1 << q_m) - 1;
+  uint32_t acc = s->acc;
+  uint32_t nof_acc = s->nof_acc;
+  cf_t *table = s->table->symbol_table;
+  cf_t *symbols = &s->symbols[s->nof_symbols];
+  const char *c = s->c;
+
+  for (i = 0; i + 8 <= nbits; i += 8) {
+    acc = (acc << 8) | pack_byte(&bits[i], &c[i]);
+    nof_acc += 8;
+    while (nof_acc >= q_m) {
+      nof_acc -= q_m;
+      *symbols++ = table[(acc >> nof_acc) & mask];
+    }
+  }
+  for (; i < nbits; i++) {
+    acc = (acc << 1) | ((bits[i] ^ c[i]) & 1);
+    nof_acc++;
+    if (nof_acc == q_m) {
+      nof_acc = 0;
+      *symbols++ = table[acc & mask];
+    }
+  }
+  s->acc = acc & mask;
+  s->nof_acc = nof_acc;
+  s->c += nbits;
+  s->nof_symbols = symbols - s->symbols;
+}
 
 /* High-Level API */
 int mod_initialize(mod_hl* hl) {
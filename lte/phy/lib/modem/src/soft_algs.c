@@ -49,8 +49,10 @@ typedef _Complex float cf_t;
 
 #if LLR_APPROX_IMPLEMENTATION == 1
 
-float dd[10000][7];             // 7 distances that are needed to compute LLR approx for 64QAM 
-uint32_t zone[10000];           // Zone of received symbol with respect to grid of QAM constellation diagram
+/* Symbols are processed in blocks of this size so that the distances and
+ * zones live on the stack of the caller, which makes llr_approx() reentrant
+ */
+#define LLR_APPROX_BLOCK        256
 
 
 /**
@@ -447,7 +449,7 @@ static void compute_zone(const cf_t * in, uint32_t * z, int N, int B)
 {
   switch (B) {
     case 1:{
-        memset(zone, 0, N * sizeof(int));
+        memset(z, 0, N * sizeof(uint32_t));
         break;
       }                         /* BPSK */
     case 2:{
@@ -466,7 +468,8 @@ static void compute_zone(const cf_t * in, uint32_t * z, int N, int B)
 }
 
 static void compute_square_dist(const cf_t * in, cf_t * symbols,
-                                uint32_t(*idx)[7], int N, int B)
+                                uint32_t(*idx)[7], uint32_t * zone,
+                                float (*dd)[7], int N, int B)
 {
   int s, b;
   float *d_ptr;
@@ -485,8 +488,8 @@ static void compute_square_dist(const cf_t * in, cf_t * symbols,
   }
 }
 
-static void compute_llr(int N, int B, uint32_t(*min)[64][6], float sigma2,
-                        float *out)
+static void compute_llr(int N, int B, uint32_t(*min)[64][6], uint32_t * zone,
+                        float (*dd)[7], float sigma2, float *out)
 {
   int s, b;
   for (s = 0; s < N; s++) {
@@ -501,10 +504,17 @@ void llr_approx(const _Complex float *in, float *out, int N, int M, int B,
                 _Complex float *symbols, uint32_t(*S)[6][32], uint32_t(*idx)[7],
                 uint32_t(*min)[64][6], float sigma2)
 {
+  float dd[LLR_APPROX_BLOCK][7];  // 7 distances that are needed to compute LLR approx for 64QAM
+  uint32_t zone[LLR_APPROX_BLOCK]; // Zone of received symbol with respect to grid of QAM constellation diagram
+  int s, n;
+
   if ((M == 2) || (M == 4) || (M == 16) || (M == 64)) {
-    compute_zone(in, zone, N, B);
-    compute_square_dist(in, symbols, idx, N, B);
-    compute_llr(N, B, min, sigma2, out);
+    for (s = 0; s < N; s += n) {
+      n = N - s < LLR_APPROX_BLOCK ? N - s : LLR_APPROX_BLOCK;
+      compute_zone(&in[s], zone, n, B);
+      compute_square_dist(&in[s], symbols, idx, zone, dd, n, B);
+      compute_llr(n, B, min, zone, dd, sigma2, &out[s * B]);
+    }
   }
 }
 
@@ -40,6 +40,7 @@
 #include "liblte/phy/utils/bit.h"
 #include "liblte/phy/utils/vector.h"
 #include "liblte/phy/utils/debug.h"
+#include "liblte/phy/utils/trace.h"
 
 const char crc_mask[4][16] = {
     { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, { 1, 1, 1, 1, 1, 1, 1,
@@ -119,6 +120,10 @@ int pbch_get(cf_t *slot1_data, cf_t *pbch, lte_cell_t cell) {
   return pbch_cp(slot1_data, pbch, cell, false);
 }
 
+static int pbch_cp_trace(void *arg, cf_t *grid, cf_t *symbols) {
+  return pbch_get(grid, symbols, *((lte_cell_t*) arg));
+}
+
 /** Initializes the PBCH transmitter and receiver. 
  * At the receiver, the field nof_ports in the cell structure indicates the 
  * maximum number of BS transmitter ports to look for.  
@@ -148,6 +153,9 @@ int pbch_init(pbch_t *q, lte_cell_t cell) {
     if (viterbi_init(&q->decoder, viterbi_37, poly, 40, true)) {
       goto clean;
     }
+    if (rm_conv_init(&q->rm_conv)) {
+      goto clean;
+    }
     if (crc_init(&q->crc, LTE_CRC16, 16)) {
       goto clean;
     }
@@ -189,10 +197,6 @@ int pbch_init(pbch_t *q, lte_cell_t cell) {
     if (!q->pbch_rm_f) {
       goto clean;
     }
-    q->pbch_rm_b = malloc(sizeof(float) * q->nof_symbols * 4 * 2);
-    if (!q->pbch_rm_b) {
-      goto clean;
-    }
     q->data = malloc(sizeof(char) * 40);
     if (!q->data) {
       goto clean;
@@ -201,6 +205,13 @@ int pbch_init(pbch_t *q, lte_cell_t cell) {
     if (!q->data_enc) {
       goto clean;
     }
+    if (re_map_init(&q->re_map, q->nof_symbols)) {
+      goto clean;
+    }
+    if (re_map_trace(&q->re_map, pbch_cp_trace, &q->cell, 
+        SLOT_LEN_RE(q->cell.nof_prb, q->cell.cp)) != q->nof_symbols) {
+      goto clean;
+    }
     ret = LIBLTE_SUCCESS;
   }
 clean: 
@@ -235,9 +246,7 @@ void pbch_free(pbch_t *q) {
   if (q->pbch_rm_f) {
     free(q->pbch_rm_f);
   }
-  if (q->pbch_rm_b) {
-    free(q->pbch_rm_b);
-  }
+  re_map_free(&q->re_map);
   if (q->data_enc) {
     free(q->data_enc);
   }
@@ -247,6 +256,7 @@ void pbch_free(pbch_t *q) {
   sequence_free(&q->seq_pbch);
   modem_table_free(&q->mod);
   viterbi_free(&q->decoder);
+  rm_conv_free(&q->rm_conv);
 }
 
 /** Unpacks MIB from PBCH message.
@@ -412,7 +422,7 @@ int pbch_decode_frame(pbch_t *q, pbch_mib_t *mib, uint32_t src, uint32_t dst, ui
   }
 
   /* unrate matching */
-  rm_conv_rx(q->temp, 4 * nof_bits, q->pbch_rm_f, 120);
+  rm_conv_rx_cached(&q->rm_conv, q->temp, 4 * nof_bits, q->pbch_rm_f, 120);
 
   /* FIXME: If channel estimates are zero, received LLR are NaN. Check and return error */
   for (j = 0; j < 120; j++) {
@@ -453,13 +463,14 @@ int pbch_decode_frame(pbch_t *q, pbch_mib_t *mib, uint32_t src, uint32_t dst, ui
  *
  * Returns 1 if successfully decoded MIB, 0 if not and -1 on error
  */
-int pbch_decode(pbch_t *q, cf_t *slot1_symbols, cf_t *ce_slot1[MAX_PORTS], pbch_mib_t *mib) {
+static int do_pbch_decode(pbch_t *q, cf_t *slot1_symbols, cf_t *ce_slot1[MAX_PORTS], pbch_mib_t *mib) {
   uint32_t src, dst, nb;
   uint32_t nant_[3] = { 1, 2, 4 };
   uint32_t na, nant;
   int i;
   int nof_bits;
   cf_t *x[MAX_LAYERS];
+  cf_t *grid[MAX_PORTS + 1], *symbols[MAX_PORTS + 1];
   
   int ret = LIBLTE_ERROR_INVALID_INPUTS;
   
@@ -482,20 +493,18 @@ int pbch_decode(pbch_t *q, cf_t *slot1_symbols, cf_t *ce_slot1[MAX_PORTS], pbch_
     }
     memset(&x[MAX_PORTS], 0, sizeof(cf_t*) * (MAX_LAYERS - MAX_PORTS));
     
-    /* extract symbols */
-    if (q->nof_symbols != pbch_get(slot1_symbols, q->pbch_symbols[0], q->cell)) {
+    /* extract symbols and channel estimates */
+    grid[0] = slot1_symbols;
+    symbols[0] = q->pbch_symbols[0];
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      grid[i + 1] = ce_slot1[i];
+      symbols[i + 1] = q->ce[i];
+    }
+    if (q->nof_symbols != re_map_get_multi(&q->re_map, grid, symbols, q->cell.nof_ports + 1)) {
       fprintf(stderr, "There was an error getting the PBCH symbols\n");
       return LIBLTE_ERROR;
     }
 
-    /* extract channel estimates */
-    for (i = 0; i < q->cell.nof_ports; i++) {
-      if (q->nof_symbols != pbch_get(ce_slot1[i], q->ce[i], q->cell)) {
-        fprintf(stderr, "There was an error getting the PBCH symbols\n");
-        return LIBLTE_ERROR;
-      }
-    }
-
     q->frame_idx++;
     ret = 0;
 
@@ -547,12 +556,22 @@ int pbch_decode(pbch_t *q, cf_t *slot1_symbols, cf_t *ce_slot1[MAX_PORTS], pbch_
   return ret;
 }
 
+int pbch_decode(pbch_t *q, cf_t *slot1_symbols, cf_t *ce_slot1[MAX_PORTS], pbch_mib_t *mib)
+{
+  int ret;
+  TRACE_BEGIN(TRACE_PBCH);
+  ret = do_pbch_decode(q, slot1_symbols, ce_slot1, mib);
+  TRACE_END(TRACE_PBCH);
+  return ret;
+}
+
 /** Converts the MIB message to symbols mapped to SLOT #1 ready for transmission
  */
 int pbch_encode(pbch_t *q, pbch_mib_t *mib, cf_t *slot1_symbols[MAX_PORTS]) {
   int i;
   int nof_bits;
   cf_t *x[MAX_LAYERS];
+  mod_stream_t mod_stream;
   
   if (q                 != NULL &&
       mib               != NULL)
@@ -580,15 +599,14 @@ int pbch_encode(pbch_t *q, pbch_mib_t *mib, cf_t *slot1_symbols[MAX_PORTS]) {
       crc_set_mask(q->data, q->cell.nof_ports);
 
       convcoder_encode(&q->encoder, q->data, q->data_enc, 40);
-
-      rm_conv_tx(q->data_enc, 120, q->pbch_rm_b, 4 * nof_bits);
-
     }
 
-    scrambling_b_offset(&q->seq_pbch, &q->pbch_rm_b[q->frame_idx * nof_bits],
-        q->frame_idx * nof_bits, nof_bits);
-    mod_modulate(&q->mod, &q->pbch_rm_b[q->frame_idx * nof_bits], q->pbch_d,
-        nof_bits);
+    /* rate matching, scrambling and modulation of this frame's part of the 
+     * 4 frame sequence */
+    mod_stream_init(&mod_stream, &q->mod, &q->seq_pbch.c[q->frame_idx * nof_bits], q->pbch_d);
+    if (rm_conv_tx_mod(q->data_enc, 120, &mod_stream, q->frame_idx * nof_bits, nof_bits)) {
+      return LIBLTE_ERROR;
+    }
 
     /* layer mapping & precoding */
     if (q->cell.nof_ports > 1) {
@@ -601,7 +619,7 @@ int pbch_encode(pbch_t *q, pbch_mib_t *mib, cf_t *slot1_symbols[MAX_PORTS]) {
 
     /* mapping to resource elements */
     for (i = 0; i < q->cell.nof_ports; i++) {
-      pbch_put(q->pbch_symbols[i], slot1_symbols[i], q->cell);
+      re_map_put(&q->re_map, q->pbch_symbols[i], slot1_symbols[i]);
     }
     q->frame_idx++;
     if (q->frame_idx == 4) {
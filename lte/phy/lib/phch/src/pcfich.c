@@ -40,6 +40,7 @@
 #include "liblte/phy/utils/bit.h"
 #include "liblte/phy/utils/vector.h"
 #include "liblte/phy/utils/debug.h"
+#include "liblte/phy/utils/trace.h"
 
 // Table 5.3.4-1
 static char cfi_table[4][PCFICH_CFI_LEN] = { { 0, 1, 1, 0, 1, 1, 0, 1, 1, 0, 1,
@@ -143,7 +144,7 @@ int pcfich_cfi_encode(int cfi, char bits[PCFICH_CFI_LEN]) {
  *
  * Returns 1 if successfully decoded the CFI, 0 if not and -1 on error
  */
-int pcfich_decode(pcfich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
+static int do_pcfich_decode(pcfich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
     uint32_t nsubframe, uint32_t *cfi, uint32_t *distance) {
   int dist;
 
@@ -151,6 +152,7 @@ int pcfich_decode(pcfich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
   int i;
   cf_t *x[MAX_LAYERS];
   cf_t *ce_precoding[MAX_PORTS];
+  cf_t *grid[MAX_PORTS + 1], *symbols[MAX_PORTS + 1];
 
   if (q                 != NULL                 && 
       slot_symbols      != NULL                 && 
@@ -165,21 +167,19 @@ int pcfich_decode(pcfich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
       ce_precoding[i] = q->ce[i];
     }
 
-    /* extract symbols */
+    /* extract symbols and channel estimates */
+    grid[0] = slot_symbols;
+    symbols[0] = q->pcfich_symbols[0];
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      grid[i + 1] = ce[i];
+      symbols[i + 1] = q->ce[i];
+    }
     if (q->nof_symbols
-        != regs_pcfich_get(q->regs, slot_symbols, q->pcfich_symbols[0])) {
+        != regs_pcfich_get_multi(q->regs, grid, symbols, q->cell.nof_ports + 1)) {
       fprintf(stderr, "There was an error getting the PCFICH symbols\n");
       return LIBLTE_ERROR;
     }
 
-    /* extract channel estimates */
-    for (i = 0; i < q->cell.nof_ports; i++) {
-      if (q->nof_symbols != regs_pcfich_get(q->regs, ce[i], q->ce[i])) {
-        fprintf(stderr, "There was an error getting the PCFICH symbols\n");
-        return LIBLTE_ERROR;
-      }
-    }
-
     /* in control channels, only diversity is supported */
     if (q->cell.nof_ports == 1) {
       /* no need for layer demapping */
@@ -214,6 +214,16 @@ int pcfich_decode(pcfich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
   
 }
 
+int pcfich_decode(pcfich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
+    uint32_t nsubframe, uint32_t *cfi, uint32_t *distance)
+{
+  int ret;
+  TRACE_BEGIN(TRACE_PCFICH);
+  ret = do_pcfich_decode(q, slot_symbols, ce, nsubframe, cfi, distance);
+  TRACE_END(TRACE_PCFICH);
+  return ret;
+}
+
 /** Encodes CFI and maps symbols to the slot
  */
 int pcfich_encode(pcfich_t *q, uint32_t cfi, cf_t *slot_symbols[MAX_PORTS],
@@ -40,6 +40,7 @@
 #include "liblte/phy/utils/bit.h"
 #include "liblte/phy/utils/vector.h"
 #include "liblte/phy/utils/debug.h"
+#include "liblte/phy/utils/trace.h"
 
 #define PDCCH_NOF_FORMATS               4
 #define PDCCH_FORMAT_NOF_CCE(i)         (1<<i)
@@ -104,7 +105,14 @@ int pdcch_init(pdcch_t *q, regs_t *regs, lte_cell_t cell) {
     }
 
     uint32_t poly[3] = { 0x6D, 0x4F, 0x57 };
-    if (viterbi_init(&q->decoder, viterbi_37, poly, DCI_MAX_BITS + 16, true)) {
+    if (viterbi_gen_init(&q->decoder, 7, 3, poly, DCI_MAX_BITS + 16, true)) {
+      goto clean;
+    }
+    /* the reliability of every candidate is computed */
+    if (viterbi_gen_set_soft_output(&q->decoder, true)) {
+      goto clean;
+    }
+    if (rm_conv_init(&q->rm_conv)) {
       goto clean;
     }
 
@@ -176,7 +184,28 @@ void pdcch_free(pdcch_t *q) {
   }
 
   modem_table_free(&q->mod);
-  viterbi_free(&q->decoder);
+  viterbi_gen_free(&q->decoder);
+  rm_conv_free(&q->rm_conv);
+}
+
+/** Candidates decoded with a reliability below threshold are rejected: 
+ * pdcch_decode_msg() sets their CRC remainder to 0, which is not a valid RNTI, 
+ * so that no PDSCH decoding is attempted for them. With threshold 0 (default) 
+ * all candidates are accepted. 
+ */
+int pdcch_set_reliability_threshold(pdcch_t *q, float threshold) {
+  if (q != NULL && threshold >= 0) {
+    q->reliability_threshold = threshold;
+    q->nof_rejected = 0;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/** Reliability of the last decoded candidate */
+float pdcch_get_reliability(pdcch_t *q) {
+  return q->last_reliability;
 }
 
 /** 36.213 v9.1.1 
@@ -284,7 +313,7 @@ static int dci_decode(pdcch_t *q, float *e, char *data, uint32_t E, uint32_t nof
   {
 
     /* unrate matching */
-    rm_conv_rx(e, E, tmp, 3 * (nof_bits + 16));
+    rm_conv_rx_cached(&q->rm_conv, e, E, tmp, 3 * (nof_bits + 16));
 
     DEBUG("Viterbi input: ", 0);
     if (VERBOSE_ISDEBUG()) {
@@ -292,12 +321,22 @@ static int dci_decode(pdcch_t *q, float *e, char *data, uint32_t E, uint32_t nof
     }
 
     /* viterbi decoder */
-    viterbi_decode_f(&q->decoder, tmp, data, nof_bits + 16);
+    viterbi_gen_decode(&q->decoder, tmp, data, nof_bits + 16);
 
     if (VERBOSE_ISDEBUG()) {
       bit_fprint(stdout, data, nof_bits + 16);
     }
 
+    q->last_reliability = viterbi_gen_reliability(&q->decoder);
+    if (q->reliability_threshold > 0 && q->last_reliability < q->reliability_threshold) {
+      DEBUG("Rejected candidate with reliability %.2f\n", q->last_reliability);
+      q->nof_rejected++;
+      if (crc) {
+        *crc = 0;
+      }
+      return LIBLTE_SUCCESS;
+    }
+
     x = &data[nof_bits];
     p_bits = (uint16_t) bit_unpack(&x, 16);
     crc_res = ((uint16_t) crc_checksum(&q->crc, data, nof_bits) & 0xffff);
@@ -328,7 +367,9 @@ int pdcch_decode_msg(pdcch_t *q, dci_msg_t *msg, dci_format_t format, uint16_t *
   {
     uint32_t nof_bits = dci_format_sizeof(format, q->cell.nof_prb);
     
+    TRACE_BEGIN(TRACE_PDCCH);
     ret = dci_decode(q, q->pdcch_llr, msg->data, q->e_bits, nof_bits, crc_rem);
+    TRACE_END(TRACE_PDCCH);
     if (ret == LIBLTE_SUCCESS) {
       msg->nof_bits = nof_bits;
     }
@@ -341,7 +382,7 @@ int pdcch_decode_msg(pdcch_t *q, dci_msg_t *msg, dci_format_t format, uint16_t *
  * Every time this function is called (with a different location), the last demodulated symbols are overwritten and
  * new messages from other locations can be decoded 
  */
-int pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], 
+static int do_pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], 
                       dci_location_t location, uint32_t nsubframe, uint32_t cfi) {
 
   int ret = LIBLTE_ERROR_INVALID_INPUTS;
@@ -349,6 +390,7 @@ int pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS],
   /* Set pointers for layermapping & precoding */
   uint32_t i, nof_symbols;
   cf_t *x[MAX_LAYERS];
+  cf_t *grid[MAX_PORTS + 1], *symbols[MAX_PORTS + 1];
 
   if (q                 != NULL && 
       nsubframe         <  10   &&
@@ -373,24 +415,20 @@ int pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS],
       }
       memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
 
-      /* extract symbols */
-      int n = regs_pdcch_get_offset(q->regs, sf_symbols, q->pdcch_symbols[0], 
-                                    location.ncce * 9, PDCCH_FORMAT_NOF_REGS(location.L));
+      /* extract symbols and channel estimates */
+      grid[0] = sf_symbols;
+      symbols[0] = q->pdcch_symbols[0];
+      for (i = 0; i < q->cell.nof_ports; i++) {
+        grid[i + 1] = ce[i];
+        symbols[i + 1] = q->ce[i];
+      }
+      int n = regs_pdcch_get_offset_multi(q->regs, grid, symbols, location.ncce * 9, 
+                                          PDCCH_FORMAT_NOF_REGS(location.L), q->cell.nof_ports + 1);
       if (nof_symbols != n) {
         fprintf(stderr, "Expected %d PDCCH symbols but got %d symbols\n", nof_symbols, n);
         return ret;
       }
 
-      /* extract channel estimates */
-      for (i = 0; i < q->cell.nof_ports; i++) {
-        n = regs_pdcch_get_offset(q->regs, ce[i], q->ce[i], 
-                                  location.ncce * 9, PDCCH_FORMAT_NOF_REGS(location.L));
-        if (nof_symbols != n) {
-          fprintf(stderr, "Expected %d PDCCH symbols but got %d symbols\n", nof_symbols, n);
-          return ret;
-        }
-      }
-
       /* in control channels, only diversity is supported */
       if (q->cell.nof_ports == 1) {
         /* no need for layer demapping */
@@ -425,6 +463,16 @@ int pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS],
   return ret;  
 }
 
+int pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], 
+                      dci_location_t location, uint32_t nsubframe, uint32_t cfi)
+{
+  int ret;
+  TRACE_BEGIN(TRACE_PDCCH);
+  ret = do_pdcch_extract_llr(q, sf_symbols, ce, location, nsubframe, cfi);
+  TRACE_END(TRACE_PDCCH);
+  return ret;
+}
+
 
 
 
@@ -442,18 +490,20 @@ static void crc_set_mask_rnti(char *crc, uint16_t rnti) {
 }
 
 /** 36.212 5.3.3.2 to 5.3.3.4
+ * The E rate matched bits are passed to the modulation stream s, which scrambles
+ * and modulates them.
  * TODO: UE transmit antenna selection CRC mask
  */
-static int dci_encode(pdcch_t *q, char *data, char *e, uint32_t nof_bits, uint32_t E,
+static int dci_encode(pdcch_t *q, char *data, mod_stream_t *s, uint32_t nof_bits, uint32_t E,
     uint16_t rnti) {
   convcoder_t encoder;
   char tmp[3 * (DCI_MAX_BITS + 16)];
   
   if (q                 != NULL        && 
       data              != NULL        && 
-      e                 != NULL        && 
+      s                 != NULL        && 
       nof_bits          < DCI_MAX_BITS &&
-      E                 < q->max_bits)
+      E                 <= q->max_bits)
   {
 
     int poly[3] = { 0x6D, 0x4F, 0x57 };
@@ -472,7 +522,9 @@ static int dci_encode(pdcch_t *q, char *data, char *e, uint32_t nof_bits, uint32
       vec_fprint_b(stdout, tmp, 3 * (nof_bits + 16));
     }
 
-    rm_conv_tx(tmp, 3 * (nof_bits + 16), e, E);
+    if (rm_conv_tx_mod(tmp, 3 * (nof_bits + 16), s, 0, E)) {
+      return LIBLTE_ERROR;
+    }
     
     return LIBLTE_SUCCESS;
   } else {
@@ -495,6 +547,7 @@ int pdcch_encode(pdcch_t *q, dci_msg_t *msg, dci_location_t location, uint16_t r
   uint32_t i;
   cf_t *x[MAX_LAYERS];
   uint32_t nof_symbols;
+  mod_stream_t mod_stream;
   
   if (q                 != NULL &&
       sf_symbols        != NULL && 
@@ -516,7 +569,16 @@ int pdcch_encode(pdcch_t *q, dci_msg_t *msg, dci_location_t location, uint16_t r
       INFO("Encoding DCI: Nbits: %d, E: %d, nCCE: %d, L: %d, RNTI: 0x%x\n",
           msg->nof_bits, q->e_bits, location.ncce, location.L, rnti);
 
-      dci_encode(q, msg->data, q->pdcch_e, msg->nof_bits, q->e_bits, rnti);
+      if (72 * location.ncce + q->e_bits > q->seq_pdcch[nsubframe].len) {
+        fprintf(stderr, "Scrambling sequence too short\n");
+        return ret;
+      }
+      mod_stream_init(&mod_stream, &q->mod, &q->seq_pdcch[nsubframe].c[72 * location.ncce], 
+                      q->pdcch_d);
+      if (dci_encode(q, msg->data, &mod_stream, msg->nof_bits, q->e_bits, rnti)) {
+        fprintf(stderr, "Error encoding DCI message\n");
+        return ret;
+      }
     
       /* number of layers equals number of ports */
       for (i = 0; i < q->cell.nof_ports; i++) {
@@ -524,15 +586,6 @@ int pdcch_encode(pdcch_t *q, dci_msg_t *msg, dci_location_t location, uint16_t r
       }
       memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
 
-      scrambling_b_offset(&q->seq_pdcch[nsubframe], q->pdcch_e, 72 * location.ncce, q->e_bits);
-      
-      DEBUG("Scrambling output: ", 0);
-      if (VERBOSE_ISDEBUG()) {        
-        vec_fprint_b(stdout, q->pdcch_e, q->e_bits);
-      }
-      
-      mod_modulate(&q->mod, q->pdcch_e, q->pdcch_d, q->e_bits);
-
       /* layer mapping & precoding */
       if (q->cell.nof_ports > 1) {
         layermap_diversity(q->pdcch_d, x, q->cell.nof_ports, nof_symbols);
@@ -40,6 +40,7 @@
 #include "liblte/phy/utils/bit.h"
 #include "liblte/phy/utils/debug.h"
 #include "liblte/phy/utils/vector.h"
+#include "liblte/phy/utils/trace.h"
 
 
 #define MAX_PDSCH_RE(cp) (2 * CP_NSYMB(cp) * 12)
@@ -48,6 +49,20 @@
 
 const lte_mod_t modulations[4] =
     { LTE_BPSK, LTE_QPSK, LTE_QAM16, LTE_QAM64 };
+
+/* Modem table of modulation mod. The tables follow the order of modulations[] */
+static modem_table_t* pdsch_mod(pdsch_t *q, lte_mod_t mod) {
+  switch(mod) {
+  case LTE_BPSK:
+    return &q->mod[0];
+  case LTE_QPSK:
+    return &q->mod[1];
+  case LTE_QAM16:
+    return &q->mod[2];
+  default:
+    return &q->mod[3];
+  }
+}
     
     
 
@@ -146,6 +161,95 @@ int pdsch_cp(pdsch_t *q, cf_t *input, cf_t *output, ra_prb_t *prb_alloc,
   }
 }
 
+struct pdsch_trace_arg {
+  pdsch_t *q;
+  ra_prb_t *prb_alloc;
+  uint32_t nsubframe;
+};
+
+static int pdsch_cp_trace(void *arg, cf_t *grid, cf_t *symbols) {
+  struct pdsch_trace_arg *a = (struct pdsch_trace_arg*) arg;
+  return pdsch_cp(a->q, grid, symbols, a->prb_alloc, a->nsubframe, false);
+}
+
+static uint32_t pdsch_re_map_hash(ra_prb_t *prb_alloc, uint32_t nsubframe) {
+  uint32_t h = 2166136261u; // FNV-1a
+  uint32_t s, n;
+
+  h = (h ^ nsubframe) * 16777619u;
+  h = (h ^ prb_alloc->lstart) * 16777619u;
+  for (s = 0; s < 2; s++) {
+    h = (h ^ prb_alloc->slot[s].nof_prb) * 16777619u;
+    for (n = 0; n < prb_alloc->slot[s].nof_prb; n++) {
+      h = (h ^ prb_alloc->slot[s].prb_idx[n]) * 16777619u;
+    }
+  }
+  return h;
+}
+
+static bool pdsch_re_map_match(pdsch_re_map_t *m, ra_prb_t *prb_alloc, 
+    uint32_t nsubframe, uint32_t hash) {
+  uint32_t s;
+  if (!m->valid || m->hash != hash || m->subframe != nsubframe ||
+      m->prb_alloc.lstart != prb_alloc->lstart) {
+    return false;
+  }
+  for (s = 0; s < 2; s++) {
+    if (m->prb_alloc.slot[s].nof_prb != prb_alloc->slot[s].nof_prb ||
+        memcmp(m->prb_alloc.slot[s].prb_idx, prb_alloc->slot[s].prb_idx,
+            sizeof(uint32_t) * prb_alloc->slot[s].nof_prb)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Returns the RE map for the allocation prb_alloc in subframe nsubframe. Maps
+ * are compiled the first time an allocation is seen and kept in a small cache
+ * (PDSCH_RE_MAP_CACHE entries, replaced in round-robin order).
+ *
+ * Returns NULL on error.
+ */
+re_map_t* pdsch_re_map(pdsch_t *q, ra_prb_t *prb_alloc, uint32_t nsubframe) {
+  uint32_t i, hash;
+  pdsch_re_map_t *m;
+  struct pdsch_trace_arg arg;
+
+  if (prb_alloc->slot[0].nof_prb > MAX_PRB || prb_alloc->slot[1].nof_prb > MAX_PRB) {
+    return NULL;
+  }
+  hash = pdsch_re_map_hash(prb_alloc, nsubframe);
+  for (i = 0; i < PDSCH_RE_MAP_CACHE; i++) {
+    if (pdsch_re_map_match(&q->re_map[i], prb_alloc, nsubframe, hash)) {
+      return &q->re_map[i].map;
+    }
+  }
+
+  m = &q->re_map[q->re_map_next];
+  q->re_map_next = (q->re_map_next + 1) % PDSCH_RE_MAP_CACHE;
+  m->valid = false;
+  if (!m->map.max_re) {
+    if (re_map_init(&m->map, q->max_symbols)) {
+      return NULL;
+    }
+  }
+  arg.q = q;
+  arg.prb_alloc = prb_alloc;
+  arg.nsubframe = nsubframe;
+  if (re_map_trace(&m->map, pdsch_cp_trace, &arg, 
+      SF_LEN_RE(q->cell.nof_prb, q->cell.cp)) < 0) {
+    return NULL;
+  }
+  INFO("Compiled PDSCH RE map SF %d: %d RE in %d runs\n", nsubframe, 
+      m->map.nof_re, m->map.nof_runs);
+  m->hash = hash;
+  m->subframe = nsubframe;
+  memcpy(&m->prb_alloc, prb_alloc, sizeof(ra_prb_t));
+  m->valid = true;
+  return &m->map;
+}
+
 /**
  * Puts PDSCH in slot number 1
  *
@@ -155,7 +259,12 @@ int pdsch_cp(pdsch_t *q, cf_t *input, cf_t *output, ra_prb_t *prb_alloc,
  */
 int pdsch_put(pdsch_t *q, cf_t *pdsch_symbols, cf_t *sf_symbols,
     ra_prb_t *prb_alloc, uint32_t subframe) {
-  return pdsch_cp(q, pdsch_symbols, sf_symbols, prb_alloc, subframe, true);
+  re_map_t *map = pdsch_re_map(q, prb_alloc, subframe);
+  if (map) {
+    return re_map_put(map, pdsch_symbols, sf_symbols);
+  } else {
+    return pdsch_cp(q, pdsch_symbols, sf_symbols, prb_alloc, subframe, true);
+  }
 }
 
 /**
@@ -167,7 +276,12 @@ int pdsch_put(pdsch_t *q, cf_t *pdsch_symbols, cf_t *sf_symbols,
  */
 int pdsch_get(pdsch_t *q, cf_t *sf_symbols, cf_t *pdsch_symbols,
     ra_prb_t *prb_alloc, uint32_t subframe) {
-  return pdsch_cp(q, sf_symbols, pdsch_symbols, prb_alloc, subframe, false);
+  re_map_t *map = pdsch_re_map(q, prb_alloc, subframe);
+  if (map) {
+    return re_map_get(map, sf_symbols, pdsch_symbols);
+  } else {
+    return pdsch_cp(q, sf_symbols, pdsch_symbols, prb_alloc, subframe, false);
+  }
 }
 
 /** Initializes the PDCCH transmitter and receiver */
@@ -235,6 +349,11 @@ int pdsch_init(pdsch_t *q, lte_cell_t cell) {
       goto clean;
     }
 
+    q->pdsch_sinr = malloc(sizeof(float) * q->max_symbols);
+    if (!q->pdsch_sinr) {
+      goto clean;
+    }
+
     for (i = 0; i < q->cell.nof_ports; i++) {
       q->ce[i] = malloc(sizeof(cf_t) * q->max_symbols);
       if (!q->ce[i]) {
@@ -274,6 +393,9 @@ void pdsch_free(pdsch_t *q) {
   if (q->pdsch_d) {
     free(q->pdsch_d);
   }
+  if (q->pdsch_sinr) {
+    free(q->pdsch_sinr);
+  }
   for (i = 0; i < q->cell.nof_ports; i++) {
     if (q->ce[i]) {
       free(q->ce[i]);
@@ -295,7 +417,10 @@ void pdsch_free(pdsch_t *q) {
   }
   tdec_free(&q->decoder);
   tcod_free(&q->encoder);
-
+  
+  for (i = 0; i < PDSCH_RE_MAP_CACHE; i++) {
+    re_map_free(&q->re_map[i].map);
+  }
 }
 
 int pdsch_set_rnti(pdsch_t *q, uint16_t rnti) {
@@ -310,6 +435,33 @@ int pdsch_set_rnti(pdsch_t *q, uint16_t rnti) {
   q->rnti = rnti; 
   return LIBLTE_SUCCESS;
 }
+/* Sets the noise variance per RE used by the MMSE detector, normally obtained 
+ * with chest_get_noise_estimate(). If set to 0 (the default), the ZF detector is used
+ * and the LLRs are not weighted. 
+ */
+void pdsch_set_noise_estimate(pdsch_t *q, float noise_estimate) {
+  q->noise_estimate = noise_estimate;
+}
+
+/* Selects how the turbo decoder iterations of each code block are stopped. 
+ * The decoder criteria are cheaper than a CRC, so PDSCH_STOP_DECODER_AND_CRC 
+ * saves the CRC of the iterations that have not converged and 
+ * PDSCH_STOP_DECODER saves all of them, at the cost of a higher BLER if they 
+ * stop too early. criteria is ignored with PDSCH_STOP_CRC (the default). 
+ */
+int pdsch_set_early_stop(pdsch_t *q, pdsch_stop_policy_t policy, tdec_stop_t *criteria) {
+  if (q == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (policy != PDSCH_STOP_CRC && (criteria == NULL || criteria->criteria == 0)) {
+    fprintf(stderr, "Early stopping policy %d needs decoder criteria\n", policy);
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  q->stop_policy = policy;
+  tdec_set_stop(&q->decoder, policy == PDSCH_STOP_CRC ? NULL : criteria);
+  return LIBLTE_SUCCESS;
+}
+
 /* Calculate Codeblock Segmentation as in Section 5.1.2 of 36.212 */
 static int codeblock_segmentation(struct cb_segm *s, uint32_t tbs) {
   uint32_t Bp, B, idx1;
@@ -351,6 +503,72 @@ static int codeblock_segmentation(struct cb_segm *s, uint32_t tbs) {
   return ret;
 }
 
+static uint32_t pdsch_tb_plan_hash(uint32_t tbs, uint32_t nb_e) {
+  uint32_t h = 2166136261u; // FNV-1a
+  h = (h ^ tbs) * 16777619u;
+  h = (h ^ nb_e) * 16777619u;
+  return h;
+}
+
+/**
+ * Returns the code block segmentation and the per code block lengths of a 
+ * transport block of tbs bits rate matched to nb_e bits. Plans are computed 
+ * the first time a (tbs, nb_e) pair is seen and kept in a direct-mapped cache 
+ * of PDSCH_TB_PLAN_CACHE entries, thus the lookup takes constant time.
+ *
+ * Returns NULL on error.
+ */
+pdsch_tb_plan_t* pdsch_tb_plan(pdsch_t *q, uint32_t tbs, uint32_t nb_e) {
+  pdsch_tb_plan_t *p;
+  pdsch_cb_plan_t *cb;
+  uint32_t i, rp, wp;
+
+  p = &q->tb_plan[pdsch_tb_plan_hash(tbs, nb_e) % PDSCH_TB_PLAN_CACHE];
+  if (p->valid && p->tbs == tbs && p->nb_e == nb_e) {
+    return p;
+  }
+  p->valid = false;
+  if (tbs == 0 || codeblock_segmentation(&p->cb_segm, tbs) < 0) {
+    fprintf(stderr, "Error in codeblock segmentation of TBS %d\n", tbs);
+    return NULL;
+  }
+  if (p->cb_segm.C > PDSCH_MAX_CB || nb_e < p->cb_segm.C) {
+    fprintf(stderr, "Invalid TB plan: TBS %d in %d CBs, %d rate matched bits\n", 
+        tbs, p->cb_segm.C, nb_e);
+    return NULL;
+  }
+
+  rp = 0;
+  wp = 0;
+  for (i = 0; i < p->cb_segm.C; i++) {
+    cb = &p->cb[i];
+    if (i < p->cb_segm.C - p->cb_segm.C2) {
+      cb->cb_len = p->cb_segm.K1;
+    } else {
+      cb->cb_len = p->cb_segm.K2;
+    }
+    if (p->cb_segm.C > 1) {
+      cb->rlen = cb->cb_len - 24;
+    } else {
+      cb->rlen = cb->cb_len;
+    }
+    cb->F = i == 0 ? p->cb_segm.F : 0;
+    if (i < p->cb_segm.C - 1) {
+      cb->e = nb_e / p->cb_segm.C;
+    } else {
+      cb->e = nb_e - rp;
+    }
+    cb->tb_offset = wp;
+    cb->e_offset = rp;
+    wp += cb->rlen - cb->F;
+    rp += cb->e;
+  }
+  p->tbs = tbs;
+  p->nb_e = nb_e;
+  p->valid = true;
+  return p;
+}
+
 int pdsch_harq_init(pdsch_harq_t *p, pdsch_t *pdsch) {
   int ret = LIBLTE_ERROR_INVALID_INPUTS;
   
@@ -463,6 +681,11 @@ float pdsch_average_noi(pdsch_t *q) {
   return q->average_nof_iterations; 
 }
 
+/* Counters of why the decoding of each code block stopped since pdsch_init() */
+void pdsch_stop_stats(pdsch_t *q, pdsch_stop_stats_t *stats) {
+  *stats = q->stop_stats;
+}
+
 uint32_t pdsch_last_noi(pdsch_t *q) {
   return q->nof_iterations;
 }
@@ -480,39 +703,33 @@ int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
   uint32_t i;
   uint32_t cb_len, rp, wp, rlen, F, n_e;
   float *e_bits = q->pdsch_e;
+  pdsch_tb_plan_t *plan;
   
   if (q         != NULL   && 
       data      != NULL   &&       
-      nb_e      < q->max_symbols * q->mod[3].nbits_x_symbol)
+      nb_e      < q->max_symbols * q->mod[3].nbits_x_symbol &&
+      harq_process != NULL)
   {
 
-    rp = 0;
-    rp = 0;
-    wp = 0;
-    for (i = 0; i < harq_process->cb_segm.C; i++) {
+    plan = pdsch_tb_plan(q, tbs, nb_e);
+    if (!plan) {
+      return LIBLTE_ERROR;
+    }
+    if (plan->cb_segm.C > harq_process->max_cb) {
+      fprintf(stderr, "TBS %d needs more CBs (%d) than allocated (%d)\n", 
+          tbs, plan->cb_segm.C, harq_process->max_cb);
+      return LIBLTE_ERROR;
+    }
 
-      /* Get read/write lengths */
-      if (i < harq_process->cb_segm.C - harq_process->cb_segm.C2) {
-        cb_len = harq_process->cb_segm.K1;
-      } else {
-        cb_len = harq_process->cb_segm.K2;
-      }
-      if (harq_process->cb_segm.C == 1) {
-        rlen = cb_len;
-      } else {
-        rlen = cb_len - 24;
-      }
-      if (i == 0) {
-        F = harq_process->cb_segm.F;
-      } else {
-        F = 0;
-      }
+    for (i = 0; i < plan->cb_segm.C; i++) {
 
-      if (i < harq_process->cb_segm.C - 1) {
-        n_e = nb_e / harq_process->cb_segm.C;
-      } else {
-        n_e = nb_e - rp;
-      }
+      /* Get read/write lengths */
+      cb_len = plan->cb[i].cb_len;
+      rlen = plan->cb[i].rlen;
+      F = plan->cb[i].F;
+      n_e = plan->cb[i].e;
+      rp = plan->cb[i].e_offset;
+      wp = plan->cb[i].tb_offset;
 
       DEBUG("CB#%d: cb_len: %d, rlen: %d, wp: %d, rp: %d, F: %d, E: %d\n", i,
           cb_len, rlen - F, wp, rp, F, n_e);
@@ -526,38 +743,65 @@ int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
         return LIBLTE_ERROR;
       }
 
-      /* Turbo Decoding with CRC-based early stopping */
+      /* Turbo Decoding with early stopping */
       q->nof_iterations = 0; 
       bool early_stop = false;
+      bool decided, check_crc;
       uint32_t len_crc; 
       char *cb_in_ptr; 
       crc_t *crc_ptr; 
       tdec_reset(&q->decoder, cb_len);
+
+      if (plan->cb_segm.C > 1) {
+        len_crc = cb_len; 
+        cb_in_ptr = q->cb_in; 
+        crc_ptr = &q->crc_cb; 
+      } else {
+        len_crc = tbs+24; 
+        cb_in_ptr = &q->cb_in[F];
+        crc_ptr = &q->crc_tb; 
+      }
             
       do {
         
         tdec_iteration(&q->decoder, (float*) q->cb_out, cb_len); 
         q->nof_iterations++;
-        
-        if (harq_process->cb_segm.C > 1) {
-          len_crc = cb_len; 
-          cb_in_ptr = q->cb_in; 
-          crc_ptr = &q->crc_cb; 
+        decided = false;
+
+        if (q->stop_policy == PDSCH_STOP_CRC) {
+          check_crc = true;
+        } else if (tdec_stop_check(&q->decoder, cb_len)) {
+          check_crc = q->stop_policy == PDSCH_STOP_DECODER_AND_CRC;
+          if (!check_crc) {
+            early_stop = true;
+            q->stop_stats.stop_decoder++;
+          }
         } else {
-          len_crc = tbs+24; 
-          bzero(q->cb_in, F*sizeof(char));
-          cb_in_ptr = &q->cb_in[F];
-          crc_ptr = &q->crc_tb; 
+          check_crc = false;
         }
 
-        tdec_decision(&q->decoder, q->cb_in, cb_len);
-  
-        /* Check Codeblock CRC and stop early if incorrect */
-        if (!crc_checksum(crc_ptr, cb_in_ptr, len_crc)) {
-          early_stop = true;           
+        if (check_crc) {
+          tdec_decision(&q->decoder, q->cb_in, cb_len);
+          decided = true;
+          q->stop_stats.nof_crc_checks++;
+
+          /* Check Codeblock CRC and stop early if correct */
+          if (!crc_checksum(crc_ptr, cb_in_ptr, len_crc)) {
+            early_stop = true;           
+            q->stop_stats.stop_crc++;
+          }
         }
         
       } while (q->nof_iterations < TDEC_MAX_ITERATIONS && !early_stop);
+
+      if (!decided) {
+        tdec_decision(&q->decoder, q->cb_in, cb_len);
+      }
+      if (!early_stop) {
+        q->stop_stats.stop_max++;
+      }
+      q->stop_stats.nof_cb++;
+      q->stop_stats.nof_iterations += q->nof_iterations;
             
       q->average_nof_iterations = EXPAVERAGE((float) q->nof_iterations, 
                                              q->average_nof_iterations, 
@@ -565,7 +809,7 @@ int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
       q->average_nof_iterations_n++;
 
       /* Copy data to another buffer, removing the Codeblock CRC */
-      if (i < harq_process->cb_segm.C - 1) {
+      if (i < plan->cb_segm.C - 1) {
         memcpy(&data[wp], &q->cb_in[F], (rlen - F) * sizeof(char));
       } else {
         DEBUG("Last CB, appending parity: %d to %d from %d and 24 from %d\n",
@@ -575,14 +819,8 @@ int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
         memcpy(&data[wp], &q->cb_in[F], (rlen - F - 24) * sizeof(char));
         memcpy(parity, &q->cb_in[rlen - 24], 24 * sizeof(char));
       }
-
-      /* Set read/write pointers */
-      wp += (rlen - F);
-      rp += n_e;
     }
 
-    DEBUG("END CB#%d: wp: %d, rp: %d\n", i, wp, rp);
-
     // Compute transport block CRC
     par_rx = crc_checksum(&q->crc_tb, data, tbs);
 
@@ -607,13 +845,15 @@ int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
 
 /** Decodes the PDSCH from the received symbols
  */
-int pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data, uint32_t subframe, 
+static int do_pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data, uint32_t subframe, 
                  pdsch_harq_t *harq_process, uint32_t rv_idx) 
 {
 
   /* Set pointers for layermapping & precoding */
   uint32_t i, n;
   cf_t *x[MAX_LAYERS];
+  cf_t *grid[MAX_PORTS + 1], *symbols[MAX_PORTS + 1];
+  re_map_t *map;
   uint32_t nof_symbols, nof_bits, nof_bits_e;
   
   if (q                     != NULL &&
@@ -626,7 +866,7 @@ int pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data,
     
     nof_bits = harq_process->mcs.tbs;
     nof_symbols = harq_process->prb_alloc.re_sf[subframe];
-    nof_bits_e = nof_symbols * q->mod[harq_process->mcs.mod - 1].nbits_x_symbol;
+    nof_bits_e = nof_symbols * pdsch_mod(q, harq_process->mcs.mod)->nbits_x_symbol;
 
 
     INFO("Decoding PDSCH SF: %d, Mod %d, NofBits: %d, NofSymbols: %d, NofBitsE: %d, rv_idx: %d\n",
@@ -638,41 +878,63 @@ int pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data,
     }
     memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
       
-    /* extract symbols */
-    n = pdsch_get(q, sf_symbols, q->pdsch_symbols[0], &harq_process->prb_alloc, subframe);
+    /* extract symbols and channel estimates in a single pass */
+    map = pdsch_re_map(q, &harq_process->prb_alloc, subframe);
+    if (!map) {
+      fprintf(stderr, "Error computing PDSCH RE map\n");
+      return LIBLTE_ERROR;
+    }
+    grid[0] = sf_symbols;
+    symbols[0] = q->pdsch_symbols[0];
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      grid[i + 1] = ce[i];
+      symbols[i + 1] = q->ce[i];
+    }
+    n = re_map_get_multi(map, grid, symbols, q->cell.nof_ports + 1);
     if (n != nof_symbols) {
       fprintf(stderr, "Error expecting %d symbols but got %d\n", nof_symbols, n);
       return LIBLTE_ERROR;
     }
-
-    /* extract channel estimates */
-    for (i = 0; i < q->cell.nof_ports; i++) {
-      n = pdsch_get(q, ce[i], q->ce[i], &harq_process->prb_alloc, subframe);
-      if (n != nof_symbols) {
-        fprintf(stderr, "Error expecting %d symbols but got %d\n", nof_symbols, n);
-        return LIBLTE_ERROR;
+      
+    demod_soft_table_set(&q->demod, pdsch_mod(q, harq_process->mcs.mod));
+    
+    if (q->noise_estimate > 0) {
+      /* TODO: only diversity is supported */
+      if (q->cell.nof_ports == 1) {
+        predecoding_single_mmse(q->pdsch_symbols[0], q->ce[0], q->pdsch_d, 
+            q->pdsch_sinr, nof_symbols, q->noise_estimate);
+      } else {
+        predecoding_diversity_mmse(q->pdsch_symbols[0], q->ce, x, q->pdsch_sinr, 
+            q->cell.nof_ports, nof_symbols, q->noise_estimate);
+        layerdemap_diversity(x, q->pdsch_d, q->cell.nof_ports,
+            nof_symbols / q->cell.nof_ports);
       }
-    }
       
-    /* TODO: only diversity is supported */
-    if (q->cell.nof_ports == 1) {
-      /* no need for layer demapping */
-      predecoding_single_zf(q->pdsch_symbols[0], q->ce[0], q->pdsch_d,
-          nof_symbols);
+      /* demodulate symbols 
+       * Each LLR is weighted by the SINR of its RE, thus the distances are not normalized 
+       */
+      demod_soft_sigma_set(&q->demod, 0.5);
+      demod_soft_demodulate_weighted(&q->demod, q->pdsch_d, q->pdsch_sinr, q->pdsch_e, nof_symbols);
     } else {
-      predecoding_diversity_zf(q->pdsch_symbols[0], q->ce, x, q->cell.nof_ports,
-          nof_symbols);
-      layerdemap_diversity(x, q->pdsch_d, q->cell.nof_ports,
-          nof_symbols / q->cell.nof_ports);
+      /* TODO: only diversity is supported */
+      if (q->cell.nof_ports == 1) {
+        /* no need for layer demapping */
+        predecoding_single_zf(q->pdsch_symbols[0], q->ce[0], q->pdsch_d,
+            nof_symbols);
+      } else {
+        predecoding_diversity_zf(q->pdsch_symbols[0], q->ce, x, q->cell.nof_ports,
+            nof_symbols);
+        layerdemap_diversity(x, q->pdsch_d, q->cell.nof_ports,
+            nof_symbols / q->cell.nof_ports);
+      }
+      
+      /* demodulate symbols 
+      * The MAX-log-MAP algorithm used in turbo decoding is unsensitive to SNR estimation, 
+      * thus we don't need tot set it in the LLRs normalization
+      */
+      demod_soft_sigma_set(&q->demod, 2.0 / pdsch_mod(q, harq_process->mcs.mod)->nbits_x_symbol);
+      demod_soft_demodulate(&q->demod, q->pdsch_d, q->pdsch_e, nof_symbols);
     }
-    
-    /* demodulate symbols 
-     * The MAX-log-MAP algorithm used in turbo decoding is unsensitive to SNR estimation, 
-     * thus we don't need tot set it in the LLRs normalization
-     */
-    demod_soft_sigma_set(&q->demod, 2.0 / q->mod[harq_process->mcs.mod - 1].nbits_x_symbol);
-    demod_soft_table_set(&q->demod, &q->mod[harq_process->mcs.mod - 1]);
-    demod_soft_demodulate(&q->demod, q->pdsch_d, q->pdsch_e, nof_symbols);
  
     /*
     for (int j=0;j<nof_symbols;j++) {
@@ -696,119 +958,113 @@ int pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data,
   }
 }
 
-/* Encode a transport block according to 36.212 5.3.2
- *
+int pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data, uint32_t subframe, 
+                 pdsch_harq_t *harq_process, uint32_t rv_idx)
+{
+  int ret;
+  TRACE_BEGIN(TRACE_PDSCH);
+  ret = do_pdsch_decode(q, sf_symbols, ce, data, subframe, harq_process, rv_idx);
+  TRACE_END(TRACE_PDSCH);
+  return ret;
+}
+
+/* Encode a transport block according to 36.212 5.3.2 and pass the nb_e rate 
+ * matched bits to the modulation stream s, which scrambles and modulates them
  */
 int pdsch_encode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e, 
-                    pdsch_harq_t *harq_process, uint32_t rv_idx) 
+                    pdsch_harq_t *harq_process, uint32_t rv_idx, mod_stream_t *s) 
 {
   char parity[24];
   char *p_parity = parity;
   uint32_t par;
   uint32_t i;
   uint32_t cb_len, rp, wp, rlen, F, n_e;
-  char *e_bits = q->pdsch_e;
   int ret = LIBLTE_ERROR_INVALID_INPUTS; 
+  pdsch_tb_plan_t *plan;
   
   if (q             != NULL &&
       data          != NULL &&
+      s             != NULL &&
+      harq_process  != NULL &&
       nb_e          <  q->max_symbols * q->mod[3].nbits_x_symbol)
   {
-  
-    if (q->rnti_is_set) {
-      if (rv_idx == 0) {
-        /* Compute transport block CRC */
-        par = crc_checksum(&q->crc_tb, data, tbs);
+    plan = pdsch_tb_plan(q, tbs, nb_e);
+    if (!plan) {
+      return LIBLTE_ERROR;
+    }
+    if (plan->cb_segm.C > harq_process->max_cb) {
+      fprintf(stderr, "TBS %d needs more CBs (%d) than allocated (%d)\n", 
+          tbs, plan->cb_segm.C, harq_process->max_cb);
+      return LIBLTE_ERROR;
+    }
 
-        /* parity bits will be appended later */
-        bit_pack(par, &p_parity, 24);
+    if (rv_idx == 0) {
+      /* Compute transport block CRC */
+      par = crc_checksum(&q->crc_tb, data, tbs);
 
-        if (VERBOSE_ISDEBUG()) {
-          DEBUG("DATA: ", 0);
-          vec_fprint_b(stdout, data, tbs);
-          DEBUG("PARITY: ", 0);
-          vec_fprint_b(stdout, parity, 24);
-        }
+      /* parity bits will be appended later */
+      bit_pack(par, &p_parity, 24);
 
-        /* Add filler bits to the new data buffer */
-        for (i = 0; i < harq_process->cb_segm.F; i++) {
-          q->cb_in[i] = LTE_NULL_BIT;
-        }
+      if (VERBOSE_ISDEBUG()) {
+        DEBUG("DATA: ", 0);
+        vec_fprint_b(stdout, data, tbs);
+        DEBUG("PARITY: ", 0);
+        vec_fprint_b(stdout, parity, 24);
       }
-      
-      wp = 0;
-      rp = 0;
-      for (i = 0; i < harq_process->cb_segm.C; i++) {
 
-        /* Get read lengths */
-        if (i < harq_process->cb_segm.C - harq_process->cb_segm.C2) {
-          cb_len = harq_process->cb_segm.K1;
-        } else {
-          cb_len = harq_process->cb_segm.K2;
-        }
-        if (harq_process->cb_segm.C > 1) {
-          rlen = cb_len - 24;
-        } else {
-          rlen = cb_len;
-        }
-        if (i == 0) {
-          F = harq_process->cb_segm.F;
-        } else {
-          F = 0;
-        }
+      /* Add filler bits to the new data buffer */
+      for (i = 0; i < plan->cb_segm.F; i++) {
+        q->cb_in[i] = LTE_NULL_BIT;
+      }
+    }
+    
+    for (i = 0; i < plan->cb_segm.C; i++) {
 
-        if (i < harq_process->cb_segm.C - 1) {
-          n_e = nb_e / harq_process->cb_segm.C;
-        } else {
-          n_e = nb_e - wp;
-        }
+      /* Get read lengths */
+      cb_len = plan->cb[i].cb_len;
+      rlen = plan->cb[i].rlen;
+      F = plan->cb[i].F;
+      n_e = plan->cb[i].e;
+      rp = plan->cb[i].tb_offset;
+      wp = plan->cb[i].e_offset;
 
-        INFO("CB#%d: cb_len: %d, rlen: %d, wp: %d, rp: %d, F: %d, E: %d\n", i,
-            cb_len, rlen - F, wp, rp, F, n_e);
+      INFO("CB#%d: cb_len: %d, rlen: %d, wp: %d, rp: %d, F: %d, E: %d\n", i,
+          cb_len, rlen - F, wp, rp, F, n_e);
 
-        if (rv_idx == 0) {
-          /* Copy data to another buffer, making space for the Codeblock CRC */
-          if (i < harq_process->cb_segm.C - 1) {
-            memcpy(&q->cb_in[F], &data[rp], (rlen - F) * sizeof(char));
-          } else {
-            INFO("Last CB, appending parity: %d from %d and 24 to %d\n",
-                rlen - F - 24, rp, rlen - 24);
-            /* Append Transport Block parity bits to the last CB */
-            memcpy(&q->cb_in[F], &data[rp], (rlen - F - 24) * sizeof(char));
-            memcpy(&q->cb_in[rlen - 24], parity, 24 * sizeof(char));
-          }        
-          if (harq_process->cb_segm.C > 1) {
-            /* Attach Codeblock CRC */
-            crc_attach(&q->crc_cb, q->cb_in, rlen);
-          }
-          if (VERBOSE_ISDEBUG()) {
-            DEBUG("CB#%d Len=%d: ", i, cb_len);
-            vec_fprint_b(stdout, q->cb_in, cb_len);
-          }
-          /* Turbo Encoding */
-          tcod_encode(&q->encoder, q->cb_in, (char*) q->cb_out, cb_len);
+      if (rv_idx == 0) {
+        /* Copy data to another buffer, making space for the Codeblock CRC */
+        if (i < plan->cb_segm.C - 1) {
+          memcpy(&q->cb_in[F], &data[rp], (rlen - F) * sizeof(char));
+        } else {
+          INFO("Last CB, appending parity: %d from %d and 24 to %d\n",
+              rlen - F - 24, rp, rlen - 24);
+          /* Append Transport Block parity bits to the last CB */
+          memcpy(&q->cb_in[F], &data[rp], (rlen - F - 24) * sizeof(char));
+          memcpy(&q->cb_in[rlen - 24], parity, 24 * sizeof(char));
+        }        
+        if (plan->cb_segm.C > 1) {
+          /* Attach Codeblock CRC */
+          crc_attach(&q->crc_cb, q->cb_in, rlen);
         }
-        
-        /* Rate matching */
-        if (rm_turbo_tx(harq_process->pdsch_w_buff_c[i], harq_process->w_buff_size, 
-                    (char*) q->cb_out, 3 * cb_len + 12,
-                    &e_bits[wp], n_e, rv_idx))
-        {
-          fprintf(stderr, "Error in rate matching\n");
-          return LIBLTE_ERROR;
+        if (VERBOSE_ISDEBUG()) {
+          DEBUG("CB#%d Len=%d: ", i, cb_len);
+          vec_fprint_b(stdout, q->cb_in, cb_len);
         }
-
-        /* Set read/write pointers */
-        rp += (rlen - F);
-        wp += n_e;
+        /* Turbo Encoding */
+        tcod_encode(&q->encoder, q->cb_in, (char*) q->cb_out, cb_len);
       }
-
-      INFO("END CB#%d: wp: %d, rp: %d\n", i, wp, rp);
       
-      ret = LIBLTE_SUCCESS;      
-    } else {
-      fprintf(stderr, "Must call pdsch_set_rnti() to set the encoder/decoder RNTI\n");  
+      /* Rate matching, scrambling and modulation */
+      if (rm_turbo_tx_mod(harq_process->pdsch_w_buff_c[i], harq_process->w_buff_size, 
+                  (char*) q->cb_out, 3 * cb_len + 12,
+                  s, n_e, rv_idx))
+      {
+        fprintf(stderr, "Error in rate matching\n");
+        return LIBLTE_ERROR;
+      }
     }
+    
+    ret = LIBLTE_SUCCESS;      
   } 
   return ret; 
 }
@@ -817,9 +1073,31 @@ int pdsch_encode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
  */
 int pdsch_encode(pdsch_t *q, char *data, cf_t *sf_symbols[MAX_PORTS], uint32_t subframe, 
                  pdsch_harq_t *harq_process, uint32_t rv_idx) 
+{
+  if (q             != NULL &&
+      subframe      <  10)
+  {
+    if (q->rnti_is_set) {
+      return pdsch_encode_seq(q, data, sf_symbols, subframe, harq_process, rv_idx, 
+                              &q->seq_pdsch[subframe]);
+    } else {
+      fprintf(stderr, "Must call pdsch_set_rnti() to set the encoder/decoder RNTI\n");       
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
+  } 
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
+/** Same as pdsch_encode() but scrambles with the sequence seq instead of the one 
+ * generated by pdsch_set_rnti(). seq must have at least as many bits as the 
+ * transport block is rate matched to.
+ */
+int pdsch_encode_seq(pdsch_t *q, char *data, cf_t *sf_symbols[MAX_PORTS], uint32_t subframe, 
+                     pdsch_harq_t *harq_process, uint32_t rv_idx, sequence_t *seq) 
 {
   int i;
   uint32_t nof_symbols, nof_bits, nof_bits_e;
+  mod_stream_t mod_stream;
   /* Set pointers for layermapping & precoding */
   cf_t *x[MAX_LAYERS];
    int ret = LIBLTE_ERROR_INVALID_INPUTS; 
@@ -827,72 +1105,70 @@ int pdsch_encode(pdsch_t *q, char *data, cf_t *sf_symbols[MAX_PORTS], uint32_t s
    if (q             != NULL &&
        data          != NULL &&
        subframe      <  10   &&
-       harq_process  != NULL)
+       harq_process  != NULL &&
+       seq           != NULL)
   {
 
-    if (q->rnti_is_set) {
-      for (i=0;i<q->cell.nof_ports;i++) {
-        if (sf_symbols[i] == NULL) {
-          return LIBLTE_ERROR_INVALID_INPUTS;
-        }
-      }
-      
-      nof_bits = harq_process->mcs.tbs;
-      nof_symbols = harq_process->prb_alloc.re_sf[subframe];
-      nof_bits_e = nof_symbols * q->mod[harq_process->mcs.mod - 1].nbits_x_symbol;
-
-      if (harq_process->mcs.tbs == 0) {
-        return LIBLTE_ERROR_INVALID_INPUTS;      
-      }
-      
-      if (nof_bits > nof_bits_e) {
-        fprintf(stderr, "Invalid code rate %.2f\n", (float) nof_bits / nof_bits_e);
-        return LIBLTE_ERROR_INVALID_INPUTS;
-      }
-
-      if (nof_symbols > q->max_symbols) {
-        fprintf(stderr,
-            "Error too many RE per subframe (%d). PDSCH configured for %d RE (%d PRB)\n",
-            nof_symbols, q->max_symbols, q->cell.nof_prb);
+    for (i=0;i<q->cell.nof_ports;i++) {
+      if (sf_symbols[i] == NULL) {
         return LIBLTE_ERROR_INVALID_INPUTS;
       }
+    }
+    
+    nof_bits = harq_process->mcs.tbs;
+    nof_symbols = harq_process->prb_alloc.re_sf[subframe];
+    nof_bits_e = nof_symbols * pdsch_mod(q, harq_process->mcs.mod)->nbits_x_symbol;
 
-      INFO("Encoding PDSCH SF: %d, Mod %d, NofBits: %d, NofSymbols: %d, NofBitsE: %d, rv_idx: %d\n",
-          subframe, harq_process->mcs.mod, nof_bits, nof_symbols, nof_bits_e, rv_idx);
+    if (harq_process->mcs.tbs == 0) {
+      return LIBLTE_ERROR_INVALID_INPUTS;      
+    }
+    
+    if (nof_bits > nof_bits_e) {
+      fprintf(stderr, "Invalid code rate %.2f\n", (float) nof_bits / nof_bits_e);
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
 
-      /* number of layers equals number of ports */
-      for (i = 0; i < q->cell.nof_ports; i++) {
-        x[i] = q->pdsch_x[i];
-      }
-      memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
+    if (nof_symbols > q->max_symbols) {
+      fprintf(stderr,
+          "Error too many RE per subframe (%d). PDSCH configured for %d RE (%d PRB)\n",
+          nof_symbols, q->max_symbols, q->cell.nof_prb);
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
+    
+    if (nof_bits_e > seq->len) {
+      fprintf(stderr, "Scrambling sequence too short (%d < %d)\n", seq->len, nof_bits_e);
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
 
-      if (pdsch_encode_tb(q, data, nof_bits, nof_bits_e, harq_process, rv_idx)) {
-        fprintf(stderr, "Error encoding TB\n");
-        return LIBLTE_ERROR;
-      }
-      
-      scrambling_b_offset(&q->seq_pdsch[subframe], (char*) q->pdsch_e, 0, nof_bits_e);
+    INFO("Encoding PDSCH SF: %d, Mod %d, NofBits: %d, NofSymbols: %d, NofBitsE: %d, rv_idx: %d\n",
+        subframe, harq_process->mcs.mod, nof_bits, nof_symbols, nof_bits_e, rv_idx);
 
-      mod_modulate(&q->mod[harq_process->mcs.mod - 1], (char*) q->pdsch_e, q->pdsch_d, nof_bits_e);
+    /* number of layers equals number of ports */
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      x[i] = q->pdsch_x[i];
+    }
+    memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
 
-      /* TODO: only diversity supported */
-      if (q->cell.nof_ports > 1) {
-        layermap_diversity(q->pdsch_d, x, q->cell.nof_ports, nof_symbols);
-        precoding_diversity(x, q->pdsch_symbols, q->cell.nof_ports,
-            nof_symbols / q->cell.nof_ports);
-      } else {
-        memcpy(q->pdsch_symbols[0], q->pdsch_d, nof_symbols * sizeof(cf_t));
-      }
+    mod_stream_init(&mod_stream, pdsch_mod(q, harq_process->mcs.mod), seq->c, q->pdsch_d);
+    if (pdsch_encode_tb(q, data, nof_bits, nof_bits_e, harq_process, rv_idx, &mod_stream)) {
+      fprintf(stderr, "Error encoding TB\n");
+      return LIBLTE_ERROR;
+    }
 
-      /* mapping to resource elements */
-      for (i = 0; i < q->cell.nof_ports; i++) {
-        pdsch_put(q, q->pdsch_symbols[i], sf_symbols[i], &harq_process->prb_alloc, subframe);
-      }
-      ret = LIBLTE_SUCCESS;
+    /* TODO: only diversity supported */
+    if (q->cell.nof_ports > 1) {
+      layermap_diversity(q->pdsch_d, x, q->cell.nof_ports, nof_symbols);
+      precoding_diversity(x, q->pdsch_symbols, q->cell.nof_ports,
+          nof_symbols / q->cell.nof_ports);
     } else {
-     fprintf(stderr, "Must call pdsch_set_rnti() to set the encoder/decoder RNTI\n");       
+      memcpy(q->pdsch_symbols[0], q->pdsch_d, nof_symbols * sizeof(cf_t));
+    }
+
+    /* mapping to resource elements */
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      pdsch_put(q, q->pdsch_symbols[i], sf_symbols[i], &harq_process->prb_alloc, subframe);
     }
+    ret = LIBLTE_SUCCESS;
   } 
   return ret; 
 }
-  
\ No newline at end of file
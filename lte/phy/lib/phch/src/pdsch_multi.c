@@ -0,0 +1,268 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "liblte/phy/phch/pdsch_multi.h"
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/utils/debug.h"
+
+static int encode_grant(pdsch_multi_t *q, pdsch_multi_worker_t *w, pdsch_grant_t *g) {
+  pdsch_harq_t *h = g->harq_process;
+  uint32_t nof_bits_e = h->prb_alloc.re_sf[q->subframe] * lte_mod_bits_x_symbol(h->mcs.mod);
+
+  if (sequence_pdsch(&w->seq, g->ra_dl->rnti, 0, 2 * q->subframe, q->cell.id, nof_bits_e)) {
+    return LIBLTE_ERROR;
+  }
+  return pdsch_encode_seq(&w->pdsch, g->data, q->sf_symbols, q->subframe, h,
+                          g->ra_dl->rv_idx, &w->seq);
+}
+
+/* Takes grants of the current job until there are none left */
+static void work(pdsch_multi_t *q, pdsch_multi_worker_t *w) {
+  pdsch_grant_t *g;
+
+  pthread_mutex_lock(&q->mutex);
+  while (q->next_grant < q->nof_grants) {
+    g = &q->grants[q->next_grant];
+    q->next_grant++;
+    pthread_mutex_unlock(&q->mutex);
+
+    g->ret = encode_grant(q, w, g);
+
+    pthread_mutex_lock(&q->mutex);
+    q->nof_done++;
+    if (q->nof_done == q->nof_grants) {
+      pthread_cond_signal(&q->cvar_done);
+    }
+  }
+  pthread_mutex_unlock(&q->mutex);
+}
+
+static void* worker_thread(void *arg) {
+  pdsch_multi_worker_t *w = (pdsch_multi_worker_t*) arg;
+  pdsch_multi_t *q = (pdsch_multi_t*) w->parent;
+  uint32_t job_id = 0;
+
+  pthread_mutex_lock(&q->mutex);
+  while (true) {
+    while (!q->stop && q->job_id == job_id) {
+      pthread_cond_wait(&q->cvar_job, &q->mutex);
+    }
+    if (q->stop) {
+      break;
+    }
+    job_id = q->job_id;
+    pthread_mutex_unlock(&q->mutex);
+    work(q, w);
+    pthread_mutex_lock(&q->mutex);
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return NULL;
+}
+
+/* Uses nof_threads threads, including the one calling pdsch_multi_encode().
+ * With nof_threads = 1 the grants are encoded sequentially and no thread is created.
+ */
+int pdsch_multi_init(pdsch_multi_t *q, lte_cell_t cell, uint32_t nof_threads) {
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  uint32_t i;
+
+  if (q                 != NULL &&
+      lte_cell_isvalid(&cell)   &&
+      nof_threads       >  0    &&
+      nof_threads       <= PDSCH_MULTI_MAX_THREADS)
+  {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(pdsch_multi_t));
+    q->cell = cell;
+    q->nof_threads = nof_threads;
+
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->cvar_job, NULL);
+    pthread_cond_init(&q->cvar_done, NULL);
+
+    for (i = 0; i < nof_threads; i++) {
+      q->workers[i].parent = q;
+      if (pdsch_init(&q->workers[i].pdsch, cell)) {
+        fprintf(stderr, "Error initiating PDSCH for thread %d\n", i);
+        goto clean;
+      }
+    }
+    /* worker 0 is the calling thread */
+    for (i = 1; i < nof_threads; i++) {
+      if (pthread_create(&q->workers[i].thread, NULL, worker_thread, &q->workers[i])) {
+        perror("pthread_create");
+        goto clean;
+      }
+      q->workers[i].thread_running = true;
+    }
+
+    INFO("Init multi-user PDSCH: %d PRB, %d threads\n", cell.nof_prb, nof_threads);
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    pdsch_multi_free(q);
+  }
+  return ret;
+}
+
+void pdsch_multi_free(pdsch_multi_t *q) {
+  uint32_t i;
+
+  pthread_mutex_lock(&q->mutex);
+  q->stop = true;
+  pthread_cond_broadcast(&q->cvar_job);
+  pthread_mutex_unlock(&q->mutex);
+
+  for (i = 0; i < q->nof_threads; i++) {
+    if (q->workers[i].thread_running) {
+      pthread_join(q->workers[i].thread, NULL);
+    }
+    pdsch_free(&q->workers[i].pdsch);
+    sequence_free(&q->workers[i].seq);
+  }
+  pthread_cond_destroy(&q->cvar_done);
+  pthread_cond_destroy(&q->cvar_job);
+  pthread_mutex_destroy(&q->mutex);
+  bzero(q, sizeof(pdsch_multi_t));
+}
+
+/* Configures the HARQ processes of new transmissions and checks that the
+ * allocations are within the cell and do not overlap
+ */
+static int setup_grants(pdsch_multi_t *q, pdsch_grant_t *grants, uint32_t nof_grants) {
+  bool used[2][MAX_PRB];
+  uint32_t i, s, n, prb;
+  ra_prb_t *prb_alloc;
+
+  /* check all the grants before touching any HARQ process */
+  bzero(used, sizeof(used));
+  for (i = 0; i < nof_grants; i++) {
+    if (!grants[i].ra_dl || !grants[i].harq_process || !grants[i].data) {
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
+    /* retransmissions use the allocation of the first transmission */
+    if (grants[i].ra_dl->rv_idx == 0) {
+      prb_alloc = &grants[i].ra_dl->prb_alloc;
+    } else {
+      prb_alloc = &grants[i].harq_process->prb_alloc;
+    }
+    for (s = 0; s < 2; s++) {
+      for (n = 0; n < prb_alloc->slot[s].nof_prb; n++) {
+        prb = prb_alloc->slot[s].prb_idx[n];
+        if (prb >= q->cell.nof_prb) {
+          fprintf(stderr, "RNTI 0x%x: PRB %d out of range\n", grants[i].ra_dl->rnti, prb);
+          return LIBLTE_ERROR_INVALID_INPUTS;
+        }
+        if (used[s][prb]) {
+          fprintf(stderr, "RNTI 0x%x: PRB %d of slot %d already allocated\n",
+                  grants[i].ra_dl->rnti, prb, s);
+          return LIBLTE_ERROR_INVALID_INPUTS;
+        }
+        used[s][prb] = true;
+      }
+    }
+  }
+  for (i = 0; i < nof_grants; i++) {
+    if (grants[i].ra_dl->rv_idx == 0) {
+      if (pdsch_harq_setup(grants[i].harq_process, grants[i].ra_dl->mcs,
+                           &grants[i].ra_dl->prb_alloc)) {
+        fprintf(stderr, "Error configuring HARQ process of RNTI 0x%x\n", grants[i].ra_dl->rnti);
+        return LIBLTE_ERROR;
+      }
+    }
+    grants[i].ret = LIBLTE_ERROR;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/** Encodes the nof_grants transport blocks of the subframe and maps them into
+ * sf_symbols. Returns LIBLTE_SUCCESS if all of them were encoded, otherwise
+ * LIBLTE_ERROR and the ret field of the failed grants is non-zero.
+ */
+int pdsch_multi_encode(pdsch_multi_t *q, pdsch_grant_t *grants, uint32_t nof_grants,
+                       cf_t *sf_symbols[MAX_PORTS], uint32_t subframe)
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  uint32_t i;
+
+  if (q                 != NULL &&
+      grants            != NULL &&
+      sf_symbols        != NULL &&
+      subframe          <  NSUBFRAMES_X_FRAME)
+  {
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      if (!sf_symbols[i]) {
+        return LIBLTE_ERROR_INVALID_INPUTS;
+      }
+    }
+    ret = setup_grants(q, grants, nof_grants);
+    if (ret != LIBLTE_SUCCESS) {
+      return ret;
+    }
+
+    pthread_mutex_lock(&q->mutex);
+    q->grants = grants;
+    q->nof_grants = nof_grants;
+    q->next_grant = 0;
+    q->nof_done = 0;
+    q->subframe = subframe;
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      q->sf_symbols[i] = sf_symbols[i];
+    }
+    if (q->nof_threads > 1 && nof_grants > 1) {
+      q->job_id++;
+      pthread_cond_broadcast(&q->cvar_job);
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    work(q, &q->workers[0]);
+
+    pthread_mutex_lock(&q->mutex);
+    while (q->nof_done < q->nof_grants) {
+      pthread_cond_wait(&q->cvar_done, &q->mutex);
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    ret = LIBLTE_SUCCESS;
+    for (i = 0; i < nof_grants; i++) {
+      if (grants[i].ret) {
+        fprintf(stderr, "Error encoding PDSCH of RNTI 0x%x\n", grants[i].ra_dl->rnti);
+        ret = LIBLTE_ERROR;
+      }
+    }
+  }
+  return ret;
+}
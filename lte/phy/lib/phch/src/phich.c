@@ -145,6 +145,7 @@ int phich_decode(phich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
   /* Set pointers for layermapping & precoding */
   int i, j;
   cf_t *x[MAX_LAYERS];
+  cf_t *grid[MAX_PORTS + 1], *symbols[MAX_PORTS + 1];
   cf_t *ce_precoding[MAX_PORTS];
   
   if (q == NULL || slot_symbols == NULL) {
@@ -182,21 +183,19 @@ int phich_decode(phich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
     ce_precoding[i] = q->ce[i];
   }
 
-  /* extract symbols */
+  /* extract symbols and channel estimates */
+  grid[0] = slot_symbols;
+  symbols[0] = q->phich_symbols[0];
+  for (i = 0; i < q->cell.nof_ports; i++) {
+    grid[i + 1] = ce[i];
+    symbols[i + 1] = q->ce[i];
+  }
   if (PHICH_MAX_NSYMB
-      != regs_phich_get(q->regs, slot_symbols, q->phich_symbols[0], ngroup)) {
+      != regs_phich_get_multi(q->regs, grid, symbols, ngroup, q->cell.nof_ports + 1)) {
     fprintf(stderr, "There was an error getting the phich symbols\n");
     return LIBLTE_ERROR;
   }
 
-  /* extract channel estimates */
-  for (i = 0; i < q->cell.nof_ports; i++) {
-    if (PHICH_MAX_NSYMB != regs_phich_get(q->regs, ce[i], q->ce[i], ngroup)) {
-      fprintf(stderr, "There was an error getting the phich symbols\n");
-      return LIBLTE_ERROR;
-    }
-  }
-
   /* in control channels, only diversity is supported */
   if (q->cell.nof_ports == 1) {
     /* no need for layer demapping */
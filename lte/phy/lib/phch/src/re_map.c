@@ -0,0 +1,200 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <complex.h>
+
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/phch/re_map.h"
+
+/* Runs shorter than this are copied element by element (the typical case in
+ * OFDM symbols carrying reference signals), longer ones with memcpy() */
+#define RE_MAP_SHORT_RUN   8
+
+int re_map_init(re_map_t *q, uint32_t max_re) {
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+
+  if (q != NULL && max_re > 0) {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(re_map_t));
+
+    q->max_re = max_re;
+    q->run_start = malloc(sizeof(uint32_t) * max_re);
+    if (!q->run_start) {
+      goto clean;
+    }
+    q->run_len = malloc(sizeof(uint32_t) * max_re);
+    if (!q->run_len) {
+      goto clean;
+    }
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    re_map_free(q);
+  }
+  return ret;
+}
+
+void re_map_free(re_map_t *q) {
+  if (q->run_start) {
+    free(q->run_start);
+  }
+  if (q->run_len) {
+    free(q->run_len);
+  }
+  bzero(q, sizeof(re_map_t));
+}
+
+void re_map_reset(re_map_t *q) {
+  q->nof_re = 0;
+  q->nof_runs = 0;
+}
+
+/* Appends the RE at grid position idx to the map, merging it with the
+ * previous run if they are contiguous.
+ */
+int re_map_push(re_map_t *q, uint32_t idx) {
+  if (q->nof_re >= q->max_re) {
+    return LIBLTE_ERROR;
+  }
+  if (q->nof_runs > 0 &&
+      q->run_start[q->nof_runs - 1] + q->run_len[q->nof_runs - 1] == idx) {
+    q->run_len[q->nof_runs - 1]++;
+  } else {
+    q->run_start[q->nof_runs] = idx;
+    q->run_len[q->nof_runs] = 1;
+    q->nof_runs++;
+  }
+  q->nof_re++;
+  return LIBLTE_SUCCESS;
+}
+
+/* Compiles the map from an existing extraction function. cp_fn() is called in
+ * "get" direction over a grid of grid_len RE where each RE holds its own
+ * position, so the extracted symbols are the positions in mapping order.
+ * This keeps the map exactly equivalent to the function it replaces.
+ *
+ * Returns the number of RE in the map or a negative value on error.
+ */
+int re_map_trace(re_map_t *q, int (*cp_fn)(void *arg, cf_t *grid, cf_t *symbols),
+    void *arg, uint32_t grid_len) {
+  cf_t *grid = NULL, *symbols = NULL;
+  int ret = LIBLTE_ERROR;
+  int i, n;
+
+  grid = malloc(sizeof(cf_t) * grid_len);
+  if (!grid) {
+    goto clean;
+  }
+  symbols = malloc(sizeof(cf_t) * q->max_re);
+  if (!symbols) {
+    goto clean;
+  }
+  for (i = 0; i < grid_len; i++) {
+    grid[i] = (float) i;
+  }
+  n = cp_fn(arg, grid, symbols);
+  if (n < 0 || n > q->max_re) {
+    fprintf(stderr, "Error tracing RE map: got %d RE (max %d)\n", n, q->max_re);
+    goto clean;
+  }
+  re_map_reset(q);
+  for (i = 0; i < n; i++) {
+    if (re_map_push(q, (uint32_t) crealf(symbols[i]))) {
+      goto clean;
+    }
+  }
+  ret = n;
+clean:
+  if (grid) {
+    free(grid);
+  }
+  if (symbols) {
+    free(symbols);
+  }
+  return ret;
+}
+
+/* Extracts the RE in the map from grid and writes them consecutively in symbols.
+ * Returns the number of symbols written.
+ */
+int re_map_get(re_map_t *q, cf_t *grid, cf_t *symbols) {
+  return re_map_get_multi(q, &grid, &symbols, 1);
+}
+
+/* Writes nof_re consecutive symbols into the RE of grid given by the map.
+ * Returns the number of symbols read.
+ */
+int re_map_put(re_map_t *q, cf_t *symbols, cf_t *grid) {
+  uint32_t r, j;
+  cf_t *in = symbols;
+  cf_t *out;
+
+  for (r = 0; r < q->nof_runs; r++) {
+    out = &grid[q->run_start[r]];
+    if (q->run_len[r] < RE_MAP_SHORT_RUN) {
+      for (j = 0; j < q->run_len[r]; j++) {
+        out[j] = in[j];
+      }
+    } else {
+      memcpy(out, in, sizeof(cf_t) * q->run_len[r]);
+    }
+    in += q->run_len[r];
+  }
+  return q->nof_re;
+}
+
+/* Extracts the same RE from nof_buffers grids (e.g. the received signal and the
+ * channel estimates of every port) in a single pass over the map.
+ * Returns the number of symbols written to each output buffer.
+ */
+int re_map_get_multi(re_map_t *q, cf_t **grid, cf_t **symbols, uint32_t nof_buffers) {
+  uint32_t r, j, b, n;
+  cf_t *in, *out;
+
+  n = 0;
+  for (r = 0; r < q->nof_runs; r++) {
+    for (b = 0; b < nof_buffers; b++) {
+      in = &grid[b][q->run_start[r]];
+      out = &symbols[b][n];
+      if (q->run_len[r] < RE_MAP_SHORT_RUN) {
+        for (j = 0; j < q->run_len[r]; j++) {
+          out[j] = in[j];
+        }
+      } else {
+        memcpy(out, in, sizeof(cf_t) * q->run_len[r]);
+      }
+    }
+    n += q->run_len[r];
+  }
+  return n;
+}
@@ -38,22 +38,14 @@
 
 
 regs_reg_t *regs_find_reg(regs_t *h, uint32_t k, uint32_t l);
-int regs_put_reg(regs_reg_t *reg, 
-                            cf_t *reg_data, 
-                            cf_t *slot_symbols, 
-                            uint32_t nof_prb);
 
-int regs_add_reg(regs_reg_t *reg, 
-                            cf_t *reg_data, 
-                            cf_t *slot_symbols, 
-                            uint32_t nof_prb);
+static int regs_ch_idx_init(regs_t *h, regs_ch_t *ch);
 
-int regs_get_reg(regs_reg_t *reg, 
-                            cf_t *slot_symbols, 
-                            cf_t *reg_data, 
-                            uint32_t nof_prb);
-
-int regs_reset_reg(regs_reg_t *reg, cf_t *slot_symbols, uint32_t nof_prb);
+static void regs_gather(uint32_t *re_idx, 
+                        uint32_t nof_re, 
+                        cf_t **slot_symbols, 
+                        cf_t **symbols, 
+                        uint32_t nof_buffers);
 
 
 /***************************************************************
@@ -68,6 +60,9 @@ void regs_pdcch_free(regs_t *h) {
     if (h->pdcch[i].regs) {
       free(h->pdcch[i].regs);
     }
+    if (h->pdcch[i].re_idx) {
+      free(h->pdcch[i].re_idx);
+    }
   }
 }
 
@@ -143,6 +138,10 @@ int regs_pdcch_init(regs_t *h) {
     h->pdcch[cfi].nof_regs = (h->pdcch[cfi].nof_regs/9)*9;
     free(tmp);
     tmp = NULL;
+    
+    if (regs_ch_idx_init(h, &h->pdcch[cfi])) {
+      goto clean_and_exit;
+    }
   }
 
   ret = LIBLTE_SUCCESS;
@@ -171,16 +170,16 @@ int regs_pdcch_nregs(regs_t *h, uint32_t cfi) {
 
 int regs_pdcch_put_offset(regs_t *h, cf_t *pdcch_symbols, cf_t *slot_symbols, uint32_t start_reg, uint32_t nof_regs) {
   if (h->cfi_initiated) {
-    if (start_reg + nof_regs <= h->pdcch[h->cfi].nof_regs) {
+    if (start_reg + nof_regs <= h->pdcch_cur->nof_regs) {
       uint32_t i, k;
-      k = 0;
-      for (i=start_reg;i<start_reg+nof_regs;i++) {
-        regs_put_reg(h->pdcch[h->cfi].regs[i], &pdcch_symbols[k], slot_symbols, h->cell.nof_prb);
-        k += 4;
+      uint32_t *re_idx = &h->pdcch_cur->re_idx[start_reg * REGS_RE_X_REG];
+      k = nof_regs * REGS_RE_X_REG;
+      for (i=0;i<k;i++) {
+        slot_symbols[re_idx[i]] = pdcch_symbols[i];
       }
       return k;      
     } else {
-      fprintf(stderr, "Out of range: start_reg + nof_reg must be lower than %d\n", h->pdcch[h->cfi].nof_regs);
+      fprintf(stderr, "Out of range: start_reg + nof_reg must be lower than %d\n", h->pdcch_cur->nof_regs);
       return LIBLTE_ERROR;      
     }       
   } else {
@@ -193,18 +192,18 @@ int regs_pdcch_put(regs_t *h, cf_t *pdcch_symbols, cf_t *slot_symbols) {
   return regs_pdcch_put_offset(h, pdcch_symbols, slot_symbols, 0, h->pdcch[h->cfi].nof_regs);
 }
 
-int regs_pdcch_get_offset(regs_t *h, cf_t *slot_symbols, cf_t *pdcch_symbols, uint32_t start_reg, uint32_t nof_regs) {
+/** Extracts the same REGs from nof_buffers grids (e.g. received symbols and the 
+ * channel estimates of each port) using the index table of the current CFI.
+ */
+int regs_pdcch_get_offset_multi(regs_t *h, cf_t **slot_symbols, cf_t **pdcch_symbols, 
+                                uint32_t start_reg, uint32_t nof_regs, uint32_t nof_buffers) {
   if (h->cfi_initiated) {
-    if (start_reg + nof_regs <= h->pdcch[h->cfi].nof_regs) {
-      uint32_t i, k;  
-      k = 0;
-      for (i=start_reg;i<start_reg + nof_regs;i++) {
-        regs_get_reg(h->pdcch[h->cfi].regs[i], slot_symbols, &pdcch_symbols[k], h->cell.nof_prb);
-        k += 4;
-      }
-      return k;    
+    if (start_reg + nof_regs <= h->pdcch_cur->nof_regs) {
+      regs_gather(&h->pdcch_cur->re_idx[start_reg * REGS_RE_X_REG], nof_regs * REGS_RE_X_REG, 
+                  slot_symbols, pdcch_symbols, nof_buffers);
+      return nof_regs * REGS_RE_X_REG;
     } else {
-      fprintf(stderr, "Out of range: start_reg + nof_reg must be lower than %d\n", h->pdcch[h->cfi].nof_regs);
+      fprintf(stderr, "Out of range: start_reg + nof_reg must be lower than %d\n", h->pdcch_cur->nof_regs);
       return LIBLTE_ERROR;
     }
   } else {
@@ -213,6 +212,10 @@ int regs_pdcch_get_offset(regs_t *h, cf_t *slot_symbols, cf_t *pdcch_symbols, ui
   }
 }
 
+int regs_pdcch_get_offset(regs_t *h, cf_t *slot_symbols, cf_t *pdcch_symbols, uint32_t start_reg, uint32_t nof_regs) {
+  return regs_pdcch_get_offset_multi(h, &slot_symbols, &pdcch_symbols, start_reg, nof_regs, 1);
+}
+
 
 int regs_pdcch_get(regs_t *h, cf_t *slot_symbols, cf_t *pdcch_symbols) {
  return regs_pdcch_get_offset(h, slot_symbols, pdcch_symbols, 0, h->pdcch[h->cfi].nof_regs);
@@ -308,6 +311,9 @@ int regs_phich_init(regs_t *h) {
       INFO("Assigned PHICH REG#%d (%d,%d)\n",nreg,h->phich[mi].regs[i]->k0,li);
       nreg++;
     }
+    if (regs_ch_idx_init(h, &h->phich[mi])) {
+      goto clean_and_exit;
+    }
   }
 
   // now the number of mapping units = number of groups for normal cp. For extended cp
@@ -324,6 +330,9 @@ clean_and_exit:
         if (h->phich[i].regs) {
           free(h->phich[i].regs);
         }
+        if (h->phich[i].re_idx) {
+          free(h->phich[i].re_idx);
+        }
       }
       free(h->phich);
     }
@@ -346,6 +355,9 @@ void regs_phich_free(regs_t *h) {
       if (h->phich[i].regs) {
         free(h->phich[i].regs);
       }
+      if (h->phich[i].re_idx) {
+        free(h->phich[i].re_idx);
+      }
     }
     free(h->phich);
   }
@@ -374,7 +386,7 @@ uint32_t regs_phich_ngroups(regs_t *h) {
  * Returns the number of written symbols, or -1 on error
  */
 int regs_phich_add(regs_t *h, cf_t phich_symbols[REGS_PHICH_NSYM], uint32_t ngroup, cf_t *slot_symbols) {
-  uint32_t i;
+  uint32_t i, n;
   if (ngroup >= h->ngroups_phich) {
     fprintf(stderr, "Error invalid ngroup %d\n", ngroup);
     return LIBLTE_ERROR_INVALID_INPUTS;
@@ -383,10 +395,11 @@ int regs_phich_add(regs_t *h, cf_t phich_symbols[REGS_PHICH_NSYM], uint32_t ngro
     ngroup /= 2;
   }
   regs_ch_t *rch = &h->phich[ngroup];
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PHICH_NSYM; i++) {
-    regs_add_reg(rch->regs[i], &phich_symbols[i*REGS_RE_X_REG], slot_symbols, h->cell.nof_prb);
+  n = REGS_PHICH_NSYM < rch->nof_regs * REGS_RE_X_REG ? REGS_PHICH_NSYM : rch->nof_regs * REGS_RE_X_REG;
+  for (i = 0; i < n; i++) {
+    slot_symbols[rch->re_idx[i]] += phich_symbols[i];
   }
-  return i*REGS_RE_X_REG;
+  return n;
 }
 
 /**
@@ -404,20 +417,22 @@ int regs_phich_reset(regs_t *h, cf_t *slot_symbols) {
       ng = ngroup;
     }
     regs_ch_t *rch = &h->phich[ng];
-    for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PHICH_NSYM; i++) {
-      regs_reset_reg(rch->regs[i], slot_symbols, h->cell.nof_prb);
+    for (i = 0; i < rch->nof_regs * REGS_RE_X_REG && i < REGS_PHICH_NSYM; i++) {
+      slot_symbols[rch->re_idx[i]] = 0;
     }
   }
   return LIBLTE_SUCCESS;
 }
 
 /**
- * Gets the PHICH symbols from the resource grid pointed by slot_symbols
+ * Gets the PHICH symbols from nof_buffers resource grids (e.g. the received symbols 
+ * and the channel estimates of each port) in a single pass over the group index table
  *
- * Returns the number of written symbols, or -1 on error
+ * Returns the number of symbols written to each buffer, or -1 on error
  */
-int regs_phich_get(regs_t *h, cf_t *slot_symbols, cf_t phich_symbols[REGS_PHICH_NSYM], uint32_t ngroup) {
-  uint32_t i;
+int regs_phich_get_multi(regs_t *h, cf_t **slot_symbols, cf_t **phich_symbols, uint32_t ngroup, 
+                         uint32_t nof_buffers) {
+  uint32_t n;
   if (ngroup >= h->ngroups_phich) {
     fprintf(stderr, "Error invalid ngroup %d\n", ngroup);
     return LIBLTE_ERROR_INVALID_INPUTS;
@@ -426,10 +441,19 @@ int regs_phich_get(regs_t *h, cf_t *slot_symbols, cf_t phich_symbols[REGS_PHICH_
     ngroup /= 2;
   }
   regs_ch_t *rch = &h->phich[ngroup];
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PHICH_NSYM; i++) {
-    regs_get_reg(rch->regs[i], slot_symbols, &phich_symbols[i*REGS_RE_X_REG], h->cell.nof_prb);
-  }
-  return i*REGS_RE_X_REG;
+  n = REGS_PHICH_NSYM < rch->nof_regs * REGS_RE_X_REG ? REGS_PHICH_NSYM : rch->nof_regs * REGS_RE_X_REG;
+  regs_gather(rch->re_idx, n, slot_symbols, phich_symbols, nof_buffers);
+  return n;
+}
+
+/**
+ * Gets the PHICH symbols from the resource grid pointed by slot_symbols
+ *
+ * Returns the number of written symbols, or -1 on error
+ */
+int regs_phich_get(regs_t *h, cf_t *slot_symbols, cf_t phich_symbols[REGS_PHICH_NSYM], uint32_t ngroup) {
+  cf_t *out = phich_symbols;
+  return regs_phich_get_multi(h, &slot_symbols, &out, ngroup, 1);
 }
 
 
@@ -485,13 +509,16 @@ int regs_pcfich_init(regs_t *h) {
       INFO("Assigned PCFICH REG#%d (%d,0)\n", i, k);
     }
   }
-  return LIBLTE_SUCCESS;
+  return regs_ch_idx_init(h, ch);
 }
 
 void regs_pcfich_free(regs_t *h) {
   if (h->pcfich.regs) {
     free(h->pcfich.regs);
   }
+  if (h->pcfich.re_idx) {
+    free(h->pcfich.re_idx);
+  }
 }
 
 uint32_t regs_pcfich_nregs(regs_t *h) {
@@ -507,10 +534,24 @@ int regs_pcfich_put(regs_t *h, cf_t pcfich_symbols[REGS_PCFICH_NSYM], cf_t *slot
   regs_ch_t *rch = &h->pcfich;
 
   uint32_t i;
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PCFICH_NSYM; i++) {
-    regs_put_reg(rch->regs[i], &pcfich_symbols[i*REGS_RE_X_REG], slot_symbols, h->cell.nof_prb);
+  for (i = 0; i < rch->nof_regs * REGS_RE_X_REG && i < REGS_PCFICH_NSYM; i++) {
+    slot_symbols[rch->re_idx[i]] = pcfich_symbols[i];
   }
-  return i*REGS_RE_X_REG;
+  return i;
+}
+
+/**
+ * Gets the PCFICH symbols from nof_buffers resource grids (e.g. the received symbols
+ * and the channel estimates of each port) in a single pass over the index table
+ *
+ * Returns the number of symbols written to each buffer, or -1 on error
+ */
+int regs_pcfich_get_multi(regs_t *h, cf_t **slot_symbols, cf_t **ch_data, uint32_t nof_buffers) {
+  regs_ch_t *rch = &h->pcfich;
+  uint32_t n;
+  n = REGS_PCFICH_NSYM < rch->nof_regs * REGS_RE_X_REG ? REGS_PCFICH_NSYM : rch->nof_regs * REGS_RE_X_REG;
+  regs_gather(rch->re_idx, n, slot_symbols, ch_data, nof_buffers);
+  return n;
 }
 
 /**
@@ -519,12 +560,8 @@ int regs_pcfich_put(regs_t *h, cf_t pcfich_symbols[REGS_PCFICH_NSYM], cf_t *slot
  * Returns the number of written symbols, or -1 on error
  */
 int regs_pcfich_get(regs_t *h, cf_t *slot_symbols, cf_t ch_data[REGS_PCFICH_NSYM]) {
-  regs_ch_t *rch = &h->pcfich;
-  uint32_t i;
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PCFICH_NSYM; i++) {
-    regs_get_reg(rch->regs[i], slot_symbols, &ch_data[i*REGS_RE_X_REG], h->cell.nof_prb);
-  }
-  return i*REGS_RE_X_REG;
+  cf_t *out = ch_data;
+  return regs_pcfich_get_multi(h, &slot_symbols, &out, 1);
 }
 
 
@@ -659,6 +696,7 @@ int regs_set_cfi(regs_t *h, uint32_t cfi) {
     } else {
       h->cfi_initiated = true;
       h->cfi = cfi - 1;
+      h->pdcch_cur = &h->pdcch[h->cfi];
       return LIBLTE_SUCCESS;
     }
   } else {
@@ -759,49 +797,37 @@ clean_and_exit:
 }
 
 /**
- * Puts one REG data (4 symbols) in the slot symbols array
- */
-int regs_put_reg(regs_reg_t *reg, cf_t *reg_data, cf_t *slot_symbols, uint32_t nof_prb) {
-  uint32_t i;
-  for (i = 0; i < REGS_RE_X_REG; i++) {
-    slot_symbols[REG_IDX(reg, i, nof_prb)] = reg_data[i];
-  }
-  return REGS_RE_X_REG;
-}
-
-/**
- * Adds one REG data (4 symbols) in the slot symbols array
- * Used by PHICH
+ * Computes the flat table with the slot index of every RE of the channel REGs, 
+ * in the order they are mapped.
  */
-int regs_add_reg(regs_reg_t *reg, cf_t *reg_data, cf_t *slot_symbols, uint32_t nof_prb) {
-  uint32_t i;
-  for (i = 0; i < REGS_RE_X_REG; i++) {
-    slot_symbols[REG_IDX(reg, i, nof_prb)] += reg_data[i];
+static int regs_ch_idx_init(regs_t *h, regs_ch_t *ch) {
+  uint32_t i, j;
+  ch->re_idx = malloc(sizeof(uint32_t) * REGS_RE_X_REG * (ch->nof_regs > 0 ? ch->nof_regs : 1));
+  if (!ch->re_idx) {
+    perror("malloc");
+    return LIBLTE_ERROR;
   }
-  return REGS_RE_X_REG;
-}
-
-
-/**
- * Reset REG data (4 symbols) in the slot symbols array
- */
-int regs_reset_reg(regs_reg_t *reg, cf_t *slot_symbols, uint32_t nof_prb) {
-  uint32_t i;
-  for (i = 0; i < REGS_RE_X_REG; i++) {
-    slot_symbols[REG_IDX(reg, i, nof_prb)] = 0;
+  for (i = 0; i < ch->nof_regs; i++) {
+    for (j = 0; j < REGS_RE_X_REG; j++) {
+      ch->re_idx[i * REGS_RE_X_REG + j] = REG_IDX(ch->regs[i], j, h->cell.nof_prb);
+    }
   }
-  return REGS_RE_X_REG;
+  return LIBLTE_SUCCESS;
 }
 
 /**
- * Gets one REG data (4 symbols) from the slot symbols array
+ * Copies the RE given by the index table from each of the nof_buffers slot grids 
+ * to the corresponding output buffer
  */
-int regs_get_reg(regs_reg_t *reg, cf_t *slot_symbols, cf_t *reg_data, uint32_t nof_prb) {
-  uint32_t i;
-  for (i = 0; i < REGS_RE_X_REG; i++) {
-    reg_data[i] = slot_symbols[REG_IDX(reg, i, nof_prb)];
+static void regs_gather(uint32_t *re_idx, uint32_t nof_re, cf_t **slot_symbols, cf_t **symbols, 
+                        uint32_t nof_buffers) {
+  uint32_t i, b;
+  for (b = 0; b < nof_buffers; b++) {
+    cf_t *in = slot_symbols[b];
+    cf_t *out = symbols[b];
+    for (i = 0; i < nof_re; i++) {
+      out[i] = in[re_idx[i]];
+    }
   }
-  return REGS_RE_X_REG;
 }
 
-
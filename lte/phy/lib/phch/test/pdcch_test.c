@@ -41,6 +41,9 @@ lte_cell_t cell = {
 };
 
 uint32_t cfi = 1;
+float reliability_threshold = 0;
+
+#define NOF_NOISE_FRAMES  200
 
 void usage(char *prog) {
   printf("Usage: %s [cell.cpv]\n", prog);
@@ -48,12 +51,14 @@ void usage(char *prog) {
   printf("\t-f cfi [Default %d]\n", cfi);
   printf("\t-p cell.nof_ports [Default %d]\n", cell.nof_ports);
   printf("\t-n cell.nof_prb [Default %d]\n", cell.nof_prb);
+  printf("\t-r reliability threshold, also checks noise rejection [Default %.1f]\n", 
+         reliability_threshold);
   printf("\t-v [set verbose to debug, default none]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "cell.cpnfv")) != -1) {
+  while ((opt = getopt(argc, argv, "cell.cpnfrv")) != -1) {
     switch (opt) {
     case 'p':
       cell.nof_ports = atoi(argv[optind]);
@@ -67,6 +72,9 @@ void parse_args(int argc, char **argv) {
     case 'c':
       cell.id = atoi(argv[optind]);
       break;
+    case 'r':
+      reliability_threshold = atof(argv[optind]);
+      break;
     case 'v':
       verbose++;
       break;
@@ -103,6 +111,33 @@ int test_dci_payload_size() {
   return 0;
 }
 
+/* Decodes candidates of subframes with only noise and checks that most of them
+ * are rejected by the reliability threshold 
+ */
+int test_noise_rejection(pdcch_t *pdcch, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], 
+                         dci_location_t location, int nof_re) {
+  dci_msg_t dci_tmp;
+  uint16_t crc_rem;
+  int i;
+
+  pdcch_set_reliability_threshold(pdcch, reliability_threshold);
+  for (i = 0; i < NOF_NOISE_FRAMES; i++) {
+    bzero(sf_symbols, sizeof(cf_t) * nof_re);
+    ch_awgn_c(sf_symbols, sf_symbols, 1.0, nof_re);
+    if (pdcch_extract_llr(pdcch, sf_symbols, ce, location, 0, cfi)) {
+      fprintf(stderr, "Error extracting LLRs\n");
+      return -1;
+    }
+    if (pdcch_decode_msg(pdcch, &dci_tmp, Format1, &crc_rem)) {
+      fprintf(stderr, "Error decoding DCI message\n");
+      return -1;
+    }
+  }
+  printf("Rejected %d/%d noise candidates with reliability threshold %.2f\n",
+         pdcch->nof_rejected, NOF_NOISE_FRAMES, reliability_threshold);
+  return pdcch->nof_rejected < NOF_NOISE_FRAMES * 3 / 4 ? -1 : 0;
+}
+
 int main(int argc, char **argv) {
   pdcch_t pdcch;
   dci_msg_t dci_tx[2], dci_rx[2], dci_tmp;
@@ -156,6 +191,10 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Error creating PDCCH object\n");
     exit(-1);
   }
+  if (pdcch_set_reliability_threshold(&pdcch, reliability_threshold)) {
+    fprintf(stderr, "Error setting reliability threshold\n");
+    exit(-1);
+  }
 
   nof_dcis = 2;
   bzero(&ra_dl, sizeof(ra_pdsch_t));
@@ -197,6 +236,10 @@ int main(int argc, char **argv) {
       fprintf(stderr, "Error decoding DCI message\n");
       goto quit;
     }      
+    if (pdcch_get_reliability(&pdcch) <= 0) {
+      printf("Reliability of DCI %d not computed\n", i);
+      goto quit;
+    }
     if (crc_rem >= 1234 && crc_rem < 1234 + nof_dcis) {
       crc_rem -= 1234;
         memcpy(&dci_rx[crc_rem], &dci_tmp, sizeof(dci_msg_t));
@@ -211,6 +254,11 @@ int main(int argc, char **argv) {
       goto quit;
     }
   }
+  if (reliability_threshold > 0) {
+    if (test_noise_rejection(&pdcch, slot_symbols[0], ce, dci_locations[0], nof_re)) {
+      goto quit;
+    }
+  }
   ret = 0;
 
 quit: 
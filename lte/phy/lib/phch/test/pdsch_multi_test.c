@@ -0,0 +1,312 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <complex.h>
+
+#include "liblte/phy/phy.h"
+
+/* Splits the cell between nof_users users, encodes their PDSCH with
+ * pdsch_multi_encode() and checks that the grid is identical to the one
+ * obtained encoding them one by one with pdsch_encode() and that every
+ * transport block is decoded. Then checks that a subframe with overlapping
+ * grants is rejected without modifying the HARQ processes.
+ */
+
+lte_cell_t cell = {
+  100,          // nof_prb
+  1,            // nof_ports
+  1,            // cell_id
+  CPNORM        // cyclic prefix
+};
+
+uint32_t cfi = 2;
+uint32_t subframe = 1;
+uint32_t mcs_idx = 16;
+uint32_t nof_users = 8;
+uint32_t nof_threads = 4;
+uint32_t nof_frames = 10;
+
+void usage(char *prog) {
+  printf("Usage: %s [npcsmutf]\n", prog);
+  printf("\t-n cell.nof_prb [Default %d]\n", cell.nof_prb);
+  printf("\t-p cell.nof_ports [Default %d]\n", cell.nof_ports);
+  printf("\t-c cell id [Default %d]\n", cell.id);
+  printf("\t-s subframe [Default %d]\n", subframe);
+  printf("\t-m MCS index [Default %d]\n", mcs_idx);
+  printf("\t-u number of users [Default %d]\n", nof_users);
+  printf("\t-t number of threads [Default %d]\n", nof_threads);
+  printf("\t-f number of subframes to measure the encoding time [Default %d]\n", nof_frames);
+  printf("\t-v [set verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "npcsmutfv")) != -1) {
+    switch(opt) {
+    case 'n':
+      cell.nof_prb = atoi(argv[optind]);
+      break;
+    case 'p':
+      cell.nof_ports = atoi(argv[optind]);
+      break;
+    case 'c':
+      cell.id = atoi(argv[optind]);
+      break;
+    case 's':
+      subframe = atoi(argv[optind]);
+      break;
+    case 'm':
+      mcs_idx = atoi(argv[optind]);
+      break;
+    case 'u':
+      nof_users = atoi(argv[optind]);
+      break;
+    case 't':
+      nof_threads = atoi(argv[optind]);
+      break;
+    case 'f':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  pdsch_multi_t pdsch_multi;
+  pdsch_t pdsch;
+  ra_pdsch_t *ra_dl = NULL;
+  pdsch_harq_t *harq = NULL;
+  pdsch_grant_t *grants = NULL;
+  char *data_rx = NULL;
+  cf_t *sf_symbols[MAX_PORTS], *sf_symbols_ref[MAX_PORTS], *ce[MAX_PORTS];
+  uint32_t i, j, u, nof_re, nof_rbg, P, total_bits;
+  struct timeval t[3];
+  int ret = -1;
+
+  parse_args(argc, argv);
+
+  bzero(sf_symbols, sizeof(cf_t*) * MAX_PORTS);
+  bzero(sf_symbols_ref, sizeof(cf_t*) * MAX_PORTS);
+  bzero(ce, sizeof(cf_t*) * MAX_PORTS);
+  bzero(&pdsch, sizeof(pdsch_t));
+  bzero(&pdsch_multi, sizeof(pdsch_multi_t));
+
+  P = ra_type0_P(cell.nof_prb);
+  nof_rbg = (cell.nof_prb + P - 1) / P;
+  if (nof_users == 0 || nof_users > nof_rbg) {
+    fprintf(stderr, "Number of users must be between 1 and %d\n", nof_rbg);
+    exit(-1);
+  }
+
+  nof_re = SF_LEN_RE(cell.nof_prb, cell.cp);
+  for (i = 0; i < cell.nof_ports; i++) {
+    sf_symbols[i] = calloc(sizeof(cf_t), nof_re);
+    sf_symbols_ref[i] = calloc(sizeof(cf_t), nof_re);
+    ce[i] = malloc(sizeof(cf_t) * nof_re);
+    if (!sf_symbols[i] || !sf_symbols_ref[i] || !ce[i]) {
+      perror("malloc");
+      goto quit;
+    }
+    for (j = 0; j < nof_re; j++) {
+      ce[i][j] = 1;
+    }
+  }
+
+  if (pdsch_init(&pdsch, cell)) {
+    fprintf(stderr, "Error creating PDSCH object\n");
+    goto quit;
+  }
+  if (pdsch_multi_init(&pdsch_multi, cell, nof_threads)) {
+    fprintf(stderr, "Error creating multi-user PDSCH object\n");
+    goto quit;
+  }
+
+  ra_dl = calloc(sizeof(ra_pdsch_t), nof_users);
+  harq = calloc(sizeof(pdsch_harq_t), nof_users);
+  grants = calloc(sizeof(pdsch_grant_t), nof_users);
+  data_rx = malloc(sizeof(char) * MAX_PRB * RE_X_RB * CPNORM_NSYMB * 2 * 6);
+  if (!ra_dl || !harq || !grants || !data_rx) {
+    perror("malloc");
+    goto quit;
+  }
+
+  /* Each user gets a contiguous block of RBGs */
+  total_bits = 0;
+  for (u = 0; u < nof_users; u++) {
+    ra_dl[u].rnti = 1000 + u;
+    ra_dl[u].mcs_idx = mcs_idx;
+    ra_dl[u].alloc_type = alloc_type0;
+    for (i = u * nof_rbg / nof_users; i < (u + 1) * nof_rbg / nof_users; i++) {
+      ra_dl[u].type0_alloc.rbg_bitmask |= 1 << (nof_rbg - i - 1);
+    }
+    if (ra_prb_get_dl(&ra_dl[u].prb_alloc, &ra_dl[u], cell.nof_prb)) {
+      fprintf(stderr, "Error computing resource allocation\n");
+      goto quit;
+    }
+    ra_prb_get_re_dl(&ra_dl[u].prb_alloc, cell.nof_prb, cell.nof_ports,
+        cell.nof_prb < 10 ? (cfi + 1) : cfi, cell.cp);
+    if (ra_mcs_from_idx_dl(mcs_idx, ra_dl[u].prb_alloc.slot[0].nof_prb, &ra_dl[u].mcs)) {
+      fprintf(stderr, "Error computing MCS\n");
+      goto quit;
+    }
+    if (pdsch_harq_init(&harq[u], &pdsch)) {
+      fprintf(stderr, "Error initiating HARQ process\n");
+      goto quit;
+    }
+    grants[u].ra_dl = &ra_dl[u];
+    grants[u].harq_process = &harq[u];
+    grants[u].data = malloc(sizeof(char) * ra_dl[u].mcs.tbs);
+    if (!grants[u].data) {
+      perror("malloc");
+      goto quit;
+    }
+    for (i = 0; i < ra_dl[u].mcs.tbs; i++) {
+      grants[u].data[i] = rand() % 2;
+    }
+    total_bits += ra_dl[u].mcs.tbs;
+    INFO("User %d: RNTI 0x%x, %d PRB, TBS %d\n", u, ra_dl[u].rnti,
+        ra_dl[u].prb_alloc.slot[0].nof_prb, ra_dl[u].mcs.tbs);
+  }
+
+  if (pdsch_multi_encode(&pdsch_multi, grants, nof_users, sf_symbols, subframe)) {
+    fprintf(stderr, "Error encoding PDSCH\n");
+    goto quit;
+  }
+
+  /* Reference: one user at a time */
+  for (u = 0; u < nof_users; u++) {
+    pdsch_set_rnti(&pdsch, ra_dl[u].rnti);
+    if (pdsch_encode(&pdsch, grants[u].data, sf_symbols_ref, subframe, &harq[u], 0)) {
+      fprintf(stderr, "Error encoding PDSCH of user %d\n", u);
+      goto quit;
+    }
+  }
+  for (i = 0; i < cell.nof_ports; i++) {
+    if (memcmp(sf_symbols[i], sf_symbols_ref[i], sizeof(cf_t) * nof_re)) {
+      fprintf(stderr, "Grid of port %d differs from the single-user encoder\n", i);
+      goto quit;
+    }
+  }
+
+  /* combine ports and decode every user */
+  for (i = 1; i < cell.nof_ports; i++) {
+    for (j = 0; j < nof_re; j++) {
+      sf_symbols_ref[0][j] += sf_symbols_ref[i][j];
+    }
+  }
+  for (u = 0; u < nof_users; u++) {
+    pdsch_set_rnti(&pdsch, ra_dl[u].rnti);
+    if (pdsch_decode(&pdsch, sf_symbols_ref[0], ce, data_rx, subframe, &harq[u], 0) ||
+        memcmp(data_rx, grants[u].data, ra_dl[u].mcs.tbs)) {
+      fprintf(stderr, "Error decoding PDSCH of user %d\n", u);
+      goto quit;
+    }
+  }
+
+  gettimeofday(&t[1], NULL);
+  for (i = 0; i < nof_frames; i++) {
+    if (pdsch_multi_encode(&pdsch_multi, grants, nof_users, sf_symbols, subframe)) {
+      fprintf(stderr, "Error encoding PDSCH\n");
+      goto quit;
+    }
+  }
+  gettimeofday(&t[2], NULL);
+  get_time_interval(t);
+  printf("%d users, %d threads: %d bits per subframe encoded in %.1f us (%.2f Mbps)\n",
+      nof_users, nof_threads, total_bits,
+      (float) (t[0].tv_sec * 1e6 + t[0].tv_usec) / nof_frames,
+      (float) total_bits * nof_frames / (t[0].tv_sec * 1e6 + t[0].tv_usec));
+
+  /* the last user overlaps the first one, that has a new transport block */
+  if (nof_users > 1) {
+    ra_dl[0].mcs.tbs -= 8;
+    memcpy(&ra_dl[nof_users - 1].prb_alloc, &ra_dl[0].prb_alloc, sizeof(ra_prb_t));
+    if (pdsch_multi_encode(&pdsch_multi, grants, nof_users, sf_symbols, subframe) !=
+        LIBLTE_ERROR_INVALID_INPUTS) {
+      fprintf(stderr, "Overlapping grants were not rejected\n");
+      goto quit;
+    }
+    if (harq[0].mcs.tbs != ra_dl[0].mcs.tbs + 8) {
+      fprintf(stderr, "Rejected grants modified the HARQ process of user 0\n");
+      goto quit;
+    }
+  }
+
+  ret = 0;
+quit:
+  pdsch_free(&pdsch);
+  pdsch_multi_free(&pdsch_multi);
+  for (u = 0; u < nof_users; u++) {
+    if (harq) {
+      pdsch_harq_free(&harq[u]);
+    }
+    if (grants && grants[u].data) {
+      free(grants[u].data);
+    }
+  }
+  if (ra_dl) {
+    free(ra_dl);
+  }
+  if (harq) {
+    free(harq);
+  }
+  if (grants) {
+    free(grants);
+  }
+  if (data_rx) {
+    free(data_rx);
+  }
+  for (i = 0; i < cell.nof_ports; i++) {
+    if (sf_symbols[i]) {
+      free(sf_symbols[i]);
+    }
+    if (sf_symbols_ref[i]) {
+      free(sf_symbols_ref[i]);
+    }
+    if (ce[i]) {
+      free(ce[i]);
+    }
+  }
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
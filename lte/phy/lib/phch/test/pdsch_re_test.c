@@ -54,7 +54,27 @@ const int test_re_num[N_TESTS][3] = {
     {1200, 1416, 1560}
 };
 
-cf_t in[200000], out[200000];
+cf_t in[200000], out[200000], grid[200000];
+
+/* Checks that putting the extracted symbols back writes exactly the RE they were read from */
+bool check_put_get(pdsch_t *pdsch, ra_prb_t *prb_alloc, uint32_t sf, int nof_re) {
+  int k, n, len;
+  len = SF_LEN_RE(pdsch->cell.nof_prb, pdsch->cell.cp);
+  bzero(grid, sizeof(cf_t) * len);
+  if (pdsch_put(pdsch, out, grid, prb_alloc, sf) != nof_re) {
+    return false;
+  }
+  n = 0;
+  for (k = 0; k < len; k++) {
+    if (grid[k] != 0) {
+      if (grid[k] != in[k]) {
+        return false;
+      }
+      n++;
+    }
+  }
+  return n == nof_re;
+}
 
 int main(int argc, char **argv) {
   int i, n, np, r;
@@ -67,6 +87,9 @@ int main(int argc, char **argv) {
     verbose++;
   }
 
+  for (i=0;i<200000;i++) {
+    in[i] = i + 1;
+  }
   for (i=0;i<110;i++) {
     prb_alloc.slot[0].prb_idx[i] = i;
     prb_alloc.slot[1].prb_idx[i] = i;
@@ -105,6 +128,10 @@ int main(int argc, char **argv) {
       if (r != prb_alloc.re_sf[n]) {
         goto go_out;
       }
+      if (!check_put_get(&pdsch, &prb_alloc, n, r)) {
+        printf("Put/get mismatch\n");
+        goto go_out;
+      }
     }
     pdsch_free(&pdsch);
   }
@@ -31,6 +31,8 @@
 #include <strings.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <math.h>
+#include <complex.h>
 
 #include "liblte/phy/phy.h"
 
@@ -46,9 +48,13 @@ uint32_t tbs = 0;
 uint32_t subframe = 1;
 lte_mod_t modulation = LTE_BPSK;
 uint32_t rv_idx = 0;
+float snr_db = 100.0;
+uint32_t nof_frames = 1;
+float max_bler = 1.0;
+pdsch_stop_policy_t stop_policy = PDSCH_STOP_CRC;
 
 void usage(char *prog) {
-  printf("Usage: %s [cpsrnfvmt] -l TBS \n", prog);
+  printf("Usage: %s [cpsrnfvmtbeo] -l TBS \n", prog);
   printf("\t-m modulation (1: BPSK, 2: QPSK, 3: QAM16, 4: QAM64) [Default BPSK]\n");
   printf("\t-c cell id [Default %d]\n", cell.id);
   printf("\t-s subframe [Default %d]\n", subframe);
@@ -56,12 +62,16 @@ void usage(char *prog) {
   printf("\t-f cfi [Default %d]\n", cfi);
   printf("\t-p cell.nof_ports [Default %d]\n", cell.nof_ports);
   printf("\t-n cell.nof_prb [Default %d]\n", cell.nof_prb);
+  printf("\t-e SNR in dB. Enables a fading channel and compares the ZF and MMSE detectors [Default none]\n");
+  printf("\t-t nof_frames for the fading channel [Default %d]\n", nof_frames);
+  printf("\t-b maximum BLER of the MMSE detector in the fading channel [Default %.1f]\n", max_bler);
+  printf("\t-o turbo early stopping (0: CRC, 1: HDA/SCR, 2: HDA/SCR then CRC) [Default %d]\n", stop_policy);
   printf("\t-v [set verbose to debug, default none]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "lcpnfvmtsr")) != -1) {
+  while ((opt = getopt(argc, argv, "lcpnfvmtbsreo")) != -1) {
     switch(opt) {
     case 'm':
       switch(atoi(argv[optind])) {
@@ -101,6 +111,18 @@ void parse_args(int argc, char **argv) {
     case 'c':
       cell.id = atoi(argv[optind]);
       break;
+    case 'e':
+      snr_db = atof(argv[optind]);
+      break;
+    case 't':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 'b':
+      max_bler = atof(argv[optind]);
+      break;
+    case 'o':
+      stop_policy = (pdsch_stop_policy_t) atoi(argv[optind]);
+      break;
     case 'v':
       verbose++;
       break;
@@ -115,6 +137,270 @@ void parse_args(int argc, char **argv) {
   }
 }
 
+/* Early stopping with hard decision agreement or less than 0.5% of sign changes */
+int set_early_stop(pdsch_t *q) {
+  tdec_stop_t stop;
+  bzero(&stop, sizeof(tdec_stop_t));
+  stop.criteria = TDEC_STOP_HDA | TDEC_STOP_SCR;
+  stop.scr = 0.005;
+  return pdsch_set_early_stop(q, stop_policy, &stop);
+}
+
+/* Runs TDEC_MAX_ITERATIONS iterations on every CB: the minimum LLR criterion 
+ * is never met and the CRC is not checked */
+int set_fixed_iterations(pdsch_t *q) {
+  tdec_stop_t stop;
+  bzero(&stop, sizeof(tdec_stop_t));
+  stop.criteria = TDEC_STOP_MIN_LLR;
+  stop.min_llr = INFINITY;
+  return pdsch_set_early_stop(q, PDSCH_STOP_DECODER, &stop);
+}
+
+float mean_iterations(pdsch_t *q) {
+  pdsch_stop_stats_t stats;
+  pdsch_stop_stats(q, &stats);
+  return stats.nof_cb ? (float) stats.nof_iterations / stats.nof_cb : 0;
+}
+
+void print_stop_stats(char *name, pdsch_t *q) {
+  pdsch_stop_stats_t stats;
+  pdsch_stop_stats(q, &stats);
+  printf("%s CBs: %lu, iterations: %.2f, CRC checks: %lu, stopped by CRC: %lu, "
+         "by decoder: %lu, at max iterations: %lu\n", name, stats.nof_cb, 
+         stats.nof_cb ? (float) stats.nof_iterations / stats.nof_cb : 0, 
+         stats.nof_crc_checks, stats.stop_crc, stats.stop_decoder, stats.stop_max);
+}
+
+/* Checks that the TB plan agrees with the segmentation of the HARQ process, 
+ * covers the TB plus its CRC and the nb_e rate matched bits, and is cached 
+ */
+int check_tb_plan(pdsch_t *q, pdsch_harq_t *harq_process, uint32_t nb_e) {
+  pdsch_tb_plan_t *plan;
+  uint32_t i, tb_len = 0, e_len = 0;
+
+  plan = pdsch_tb_plan(q, harq_process->mcs.tbs, nb_e);
+  if (!plan || memcmp(&plan->cb_segm, &harq_process->cb_segm, sizeof(struct cb_segm))) {
+    fprintf(stderr, "TB plan does not match the HARQ process segmentation\n");
+    return -1;
+  }
+  for (i = 0; i < plan->cb_segm.C; i++) {
+    if (plan->cb[i].tb_offset != tb_len || plan->cb[i].e_offset != e_len) {
+      fprintf(stderr, "Wrong offsets in CB#%d of the TB plan\n", i);
+      return -1;
+    }
+    tb_len += plan->cb[i].rlen - plan->cb[i].F;
+    e_len += plan->cb[i].e;
+  }
+  if (tb_len != harq_process->mcs.tbs + 24 || e_len != nb_e) {
+    fprintf(stderr, "TB plan covers %d TB bits and %d rate matched bits\n", tb_len, e_len);
+    return -1;
+  }
+  if (pdsch_tb_plan(q, harq_process->mcs.tbs, nb_e) != plan) {
+    fprintf(stderr, "TB plan was not cached\n");
+    return -1;
+  }
+  return 0;
+}
+
+/* Transmits the subframe with the cell reference signals through an 
+ * independent Rayleigh fading channel from each antenna port, with 
+ * FADING_NOF_TAPS taps one sample apart at the FFT size of the cell, plus AWGN. 
+ * The noise variance is estimated from the reference signals with chest_t and 
+ * drives the MMSE detector; the test fails if the mean estimate is more than 
+ * FADING_NOISE_TOL off the injected variance. Both the ZF and MMSE detectors 
+ * use the true channel. Reports the BLER and the average number of turbo 
+ * decoder iterations of each, and fails if the MMSE detector has more errors 
+ * than the ZF one or a BLER above max_bler. With an early stopping policy other than the CRC, 
+ * ZF is also decoded with a fixed number of iterations, and the test fails if 
+ * early stopping decodes a different number of TBs or does not reduce the 
+ * mean number of iterations. 
+ */
+#define FADING_NOF_TAPS   5
+#define FADING_NOISE_TOL  0.1
+
+int fading_test(pdsch_t *pdsch_zf, pdsch_harq_t *harq_process, char *data, 
+                cf_t *slot_symbols[MAX_PORTS], cf_t *ce[MAX_PORTS], uint32_t nof_re) 
+{
+  pdsch_t pdsch_mmse, pdsch_fixed; 
+  chest_t chest;
+  refsignal_t refs[MAX_PORTS][2];
+  bool fixed = stop_policy != PDSCH_STOP_CRC;
+  cf_t *rx_symbols = NULL, *h[MAX_PORTS], *ce_est[MAX_PORTS], taps[FADING_NOF_TAPS];
+  char *data_rx = NULL;
+  uint32_t i, j, k, l, n, nof_errors_zf = 0, nof_errors_mmse = 0, nof_errors_fixed = 0;
+  uint32_t nof_sc = cell.nof_prb * RE_X_RB, symbol_sz = lte_symbol_sz(cell.nof_prb);
+  float noise = powf(10, -snr_db / 10), noise_est = 0;
+  int ret = -1;
+
+  bzero(h, sizeof(cf_t*) * MAX_PORTS);
+  bzero(ce_est, sizeof(cf_t*) * MAX_PORTS);
+  bzero(refs, sizeof(refs));
+  bzero(&chest, sizeof(chest_t));
+  bzero(&pdsch_fixed, sizeof(pdsch_t));
+  if (pdsch_init(&pdsch_mmse, cell)) {
+    fprintf(stderr, "Error creating PDSCH object\n");
+    return -1;
+  }
+  if (chest_init_LTEDL(&chest, cell)) {
+    fprintf(stderr, "Error initiating channel estimator\n");
+    goto quit;
+  }
+  if (fixed) {
+    if (pdsch_init(&pdsch_fixed, cell)) {
+      fprintf(stderr, "Error creating PDSCH object\n");
+      goto quit;
+    }
+    pdsch_set_rnti(&pdsch_fixed, 1234);
+    if (set_fixed_iterations(&pdsch_fixed)) {
+      goto quit;
+    }
+  }
+  pdsch_set_rnti(&pdsch_mmse, 1234);
+  if (set_early_stop(&pdsch_mmse)) {
+    goto quit;
+  }
+
+  rx_symbols = malloc(sizeof(cf_t) * nof_re);
+  data_rx = malloc(sizeof(char) * harq_process->mcs.tbs);
+  if (!rx_symbols || !data_rx) {
+    perror("malloc");
+    goto quit;
+  }
+  for (i=0;i<cell.nof_ports;i++) {
+    for (j=0;j<2;j++) {
+      if (refsignal_init_LTEDL(&refs[i][j], i, 2 * subframe + j, cell)) {
+        fprintf(stderr, "Error initiating reference signal\n");
+        goto quit;
+      }
+    }
+    h[i] = malloc(sizeof(cf_t) * nof_sc);
+    ce_est[i] = malloc(sizeof(cf_t) * nof_re);
+    if (!h[i] || !ce_est[i]) {
+      perror("malloc");
+      goto quit;
+    }
+  }
+
+  for (n=0;n<nof_frames;n++) {
+    for (i=0;i<harq_process->mcs.tbs;i++) {
+      data[i] = rand()%2;
+    }
+    for (i=0;i<cell.nof_ports;i++) {
+      bzero(slot_symbols[i], sizeof(cf_t) * nof_re);
+    }
+    if (pdsch_encode(pdsch_zf, data, slot_symbols, subframe, harq_process, 0)) {
+      fprintf(stderr, "Error encoding PDSCH\n");
+      goto quit;
+    }
+    for (i=0;i<cell.nof_ports;i++) {
+      refsignal_put(&refs[i][0], slot_symbols[i]);
+      refsignal_put(&refs[i][1], &slot_symbols[i][nof_re / 2]);
+    }
+    
+    /* Frequency response of unit-power Rayleigh taps */
+    for (i=0;i<cell.nof_ports;i++) {
+      bzero(taps, sizeof(taps));
+      ch_awgn_c(taps, taps, sqrtf(0.5 / FADING_NOF_TAPS), FADING_NOF_TAPS);
+      for (k=0;k<nof_sc;k++) {
+        h[i][k] = 0;
+        for (l=0;l<FADING_NOF_TAPS;l++) {
+          h[i][k] += taps[l] * cexpf(-I * 2 * M_PI * k * l / symbol_sz);
+        }
+      }
+    }
+    bzero(rx_symbols, sizeof(cf_t) * nof_re);
+    for (i=0;i<cell.nof_ports;i++) {
+      for (j=0;j<nof_re;j++) {
+        ce[i][j] = h[i][j % nof_sc];
+        rx_symbols[j] += ce[i][j] * slot_symbols[i][j];
+      }
+    }
+    ch_awgn_c(rx_symbols, rx_symbols, sqrtf(noise / 2), nof_re);
+
+    chest_ce_sf(&chest, rx_symbols, ce_est, subframe);
+    pdsch_set_noise_estimate(&pdsch_mmse, chest_get_noise_estimate(&chest));
+    noise_est += chest_get_noise_estimate(&chest) / nof_frames;
+
+    if (pdsch_decode(pdsch_zf, rx_symbols, ce, data_rx, subframe, harq_process, 0) ||
+        memcmp(data, data_rx, harq_process->mcs.tbs)) 
+    {
+      nof_errors_zf++;
+    }
+    if (pdsch_decode(&pdsch_mmse, rx_symbols, ce, data_rx, subframe, harq_process, 0) ||
+        memcmp(data, data_rx, harq_process->mcs.tbs)) 
+    {
+      nof_errors_mmse++;
+    }
+    if (fixed && 
+        (pdsch_decode(&pdsch_fixed, rx_symbols, ce, data_rx, subframe, harq_process, 0) ||
+         memcmp(data, data_rx, harq_process->mcs.tbs))) 
+    {
+      nof_errors_fixed++;
+    }
+  }
+  
+  printf("SNR: %.1f dB, %d frames, noise variance %.4f, mean estimate %.4f\n", 
+         snr_db, nof_frames, noise, noise_est);
+  printf("ZF:   BLER: %.3f, average iterations: %.2f\n", 
+         (float) nof_errors_zf / nof_frames, pdsch_average_noi(pdsch_zf));
+  printf("MMSE: BLER: %.3f, average iterations: %.2f\n", 
+         (float) nof_errors_mmse / nof_frames, pdsch_average_noi(&pdsch_mmse));
+  print_stop_stats("ZF:  ", pdsch_zf);
+  print_stop_stats("MMSE:", &pdsch_mmse);
+  if (fixed) {
+    printf("ZF with %d iterations: BLER: %.3f\n", TDEC_MAX_ITERATIONS, 
+           (float) nof_errors_fixed / nof_frames);
+    if (nof_errors_zf != nof_errors_fixed) {
+      fprintf(stderr, "Early stopping changed the number of decoded TBs\n");
+      goto quit;
+    }
+    if (mean_iterations(pdsch_zf) >= mean_iterations(&pdsch_fixed) ||
+        mean_iterations(&pdsch_mmse) >= mean_iterations(&pdsch_fixed)) 
+    {
+      fprintf(stderr, "Early stopping did not reduce the number of iterations\n");
+      goto quit;
+    }
+  }
+  if (fabsf(noise_est / noise - 1) > FADING_NOISE_TOL) {
+    fprintf(stderr, "Noise variance estimate off by more than %.0f%%\n", 
+            FADING_NOISE_TOL * 100);
+    goto quit;
+  }
+  if (nof_errors_mmse > nof_errors_zf) {
+    fprintf(stderr, "MMSE detector has more errors than ZF\n");
+    goto quit;
+  }
+  if ((float) nof_errors_mmse / nof_frames > max_bler) {
+    fprintf(stderr, "MMSE BLER above %.3f\n", max_bler);
+    goto quit;
+  }
+  ret = 0;
+quit:
+  pdsch_free(&pdsch_mmse);
+  if (fixed) {
+    pdsch_free(&pdsch_fixed);
+  }
+  chest_free(&chest);
+  for (i=0;i<cell.nof_ports;i++) {
+    for (j=0;j<2;j++) {
+      refsignal_free(&refs[i][j]);
+    }
+    if (h[i]) {
+      free(h[i]);
+    }
+    if (ce_est[i]) {
+      free(ce_est[i]);
+    }
+  }
+  if (rx_symbols) {
+    free(rx_symbols);
+  }
+  if (data_rx) {
+    free(data_rx);
+  }
+  return ret;
+}
+
 int main(int argc, char **argv) {
   pdsch_t pdsch;
   uint32_t i, j;
@@ -172,6 +458,9 @@ int main(int argc, char **argv) {
   }
   
   pdsch_set_rnti(&pdsch, 1234);
+  if (set_early_stop(&pdsch)) {
+    goto quit;
+  }
   
   if (pdsch_harq_init(&harq_process, &pdsch)) {
     fprintf(stderr, "Error initiating HARQ process\n");
@@ -182,6 +471,16 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Error configuring HARQ process\n");
     goto quit;
   }
+  
+  if (check_tb_plan(&pdsch, &harq_process, 
+      prb_alloc.re_sf[subframe] * lte_mod_bits_x_symbol(mcs.mod))) {
+    goto quit;
+  }
+
+  if (snr_db < 100.0) {
+    ret = fading_test(&pdsch, &harq_process, data, slot_symbols, ce, nof_re);
+    goto quit;
+  }
 
   for (i=0;i<mcs.tbs;i++) {
     data[i] = rand()%2;
@@ -0,0 +1,355 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <complex.h>
+#include <math.h>
+
+#include "liblte/phy/resampling/channelizer.h"
+#include "liblte/phy/filter/fir.h"
+#include "liblte/phy/utils/debug.h"
+
+/* Designs the default prototype: a lowpass with the -6 dB point at the edge 
+ * of the channel. 
+ */
+static int channelizer_default_taps(float *taps, uint32_t nof_channels) {
+  return fir_lowpass(taps, CHANNELIZER_DEFAULT_TAPS * nof_channels, 
+                     0.5 / nof_channels, fir_kaiser_beta(70));
+}
+
+/** Initializes a channelizer of nof_channels channels decimated by decim, with 
+ * the prototype lowpass filter taps, which is padded with zeros to a multiple 
+ * of nof_channels. If taps is NULL, a default prototype is designed and 
+ * nof_taps is ignored. 
+ */
+int channelizer_init(channelizer_t *q, uint32_t nof_channels, uint32_t decim, 
+                     float *taps, uint32_t nof_taps) 
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  float *proto = NULL;
+  uint32_t N, p, r;
+
+  if (q                 != NULL &&
+      nof_channels      >  0    &&
+      nof_channels      <= CHANNELIZER_MAX_CHANNELS &&
+      decim             >  0    &&
+      nof_channels % decim == 0 &&
+      (taps == NULL || nof_taps > 0))
+  {
+    ret = LIBLTE_ERROR;
+    bzero(q, sizeof(channelizer_t));
+    N = nof_channels;
+    q->nof_channels = N;
+    q->decim = decim;
+    if (taps == NULL) {
+      nof_taps = CHANNELIZER_DEFAULT_TAPS * N;
+    }
+    q->nof_branch_taps = (nof_taps + N - 1) / N;
+    q->nof_taps = q->nof_branch_taps * N;
+
+    proto = calloc(q->nof_taps, sizeof(float));
+    q->taps = malloc(sizeof(float) * 2 * q->nof_taps);
+    q->buffer = malloc(sizeof(cf_t) * (q->nof_taps - 1 + CHANNELIZER_CHUNK));
+    q->branch = malloc(sizeof(float) * 2 * N);
+    q->dft_in = malloc(sizeof(cf_t) * N);
+    q->dft_out = malloc(sizeof(cf_t) * N);
+    if (!proto || !q->taps || !q->buffer || !q->branch || !q->dft_in || !q->dft_out) {
+      perror("malloc");
+      goto clean;
+    }
+    if (taps == NULL) {
+      if (channelizer_default_taps(proto, N)) {
+        goto clean;
+      }
+    } else {
+      memcpy(proto, taps, sizeof(float) * nof_taps);
+    }
+    /* branch tap p of branch r is proto[p*N+r]. The oldest block of the 
+     * window is multiplied by the last branch tap */
+    for (p = 0; p < q->nof_branch_taps; p++) {
+      for (r = 0; r < N; r++) {
+        q->taps[2 * ((q->nof_branch_taps - 1 - p) * N + N - 1 - r)] = proto[p * N + r];
+        q->taps[2 * ((q->nof_branch_taps - 1 - p) * N + N - 1 - r) + 1] = proto[p * N + r];
+      }
+    }
+    if (dft_plan_c(&q->dft, N, BACKWARD)) {
+      fprintf(stderr, "Error creating DFT plan\n");
+      goto clean;
+    }
+    channelizer_reset(q);
+    INFO("Init channelizer: %d channels, decim %d, %d taps\n", N, decim, q->nof_taps);
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (proto) {
+    free(proto);
+  }
+  if (ret == LIBLTE_ERROR) {
+    channelizer_free(q);
+  }
+  return ret;
+}
+
+void channelizer_free(channelizer_t *q) {
+  if (q->taps) {
+    free(q->taps);
+  }
+  if (q->buffer) {
+    free(q->buffer);
+  }
+  if (q->branch) {
+    free(q->branch);
+  }
+  if (q->dft_in) {
+    free(q->dft_in);
+  }
+  if (q->dft_out) {
+    free(q->dft_out);
+  }
+  dft_plan_free(&q->dft);
+  bzero(q, sizeof(channelizer_t));
+}
+
+/* Clears the history. The next input sample is decimated to the next output */
+void channelizer_reset(channelizer_t *q) {
+  bzero(q->buffer, sizeof(cf_t) * (q->nof_taps - 1));
+  q->next = 0;
+  q->rot = 0;
+}
+
+/* Computes the output of all the channels for the window x of nof_taps samples 
+ * ending at input index n, with rot = n mod nof_channels: 
+ *   v[r] = sum_p proto[p*N+r]*x[n-p*N-r]
+ *   y[k] = sum_r v[r]*exp(-j*2*pi*k*(n-r)/N) = IDFT(v[(q+rot) mod N])[k]
+ */
+static void channelizer_window(channelizer_t *q, cf_t *x, cf_t **output, uint32_t idx) {
+  int N = (int) q->nof_channels;
+  int len = 2 * N;
+  float *branch = q->branch;
+  float *xf, *t;
+  uint32_t p, k, r;
+  int j;
+
+  for (j = 0; j < len; j++) {
+    branch[j] = 0;
+  }
+  for (p = 0; p < q->nof_branch_taps; p++) {
+    xf = (float*) &x[p * N];
+    t = &q->taps[p * len];
+    for (j = 0; j < len; j++) {
+      branch[j] += t[j] * xf[j];
+    }
+  }
+  /* branch holds v[N-1], v[N-2], ..., v[0] */
+  r = q->rot;
+  for (k = 0; k < (uint32_t) N; k++) {
+    q->dft_in[k] = branch[2 * (N - 1 - r)] + branch[2 * (N - 1 - r) + 1] * I;
+    if (++r == (uint32_t) N) {
+      r = 0;
+    }
+  }
+  dft_run_c(&q->dft, q->dft_in, q->dft_out);
+  for (k = 0; k < (uint32_t) N; k++) {
+    output[k][idx] = q->dft_out[k];
+  }
+}
+
+/** Channelizes len input samples. Each output[k] must have room for 
+ * len/decim+1 samples. Returns the number of output samples of each channel.
+ */
+int channelizer_run(channelizer_t *q, cf_t *input, uint32_t len, cf_t **output) {
+  uint32_t hist, n, total, n_out = 0;
+
+  if (q == NULL || input == NULL || output == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  hist = q->nof_taps - 1;
+  while (len > 0) {
+    n = len > CHANNELIZER_CHUNK ? CHANNELIZER_CHUNK : len;
+    memcpy(&q->buffer[hist], input, sizeof(cf_t) * n);
+    total = hist + n;
+    while (q->next + q->nof_taps <= total) {
+      channelizer_window(q, &q->buffer[q->next], output, n_out++);
+      q->next += q->decim;
+      q->rot += q->decim;
+      if (q->rot >= q->nof_channels) {
+        q->rot -= q->nof_channels;
+      }
+    }
+    memmove(q->buffer, &q->buffer[n], sizeof(cf_t) * hist);
+    q->next -= n;
+    input += n;
+    len -= n;
+  }
+  return (int) n_out;
+}
+
+/** Initializes a channelizer that reads the wideband stream from 
+ * recv_callback(recv_handler, ...). Receivers may ask for up to max_recv_len 
+ * samples at once. 
+ */
+int channelizer_stream_init(channelizer_stream_t *q, uint32_t nof_channels, uint32_t decim, 
+                            float *taps, uint32_t nof_taps, uint32_t max_recv_len, 
+                            int (recv_callback)(void*, void*, uint32_t), void *recv_handler) 
+{
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  uint32_t k;
+
+  if (q                 != NULL &&
+      recv_callback     != NULL &&
+      max_recv_len      >  0)
+  {
+    bzero(q, sizeof(channelizer_stream_t));
+    ret = channelizer_init(&q->chan, nof_channels, decim, taps, nof_taps);
+    if (ret != LIBLTE_SUCCESS) {
+      return ret;
+    }
+    ret = LIBLTE_ERROR;
+    q->recv_callback = recv_callback;
+    q->recv_handler = recv_handler;
+    q->fifo_size = max_recv_len + CHANNELIZER_CHUNK / decim + 1;
+    q->input = malloc(sizeof(cf_t) * CHANNELIZER_CHUNK);
+    if (!q->input) {
+      perror("malloc");
+      goto clean;
+    }
+    for (k = 0; k < nof_channels; k++) {
+      q->fifo[k] = malloc(sizeof(cf_t) * q->fifo_size);
+      if (!q->fifo[k]) {
+        perror("malloc");
+        goto clean;
+      }
+      q->port[k].stream = q;
+      q->port[k].channel = k;
+    }
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (ret == LIBLTE_ERROR) {
+    channelizer_stream_free(q);
+  }
+  return ret;
+}
+
+void channelizer_stream_free(channelizer_stream_t *q) {
+  uint32_t k;
+
+  for (k = 0; k < CHANNELIZER_MAX_CHANNELS; k++) {
+    if (q->fifo[k]) {
+      free(q->fifo[k]);
+    }
+  }
+  if (q->input) {
+    free(q->input);
+  }
+  channelizer_free(&q->chan);
+  bzero(q, sizeof(channelizer_stream_t));
+}
+
+/* Returns the stream handler to pass to the receiver of channel */
+channelizer_port_t* channelizer_stream_port(channelizer_stream_t *q, uint32_t channel) {
+  if (q != NULL && channel < q->chan.nof_channels) {
+    return &q->port[channel];
+  }
+  return NULL;
+}
+
+/* Reads and channelizes wideband samples until channel has nsamples queued 
+ * or the wideband source returns no samples 
+ */
+static int channelizer_stream_fill(channelizer_stream_t *q, uint32_t channel, uint32_t nsamples) {
+  cf_t *out[CHANNELIZER_MAX_CHANNELS];
+  uint32_t k, n, nof_channels = q->chan.nof_channels;
+  int n_out, n_recv;
+
+  while (q->fifo_len[channel] < nsamples) {
+    /* input samples that yield the missing ones */
+    n = (nsamples - q->fifo_len[channel]) * q->chan.decim;
+    if (n > CHANNELIZER_CHUNK) {
+      n = CHANNELIZER_CHUNK;
+    }
+    n_recv = q->recv_callback(q->recv_handler, q->input, n);
+    if (n_recv < 0) {
+      return LIBLTE_ERROR;
+    } else if (n_recv == 0) {
+      break;
+    }
+    n = (uint32_t) n_recv;
+    /* channels whose receiver fell behind drop the oldest samples */
+    for (k = 0; k < nof_channels; k++) {
+      if (q->fifo_len[k] + n / q->chan.decim + 1 > q->fifo_size) {
+        q->overflow[k] += q->fifo_len[k];
+        q->fifo_len[k] = 0;
+      }
+      out[k] = &q->fifo[k][q->fifo_len[k]];
+    }
+    n_out = channelizer_run(&q->chan, q->input, n, out);
+    if (n_out < 0) {
+      return LIBLTE_ERROR;
+    }
+    for (k = 0; k < nof_channels; k++) {
+      q->fifo_len[k] += (uint32_t) n_out;
+    }
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/** Receive callback for the receiver of one channel. h is the 
+ * channelizer_port_t returned by channelizer_stream_port(). Returns nsamples, 
+ * fewer if the wideband source ran out of samples, or a negative value if it 
+ * failed.
+ */
+int channelizer_stream_recv(void *h, void *data, uint32_t nsamples) {
+  channelizer_port_t *port = (channelizer_port_t*) h;
+  channelizer_stream_t *q;
+  cf_t *fifo;
+
+  if (port == NULL || (data == NULL && nsamples > 0)) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  q = (channelizer_stream_t*) port->stream;
+  if (nsamples > q->fifo_size - CHANNELIZER_CHUNK / q->chan.decim - 1) {
+    fprintf(stderr, "Channelizer stream initiated for max_recv_len=%d\n", 
+            q->fifo_size - CHANNELIZER_CHUNK / q->chan.decim - 1);
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (channelizer_stream_fill(q, port->channel, nsamples)) {
+    return LIBLTE_ERROR;
+  }
+  if (nsamples > q->fifo_len[port->channel]) {
+    nsamples = q->fifo_len[port->channel];
+  }
+  fifo = q->fifo[port->channel];
+  memcpy(data, fifo, sizeof(cf_t) * nsamples);
+  q->fifo_len[port->channel] -= nsamples;
+  memmove(fifo, &fifo[nsamples], sizeof(cf_t) * q->fifo_len[port->channel]);
+  return (int) nsamples;
+}
@@ -25,10 +25,15 @@
  *
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include <complex.h>
 #include <math.h>
 #include "liblte/phy/resampling/decim.h"
 #include "liblte/phy/utils/debug.h"
+#include "liblte/phy/utils/vector.h"
 
 
 /* Performs integer linear decimation by a factor of M */
@@ -47,3 +52,118 @@ void decim_f(float *input, float *output, int M, int len) {
     output[i] = input[i*M];
   }
 }
+
+
+static int decim_fir_alloc(decim_fir_t *q, uint32_t M, uint32_t nof_taps, bool complex_taps) {
+  bzero(q, sizeof(decim_fir_t));
+  q->M = M;
+  q->nof_taps = nof_taps + nof_taps % 2;
+  q->complex_taps = complex_taps;
+  q->taps_re = calloc(2 * q->nof_taps, sizeof(float));
+  if (complex_taps) {
+    q->taps_im = calloc(2 * q->nof_taps, sizeof(float));
+  }
+  q->buffer = malloc(sizeof(cf_t) * (q->nof_taps - 1 + DECIM_FIR_CHUNK));
+  if (!q->taps_re || (complex_taps && !q->taps_im) || !q->buffer) {
+    perror("malloc");
+    decim_fir_free(q);
+    return LIBLTE_ERROR;
+  }
+  decim_fir_reset(q);
+  return LIBLTE_SUCCESS;
+}
+
+/** Initializes a decimator by M with nof_taps real taps. The output sample n 
+ * is sum_i taps[i]*input[n*M-i].
+ */
+int decim_fir_init(decim_fir_t *q, uint32_t M, float *taps, uint32_t nof_taps) {
+  uint32_t i, j;
+
+  if (q != NULL && taps != NULL && M > 0 && nof_taps > 0) {
+    if (decim_fir_alloc(q, M, nof_taps, false)) {
+      return LIBLTE_ERROR;
+    }
+    /* the padding tap (if any) goes first, as the oldest sample */
+    for (i = 0; i < nof_taps; i++) {
+      j = q->nof_taps - 1 - i;
+      q->taps_re[2 * j] = taps[i];
+      q->taps_re[2 * j + 1] = taps[i];
+    }
+    return LIBLTE_SUCCESS;
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
+/** Same as decim_fir_init() with complex taps */
+int decim_fir_init_c(decim_fir_t *q, uint32_t M, cf_t *taps, uint32_t nof_taps) {
+  uint32_t i, j;
+
+  if (q != NULL && taps != NULL && M > 0 && nof_taps > 0) {
+    if (decim_fir_alloc(q, M, nof_taps, true)) {
+      return LIBLTE_ERROR;
+    }
+    for (i = 0; i < nof_taps; i++) {
+      j = q->nof_taps - 1 - i;
+      q->taps_re[2 * j] = crealf(taps[i]);
+      q->taps_re[2 * j + 1] = crealf(taps[i]);
+      q->taps_im[2 * j] = cimagf(taps[i]);
+      q->taps_im[2 * j + 1] = cimagf(taps[i]);
+    }
+    return LIBLTE_SUCCESS;
+  }
+  return LIBLTE_ERROR_INVALID_INPUTS;
+}
+
+void decim_fir_free(decim_fir_t *q) {
+  if (q->taps_re) {
+    free(q->taps_re);
+  }
+  if (q->taps_im) {
+    free(q->taps_im);
+  }
+  if (q->buffer) {
+    free(q->buffer);
+  }
+  bzero(q, sizeof(decim_fir_t));
+}
+
+/* Clears the history. The next input sample is decimated to the next output */
+void decim_fir_reset(decim_fir_t *q) {
+  bzero(q->buffer, sizeof(cf_t) * (q->nof_taps - 1));
+  q->next = 0;
+}
+
+/** Filters and decimates len input samples. output must have room for 
+ * len/M+1 samples. Returns the number of output samples.
+ */
+int decim_fir_run(decim_fir_t *q, cf_t *input, cf_t *output, uint32_t len) {
+  uint32_t hist, n, total, n_out = 0;
+  cf_t a, b, *x;
+
+  if (q == NULL || input == NULL || output == NULL) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  hist = q->nof_taps - 1;
+  while (len > 0) {
+    n = len > DECIM_FIR_CHUNK ? DECIM_FIR_CHUNK : len;
+    memcpy(&q->buffer[hist], input, sizeof(cf_t) * n);
+    total = hist + n;
+    while (q->next + q->nof_taps <= total) {
+      x = &q->buffer[q->next];
+      a = vec_dot_prod_cfc_iq(x, q->taps_re, q->nof_taps);
+      if (q->complex_taps) {
+        /* (a_re + j*a_im) + j*(b_re + j*b_im) */
+        b = vec_dot_prod_cfc_iq(x, q->taps_im, q->nof_taps);
+        a = (crealf(a) - cimagf(b)) + (cimagf(a) + crealf(b)) * I;
+      }
+      output[n_out++] = a;
+      q->next += q->M;
+    }
+    /* keep the last nof_taps-1 samples */
+    memmove(q->buffer, &q->buffer[n], sizeof(cf_t) * hist);
+    q->next -= n;
+    input += n;
+    len -= n;
+  }
+  return (int) n_out;
+}
@@ -45,6 +45,19 @@
 
 #define MAX_OFFSET      64
 
+/* Phase step from arg0 to arg1 taking the shortest way around the circle, so
+ * that interpolating between phases close to -pi and pi does not go through 0
+ */
+static inline float arg_diff(float arg1, float arg0) {
+  float d = arg1 - arg0;
+  if (d > M_PI) {
+    d -= 2 * M_PI;
+  } else if (d < -M_PI) {
+    d += 2 * M_PI;
+  }
+  return d;
+}
+
 int interp_init(interp_t *q, interp_type_t type, uint32_t len, uint32_t M) {
   int ret = LIBLTE_ERROR_INVALID_INPUTS; 
   
@@ -147,7 +160,7 @@ void interp_run_offset(interp_t *q, cf_t *input, cf_t *output, uint32_t off_st,
     arg0 = q->in_arg[0];
     arg1 = q->in_arg[1];
     dmag=(mag1-mag0)/M;
-    darg=(arg1-arg0)/M; 
+    darg=arg_diff(arg1, arg0)/M; 
     for (j=0;j<off_st;j++) {
       q->out_mag[j] = mag0 - (j+1)*dmag;
       q->out_arg[j] = arg0 - (j+1)*darg;
@@ -159,7 +172,7 @@ void interp_run_offset(interp_t *q, cf_t *input, cf_t *output, uint32_t off_st,
       arg0 = q->in_arg[i];
       arg1 = q->in_arg[i+1];
       dmag=(mag1-mag0)/M;
-      darg=(arg1-arg0)/M;
+      darg=arg_diff(arg1, arg0)/M;
       for (j=0;j<M;j++) {
         q->out_mag[i*M+j+off_st] = mag0 + j*dmag;
         q->out_arg[i*M+j+off_st] = arg0 + j*darg;
@@ -174,8 +187,9 @@ void interp_run_offset(interp_t *q, cf_t *input, cf_t *output, uint32_t off_st,
     uint32_t len=i*M+j+off_st;
 #ifdef TABLE_SIZE
     vec_convert_fi(q->out_arg, q->table_idx, (float) TABLE_SIZE/2/M_PI, len);
+    /* extrapolated phases may fall out of [-pi, pi), wrap them around the table */
     for (n=0;n<len;n++) {
-      q->out_cexp[n] = q->cexptable[q->table_idx[n]+TABLE_SIZE/2];
+      q->out_cexp[n] = q->cexptable[((uint32_t) (q->table_idx[n]+TABLE_SIZE/2)) & (TABLE_SIZE-1)];
     }
 #else
     for (n=0;n<len;n++) {
@@ -194,30 +208,31 @@ void interp_run(interp_t *q, cf_t *input, cf_t *output) {
 /* Performs 1st order linear interpolation with out-of-bound interpolation */
 void interp_linear_offset(cf_t *input, cf_t *output, uint32_t M, uint32_t len, uint32_t off_st, uint32_t off_end) {
   uint32_t i, j;
-  float mag0=0, mag1=0, arg0=0, arg1=0, mag=0, arg=0;
+  float mag0=0, mag1=0, arg0=0, arg1=0, mag=0, arg=0, darg=0;
 
   for (i=0;i<len-1;i++) {
     mag0 = cabsf(input[i]);
     mag1 = cabsf(input[i+1]);
     arg0 = cargf(input[i]);
     arg1 = cargf(input[i+1]);
+    darg = arg_diff(arg1, arg0);
     if (i==0) {
       for (j=0;j<off_st;j++) {
         mag = mag0 - (j+1)*(mag1-mag0)/M;
-        arg = arg0 - (j+1)*(arg1-arg0)/M;
+        arg = arg0 - (j+1)*darg/M;
         output[j] = mag * cexpf(I * arg);
       }
     }
     for (j=0;j<M;j++) {
       mag = mag0 + j*(mag1-mag0)/M;
-      arg = arg0 + j*(arg1-arg0)/M;
+      arg = arg0 + j*darg/M;
       output[i*M+j+off_st] = mag * cexpf(I * arg);
     }
   }
   if (len > 1) {
     for (j=0;j<off_end;j++) {
       mag = mag1 + j*(mag1-mag0)/M;
-      arg = arg1 + j*(arg1-arg0)/M;
+      arg = arg1 + j*darg/M;
       output[i*M+j+off_st] = mag * cexpf(I * arg);
     }
   }
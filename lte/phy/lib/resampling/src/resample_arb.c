@@ -25,10 +25,13 @@
  *
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include "liblte/phy/resampling/resample_arb.h"
 #include "liblte/phy/utils/debug.h"
+#include "liblte/phy/utils/vector.h"
 
 float resample_arb_polyfilt[RESAMPLE_ARB_N][RESAMPLE_ARB_M] =
 {{0,0.002400347599485495,-0.006922416132556366,0.0179104136912176,0.99453086623794,-0.008521087756729117,0.0008598969867484128,0.0004992625165376107},
@@ -112,3 +115,194 @@ int resample_arb_compute(resample_arb_t *q, cf_t *input, cf_t *output, int n_in)
   }
   return n_out;
 }
+
+#define RESAMPLE_ARB_PHASE_SHIFT  27  // 32 - log2(RESAMPLE_ARB_N)
+
+/* Best approximation of rate by interp/decim with decim <= RESAMPLE_ARB_MAX_DECIM,
+ * using the convergents of its continued fraction
+ */
+static void resample_arb_ratio(float rate, uint32_t *interp, uint32_t *decim) {
+  double x = rate, a;
+  uint64_t h0 = 0, h1 = 1, k0 = 1, k1 = 0, h, k;
+
+  while (true) {
+    a = floor(x);
+    h = (uint64_t) a * h1 + h0;
+    k = (uint64_t) a * k1 + k0;
+    if (k > RESAMPLE_ARB_MAX_DECIM || h > UINT32_MAX) {
+      break;
+    }
+    h0 = h1; h1 = h;
+    k0 = k1; k1 = k;
+    if (x - a < 1e-9 || fabs((double) h1 / k1 - rate) < 1e-7 * rate) {
+      break;
+    }
+    x = 1 / (x - a);
+  }
+  *interp = (uint32_t) h1;
+  *decim = (uint32_t) k1;
+}
+
+/* Taps for the output instant frac, linearly interpolated between the two 
+ * closest phases of the filter 
+ */
+static inline void resample_arb_block_taps(resample_arb_block_t *q, uint32_t frac, float *c) {
+  uint32_t p = frac >> RESAMPLE_ARB_PHASE_SHIFT;
+  float mu = (float) (frac & ((1 << RESAMPLE_ARB_PHASE_SHIFT) - 1)) 
+             * (1.0f / (1 << RESAMPLE_ARB_PHASE_SHIFT));
+  int j;
+
+  for (j = 0; j < 2 * RESAMPLE_ARB_M; j++) {
+    c[j] = q->taps[p][j] + mu * q->dtaps[p][j];
+  }
+}
+
+int resample_arb_block_init(resample_arb_block_t *q, float rate) {
+  uint32_t p, j;
+  uint64_t rem;
+  float next;
+
+  if (q == NULL || !(rate > 0) || rate * RESAMPLE_ARB_MAX_DECIM > UINT32_MAX) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  memset(q, 0, sizeof(resample_arb_block_t));
+  q->rate = rate;
+  resample_arb_ratio(rate, &q->interp, &q->decim);
+  if (q->interp == 0) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  q->step_int = q->decim / q->interp;
+  rem = (uint64_t) (q->decim % q->interp) << 32;
+  q->step_frac = (uint32_t) (rem / q->interp);
+  q->step_rem = (uint32_t) (rem % q->interp);
+  q->phase_step = q->decim % q->interp;
+
+  /* The window is ordered from the oldest to the newest sample, thus the taps 
+   * are reversed. The phase after the last one is the first one delayed by 
+   * one sample.
+   */
+  for (p = 0; p < RESAMPLE_ARB_N; p++) {
+    for (j = 0; j < RESAMPLE_ARB_M; j++) {
+      if (p < RESAMPLE_ARB_N - 1) {
+        next = resample_arb_polyfilt[p + 1][RESAMPLE_ARB_M - 1 - j];
+      } else {
+        next = j > 0 ? resample_arb_polyfilt[0][RESAMPLE_ARB_M - j] : 0;
+      }
+      q->taps[p][2 * j] = resample_arb_polyfilt[p][RESAMPLE_ARB_M - 1 - j];
+      q->taps[p][2 * j + 1] = q->taps[p][2 * j];
+      q->dtaps[p][2 * j] = next - q->taps[p][2 * j];
+      q->dtaps[p][2 * j + 1] = q->dtaps[p][2 * j];
+    }
+  }
+
+  if (q->interp <= RESAMPLE_ARB_MAX_PHASES) {
+    q->phase_taps = malloc(sizeof(float) * 2 * RESAMPLE_ARB_M * q->interp);
+    if (!q->phase_taps) {
+      perror("malloc");
+      return LIBLTE_ERROR;
+    }
+    for (p = 0; p < q->interp; p++) {
+      resample_arb_block_taps(q, (uint32_t) (((uint64_t) p << 32) / q->interp), 
+                              &q->phase_taps[2 * RESAMPLE_ARB_M * p]);
+    }
+  }
+  INFO("Arbitrary resampler rate %f ~ %d/%d\n", rate, q->interp, q->decim);
+  return LIBLTE_SUCCESS;
+}
+
+void resample_arb_block_free(resample_arb_block_t *q) {
+  if (q->phase_taps) {
+    free(q->phase_taps);
+  }
+  memset(q, 0, sizeof(resample_arb_block_t));
+}
+
+/* Clears the delay line and the phase */
+void resample_arb_block_reset(resample_arb_block_t *q) {
+  memset(q->delay, 0, sizeof(cf_t) * 2 * RESAMPLE_ARB_M);
+  q->widx = 0;
+  q->frac = 0;
+  q->rem = 0;
+  q->phase = 0;
+  q->pending = 0;
+}
+
+/** Resamples n_in input samples. Samples are kept across calls, so a stream 
+ * can be resampled in blocks of any size. output must have room for 
+ * ceil(n_in*rate)+1 samples. Returns the number of output samples.
+ *
+ * Once RESAMPLE_ARB_M samples of the block have been consumed, windows are read 
+ * from input directly. The delay line only holds the samples that precede the 
+ * block.
+ */
+int resample_arb_block_compute(resample_arb_block_t *q, cf_t *input, cf_t *output, int n_in) {
+  int cnt = 0;
+  int n_out = 0;
+  int n, j;
+  uint32_t frac = q->frac, rem = q->rem, phase = q->phase;
+  uint32_t pending = q->pending, widx = q->widx;
+  uint32_t rem_wrap = q->interp - q->step_rem;
+  uint64_t acc;
+  cf_t *x;
+  float *c;
+  float taps[2 * RESAMPLE_ARB_M];
+
+  while (true) {
+    n = (int) pending < n_in - cnt ? (int) pending : n_in - cnt;
+    if (cnt < RESAMPLE_ARB_M) {
+      for (j = 0; j < n; j++) {
+        q->delay[widx] = input[cnt + j];
+        q->delay[widx + RESAMPLE_ARB_M] = input[cnt + j];
+        widx = (widx + 1) % RESAMPLE_ARB_M;
+      }
+    }
+    cnt += n;
+    pending -= n;
+    if (pending > 0) {
+      break;
+    }
+
+    if (cnt >= RESAMPLE_ARB_M) {
+      x = &input[cnt - RESAMPLE_ARB_M];
+    } else {
+      x = &q->delay[widx];
+    }
+    if (q->phase_taps) {
+      c = &q->phase_taps[2 * RESAMPLE_ARB_M * phase];
+    } else {
+      resample_arb_block_taps(q, frac, taps);
+      c = taps;
+    }
+    output[n_out++] = vec_dot_prod_cfc_iq(x, c, RESAMPLE_ARB_M);
+
+    /* advance decim/interp input samples */
+    acc = (uint64_t) frac + q->step_frac;
+    if (rem >= rem_wrap) {
+      rem -= rem_wrap;
+      acc++;
+    } else {
+      rem += q->step_rem;
+    }
+    frac = (uint32_t) acc;
+    pending = q->step_int + (uint32_t) (acc >> 32);
+    phase += q->phase_step;
+    if (phase >= q->interp) {
+      phase -= q->interp;
+    }
+  }
+
+  /* keep the last samples for the next block */
+  if (cnt >= RESAMPLE_ARB_M) {
+    for (j = 0; j < RESAMPLE_ARB_M; j++) {
+      q->delay[j] = input[cnt - RESAMPLE_ARB_M + j];
+      q->delay[j + RESAMPLE_ARB_M] = q->delay[j];
+    }
+    widx = 0;
+  }
+  q->frac = frac;
+  q->rem = rem;
+  q->phase = phase;
+  q->pending = pending;
+  q->widx = widx;
+  return n_out;
+}
@@ -0,0 +1,289 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+#include "tone.h"
+
+/* Checks channelizer_run() with the default prototype filter for critically 
+ * sampled and oversampled channels: a tone in each channel must come out of 
+ * that channel with at least min_snr dB of SNR and unity gain, and must be 
+ * attenuated by at least min_atten dB in the rest of channels. Also checks 
+ * that channelizing in blocks of random size and pulling each channel through 
+ * channelizer_stream_recv(), as independent receivers would, gives the same 
+ * samples as in a single call, also when the wideband source returns short 
+ * reads and runs out of samples.
+ */
+
+uint32_t nof_channels = 8;
+uint32_t nof_samples = 80000;
+float min_snr = 60.0;
+float min_atten = 60.0;
+uint32_t seed = 0;
+
+void usage(char *prog) {
+  printf("Usage: %s [cneas]\n", prog);
+  printf("\t-c nof_channels [Default %d]\n", nof_channels);
+  printf("\t-n nof_samples [Default %d]\n", nof_samples);
+  printf("\t-e minimum SNR in dB [Default %.1f]\n", min_snr);
+  printf("\t-a minimum attenuation of other channels in dB [Default %.1f]\n", min_atten);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "cneas")) != -1) {
+    switch (opt) {
+    case 'c':
+      nof_channels = atoi(argv[optind]);
+      break;
+    case 'n':
+      nof_samples = atoi(argv[optind]);
+      break;
+    case 'e':
+      min_snr = atof(argv[optind]);
+      break;
+    case 'a':
+      min_atten = atof(argv[optind]);
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* Wideband source for channelizer_stream_t, returns a random number of 
+ * samples up to nsamples and 0 at the end */
+typedef struct {
+  cf_t *samples;
+  uint32_t len;
+  uint32_t rp;
+} wideband_source_t;
+
+int wideband_recv(void *h, void *data, uint32_t nsamples) {
+  wideband_source_t *src = (wideband_source_t*) h;
+  if (nsamples > 0) {
+    nsamples = 1 + rand() % nsamples;
+  }
+  if (src->rp + nsamples > src->len) {
+    nsamples = src->len - src->rp;
+  }
+  memcpy(data, &src->samples[src->rp], sizeof(cf_t) * nsamples);
+  src->rp += nsamples;
+  return nsamples;
+}
+
+int main(int argc, char **argv) {
+  channelizer_t chan;
+  channelizer_stream_t stream;
+  wideband_source_t src;
+  cf_t *input, *output[CHANNELIZER_MAX_CHANNELS], *output_blk[CHANNELIZER_MAX_CHANNELS];
+  cf_t *blk[CHANNELIZER_MAX_CHANNELS];
+  uint32_t i, k, c, N, D, n_out, n_blk, len, skip, rp[CHANNELIZER_MAX_CHANNELS], min_rp;
+  struct timeval t[3];
+  float snr, gain, atten, worst_atten, t_chan = 0;
+  double freq;
+  uint64_t total_in = 0;
+  int n, ret = -1;
+
+  bzero(&chan, sizeof(channelizer_t));
+  bzero(&stream, sizeof(channelizer_stream_t));
+  bzero(output, sizeof(output));
+  bzero(output_blk, sizeof(output_blk));
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+  N = nof_channels;
+
+  input = malloc(sizeof(cf_t) * nof_samples);
+  if (!input) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (k = 0; k < N; k++) {
+    output[k] = malloc(sizeof(cf_t) * (nof_samples + 1));
+    output_blk[k] = malloc(sizeof(cf_t) * (nof_samples + 1));
+    if (!output[k] || !output_blk[k]) {
+      perror("malloc");
+      goto quit;
+    }
+  }
+
+  /* critically sampled, 2x and 4x oversampled */
+  for (D = N; D >= N / 4 && D > 0; D /= 2) {
+    if (channelizer_init(&chan, N, D, NULL, 0)) {
+      fprintf(stderr, "Error initiating channelizer\n");
+      goto quit;
+    }
+    skip = chan.nof_taps / D + 1;
+    for (c = 0; c < N; c++) {
+      /* tone 0.2 channels above the center of channel c */
+      freq = (c + 0.2) / N;
+      for (i = 0; i < nof_samples; i++) {
+        input[i] = cexp(I * 2 * M_PI * freq * (double) i);
+      }
+      channelizer_reset(&chan);
+      gettimeofday(&t[1], NULL);
+      n_out = channelizer_run(&chan, input, nof_samples, output);
+      gettimeofday(&t[2], NULL);
+      t_chan += get_time_interval_us(t);
+      total_in += nof_samples;
+      if (n_out != (nof_samples + D - 1) / D) {
+        fprintf(stderr, "N=%d, D=%d: %d output samples, expected %d\n", N, D, n_out, 
+            (nof_samples + D - 1) / D);
+        goto quit;
+      }
+      snr = tone_fit(output[c], n_out, skip, (freq - (double) c / N) * D, &gain);
+      worst_atten = 1000;
+      for (k = 0; k < N; k++) {
+        if (k != c) {
+          atten = -power_db(output[k], n_out, skip);
+          if (atten < worst_atten) {
+            worst_atten = atten;
+          }
+        }
+      }
+      if (c == 0 || snr < min_snr || fabsf(gain) > 0.01 || worst_atten < min_atten) {
+        printf("N=%d, D=%d, channel %d: SNR %.1f dB, gain %.3f dB, other channels %.1f dB\n", 
+            N, D, c, snr, gain, worst_atten);
+      }
+      if (snr < min_snr || fabsf(gain) > 0.01 || worst_atten < min_atten) {
+        fprintf(stderr, "Channel does not meet SNR %.1f dB and attenuation %.1f dB\n", 
+            min_snr, min_atten);
+        goto quit;
+      }
+    }
+
+    /* random signal in blocks of random length */
+    for (i = 0; i < nof_samples; i++) {
+      input[i] = ((float) rand() / RAND_MAX - 0.5) + ((float) rand() / RAND_MAX - 0.5) * I;
+    }
+    channelizer_reset(&chan);
+    n_out = channelizer_run(&chan, input, nof_samples, output);
+    channelizer_reset(&chan);
+    n_blk = 0;
+    for (i = 0; i < nof_samples; i += len) {
+      len = rand() % 10000;
+      if (i + len > nof_samples) {
+        len = nof_samples - i;
+      }
+      for (k = 0; k < N; k++) {
+        blk[k] = &output_blk[k][n_blk];
+      }
+      n_blk += channelizer_run(&chan, &input[i], len, blk);
+    }
+    for (k = 0; k < N; k++) {
+      if (n_blk != n_out || memcmp(output[k], output_blk[k], sizeof(cf_t) * n_out)) {
+        fprintf(stderr, "N=%d, D=%d: channel %d in blocks differs\n", N, D, k);
+        goto quit;
+      }
+    }
+
+    /* each channel pulled by its own receiver, in random order and lengths, 
+     * none of them more than 2000 samples ahead of the others */
+    src.samples = input;
+    src.len = nof_samples;
+    src.rp = 0;
+    if (channelizer_stream_init(&stream, N, D, NULL, 0, 2000, wideband_recv, &src)) {
+      fprintf(stderr, "Error initiating channelizer stream\n");
+      goto quit;
+    }
+    bzero(rp, sizeof(rp));
+    while (true) {
+      min_rp = rp[0];
+      for (k = 1; k < N; k++) {
+        if (rp[k] < min_rp) {
+          min_rp = rp[k];
+        }
+      }
+      do {
+        k = rand() % N;
+      } while (rp[k] >= min_rp + 1000);
+      len = rand() % 1000;
+      n = channelizer_stream_recv(channelizer_stream_port(&stream, k), 
+                                  &output_blk[k][rp[k]], len);
+      if (n < 0) {
+        fprintf(stderr, "Error receiving channel %d\n", k);
+        goto quit;
+      }
+      rp[k] += (uint32_t) n;
+      if ((uint32_t) n < len) {
+        break;
+      }
+    }
+    /* the source ran out, the channel got all its samples */
+    if (rp[k] != n_out) {
+      fprintf(stderr, "N=%d, D=%d: channel %d received %d samples at the end, expected %d\n", 
+              N, D, k, rp[k], n_out);
+      goto quit;
+    }
+    for (k = 0; k < N; k++) {
+      if (stream.overflow[k] || memcmp(output[k], output_blk[k], sizeof(cf_t) * rp[k])) {
+        fprintf(stderr, "N=%d, D=%d: channel %d received through the stream differs\n", N, D, k);
+        goto quit;
+      }
+    }
+    channelizer_stream_free(&stream);
+    channelizer_free(&chan);
+  }
+  printf("Channelized %lu samples at %.1f Msps\n", total_in, total_in / t_chan);
+  ret = 0;
+quit:
+  channelizer_stream_free(&stream);
+  channelizer_free(&chan);
+  free(input);
+  for (k = 0; k < N; k++) {
+    if (output[k]) {
+      free(output[k]);
+    }
+    if (output_blk[k]) {
+      free(output_blk[k]);
+    }
+  }
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
@@ -0,0 +1,227 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+#include "tone.h"
+
+/* Checks decim_fir_run() with Kaiser lowpass filters designed with fir_lowpass() 
+ * for several decimation factors, with real taps and with complex taps 
+ * centered off DC: a tone in the passband must come out with at least min_snr 
+ * dB of SNR and unity gain, a tone in the stopband (which would alias into the 
+ * passband) must be attenuated by at least min_atten dB, the number of output 
+ * samples must be exact and decimating in blocks of random size must give the 
+ * same samples as in a single call.
+ */
+
+#define ATTEN_DB  70
+
+uint32_t nof_samples = 100000;
+float min_snr = 60.0;
+float min_atten = 60.0;
+uint32_t seed = 0;
+
+uint32_t factors[] = { 2, 3, 4, 5, 8, 16 };
+double centers[] = { 0, 0.25, -0.1 };
+
+void usage(char *prog) {
+  printf("Usage: %s [neas]\n", prog);
+  printf("\t-n nof_samples per filter [Default %d]\n", nof_samples);
+  printf("\t-e minimum SNR in dB [Default %.1f]\n", min_snr);
+  printf("\t-a minimum stopband attenuation in dB [Default %.1f]\n", min_atten);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "neas")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_samples = atoi(argv[optind]);
+      break;
+    case 'e':
+      min_snr = atof(argv[optind]);
+      break;
+    case 'a':
+      min_atten = atof(argv[optind]);
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+void gen_tone(cf_t *x, uint32_t len, double freq) {
+  uint32_t i;
+  for (i = 0; i < len; i++) {
+    x[i] = cexp(I * 2 * M_PI * freq * (double) i);
+  }
+}
+
+int main(int argc, char **argv) {
+  decim_fir_t d;
+  float *taps = NULL;
+  cf_t *taps_c = NULL, *input, *output, *output_blk;
+  uint32_t i, m, c, M, nof_taps, n_out, n_blk, len, skip;
+  struct timeval t[3];
+  float snr, gain, atten, t_decim = 0;
+  double fc;
+  uint64_t total_in = 0;
+  int ret = -1;
+
+  bzero(&d, sizeof(decim_fir_t));
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+
+  input = malloc(sizeof(cf_t) * nof_samples);
+  output = malloc(sizeof(cf_t) * (nof_samples + 1));
+  output_blk = malloc(sizeof(cf_t) * (nof_samples + 1));
+  if (!input || !output || !output_blk) {
+    perror("malloc");
+    exit(-1);
+  }
+
+  for (m = 0; m < sizeof(factors) / sizeof(uint32_t); m++) {
+    M = factors[m];
+    /* passband up to 0.3/M, stopband from 0.7/M */
+    nof_taps = fir_kaiser_len(ATTEN_DB, 0.4 / M);
+    taps = malloc(sizeof(float) * nof_taps);
+    taps_c = malloc(sizeof(cf_t) * nof_taps);
+    if (!taps || !taps_c) {
+      perror("malloc");
+      goto quit;
+    }
+    if (fir_lowpass(taps, nof_taps, 0.5 / M, fir_kaiser_beta(ATTEN_DB))) {
+      fprintf(stderr, "Error designing filter\n");
+      goto quit;
+    }
+    skip = nof_taps / M + 1;
+
+    for (c = 0; c < sizeof(centers) / sizeof(double); c++) {
+      fc = centers[c];
+      if (fc == 0) {
+        if (decim_fir_init(&d, M, taps, nof_taps)) {
+          goto quit;
+        }
+      } else {
+        fir_shift(taps, taps_c, nof_taps, fc);
+        if (decim_fir_init_c(&d, M, taps_c, nof_taps)) {
+          goto quit;
+        }
+      }
+
+      /* passband tone */
+      gen_tone(input, nof_samples, fc + 0.3 / M);
+      gettimeofday(&t[1], NULL);
+      n_out = decim_fir_run(&d, input, output, nof_samples);
+      gettimeofday(&t[2], NULL);
+      t_decim += get_time_interval_us(t);
+      total_in += nof_samples;
+      if (n_out != (nof_samples + M - 1) / M) {
+        fprintf(stderr, "M=%d: %d output samples, expected %d\n", M, n_out, 
+            (nof_samples + M - 1) / M);
+        goto quit;
+      }
+      snr = tone_fit(output, n_out, skip, (fc + 0.3 / M) * M, &gain);
+
+      /* stopband tone */
+      decim_fir_reset(&d);
+      gen_tone(input, nof_samples, fc + 0.7 / M);
+      n_out = decim_fir_run(&d, input, output, nof_samples);
+      atten = -power_db(output, n_out, skip);
+
+      printf("M=%2d, %3d taps, fc=%5.2f: SNR %.1f dB, gain %.3f dB, stopband %.1f dB\n", 
+          M, nof_taps, fc, snr, gain, atten);
+      if (snr < min_snr || fabsf(gain) > 0.01 || atten < min_atten) {
+        fprintf(stderr, "Filter does not meet SNR %.1f dB and attenuation %.1f dB\n", 
+            min_snr, min_atten);
+        goto quit;
+      }
+
+      /* random signal in blocks of random length */
+      for (i = 0; i < nof_samples; i++) {
+        input[i] = ((float) rand() / RAND_MAX - 0.5) + ((float) rand() / RAND_MAX - 0.5) * I;
+      }
+      decim_fir_reset(&d);
+      n_out = decim_fir_run(&d, input, output, nof_samples);
+      decim_fir_reset(&d);
+      n_blk = 0;
+      for (i = 0; i < nof_samples; i += len) {
+        len = rand() % 3000;
+        if (i + len > nof_samples) {
+          len = nof_samples - i;
+        }
+        n_blk += decim_fir_run(&d, &input[i], &output_blk[n_blk], len);
+      }
+      if (n_blk != n_out || memcmp(output, output_blk, sizeof(cf_t) * n_out)) {
+        fprintf(stderr, "M=%d, fc=%.2f: output in blocks differs\n", M, fc);
+        goto quit;
+      }
+      decim_fir_free(&d);
+    }
+    free(taps);
+    free(taps_c);
+    taps = NULL;
+    taps_c = NULL;
+  }
+  printf("Decimated %lu samples at %.1f Msps\n", total_in, total_in / t_decim);
+  ret = 0;
+quit:
+  decim_fir_free(&d);
+  if (taps) {
+    free(taps);
+  }
+  if (taps_c) {
+    free(taps_c);
+  }
+  free(input);
+  free(output);
+  free(output_blk);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
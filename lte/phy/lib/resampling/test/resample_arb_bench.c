@@ -10,11 +10,15 @@
 
 typedef _Complex float cf_t;
 
+/* Compares the throughput of resample_arb_compute() and resample_arb_block_compute()
+ * converting 25 MHz to 24 MHz in blocks of 1 ms
+ */
 int main(int argc, char **argv) {
-  int N=10000000;
+  int N=5000000;
+  int blk=25000;
   float rate = 24.0/25.0;
   cf_t *in = malloc(N*sizeof(cf_t));
-  cf_t *out = malloc(N*sizeof(cf_t));
+  cf_t *out = malloc((N+blk)*sizeof(cf_t));
 
   for(int i=0;i<N;i++)
     in[i] = sin(i*2*M_PI/100);
@@ -23,14 +27,31 @@ int main(int argc, char **argv) {
   resample_arb_init(&r, rate);
 
   clock_t start = clock(), diff;
-  //int n_out = resample_arb_compute(&r, in, out, N);
+  int n_out = 0;
+  for(int i=0;i<N;i+=blk)
+    n_out += resample_arb_compute(&r, &in[i], &out[n_out], blk);
   diff = clock() - start;
 
   int msec = diff * 1000 / CLOCKS_PER_SEC;
   float thru = (CLOCKS_PER_SEC/(float)diff)*(N/1e6);
-  printf("Time taken %d seconds %d milliseconds\n", msec/1000, msec%1000);
-  printf("Rate = %f MS/sec\n", thru);
+  printf("resample_arb_compute: %d samples in %d.%03d s, %f MS/sec\n", n_out, msec/1000, msec%1000, thru);
 
+  resample_arb_block_t rb;
+  if (resample_arb_block_init(&rb, rate)) {
+    exit(-1);
+  }
+
+  start = clock();
+  n_out = 0;
+  for(int i=0;i<N;i+=blk)
+    n_out += resample_arb_block_compute(&rb, &in[i], &out[n_out], blk);
+  diff = clock() - start;
+
+  msec = diff * 1000 / CLOCKS_PER_SEC;
+  float thru_blk = (CLOCKS_PER_SEC/(float)diff)*(N/1e6);
+  printf("resample_arb_block_compute: %d samples in %d.%03d s, %f MS/sec (x%.1f)\n", n_out, msec/1000, msec%1000, thru_blk, thru_blk/thru);
+
+  resample_arb_block_free(&rb);
   free(in);
   free(out);
   printf("Done\n");
@@ -0,0 +1,195 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Checks resample_arb_block_compute() for the rates between the usual front-end
+ * and LTE sampling rates: a tone must come out with at least min_snr dB of SNR,
+ * resampling in blocks of random size must give the same samples as in a
+ * single call, and the number of output samples must be exact. Also checks that
+ * the precomputed taps of each phase give the same samples as interpolating them
+ * for every output.
+ */
+
+uint32_t nof_samples = 200000;
+float min_snr = 50.0;
+uint32_t seed = 0;
+
+float rates[] = { 
+  23.04 / 25, 30.72 / 25, 15.36 / 25, 15.36 / 20, 19.2 / 20, 30.72 / 20, 
+  0.5, 1.0, 2.0, 24.0 / 25, 0.7071068 
+};
+
+void usage(char *prog) {
+  printf("Usage: %s [nes]\n", prog);
+  printf("\t-n nof_samples per rate [Default %d]\n", nof_samples);
+  printf("\t-e minimum SNR in dB [Default %.1f]\n", min_snr);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "nes")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_samples = atoi(argv[optind]);
+      break;
+    case 'e':
+      min_snr = atof(argv[optind]);
+      break;
+    case 's':
+      seed = (uint32_t) strtoul(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* SNR of output sample k against the tone at k*decim/interp input samples, 
+ * minus the 5 samples of delay of the filter 
+ */
+float tone_snr(resample_arb_block_t *r, cf_t *output, uint32_t n_out, float freq) {
+  double t, s = 0, e = 0;
+  cf_t ideal;
+  uint32_t k;
+
+  for (k = RESAMPLE_ARB_M; k < n_out; k++) {
+    t = (double) k * r->decim / r->interp - 5 + 1.0 / (2 * RESAMPLE_ARB_N);
+    ideal = cexpf(I * 2 * M_PI * freq * t);
+    s += crealf(ideal * conjf(ideal));
+    e += crealf((output[k] - ideal) * conjf(output[k] - ideal));
+  }
+  return 10 * log10(s / e);
+}
+
+int main(int argc, char **argv) {
+  resample_arb_block_t r;
+  cf_t *input, *output, *output_blk;
+  uint32_t i, n, n_out, n_blk, len, expected;
+  struct timeval t[3];
+  float snr, t_block = 0;
+  uint64_t total_in = 0;
+  int ret = -1;
+
+  bzero(&r, sizeof(resample_arb_block_t));
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+
+  input = malloc(sizeof(cf_t) * nof_samples);
+  output = malloc(sizeof(cf_t) * (2 * nof_samples + 2));
+  output_blk = malloc(sizeof(cf_t) * (2 * nof_samples + 2));
+  if (!input || !output || !output_blk) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (i = 0; i < nof_samples; i++) {
+    input[i] = cexpf(I * 2 * M_PI * 0.02 * i);
+  }
+
+  for (n = 0; n < sizeof(rates) / sizeof(float); n++) {
+    if (resample_arb_block_init(&r, rates[n])) {
+      fprintf(stderr, "Error initiating resampler with rate %f\n", rates[n]);
+      goto quit;
+    }
+    gettimeofday(&t[1], NULL);
+    n_out = resample_arb_block_compute(&r, input, output, nof_samples);
+    gettimeofday(&t[2], NULL);
+    t_block += get_time_interval_us(t);
+    total_in += nof_samples;
+
+    expected = (uint32_t) (((uint64_t) (nof_samples + 1) * r.interp + r.decim - 1) / r.decim);
+    if (n_out != expected) {
+      fprintf(stderr, "Rate %d/%d: %d output samples, expected %d\n", 
+          r.interp, r.decim, n_out, expected);
+      goto quit;
+    }
+
+    snr = tone_snr(&r, output, n_out, 0.02);
+    printf("Rate %f = %d/%d: %d samples, SNR %.1f dB\n", rates[n], r.interp, r.decim, n_out, snr);
+    if (snr < min_snr) {
+      fprintf(stderr, "SNR below %.1f dB\n", min_snr);
+      goto quit;
+    }
+
+    /* same stream interpolating the taps for every output */
+    if (r.phase_taps) {
+      free(r.phase_taps);
+      r.phase_taps = NULL;
+      resample_arb_block_reset(&r);
+      if (resample_arb_block_compute(&r, input, output_blk, nof_samples) != n_out ||
+          memcmp(output, output_blk, sizeof(cf_t) * n_out)) {
+        fprintf(stderr, "Rate %d/%d: precomputed phases give different samples\n", 
+            r.interp, r.decim);
+        goto quit;
+      }
+    }
+
+    /* same stream in blocks of random length */
+    resample_arb_block_reset(&r);
+    n_blk = 0;
+    for (i = 0; i < nof_samples; i += len) {
+      len = rand() % 300;
+      if (i + len > nof_samples) {
+        len = nof_samples - i;
+      }
+      n_blk += resample_arb_block_compute(&r, &input[i], &output_blk[n_blk], len);
+    }
+    if (n_blk != n_out || memcmp(output, output_blk, sizeof(cf_t) * n_out)) {
+      fprintf(stderr, "Rate %d/%d: output in blocks differs\n", r.interp, r.decim);
+      goto quit;
+    }
+    resample_arb_block_free(&r);
+  }
+  printf("Resampled %lu samples at %.1f Msps\n", total_in, total_in / t_block);
+  ret = 0;
+quit:
+  resample_arb_block_free(&r);
+  free(input);
+  free(output);
+  free(output_blk);
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
@@ -0,0 +1,64 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+
+#include "tone.h"
+
+/* Fits output[k] = g*exp(j*2*pi*freq*k) from sample skip on. Returns the SNR 
+ * of the fit and the gain g in dB.
+ */
+float tone_fit(cf_t *output, uint32_t n_out, uint32_t skip, double freq, float *gain_db) {
+  _Complex double g = 0, e;
+  double s = 0, err = 0;
+  uint32_t k;
+
+  for (k = skip; k < n_out; k++) {
+    g += output[k] * cexp(-I * 2 * M_PI * freq * (double) k);
+  }
+  g /= (n_out - skip);
+  for (k = skip; k < n_out; k++) {
+    e = output[k] - g * cexp(I * 2 * M_PI * freq * (double) k);
+    err += creal(e * conj(e));
+    s += creal(g * conj(g));
+  }
+  *gain_db = 20 * log10(cabs(g));
+  return 10 * log10(s / err);
+}
+
+/* Power of output from sample skip on, in dB */
+float power_db(cf_t *output, uint32_t n_out, uint32_t skip) {
+  double p = 0;
+  uint32_t k;
+  for (k = skip; k < n_out; k++) {
+    p += crealf(output[k] * conjf(output[k]));
+  }
+  return 10 * log10(p / (n_out - skip) + 1e-30);
+}
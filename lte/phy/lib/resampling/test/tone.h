@@ -0,0 +1,49 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#ifndef TONE_
+#define TONE_
+
+#include <stdint.h>
+#include <complex.h>
+
+typedef _Complex float cf_t;
+
+/* Tone measurements shared by the decimator and channelizer tests */
+
+float tone_fit(cf_t *output, 
+               uint32_t n_out, 
+               uint32_t skip, 
+               double freq, 
+               float *gain_db);
+
+float power_db(cf_t *output, 
+               uint32_t n_out, 
+               uint32_t skip);
+
+#endif // TONE_
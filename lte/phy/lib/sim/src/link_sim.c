@@ -0,0 +1,547 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <complex.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "liblte/phy/sim/link_sim.h"
+#include "liblte/phy/common/phy_common.h"
+#include "liblte/phy/common/fft.h"
+#include "liblte/phy/ch_estimation/chest.h"
+#include "liblte/phy/ch_estimation/refsignal.h"
+#include "liblte/phy/channel/ch_rand.h"
+#include "liblte/phy/channel/ch_awgn.h"
+#include "liblte/phy/channel/ch_fading.h"
+#include "liblte/phy/phch/pdsch.h"
+#include "liblte/phy/phch/ra.h"
+#include "liblte/phy/utils/debug.h"
+
+#define SIM_SUBFRAME    1
+#define SIM_RNTI        1234
+#define SIM_CTRL_SYMBOLS 2
+#define SIM_CHANNEL_STREAM 0xffffffff  // stream of the channel of port 0, the next ports count down
+
+#define FRAME_PENDING   0
+#define FRAME_OK        1
+#define FRAME_ERROR     2
+
+static char *stage_names[LINK_SIM_NOF_STAGES] = {
+  "encode", "ifft", "channel", "fft", "chest", "decode"
+};
+
+/* Each worker owns a complete transmitter, channel and receiver */
+typedef struct {
+  void *sim;                    // link_sim_t this worker belongs to
+  pdsch_t pdsch;
+  pdsch_harq_t harq;
+  refsignal_t refs[MAX_PORTS][2];
+  chest_t chest;
+  lte_fft_t ifft;
+  lte_fft_t fft;
+  ch_fading_t fading[MAX_PORTS];
+  ch_rand_t gen;
+  cf_t *sf_symbols[MAX_PORTS];
+  cf_t *tx[MAX_PORTS];
+  cf_t *ce[MAX_PORTS];
+  cf_t *rx;
+  cf_t *rx_symbols;
+  cf_t *tmp;
+  float *bits;
+  char *data;
+  char *data_rx;
+  pthread_t thread;
+  bool thread_running;
+} link_sim_worker_t;
+
+typedef struct {
+  link_sim_cfg_t *cfg;
+  lte_cell_t cell;
+  ra_mcs_t mcs;
+  ra_prb_t prb_alloc;
+  bool fading;
+  ch_fading_model_t model;
+  float doppler;
+  float srate;
+  float noise_std;
+  uint32_t nof_re;
+  uint32_t sf_len;
+  uint32_t nof_workers;
+  link_sim_worker_t *workers;
+
+  /* per-subframe results, indexed by the subframe number */
+  uint8_t *status;
+  float *cpu_us;
+  uint32_t next_frame;          // next subframe to be simulated
+  uint32_t nof_frames;          // subframes in the contiguous completed prefix
+  uint32_t nof_errors;          // errors in the prefix
+  bool stop;
+  pthread_mutex_t mutex;
+} link_sim_t;
+
+void link_sim_cfg_default(link_sim_cfg_t *cfg) {
+  cfg->min_errors = 100;
+  cfg->min_frames = 100;
+  cfg->max_frames = 10000;
+  cfg->nof_threads = 1;
+  cfg->seed = 1;
+}
+
+char* link_sim_stage_string(link_sim_stage_t stage) {
+  if (stage < LINK_SIM_NOF_STAGES) {
+    return stage_names[stage];
+  }
+  return "unknown";
+}
+
+/* CPU time consumed by the calling thread, in microseconds */
+static double thread_cpu_us() {
+  struct timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return (double) t.tv_sec * 1e6 + (double) t.tv_nsec / 1e3;
+}
+
+static void worker_free(link_sim_worker_t *w) {
+  uint32_t i, n;
+
+  pdsch_harq_free(&w->harq);
+  pdsch_free(&w->pdsch);
+  for (i = 0; i < MAX_PORTS; i++) {
+    for (n = 0; n < 2; n++) {
+      refsignal_free(&w->refs[i][n]);
+    }
+    if (w->sf_symbols[i]) {
+      free(w->sf_symbols[i]);
+    }
+    if (w->tx[i]) {
+      free(w->tx[i]);
+    }
+    if (w->ce[i]) {
+      free(w->ce[i]);
+    }
+  }
+  for (i = 0; i < MAX_PORTS; i++) {
+    ch_fading_free(&w->fading[i]);
+  }
+  chest_free(&w->chest);
+  lte_ifft_free(&w->ifft);
+  lte_fft_free(&w->fft);
+  if (w->rx) {
+    free(w->rx);
+  }
+  if (w->rx_symbols) {
+    free(w->rx_symbols);
+  }
+  if (w->tmp) {
+    free(w->tmp);
+  }
+  if (w->bits) {
+    free(w->bits);
+  }
+  if (w->data) {
+    free(w->data);
+  }
+  if (w->data_rx) {
+    free(w->data_rx);
+  }
+  bzero(w, sizeof(link_sim_worker_t));
+}
+
+/* FFTW plans are created here, thus workers must be initialized from a single thread */
+static int worker_init(link_sim_t *s, link_sim_worker_t *w) {
+  uint32_t i, n;
+
+  bzero(w, sizeof(link_sim_worker_t));
+  w->sim = s;
+  if (pdsch_init(&w->pdsch, s->cell)) {
+    fprintf(stderr, "Error creating PDSCH object\n");
+    goto clean;
+  }
+  pdsch_set_rnti(&w->pdsch, SIM_RNTI);
+  if (pdsch_harq_init(&w->harq, &w->pdsch)) {
+    fprintf(stderr, "Error initiating HARQ process\n");
+    goto clean;
+  }
+  if (pdsch_harq_setup(&w->harq, s->mcs, &s->prb_alloc)) {
+    fprintf(stderr, "Error configuring HARQ process\n");
+    goto clean;
+  }
+  for (i = 0; i < s->cell.nof_ports; i++) {
+    for (n = 0; n < 2; n++) {
+      if (refsignal_init_LTEDL(&w->refs[i][n], i, 2 * SIM_SUBFRAME + n, s->cell)) {
+        fprintf(stderr, "Error initiating reference signal\n");
+        goto clean;
+      }
+    }
+    /* every worker has the same realization of the channel */
+    if (s->fading) {
+      ch_rand_init(&w->gen, s->cfg->seed, SIM_CHANNEL_STREAM - i);
+      if (ch_fading_init(&w->fading[i], s->model, s->doppler, s->srate, &w->gen)) {
+        fprintf(stderr, "Error initiating fading channel\n");
+        goto clean;
+      }
+    }
+    w->sf_symbols[i] = malloc(sizeof(cf_t) * s->nof_re);
+    w->tx[i] = malloc(sizeof(cf_t) * s->sf_len);
+    w->ce[i] = malloc(sizeof(cf_t) * s->nof_re);
+    if (!w->sf_symbols[i] || !w->tx[i] || !w->ce[i]) {
+      perror("malloc");
+      goto clean;
+    }
+  }
+  if (chest_init_LTEDL(&w->chest, s->cell)) {
+    fprintf(stderr, "Error initiating channel estimator\n");
+    goto clean;
+  }
+  if (lte_ifft_init(&w->ifft, s->cell.cp, s->cell.nof_prb) ||
+      lte_fft_init(&w->fft, s->cell.cp, s->cell.nof_prb)) {
+    fprintf(stderr, "Error initiating FFT\n");
+    goto clean;
+  }
+  w->rx = malloc(sizeof(cf_t) * s->sf_len);
+  w->rx_symbols = malloc(sizeof(cf_t) * s->nof_re);
+  w->tmp = malloc(sizeof(cf_t) * s->sf_len);
+  w->bits = malloc(sizeof(float) * s->mcs.tbs);
+  w->data = malloc(sizeof(char) * s->mcs.tbs);
+  w->data_rx = malloc(sizeof(char) * s->mcs.tbs);
+  if (!w->rx || !w->rx_symbols || !w->tmp || !w->bits || !w->data || !w->data_rx) {
+    perror("malloc");
+    goto clean;
+  }
+  return LIBLTE_SUCCESS;
+clean:
+  worker_free(w);
+  return LIBLTE_ERROR;
+}
+
+/* Simulates subframe n. Returns FRAME_OK or FRAME_ERROR, or LIBLTE_ERROR
+ * if the chain could not be run. Writes the CPU time of each stage to cpu_us.
+ */
+static int simulate_frame(link_sim_t *s, link_sim_worker_t *w, uint32_t n, float *cpu_us) {
+  uint32_t i, j, tbs = s->mcs.tbs;
+  double t, t_prev;
+  int ret;
+
+  ch_rand_init(&w->gen, s->cfg->seed, n);
+
+  t_prev = thread_cpu_us();
+  ch_rand_uniform(&w->gen, w->bits, tbs);
+  for (i = 0; i < tbs; i++) {
+    w->data[i] = w->bits[i] < 0.5 ? 1 : 0;
+  }
+  for (i = 0; i < s->cell.nof_ports; i++) {
+    bzero(w->sf_symbols[i], sizeof(cf_t) * s->nof_re);
+    refsignal_put(&w->refs[i][0], w->sf_symbols[i]);
+    refsignal_put(&w->refs[i][1], &w->sf_symbols[i][s->nof_re / 2]);
+  }
+  if (pdsch_encode(&w->pdsch, w->data, w->sf_symbols, SIM_SUBFRAME, &w->harq, 0)) {
+    fprintf(stderr, "Error encoding PDSCH\n");
+    return LIBLTE_ERROR;
+  }
+  t = thread_cpu_us();
+  cpu_us[LINK_SIM_ENCODE] = (float) (t - t_prev);
+  t_prev = t;
+
+  for (i = 0; i < s->cell.nof_ports; i++) {
+    lte_ifft_run_sf(&w->ifft, w->sf_symbols[i], w->tx[i]);
+  }
+  t = thread_cpu_us();
+  cpu_us[LINK_SIM_IFFT] = (float) (t - t_prev);
+  t_prev = t;
+
+  /* one receive antenna: add the signal of every port after its own channel */
+  for (i = 0; i < s->cell.nof_ports; i++) {
+    if (s->fading) {
+      ch_fading_set_time(&w->fading[i], (uint64_t) n * s->sf_len);
+      ch_fading_run(&w->fading[i], w->tx[i], w->tmp, s->sf_len);
+    } else {
+      memcpy(w->tmp, w->tx[i], sizeof(cf_t) * s->sf_len);
+    }
+    if (i == 0) {
+      memcpy(w->rx, w->tmp, sizeof(cf_t) * s->sf_len);
+    } else {
+      for (j = 0; j < s->sf_len; j++) {
+        w->rx[j] += w->tmp[j];
+      }
+    }
+  }
+  ch_awgn_c_rand(&w->gen, w->rx, w->rx, s->noise_std, s->sf_len);
+  t = thread_cpu_us();
+  cpu_us[LINK_SIM_CHANNEL] = (float) (t - t_prev);
+  t_prev = t;
+
+  lte_fft_run_sf(&w->fft, w->rx, w->rx_symbols);
+  t = thread_cpu_us();
+  cpu_us[LINK_SIM_FFT] = (float) (t - t_prev);
+  t_prev = t;
+
+  chest_ce_sf(&w->chest, w->rx_symbols, w->ce, SIM_SUBFRAME);
+  t = thread_cpu_us();
+  cpu_us[LINK_SIM_CHEST] = (float) (t - t_prev);
+  t_prev = t;
+
+  pdsch_set_noise_estimate(&w->pdsch, chest_get_noise_estimate(&w->chest));
+  ret = pdsch_decode(&w->pdsch, w->rx_symbols, w->ce, w->data_rx, SIM_SUBFRAME, &w->harq, 0);
+  t = thread_cpu_us();
+  cpu_us[LINK_SIM_DECODE] = (float) (t - t_prev);
+
+  if (ret == LIBLTE_ERROR_INVALID_INPUTS) {
+    fprintf(stderr, "Error calling pdsch_decode()\n");
+    return LIBLTE_ERROR;
+  }
+  if (ret != LIBLTE_SUCCESS || memcmp(w->data, w->data_rx, tbs)) {
+    return FRAME_ERROR;
+  }
+  return FRAME_OK;
+}
+
+/* Extends the completed prefix and decides whether the point is finished.
+ * Must be called with the mutex locked.
+ */
+static void update_prefix(link_sim_t *s) {
+  link_sim_cfg_t *cfg = s->cfg;
+
+  while (!s->stop && s->nof_frames < cfg->max_frames &&
+         s->status[s->nof_frames] != FRAME_PENDING)
+  {
+    if (s->status[s->nof_frames] == FRAME_ERROR) {
+      s->nof_errors++;
+    }
+    s->nof_frames++;
+    if ((s->nof_frames >= cfg->min_frames && s->nof_errors >= cfg->min_errors) ||
+        s->nof_frames >= cfg->max_frames)
+    {
+      s->stop = true;
+    }
+  }
+}
+
+static void* worker_thread(void *arg) {
+  link_sim_worker_t *w = (link_sim_worker_t*) arg;
+  link_sim_t *s = (link_sim_t*) w->sim;
+  uint32_t n;
+  int r;
+
+  pthread_mutex_lock(&s->mutex);
+  while (!s->stop && s->next_frame < s->cfg->max_frames) {
+    n = s->next_frame;
+    s->next_frame++;
+    pthread_mutex_unlock(&s->mutex);
+
+    r = simulate_frame(s, w, n, &s->cpu_us[n * LINK_SIM_NOF_STAGES]);
+
+    pthread_mutex_lock(&s->mutex);
+    if (r == LIBLTE_ERROR) {
+      s->stop = true;
+      s->nof_frames = 0;
+      break;
+    }
+    s->status[n] = (uint8_t) r;
+    update_prefix(s);
+  }
+  pthread_mutex_unlock(&s->mutex);
+  return NULL;
+}
+
+static int sim_setup(link_sim_t *s, link_sim_cfg_t *cfg, link_sim_point_t *point) {
+  uint32_t i;
+
+  s->cfg = cfg;
+  s->cell.nof_prb = point->nof_prb;
+  s->cell.nof_ports = point->nof_ports;
+  s->cell.id = 0;
+  s->cell.cp = CPNORM;
+  if (!lte_cell_isvalid(&s->cell) || s->cell.nof_ports == 3) {
+    fprintf(stderr, "Invalid cell: %d PRB, %d ports\n", point->nof_prb, point->nof_ports);
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (ra_mcs_from_idx_dl(point->mcs_idx, point->nof_prb, &s->mcs) || !s->mcs.tbs) {
+    fprintf(stderr, "Invalid MCS %d for %d PRB\n", point->mcs_idx, point->nof_prb);
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (!strcasecmp(point->channel, "AWGN")) {
+    s->fading = false;
+  } else if (ch_fading_parse(point->channel, &s->model, &s->doppler) == LIBLTE_SUCCESS) {
+    s->fading = true;
+  } else {
+    fprintf(stderr, "Invalid channel %s\n", point->channel);
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+
+  /* the whole bandwidth is allocated in both slots */
+  s->prb_alloc.slot[0].nof_prb = point->nof_prb;
+  for (i = 0; i < point->nof_prb; i++) {
+    s->prb_alloc.slot[0].prb_idx[i] = i;
+  }
+  memcpy(&s->prb_alloc.slot[1], &s->prb_alloc.slot[0], sizeof(ra_prb_slot_t));
+  ra_prb_get_re_dl(&s->prb_alloc, point->nof_prb, point->nof_ports, SIM_CTRL_SYMBOLS, CPNORM);
+
+  /* FFTs are unitary, thus the noise power per resource element equals the
+   * noise power per time sample
+   */
+  s->srate = (float) lte_sampling_freq_hz(point->nof_prb);
+  s->noise_std = sqrtf(powf(10, -point->snr_db / 10) / 2);
+  s->nof_re = SF_LEN_RE(point->nof_prb, CPNORM);
+  s->sf_len = SF_LEN(lte_symbol_sz(point->nof_prb));
+  return LIBLTE_SUCCESS;
+}
+
+/** Simulates one point until the stopping rule of cfg is met and writes
+ * BLER, throughput and mean CPU time of each stage to result.
+ */
+int link_sim_run(link_sim_cfg_t *cfg, link_sim_point_t *point, link_sim_result_t *result) {
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  link_sim_t s;
+  double cpu_total[LINK_SIM_NOF_STAGES];
+  uint32_t i, j;
+
+  bzero(&s, sizeof(link_sim_t));
+  if (cfg                   != NULL &&
+      point                 != NULL &&
+      result                != NULL &&
+      cfg->max_frames       >  0    &&
+      cfg->nof_threads      >  0    &&
+      cfg->nof_threads      <= LINK_SIM_MAX_THREADS)
+  {
+    ret = sim_setup(&s, cfg, point);
+    if (ret != LIBLTE_SUCCESS) {
+      return ret;
+    }
+    ret = LIBLTE_ERROR;
+    pthread_mutex_init(&s.mutex, NULL);
+    s.status = calloc(cfg->max_frames, sizeof(uint8_t));
+    s.cpu_us = calloc(cfg->max_frames * LINK_SIM_NOF_STAGES, sizeof(float));
+    s.workers = calloc(cfg->nof_threads, sizeof(link_sim_worker_t));
+    if (!s.status || !s.cpu_us || !s.workers) {
+      perror("malloc");
+      goto clean;
+    }
+    for (i = 0; i < cfg->nof_threads; i++) {
+      if (worker_init(&s, &s.workers[i])) {
+        goto clean;
+      }
+      s.nof_workers++;
+    }
+    INFO("Simulating MCS %d, %d PRB, %d ports, %s, SNR %.1f dB with %d threads\n",
+         point->mcs_idx, point->nof_prb, point->nof_ports, point->channel,
+         point->snr_db, cfg->nof_threads);
+
+    /* worker 0 is the calling thread */
+    for (i = 1; i < s.nof_workers; i++) {
+      if (pthread_create(&s.workers[i].thread, NULL, worker_thread, &s.workers[i])) {
+        perror("pthread_create");
+        break;
+      }
+      s.workers[i].thread_running = true;
+    }
+    worker_thread(&s.workers[0]);
+    for (i = 1; i < s.nof_workers; i++) {
+      if (s.workers[i].thread_running) {
+        pthread_join(s.workers[i].thread, NULL);
+      }
+    }
+    if (!s.nof_frames) {
+      goto clean;
+    }
+
+    bzero(result, sizeof(link_sim_result_t));
+    memcpy(&result->point, point, sizeof(link_sim_point_t));
+    result->tbs = s.mcs.tbs;
+    result->nof_frames = s.nof_frames;
+    result->nof_errors = s.nof_errors;
+    result->bler = (float) s.nof_errors / s.nof_frames;
+    result->throughput_mbps = (float) s.mcs.tbs * (1 - result->bler) / 1000;
+    bzero(cpu_total, sizeof(cpu_total));
+    for (i = 0; i < s.nof_frames; i++) {
+      for (j = 0; j < LINK_SIM_NOF_STAGES; j++) {
+        cpu_total[j] += s.cpu_us[i * LINK_SIM_NOF_STAGES + j];
+      }
+    }
+    for (j = 0; j < LINK_SIM_NOF_STAGES; j++) {
+      result->cpu_us[j] = (float) (cpu_total[j] / s.nof_frames);
+    }
+    ret = LIBLTE_SUCCESS;
+  }
+clean:
+  if (s.workers) {
+    for (i = 0; i < s.nof_workers; i++) {
+      worker_free(&s.workers[i]);
+    }
+    free(s.workers);
+  }
+  if (s.status) {
+    free(s.status);
+  }
+  if (s.cpu_us) {
+    free(s.cpu_us);
+  }
+  if (ret != LIBLTE_ERROR_INVALID_INPUTS) {
+    pthread_mutex_destroy(&s.mutex);
+  }
+  return ret;
+}
+
+void link_sim_fprint_csv_header(FILE *f) {
+  uint32_t j;
+  fprintf(f, "mcs,nof_prb,nof_ports,channel,snr_db,tbs,frames,errors,bler,throughput_mbps");
+  for (j = 0; j < LINK_SIM_NOF_STAGES; j++) {
+    fprintf(f, ",cpu_us_%s", stage_names[j]);
+  }
+  fprintf(f, "\n");
+}
+
+void link_sim_fprint_csv(FILE *f, link_sim_result_t *r) {
+  uint32_t j;
+  fprintf(f, "%d,%d,%d,%s,%.2f,%d,%d,%d,%.6f,%.4f", r->point.mcs_idx, r->point.nof_prb,
+          r->point.nof_ports, r->point.channel, r->point.snr_db, r->tbs, r->nof_frames,
+          r->nof_errors, r->bler, r->throughput_mbps);
+  for (j = 0; j < LINK_SIM_NOF_STAGES; j++) {
+    fprintf(f, ",%.2f", r->cpu_us[j]);
+  }
+  fprintf(f, "\n");
+}
+
+/* Prints the result as a JSON object, without trailing separator */
+void link_sim_fprint_json(FILE *f, link_sim_result_t *r) {
+  uint32_t j;
+  fprintf(f, "{\"mcs\": %d, \"nof_prb\": %d, \"nof_ports\": %d, \"channel\": \"%s\", "
+          "\"snr_db\": %.2f, \"tbs\": %d, \"frames\": %d, \"errors\": %d, \"bler\": %.6f, "
+          "\"throughput_mbps\": %.4f, \"cpu_us\": {", r->point.mcs_idx, r->point.nof_prb,
+          r->point.nof_ports, r->point.channel, r->point.snr_db, r->tbs, r->nof_frames,
+          r->nof_errors, r->bler, r->throughput_mbps);
+  for (j = 0; j < LINK_SIM_NOF_STAGES; j++) {
+    fprintf(f, "%s\"%s\": %.2f", j ? ", " : "", stage_names[j], r->cpu_us[j]);
+  }
+  fprintf(f, "}}");
+}
@@ -0,0 +1,151 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "liblte/phy/phy.h"
+
+/* Checks link_sim_run(): no errors at high SNR in AWGN, every subframe in
+ * error at very low SNR, where the point must stop exactly after min_errors
+ * subframes, and the same results for a fading channel with 2 ports whether
+ * it is simulated with 1 or with several threads.
+ */
+
+uint32_t nof_threads = 2;
+uint64_t seed = 0;
+
+void usage(char *prog) {
+  printf("Usage: %s [ts]\n", prog);
+  printf("\t-t nof_threads for the parallel run [Default %d]\n", nof_threads);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ts")) != -1) {
+    switch (opt) {
+    case 't':
+      nof_threads = atoi(argv[optind]);
+      break;
+    case 's':
+      seed = strtoull(argv[optind], NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+int run_point(link_sim_cfg_t *cfg, uint32_t mcs_idx, uint32_t nof_prb, uint32_t nof_ports,
+              char *channel, float snr_db, link_sim_result_t *r)
+{
+  link_sim_point_t point;
+
+  bzero(&point, sizeof(link_sim_point_t));
+  point.mcs_idx = mcs_idx;
+  point.nof_prb = nof_prb;
+  point.nof_ports = nof_ports;
+  point.snr_db = snr_db;
+  strncpy(point.channel, channel, LINK_SIM_CHANNEL_LEN - 1);
+  if (link_sim_run(cfg, &point, r)) {
+    fprintf(stderr, "Error running MCS %d, %s, SNR %.1f dB\n", mcs_idx, channel, snr_db);
+    return -1;
+  }
+  link_sim_fprint_csv(stdout, r);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  link_sim_cfg_t cfg;
+  link_sim_result_t r, r_par;
+  uint32_t j;
+
+  parse_args(argc, argv);
+  if (!seed) {
+    seed = time(NULL);
+  }
+  link_sim_cfg_default(&cfg);
+  cfg.seed = seed;
+  link_sim_fprint_csv_header(stdout);
+
+  cfg.min_errors = 10;
+  cfg.min_frames = 20;
+  cfg.max_frames = 20;
+  if (run_point(&cfg, 9, 6, 1, "AWGN", 30.0, &r)) {
+    exit(-1);
+  }
+  if (r.nof_frames != 20 || r.nof_errors != 0) {
+    fprintf(stderr, "Expected no errors at high SNR\n");
+    exit(-1);
+  }
+  if (r.throughput_mbps != (float) r.tbs / 1000) {
+    fprintf(stderr, "Throughput %.3f Mbps does not match TBS %d\n", r.throughput_mbps, r.tbs);
+    exit(-1);
+  }
+  for (j = 0; j < LINK_SIM_NOF_STAGES; j++) {
+    if (r.cpu_us[j] < 0) {
+      fprintf(stderr, "Negative CPU time for stage %s\n", link_sim_stage_string(j));
+      exit(-1);
+    }
+  }
+
+  cfg.min_frames = 1;
+  cfg.max_frames = 100;
+  if (run_point(&cfg, 20, 6, 2, "AWGN", -10.0, &r)) {
+    exit(-1);
+  }
+  if (r.nof_frames != cfg.min_errors || r.nof_errors != cfg.min_errors || r.bler != 1.0) {
+    fprintf(stderr, "Expected to stop after %d errors at low SNR\n", cfg.min_errors);
+    exit(-1);
+  }
+
+  cfg.min_errors = 5;
+  cfg.min_frames = 10;
+  cfg.max_frames = 40;
+  cfg.nof_threads = 1;
+  if (run_point(&cfg, 15, 15, 2, "EVA70", 12.0, &r)) {
+    exit(-1);
+  }
+  cfg.nof_threads = nof_threads;
+  if (run_point(&cfg, 15, 15, 2, "EVA70", 12.0, &r_par)) {
+    exit(-1);
+  }
+  if (r.nof_frames != r_par.nof_frames || r.nof_errors != r_par.nof_errors) {
+    fprintf(stderr, "Results with 1 and %d threads differ\n", nof_threads);
+    exit(-1);
+  }
+
+  printf("Ok\n");
+  exit(0);
+}
@@ -33,6 +33,7 @@
 #include "liblte/phy/common/phy_common.h"
 #include "liblte/phy/sync/sync.h"
 #include "liblte/phy/utils/vector.h"
+#include "liblte/phy/utils/trace.h"
 
 
 static bool fft_size_isvalid(uint32_t fft_size) {
@@ -218,7 +219,7 @@ int sync_sss(sync_t *q, cf_t *input, uint32_t peak_pos) {
   return 1;
 }
 
-int sync_find(sync_t *q, cf_t *input, uint32_t find_offset, uint32_t *peak_position) 
+static int do_sync_find(sync_t *q, cf_t *input, uint32_t find_offset, uint32_t *peak_position) 
 {
   
   int ret = LIBLTE_ERROR_INVALID_INPUTS; 
@@ -291,6 +292,15 @@ int sync_find(sync_t *q, cf_t *input, uint32_t find_offset, uint32_t *peak_posit
   return ret; 
 }
 
+int sync_find(sync_t *q, cf_t *input, uint32_t find_offset, uint32_t *peak_position)
+{
+  int ret;
+  TRACE_BEGIN(TRACE_SYNC_FIND);
+  ret = do_sync_find(q, input, find_offset, peak_position);
+  TRACE_END(TRACE_SYNC_FIND);
+  return ret;
+}
+
 void sync_reset(sync_t *q) {
   q->frame_cnt = 0;
 }
@@ -26,6 +26,7 @@
  */
 
 #include "liblte/phy/ue/ue_dl.h"
+#include "liblte/phy/utils/trace.h"
 
 #include <complex.h>
 #include <math.h>
@@ -145,7 +146,7 @@ void ue_dl_free(ue_dl_t *q) {
 LIBLTE_API float mean_exec_time=0; 
 int frame_cnt=0;
 
-int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t rnti) 
+static int do_ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t rnti) 
 {
   uint32_t cfi, cfi_distance, i;
   ra_pdsch_t ra_dl;
@@ -266,6 +267,7 @@ int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t
         }
       }
       if (q->harq_process[0].mcs.mod > 0) {
+        pdsch_set_noise_estimate(&q->pdsch, chest_get_noise_estimate(&q->chest));
         ret = pdsch_decode(&q->pdsch, q->sf_symbols, q->ce, data, sf_idx, 
             &q->harq_process[0], rvidx);
         if (ret == LIBLTE_ERROR) {
@@ -301,3 +303,12 @@ int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t
     return 0;
   }
 }
+
+int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t rnti)
+{
+  int ret;
+  TRACE_BEGIN(TRACE_UE_DL);
+  ret = do_ue_dl_decode(q, input, data, sf_idx, rnti);
+  TRACE_END(TRACE_UE_DL);
+  return ret;
+}
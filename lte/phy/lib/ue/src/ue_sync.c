@@ -36,6 +36,7 @@
 
 #include "liblte/phy/utils/debug.h"
 #include "liblte/phy/utils/vector.h"
+#include "liblte/phy/utils/trace.h"
 
 #define MAX_TIME_OFFSET 128
 cf_t dummy[MAX_TIME_OFFSET];
@@ -145,11 +146,49 @@ void ue_sync_decode_sss_on_track(ue_sync_t *q, bool enabled) {
   q->decode_sss_on_track = enabled; 
 }
 
+/* Records the received samples and the aligned subframes in recorder. 
+ * NULL stops recording. 
+ */
+void ue_sync_set_recorder(ue_sync_t *q, sigmf_sink_t *recorder) {
+  q->recorder = recorder; 
+}
+
+/* All the samples are received through here, so that they can be recorded */
+static int recv_samples(ue_sync_t *q, cf_t *buffer, uint32_t nsamples) {
+  int n = q->recv_callback(q->stream, buffer, nsamples);
+  if (n < 0) {
+    return n; 
+  }
+  /* only the n samples received are valid on a short read */
+  if (q->recorder) {
+    if (sigmf_sink_write(q->recorder, buffer, (uint32_t) n)) {
+      fprintf(stderr, "Error recording samples\n");
+    }
+  }
+  q->nof_recv += n; 
+  return n; 
+}
+
+static void annotate(ue_sync_t *q, uint64_t sf_end, bool pss) {
+  sigmf_annotation_t a; 
+  
+  a.sample_start = sf_end - CURRENT_SFLEN; 
+  a.sample_count = CURRENT_SFLEN; 
+  a.sf_idx = q->sf_idx; 
+  a.sfn = SIGMF_SFN_UNKNOWN; 
+  a.cell_id = q->cell.id; 
+  a.cfo = ue_sync_get_cfo(q);
+  a.pss = pss; 
+  if (sigmf_sink_annotate(q->recorder, &a)) {
+    fprintf(stderr, "Error annotating recording\n");
+  }
+}
+
 
 static int find_peak_ok(ue_sync_t *q) {
 
   /* Receive the rest of the next subframe */
-  if (q->recv_callback(q->stream, q->input_buffer, q->peak_idx+CURRENT_SFLEN/2) < 0) {
+  if (recv_samples(q, q->input_buffer, q->peak_idx+CURRENT_SFLEN/2) < 0) {
     return LIBLTE_ERROR;
   }
   
@@ -189,7 +228,7 @@ int track_peak_ok(ue_sync_t *q, uint32_t track_idx) {
     /* If the PSS peak is beyond the frame (we sample too slowly), 
       discard the offseted samples to align next frame */
     if (q->time_offset > 0 && q->time_offset < MAX_TIME_OFFSET) {
-      if (q->recv_callback(q->stream, dummy, (uint32_t) q->time_offset) < 0) {
+      if (recv_samples(q, dummy, (uint32_t) q->time_offset) < 0) {
         fprintf(stderr, "Error receiving from USRP\n");
         return LIBLTE_ERROR; 
       }
@@ -237,7 +276,7 @@ static int receive_samples(ue_sync_t *q) {
   //memcpy(q->input_buffer, &q->input_buffer[CURRENT_SFLEN-q->time_offset], q->time_offset*sizeof(cf_t));
   
   /* Get 1 subframe from the USRP getting more samples and keeping the previous samples, if any */  
-  if (q->recv_callback(q->stream, &q->input_buffer[q->time_offset], CURRENT_SFLEN - q->time_offset) < 0) {
+  if (recv_samples(q, &q->input_buffer[q->time_offset], CURRENT_SFLEN - q->time_offset) < 0) {
     return LIBLTE_ERROR;
   }
   
@@ -247,10 +286,12 @@ static int receive_samples(ue_sync_t *q) {
   return LIBLTE_SUCCESS; 
 }
 
-int ue_sync_get_buffer(ue_sync_t *q, cf_t **sf_symbols) {
+static int do_ue_sync_get_buffer(ue_sync_t *q, cf_t **sf_symbols) {
   int ret = LIBLTE_ERROR_INVALID_INPUTS; 
   uint32_t track_idx; 
   struct timeval t[3];
+  uint64_t sf_end; 
+  bool pss = false; 
 
   if (q               != NULL   &&
       sf_symbols      != NULL   &&
@@ -261,6 +302,7 @@ int ue_sync_get_buffer(ue_sync_t *q, cf_t **sf_symbols) {
       fprintf(stderr, "Error receiving samples\n");
       return -1;
     }
+    sf_end = q->nof_recv; 
     
     switch (q->state) {
       case SF_FIND:        
@@ -279,7 +321,7 @@ int ue_sync_get_buffer(ue_sync_t *q, cf_t **sf_symbols) {
           } else {
             rlen = q->peak_idx;
           }
-          if (q->recv_callback(q->stream, q->input_buffer, rlen) < 0) {
+          if (recv_samples(q, q->input_buffer, rlen) < 0) {
             return LIBLTE_ERROR;
           }
         }
@@ -314,6 +356,7 @@ int ue_sync_get_buffer(ue_sync_t *q, cf_t **sf_symbols) {
           #endif
 
           if (ret == 1) {
+            pss = true; 
             ret = track_peak_ok(q, track_idx);
           } else {
             ret = track_peak_no(q); 
@@ -331,12 +374,24 @@ int ue_sync_get_buffer(ue_sync_t *q, cf_t **sf_symbols) {
         cfo_correct(&q->cfocorr, q->input_buffer, q->input_buffer, -q->cur_cfo / CURRENT_FFTSIZE);         
         *sf_symbols = q->input_buffer;
         
+        if (q->recorder) {
+          annotate(q, sf_end, pss);
+        }
       break;
     }
   }  
   return ret; 
 }
 
+int ue_sync_get_buffer(ue_sync_t *q, cf_t **sf_symbols)
+{
+  int ret;
+  TRACE_BEGIN(TRACE_UE_SYNC);
+  ret = do_ue_sync_get_buffer(q, sf_symbols);
+  TRACE_END(TRACE_UE_SYNC);
+  return ret;
+}
+
 void ue_sync_reset(ue_sync_t *q) {
   q->state = SF_FIND;
     
@@ -38,3 +38,9 @@ void get_time_interval(struct timeval * tdata) {
     tdata[0].tv_usec += 1000000;
   }
 }
+
+/* Same as get_time_interval(), also returns the interval in microseconds */
+float get_time_interval_us(struct timeval * tdata) {
+  get_time_interval(tdata);
+  return (float) tdata[0].tv_sec * 1e6 + tdata[0].tv_usec;
+}
@@ -0,0 +1,281 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "liblte/phy/utils/trace.h"
+
+#define TRACE_NAME_LEN        32
+#define TRACE_CALIB_MIN_NS    10000000
+
+typedef struct {
+  uint64_t ticks;
+  uint16_t stage;
+  uint8_t type;
+} trace_rec_t;
+
+typedef struct trace_buffer_s {
+  struct trace_buffer_s *next;
+  uint32_t tid;
+  char name[TRACE_NAME_LEN];
+  uint64_t head;                // number of events written, only grows
+  trace_rec_t events[];
+} trace_buffer_t;
+
+static const char *stage_names[TRACE_NOF_STAGES] = {
+  "cuhd_recv", "ue_sync", "sync_find", "fft", "chest", "pbch", "pcfich",
+  "pdcch", "pdsch", "turbo_iter", "ue_dl"
+};
+
+bool trace_enabled = false;
+
+static trace_buffer_t *buffers = NULL;
+static uint32_t nof_events = 0;      // power of two
+static uint32_t generation = 0;
+static uint32_t next_tid = 0;
+static uint64_t t0_ticks;
+static uint64_t t0_ns;
+
+/* A thread's buffer belongs to the trace_init() call of its generation */
+static __thread trace_buffer_t *thread_buffer = NULL;
+static __thread uint32_t thread_generation = 0;
+
+static inline uint64_t trace_ns() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static inline uint64_t trace_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+#else
+  return trace_ns();
+#endif
+}
+
+/* Allocates the buffer of the calling thread and pushes it to the list */
+static trace_buffer_t* buffer_register() {
+  uint32_t gen = generation;
+  trace_buffer_t *b;
+
+  if (!nof_events) {
+    return NULL;
+  }
+  b = calloc(1, sizeof(trace_buffer_t) + sizeof(trace_rec_t) * nof_events);
+  if (!b) {
+    return NULL;
+  }
+  b->tid = __sync_add_and_fetch(&next_tid, 1);
+  snprintf(b->name, TRACE_NAME_LEN, "thread %d", b->tid);
+  do {
+    b->next = buffers;
+  } while (!__sync_bool_compare_and_swap(&buffers, b->next, b));
+
+  thread_buffer = b;
+  thread_generation = gen;
+  return b;
+}
+
+static inline trace_buffer_t* buffer_get() {
+  if (thread_generation == generation && thread_buffer) {
+    return thread_buffer;
+  }
+  return buffer_register();
+}
+
+/** Allocates nof_events_x_thread events (rounded up to a power of two) for
+ * each thread that records events from now on, and enables tracing. Calling
+ * it again discards the events recorded so far.
+ *
+ * It frees the buffers of the previous call, so like trace_free() it must not
+ * be called while another thread may be recording events.
+ */
+int trace_init(uint32_t nof_events_x_thread) {
+  if (nof_events_x_thread == 0) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  trace_free();
+  nof_events = 1;
+  while (nof_events < nof_events_x_thread) {
+    nof_events <<= 1;
+  }
+  t0_ns = trace_ns();
+  t0_ticks = trace_ticks();
+  trace_enabled = true;
+  return LIBLTE_SUCCESS;
+}
+
+/* Disables tracing and frees the buffers of all threads. Recording does not
+ * lock the buffers, so the caller must make sure that no other thread is
+ * running an instrumented stage, e.g. by joining them first.
+ */
+void trace_free() {
+  trace_buffer_t *b, *next;
+
+  trace_enabled = false;
+  b = __sync_lock_test_and_set(&buffers, NULL);
+  while (b) {
+    next = b->next;
+    free(b);
+    b = next;
+  }
+  nof_events = 0;
+  __sync_add_and_fetch(&generation, 1);
+}
+
+void trace_set_enabled(bool enabled) {
+  trace_enabled = enabled && nof_events > 0;
+}
+
+/* Names the calling thread in the trace */
+int trace_thread_name(const char *name) {
+  trace_buffer_t *b = buffer_get();
+  if (!b || !name) {
+    return LIBLTE_ERROR;
+  }
+  strncpy(b->name, name, TRACE_NAME_LEN - 1);
+  return LIBLTE_SUCCESS;
+}
+
+void trace_event(trace_stage_t stage, trace_ev_t type) {
+  trace_buffer_t *b = buffer_get();
+  trace_rec_t *e;
+  uint64_t head;
+
+  if (b) {
+    head = b->head;
+    e = &b->events[head & (nof_events - 1)];
+    e->ticks = trace_ticks();
+    e->stage = (uint16_t) stage;
+    e->type = (uint8_t) type;
+    __atomic_store_n(&b->head, head + 1, __ATOMIC_RELEASE);
+  }
+}
+
+const char* trace_stage_name(trace_stage_t stage) {
+  if (stage < TRACE_NOF_STAGES) {
+    return stage_names[stage];
+  } else {
+    return "unknown";
+  }
+}
+
+/* Writes s as a JSON string, escaping quotes, backslashes and control characters */
+static void write_json_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') {
+      fprintf(f, "\\%c", *s);
+    } else if ((unsigned char) *s < 0x20) {
+      fprintf(f, "\\u%04x", (unsigned char) *s);
+    } else {
+      fputc(*s, f);
+    }
+  }
+  fputc('"', f);
+}
+
+/* Writes the events of one thread. End events at the start of the ring whose
+ * begin event was overwritten are skipped.
+ */
+static void write_buffer(FILE *f, trace_buffer_t *b, double us_x_tick, bool *first) {
+  uint64_t head, i;
+  uint32_t depth = 0;
+  trace_rec_t *e;
+
+  fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+      "\"args\":{\"name\":", *first ? "" : ",", b->tid);
+  write_json_string(f, b->name);
+  fprintf(f, "}}");
+  *first = false;
+
+  head = __atomic_load_n(&b->head, __ATOMIC_ACQUIRE);
+  for (i = head > nof_events ? head - nof_events : 0; i < head; i++) {
+    e = &b->events[i & (nof_events - 1)];
+    if (e->type == TRACE_EV_END) {
+      if (depth == 0) {
+        continue;
+      }
+      depth--;
+    } else {
+      depth++;
+    }
+    fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+        trace_stage_name(e->stage), e->type == TRACE_EV_BEGIN ? "B" : "E",
+        (double) (int64_t) (e->ticks - t0_ticks) * us_x_tick, b->tid);
+  }
+}
+
+/** Writes the events recorded by all threads in the Chrome trace event format.
+ * Time stamps are in microseconds since trace_init().
+ */
+int trace_write_json(const char *filename) {
+  FILE *f;
+  trace_buffer_t *b;
+  uint64_t ns, ticks;
+  struct timespec t;
+  double us_x_tick;
+  bool first = true;
+
+  if (!filename) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  f = fopen(filename, "w");
+  if (!f) {
+    perror("fopen");
+    return LIBLTE_ERROR;
+  }
+
+  /* calibrate the tick rate against the monotonic clock */
+  ns = trace_ns() - t0_ns;
+  if (ns < TRACE_CALIB_MIN_NS) {
+    t.tv_sec = 0;
+    t.tv_nsec = TRACE_CALIB_MIN_NS - ns;
+    nanosleep(&t, NULL);
+  }
+  ticks = trace_ticks() - t0_ticks;
+  ns = trace_ns() - t0_ns;
+  us_x_tick = ticks > 0 ? (double) ns / 1000 / ticks : 0;
+
+  fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (b = buffers; b; b = b->next) {
+    write_buffer(f, b, us_x_tick, &first);
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+  return LIBLTE_SUCCESS;
+}
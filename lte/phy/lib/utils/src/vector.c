@@ -156,6 +156,19 @@ void vec_convert_fi(float *x, int16_t *z, float scale, uint32_t len) {
 #endif
 }
 
+/* z = x / scale. The generic loop is vectorized by the compiler */
+void vec_convert_if(int16_t *x, float *z, float scale, uint32_t len) {
+#ifdef HAVE_VOLK_CONVERT_IF_FUNCTION
+  volk_16i_s32f_convert_32f(z, x, scale, len);
+#else 
+  int i;
+  float gain = 1 / scale;
+  for (i=0;i<len;i++) {
+    z[i] = (float) x[i] * gain;
+  }
+#endif
+}
+
 void vec_deinterleave_cf(cf_t *x, float *real, float *imag, uint32_t len) {
  #ifdef HAVE_VOLK_DEINTERLEAVE_FUNCTION
   volk_32fc_deinterleave_32f_x2(real, imag, x, len);
@@ -366,6 +379,21 @@ cf_t vec_dot_prod_conj_ccc(cf_t *x, cf_t *y, uint32_t len) {
 }
 
 
+cf_t vec_dot_prod_cfc_iq(cf_t *x, float *y, uint32_t len) {
+  float *xf = (float*) x;
+  float acc[4];
+  uint32_t i, k;
+
+  /* accumulates [re im re im] groups, so the loop vectorizes on 4 floats */
+  for (k = 0; k < 4; k++) {
+    acc[k] = 0;
+    for (i = 0; i < 2 * len; i += 4) {
+      acc[k] += xf[i + k] * y[i + k];
+    }
+  }
+  return (acc[0] + acc[2]) + (acc[1] + acc[3]) * I;
+}
+
 float vec_dot_prod_fff(float *x, float *y, uint32_t len) {
 #ifdef HAVE_VOLK_DOTPROD_F_FUNCTION
   float res;
@@ -0,0 +1,209 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "liblte/phy/phy.h"
+
+/* Records nested stage events from several threads into rings shorter than
+ * the number of events, so that the oldest ones are overwritten, and checks
+ * the Chrome trace written by trace_write_json(): one name per thread, with
+ * the quotes in it escaped, no more events than the ring length, begin/end
+ * events balanced and time stamps in order.
+ */
+
+#define MAX_THREADS   16
+
+uint32_t nof_threads = 4;
+uint32_t nof_events = 1000;
+uint32_t nof_subframes = 300;
+char *output_file_name = "trace_test.json";
+
+void usage(char *prog) {
+  printf("Usage: %s [tesov]\n", prog);
+  printf("\t-t nof_threads [Default %d]\n", nof_threads);
+  printf("\t-e nof_events per thread [Default %d]\n", nof_events);
+  printf("\t-s nof_subframes per thread [Default %d]\n", nof_subframes);
+  printf("\t-o output file [Default %s]\n", output_file_name);
+  printf("\t-v [set verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "tesov")) != -1) {
+    switch (opt) {
+    case 't':
+      nof_threads = atoi(argv[optind]);
+      break;
+    case 'e':
+      nof_events = atoi(argv[optind]);
+      break;
+    case 's':
+      nof_subframes = atoi(argv[optind]);
+      break;
+    case 'o':
+      output_file_name = argv[optind];
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (nof_threads < 1 || nof_threads > MAX_THREADS) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+/* Each subframe records ue_dl { fft, chest, pdsch { 4 x turbo_iter } } */
+void* thread_fn(void *arg) {
+  char name[32];
+  uint32_t i, j;
+
+  snprintf(name, 32, "worker \"%ld\"", (long) arg);
+  trace_thread_name(name);
+  for (i = 0; i < nof_subframes; i++) {
+    trace_event(TRACE_UE_DL, TRACE_EV_BEGIN);
+    trace_event(TRACE_FFT, TRACE_EV_BEGIN);
+    trace_event(TRACE_FFT, TRACE_EV_END);
+    trace_event(TRACE_CHEST, TRACE_EV_BEGIN);
+    trace_event(TRACE_CHEST, TRACE_EV_END);
+    trace_event(TRACE_PDSCH, TRACE_EV_BEGIN);
+    for (j = 0; j < 4; j++) {
+      trace_event(TRACE_TURBO_ITER, TRACE_EV_BEGIN);
+      trace_event(TRACE_TURBO_ITER, TRACE_EV_END);
+    }
+    trace_event(TRACE_PDSCH, TRACE_EV_END);
+    trace_event(TRACE_UE_DL, TRACE_EV_END);
+  }
+  return NULL;
+}
+
+/* Parses the trace. Events are written one per line */
+int check_trace(char *filename) {
+  FILE *f;
+  char line[256], name[64], ph[4], *p;
+  int tid, nof_names = 0;
+  double ts, last_ts[MAX_THREADS + 1];
+  uint32_t nof_ev[MAX_THREADS + 1];
+  int depth[MAX_THREADS + 1];
+  uint32_t i, ring_len;
+
+  f = fopen(filename, "r");
+  if (!f) {
+    perror(filename);
+    return -1;
+  }
+  bzero(nof_ev, sizeof(nof_ev));
+  bzero(depth, sizeof(depth));
+  for (i = 0; i <= MAX_THREADS; i++) {
+    last_ts[i] = -1e9;
+  }
+  while (fgets(line, 256, f)) {
+    p = strchr(line, '{');
+    if (p && sscanf(p, "{\"name\":\"%63[^\"]\",\"ph\":\"%3[^\"]\",\"ts\":%lf,\"pid\":1,\"tid\":%d}",
+               name, ph, &ts, &tid) == 4) {
+      if (tid < 1 || tid > MAX_THREADS) {
+        fprintf(stderr, "Invalid tid %d\n", tid);
+        return -1;
+      }
+      if (ts < last_ts[tid]) {
+        fprintf(stderr, "Thread %d: time stamps out of order\n", tid);
+        return -1;
+      }
+      last_ts[tid] = ts;
+      depth[tid] += ph[0] == 'B' ? 1 : -1;
+      if (depth[tid] < 0) {
+        fprintf(stderr, "Thread %d: end event without begin\n", tid);
+        return -1;
+      }
+      nof_ev[tid]++;
+    } else if (strstr(line, "\"thread_name\"") && strstr(line, "\"name\":\"worker \\\"")) {
+      nof_names++;
+    }
+  }
+  fclose(f);
+
+  for (ring_len = 1; ring_len < nof_events; ring_len <<= 1);
+  if (nof_names != nof_threads) {
+    fprintf(stderr, "Expected %d threads, found %d\n", nof_threads, nof_names);
+    return -1;
+  }
+  for (i = 1; i <= nof_threads; i++) {
+    INFO("Thread %d: %d events\n", i, nof_ev[i]);
+    if (nof_ev[i] == 0 || nof_ev[i] > ring_len) {
+      fprintf(stderr, "Thread %d: %d events, ring of %d\n", i, nof_ev[i], ring_len);
+      return -1;
+    }
+    if (depth[i] != 0) {
+      fprintf(stderr, "Thread %d: %d begin events without end\n", i, depth[i]);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  pthread_t threads[MAX_THREADS];
+  long i;
+
+  parse_args(argc, argv);
+
+  if (trace_init(nof_events)) {
+    fprintf(stderr, "Error initiating trace\n");
+    exit(-1);
+  }
+  for (i = 0; i < nof_threads; i++) {
+    if (pthread_create(&threads[i], NULL, thread_fn, (void*) i)) {
+      perror("pthread_create");
+      exit(-1);
+    }
+  }
+  for (i = 0; i < nof_threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  if (trace_write_json(output_file_name)) {
+    exit(-1);
+  }
+  trace_free();
+
+  if (check_trace(output_file_name)) {
+    printf("Error\n");
+    exit(-1);
+  }
+  printf("Ok\n");
+  exit(0);
+}